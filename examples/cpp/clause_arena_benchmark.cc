@@ -0,0 +1,172 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the ClauseArena storing the clauses of the SatSolver. It prints
+// the time per clause of the basic operations of the arena on a set of random
+// clauses:
+//   - create: SatClause::Create() in the arena.
+//   - index_of: ClauseArena::IndexOf() on each clause.
+//   - attach: LiteralWatchers::AttachAndPropagate(), which computes the index
+//     of the clause for its two watchers.
+//   - compact: detach and free half of the clauses, then compact the arena and
+//     relocate the other half and their watchers.
+// It then solves a random 3-SAT instance within a conflict limit, and prints
+// the number of propagations per microsecond, which depends on the memory
+// locality of the clauses.
+
+#include <stdio.h>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "sat/clause.h"
+#include "sat/sat_base.h"
+#include "sat/sat_parameters.pb.h"
+#include "sat/sat_solver.h"
+
+DEFINE_int32(num_variables, 100000, "Number of variables of the clauses.");
+DEFINE_int32(num_clauses, 2000000, "Number of clauses of the arena benchmark.");
+DEFINE_int32(max_clause_size, 10, "The clauses have between 3 and this number "
+             "of literals.");
+DEFINE_int32(solve_num_variables, 5000,
+             "Number of variables of the random 3-SAT instance.");
+DEFINE_int64(solve_max_conflicts, 20000,
+             "Conflict limit of the resolution of the 3-SAT instance.");
+DEFINE_int32(seed, 0, "Seed of the random clauses.");
+
+namespace operations_research {
+namespace sat {
+namespace {
+
+void RandomClause(int num_variables, int size, ACMRandom* random,
+                  std::vector<Literal>* literals) {
+  literals->clear();
+  while (literals->size() < size) {
+    const Literal literal(VariableIndex(random->Uniform(num_variables)),
+                          random->OneIn(2));
+    bool is_new = true;
+    for (const Literal other : *literals) {
+      if (other.Variable() == literal.Variable()) is_new = false;
+    }
+    if (is_new) literals->push_back(literal);
+  }
+}
+
+void PrintTime(const char* name, const WallTimer& timer, int64 count) {
+  printf("%-10s %9.3f s %9.1f ns/clause\n", name, timer.Get(),
+         timer.Get() * 1e9 / std::max<int64>(1, count));
+}
+
+void BenchmarkArena() {
+  ACMRandom random(FLAGS_seed);
+  ClauseArena arena;
+  std::vector<SatClause*> clauses;
+  std::vector<Literal> literals;
+  WallTimer timer;
+
+  timer.Start();
+  for (int i = 0; i < FLAGS_num_clauses; ++i) {
+    RandomClause(FLAGS_num_variables,
+                 3 + random.Uniform(FLAGS_max_clause_size - 2), &random,
+                 &literals);
+    clauses.push_back(SatClause::Create(literals, /*is_redundant=*/true,
+                                        /*node=*/nullptr, &arena));
+  }
+  timer.Stop();
+  PrintTime("create", timer, clauses.size());
+
+  timer.Restart();
+  int64 checksum = 0;
+  for (SatClause* clause : clauses) {
+    checksum += arena.IndexOf(clause).value();
+  }
+  timer.Stop();
+  PrintTime("index_of", timer, clauses.size());
+  CHECK_GT(checksum, 0);
+
+  Trail trail;
+  trail.Resize(FLAGS_num_variables);
+  LiteralWatchers watchers(&arena);
+  watchers.Resize(FLAGS_num_variables);
+  timer.Restart();
+  for (SatClause* clause : clauses) {
+    CHECK(watchers.AttachAndPropagate(clause, &trail));
+  }
+  timer.Stop();
+  PrintTime("attach", timer, clauses.size());
+
+  timer.Restart();
+  std::vector<SatClause*> live_clauses;
+  for (int i = 0; i < clauses.size(); ++i) {
+    if (i % 2 == 0) {
+      watchers.LazyDetach(clauses[i]);
+    } else {
+      live_clauses.push_back(clauses[i]);
+    }
+  }
+  watchers.CleanUpWatchers();
+  for (int i = 0; i < clauses.size(); i += 2) {
+    arena.Free(clauses[i]);
+  }
+  arena.StartCompaction();
+  for (SatClause*& clause : live_clauses) {
+    clause = arena.Relocate(clause);
+  }
+  watchers.RelocateWatchers();
+  arena.FinishCompaction();
+  timer.Stop();
+  PrintTime("compact", timer, clauses.size());
+  printf("arena: %lld used bytes, %lld live bytes\n",
+         static_cast<long long>(arena.num_used_bytes()),
+         static_cast<long long>(arena.num_live_bytes()));
+}
+
+void BenchmarkSolve() {
+  ACMRandom random(FLAGS_seed);
+  SatSolver solver;
+  SatParameters parameters;
+  parameters.set_max_number_of_conflicts(FLAGS_solve_max_conflicts);
+  parameters.set_log_search_progress(false);
+  solver.SetParameters(parameters);
+  solver.SetNumVariables(FLAGS_solve_num_variables);
+  // A clause/variable ratio close to the satisfiability threshold of 4.26
+  // gives hard instances.
+  const int num_clauses = 4.2 * FLAGS_solve_num_variables;
+  std::vector<Literal> literals;
+  for (int i = 0; i < num_clauses; ++i) {
+    RandomClause(FLAGS_solve_num_variables, 3, &random, &literals);
+    if (!solver.AddProblemClause(literals)) break;
+  }
+  WallTimer timer;
+  timer.Start();
+  const SatSolver::Status status = solver.Solve();
+  timer.Stop();
+  printf("solve: %s in %.3f s, %lld conflicts, %.1f propagations/us\n",
+         SatStatusString(status).c_str(), timer.Get(),
+         static_cast<long long>(solver.num_failures()),
+         solver.num_propagations() / (timer.Get() * 1e6));
+}
+
+}  // namespace
+}  // namespace sat
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::sat::BenchmarkArena();
+  operations_research::sat::BenchmarkSolve();
+  return EXIT_SUCCESS;
+}
@@ -20,7 +20,9 @@
 //
 // This example contains two separate implementations. CostasHard()
 // uses hard constraints, whereas CostasSoft() uses a minimizer to
-// minimize the number of duplicates.
+// minimize the number of duplicates. With --num_workers > 0, the local
+// search of CostasSoft() runs on that many threads sharing the best
+// solution (see constraint_solver/parallel_search.h).
 #include <ctime>
 #include <set>
 #include <utility>
@@ -32,6 +34,7 @@
 #include "base/stringprintf.h"
 #include "constraint_solver/constraint_solver.h"
 #include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/parallel_search.h"
 #include "base/random.h"
 
 DEFINE_int32(minsize, 0, "Minimum degree of Costas matrix.");
@@ -42,6 +45,8 @@ DEFINE_int32(sublimit, 20, "Number of attempts per subtree.");
 DEFINE_int32(timelimit, 120000, "Time limit for local search.");
 DEFINE_bool(soft_constraints, false, "Use soft constraints.");
 DEFINE_string(export_profile, "", "filename to save the profile overview");
+DEFINE_int32(num_workers, 0, "If positive, run the local search of the soft "
+             "constraint model on that many threads.");
 
 namespace operations_research {
 
@@ -141,10 +146,8 @@ class OrderedLNS : public BaseLNS {
 // number of elements specified in 'free_elements' randomly.
 class RandomLNS : public BaseLNS {
  public:
-  RandomLNS(const std::vector<IntVar*>& vars, int free_elements)
-      : BaseLNS(vars),
-        free_elements_(free_elements),
-        rand_(ACMRandom::HostnamePidTimeSeed()) {}
+  RandomLNS(const std::vector<IntVar*>& vars, int free_elements, int32 seed)
+      : BaseLNS(vars), free_elements_(free_elements), rand_(seed) {}
 
   virtual bool NextFragment(std::vector<int>* const fragment) {
     std::vector<int> weighted_elements;
@@ -179,7 +182,7 @@ class RandomLNS : public BaseLNS {
             ++end;
           }
 
-          pos = weighted_elements.erase(pos, end);
+          pos = weighted_elements.erase(pos, end + 1);
         } else {
           ++pos;
         }
@@ -196,7 +199,7 @@ class RandomLNS : public BaseLNS {
   ACMRandom rand_;
 };
 
-class Evaluator {
+class Evaluator : public BaseObject {
  public:
   explicit Evaluator(const std::vector<IntVar*>& vars) : vars_(vars) {}
 
@@ -221,6 +224,75 @@ class Evaluator {
   std::vector<IntVar*> vars_;
 };
 
+// Builds the local search improving the first solution of the soft model. If
+// 'randomized' is true, the first operator frees random variables, chosen
+// with the random generator of the solver, instead of enumerating fragments.
+DecisionBuilder* MakeCostasLocalSearch(Solver* const solver,
+                                       const std::vector<IntVar*>& matrix,
+                                       SolutionPool* const pool,
+                                       bool randomized) {
+  // The first solution that the local optimization is based on
+  Evaluator* const evaluator = solver->RevAlloc(new Evaluator(matrix));
+  DecisionBuilder* const first_solution = solver->MakePhase(
+      matrix, NewPermanentCallback(evaluator, &Evaluator::VarEvaluator),
+      NewPermanentCallback(evaluator, &Evaluator::ValueEvaluator));
+
+  // Locally optimize solutions for LNS
+  SearchLimit* const fail_limit =
+      solver->MakeLimit(kint64max, kint64max, FLAGS_sublimit, kint64max);
+
+  DecisionBuilder* const subdecision_builder =
+      solver->MakeSolveOnce(first_solution, fail_limit);
+
+  std::vector<LocalSearchOperator*> localSearchOperators;
+
+  // Apply RandomLNS to free FLAGS_freevar variables at each stage
+  if (randomized) {
+    localSearchOperators.push_back(solver->RevAlloc(
+        new RandomLNS(matrix, FLAGS_freevar, solver->Rand32(kint32max))));
+  } else {
+    localSearchOperators.push_back(
+        solver->RevAlloc(new OrderedLNS(matrix, FLAGS_freevar)));
+  }
+
+  // Go through all possible permutations one by one
+  localSearchOperators.push_back(
+      solver->RevAlloc(new OrderedLNS(matrix, FLAGS_freeorderedvar)));
+
+  LocalSearchPhaseParameters* const ls_params =
+      solver->MakeLocalSearchPhaseParameters(
+          pool, solver->ConcatenateOperators(localSearchOperators),
+          subdecision_builder);
+
+  return solver->MakeLocalSearchPhase(matrix, first_solution, ls_params);
+}
+
+// Builds the local search of a worker of the parallel local search.
+DecisionBuilder* BuildWorkerLocalSearch(Solver* const solver,
+                                        const DecisionVariables& variables,
+                                        SolutionPool* const pool) {
+  return MakeCostasLocalSearch(solver, variables.vars, pool, true);
+}
+
+// Logs the matrix found by a collector.
+void DisplayCostas(SolutionCollector* const collector,
+                   const std::vector<IntVar*>& matrix) {
+  std::vector<int64> costas_matrix;
+  std::string output;
+
+  for (int n = 0; n < matrix.size(); ++n) {
+    const int64 v = collector->Value(0, matrix[n]);
+    costas_matrix.push_back(v);
+    StringAppendF(&output, "%3lld", v);
+  }
+
+  if (!CheckCostas(costas_matrix)) {
+    LOG(INFO) << "No Costas Matrix found, closest solution displayed.";
+  }
+
+  LOG(INFO) << output;
+}
+
 // Computes a Costas Array using soft constraints.
 // Instead of enforcing that all distance vectors are unique, we
 // minimize the number of duplicate distance vectors.
@@ -302,65 +374,46 @@ void CostasSoft(const int dim) {
   IntVar* const objective_var = solver.MakeSum(occurences)->Var();
   OptimizeVar* const total_duplicates = solver.MakeMinimize(objective_var, 1);
 
-  SearchMonitor* const log = solver.MakeSearchLog(1000, objective_var);
-
-  // Out of all solutions, we just want to store the last one.
-  SolutionCollector* const collector = solver.MakeLastSolutionCollector();
-  collector->Add(vars);
-
-  // The first solution that the local optimization is based on
-  Evaluator evaluator(matrix);
-  DecisionBuilder* const first_solution = solver.MakePhase(
-      matrix, NewPermanentCallback(&evaluator, &Evaluator::VarEvaluator),
-      NewPermanentCallback(&evaluator, &Evaluator::ValueEvaluator));
-
   SearchLimit* const search_time_limit =
       solver.MakeLimit(FLAGS_timelimit, kint64max, kint64max, kint64max);
 
-  // Locally optimize solutions for LNS
-  SearchLimit* const fail_limit =
-      solver.MakeLimit(kint64max, kint64max, FLAGS_sublimit, kint64max);
-
-  DecisionBuilder* const subdecision_builder =
-      solver.MakeSolveOnce(first_solution, fail_limit);
-
-  std::vector<LocalSearchOperator*> localSearchOperators;
-
-  // Apply RandomLNS to free FLAGS_freevar variables at each stage
-  localSearchOperators.push_back(
-      solver.RevAlloc(new OrderedLNS(matrix, FLAGS_freevar)));
-
-  // Go through all possible permutations one by one
-  localSearchOperators.push_back(
-      solver.RevAlloc(new OrderedLNS(matrix, FLAGS_freeorderedvar)));
+  DecisionBuilder* const second_phase = MakeCostasLocalSearch(
+      &solver, matrix, solver.MakeDefaultSolutionPool(), false);
+
+  if (FLAGS_num_workers > 0) {
+    std::vector<SearchMonitor*> monitors;
+    monitors.push_back(total_duplicates);
+    monitors.push_back(search_time_limit);
+    ParallelLocalSearch search(&solver, second_phase, monitors,
+                               NewPermanentCallback(&BuildWorkerLocalSearch),
+                               FLAGS_num_workers);
+    ParallelSolutionCollector collector(&solver, false);
+    collector.Add(matrix);
+    if (search.Solve(&collector)) {
+      LOG(INFO) << search.best_objective() << " duplicates found in "
+                << collector.wall_time(0) << " ms with " << FLAGS_num_workers
+                << " workers, " << search.neighbors() << " neighbors, "
+                << search.solutions() << " improvements and "
+                << search.imports() << " imported solutions.";
+      DisplayCostas(&collector, matrix);
+    } else {
+      LOG(INFO) << "No solution found";
+    }
+    return;
+  }
 
-  LocalSearchPhaseParameters* const ls_params =
-      solver.MakeLocalSearchPhaseParameters(
-          solver.ConcatenateOperators(localSearchOperators),
-          subdecision_builder);
+  SearchMonitor* const log = solver.MakeSearchLog(1000, objective_var);
 
-  DecisionBuilder* const second_phase =
-      solver.MakeLocalSearchPhase(matrix, first_solution, ls_params);
+  // Out of all solutions, we just want to store the last one.
+  SolutionCollector* const collector = solver.MakeLastSolutionCollector();
+  collector->Add(vars);
 
   // Try to find a solution
   solver.Solve(second_phase, collector, log, total_duplicates,
                search_time_limit);
 
   if (collector->solution_count() > 0) {
-    std::vector<int64> costas_matrix;
-    std::string output;
-
-    for (int n = 0; n < dim; ++n) {
-      const int64 v = collector->Value(0, vars[n]);
-      costas_matrix.push_back(v);
-      StringAppendF(&output, "%3lld", v);
-    }
-
-    if (!CheckCostas(costas_matrix)) {
-      LOG(INFO) << "No Costas Matrix found, closest solution displayed.";
-    }
-
-    LOG(INFO) << output;
+    DisplayCostas(collector, matrix);
   } else {
     LOG(INFO) << "No solution found";
   }
@@ -0,0 +1,172 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmark of the dense vector kernels used by glop. For each kernel and
+// each instruction set supported by the CPU, it prints the time per entry and
+// the speedup over the scalar version, and checks that all the instruction
+// sets give bitwise identical results.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "lp_data/dense_vector_kernels.h"
+
+DEFINE_int32(size, 1000, "Number of entries of the vectors.");
+DEFINE_double(mask_density, 0.3,
+              "Fraction of the entries in the mask of the masked kernel.");
+DEFINE_double(min_time_in_seconds, 0.2,
+              "Minimum running time of each kernel for each instruction set.");
+
+using operations_research::MTRandom;
+using operations_research::WallTimer;
+using operations_research::glop::DenseVectorKernels;
+using operations_research::glop::Fractional;
+using operations_research::glop::GetDenseVectorKernels;
+using operations_research::glop::GetSimdInstructionSetString;
+using operations_research::glop::IsSimdInstructionSetSupported;
+using operations_research::glop::SimdInstructionSet;
+
+namespace {
+
+enum Kernel {
+  ADD_MULTIPLE,
+  SCALAR_PRODUCT,
+  PRECISE_SCALAR_PRODUCT,
+  INFINITY_NORM,
+  MASKED_INFINITY_NORM,
+  NUM_KERNELS
+};
+
+const char* const kKernelNames[NUM_KERNELS] = {
+    "add_multiple", "scalar_product", "precise_scalar_product",
+    "infinity_norm", "masked_infinity_norm"};
+
+struct BenchmarkData {
+  std::vector<Fractional> u;
+  std::vector<Fractional> v;
+  std::vector<Fractional> y;
+  std::vector<uint64> mask;
+};
+
+// Runs the given kernel once and returns its result. For add_multiple(), the
+// output is data->y and the result is its last entry.
+Fractional RunKernel(const DenseVectorKernels& kernels, Kernel kernel,
+                     BenchmarkData* data) {
+  const int n = data->u.size();
+  switch (kernel) {
+    case ADD_MULTIPLE:
+      kernels.add_multiple(1e-3, data->u.data(), n, data->y.data());
+      return data->y[n - 1];
+    case SCALAR_PRODUCT:
+      return kernels.scalar_product(data->u.data(), data->v.data(), n);
+    case PRECISE_SCALAR_PRODUCT:
+      return kernels.precise_scalar_product(data->u.data(), data->v.data(), n);
+    case INFINITY_NORM:
+      return kernels.infinity_norm(data->u.data(), n);
+    case MASKED_INFINITY_NORM:
+      return kernels.masked_infinity_norm(data->u.data(), data->mask.data(),
+                                          n);
+    default:
+      LOG(FATAL) << "Unknown kernel " << kernel;
+  }
+  return 0.0;
+}
+
+// Returns true if the two vectors are bitwise identical.
+bool AreIdentical(const std::vector<Fractional>& a,
+                  const std::vector<Fractional>& b) {
+  return a.size() == b.size() &&
+         memcmp(a.data(), b.data(), a.size() * sizeof(Fractional)) == 0;
+}
+
+// Returns the time per call in nanoseconds.
+double TimeKernel(const DenseVectorKernels& kernels, Kernel kernel,
+                  BenchmarkData* data) {
+  int64 num_calls = 0;
+  Fractional sum = 0.0;
+  WallTimer timer;
+  timer.Start();
+  do {
+    for (int i = 0; i < 100; ++i) sum += RunKernel(kernels, kernel, data);
+    num_calls += 100;
+  } while (timer.Get() < FLAGS_min_time_in_seconds);
+  timer.Stop();
+  // Makes sure the calls are not optimized away.
+  VLOG(1) << kKernelNames[kernel] << " sum: " << sum;
+  return 1e9 * timer.Get() / num_calls;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_GT(FLAGS_size, 0);
+
+  MTRandom random(12345);
+  BenchmarkData data;
+  const int n = FLAGS_size;
+  for (int i = 0; i < n; ++i) {
+    data.u.push_back(random.UniformDouble(-1.0, 1.0));
+    data.v.push_back(random.UniformDouble(-1.0, 1.0));
+  }
+  data.y = data.v;
+  data.mask.assign((n + 63) / 64, 0);
+  for (int i = 0; i < n; ++i) {
+    if (random.RandDouble() < FLAGS_mask_density) {
+      data.mask[i / 64] |= GG_ULONGLONG(1) << (i % 64);
+    }
+  }
+
+  const SimdInstructionSet kInstructionSets[] = {
+      SimdInstructionSet::SCALAR, SimdInstructionSet::SSE2,
+      SimdInstructionSet::AVX2, SimdInstructionSet::AVX512};
+  printf("%-24s %-8s %12s %12s %8s\n", "kernel", "isa", "ns/call",
+         "ns/entry", "speedup");
+  for (int i = 0; i < NUM_KERNELS; ++i) {
+    const Kernel kernel = static_cast<Kernel>(i);
+    Fractional scalar_result = 0.0;
+    std::vector<Fractional> scalar_output;
+    double scalar_time = 0.0;
+    for (const SimdInstructionSet instruction_set : kInstructionSets) {
+      if (!IsSimdInstructionSetSupported(instruction_set)) continue;
+      const DenseVectorKernels& kernels =
+          GetDenseVectorKernels(instruction_set);
+
+      // Checks the result of one call against the scalar version.
+      data.y = data.v;
+      const Fractional result = RunKernel(kernels, kernel, &data);
+      if (instruction_set == SimdInstructionSet::SCALAR) {
+        scalar_result = result;
+        scalar_output = data.y;
+      }
+      CHECK(memcmp(&result, &scalar_result, sizeof(result)) == 0 &&
+            AreIdentical(data.y, scalar_output))
+          << kKernelNames[kernel] << " "
+          << GetSimdInstructionSetString(instruction_set) << ": " << result
+          << " != " << scalar_result;
+
+      const double time = TimeKernel(kernels, kernel, &data);
+      if (instruction_set == SimdInstructionSet::SCALAR) scalar_time = time;
+      printf("%-24s %-8s %12.1f %12.3f %7.2fx\n", kKernelNames[kernel],
+             GetSimdInstructionSetString(instruction_set).c_str(), time,
+             time / n, scalar_time / time);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Utilities shared by the problem readers to parse a big text file quickly:
+// the file is memory-mapped and split into chunks of whole lines that are
+// parsed concurrently.
+
+#ifndef OR_TOOLS_SAT_MAPPED_FILE_H_
+#define OR_TOOLS_SAT_MAPPED_FILE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mapped_file.h"
+#include "base/strutil.h"
+#include "base/threadpool.h"
+
+namespace operations_research {
+namespace sat {
+
+// Splits [begin, end) into parsers->size() consecutive chunks of roughly the
+// same size that only contain whole lines (the last line may not end by '\n'),
+// and calls (*parsers)[i].Parse(chunk_begin, chunk_end) on the i-th chunk, all
+// of them concurrently. The parsers must not share any mutable state.
+template <class ChunkParser>
+void ParseLinesInParallel(const char* begin, const char* end,
+                          std::vector<ChunkParser>* parsers) {
+  const int num_chunks = parsers->size();
+  CHECK_GT(num_chunks, 0);
+  if (num_chunks == 1) {
+    (*parsers)[0].Parse(begin, end);
+    return;
+  }
+  std::vector<const char*> starts(1, begin);
+  for (int i = 1; i < num_chunks; ++i) {
+    const char* start = begin + (end - begin) * i / num_chunks;
+    if (start < starts.back()) start = starts.back();
+    while (start > begin && start < end && start[-1] != '\n') ++start;
+    starts.push_back(start);
+  }
+  starts.push_back(end);
+  ThreadPool pool("ParseLines", num_chunks);
+  for (int i = 0; i < num_chunks; ++i) {
+    pool.Add(NewCallback(&(*parsers)[i], &ChunkParser::Parse, starts[i],
+                         starts[i + 1]));
+  }
+  pool.StartWorkers();
+}
+
+// Fast parsing helpers for the ChunkParser implementations. They work directly
+// on the mapped memory and never read past the given end.
+inline bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Skips the blanks (but not the end of line) and returns the new position.
+inline const char* SkipBlanks(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) ++p;
+  return p;
+}
+
+// Returns the position just after the end of the line starting at p.
+inline const char* SkipLine(const char* p, const char* end) {
+  while (p < end && *p != '\n') ++p;
+  return p < end ? p + 1 : end;
+}
+
+// Parses a signed integer in decimal notation. Like atoi64(), this stops at
+// the first invalid character, and returns 0 if there are no digits.
+inline const char* ParseInt64(const char* p, const char* end, int64* value) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  int64 result = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    result = result * 10 + (*p - '0');
+    ++p;
+  }
+  *value = negative ? -result : result;
+  return p;
+}
+
+}  // namespace sat
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_SAT_MAPPED_FILE_H_
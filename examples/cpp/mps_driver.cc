@@ -40,6 +40,8 @@ DEFINE_bool(mps_solve, true, "Solves problem.");
 DEFINE_bool(mps_terse_result, false,
             "Displays the result in form of a single CSV line.");
 DEFINE_bool(mps_verbose_result, true, "Displays the result in verbose form.");
+DEFINE_bool(mps_display_preprocessor_stats, false,
+            "Displays the time and reductions of each preprocessor.");
 DEFINE_bool(mps_display_full_path, true,
             "Displays the full path of the input file in the result line.");
 DEFINE_string(input, "", "File pattern for problems to be optimized.");
@@ -158,6 +160,10 @@ int main(int argc, char* argv[]) {
       printf("%s%s", linear_program.GetPrettyProblemStats().c_str(),
              linear_program.GetPrettyNonZeroStats().c_str());
     }
+
+    if (FLAGS_mps_solve && FLAGS_mps_display_preprocessor_stats) {
+      printf("%s", solver.GetPreprocessorStatString().c_str());
+    }
   }
   return EXIT_SUCCESS;
 }
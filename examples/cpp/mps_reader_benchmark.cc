@@ -0,0 +1,183 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the MPS reader. It reads the same file line by line and from a
+// memory mapping with 1 and --threads threads, prints the throughput in MB/s
+// of each mode and checks that they all give the same LinearProgram. If no
+// --input is given, a random free-form MPS file is generated first.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "base/commandlineflags.h"
+#include "base/fingerprint2011.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/mps_reader.h"
+
+DEFINE_string(input, "", "MPS file to read. If empty, a random file is "
+              "generated in --generated_file.");
+DEFINE_bool(free_form, false, "Whether --input is in free form.");
+DEFINE_string(generated_file, "/tmp/mps_reader_benchmark.mps",
+              "Where to write the random MPS file.");
+DEFINE_int32(num_rows, 100000, "Number of rows of the random file.");
+DEFINE_int32(num_cols, 200000, "Number of columns of the random file.");
+DEFINE_int32(entries_per_column, 20,
+             "Number of entries per column of the random file.");
+DEFINE_int32(num_runs, 3, "Number of times the file is read in each mode. The "
+             "best time is reported.");
+DEFINE_int32(threads, 4, "Number of threads of the parallel mode.");
+
+DECLARE_bool(mps_use_mmap);
+DECLARE_int32(mps_num_threads);
+
+using operations_research::MTRandom;
+using operations_research::WallTimer;
+using operations_research::glop::ColIndex;
+using operations_research::glop::Fractional;
+using operations_research::glop::LinearProgram;
+using operations_research::glop::MPSReader;
+using operations_research::glop::RowIndex;
+using operations_research::glop::SparseColumn;
+
+namespace {
+
+// Writes a random free-form MPS file with the given dimensions.
+void GenerateMpsFile(const std::string& file_name, int num_rows, int num_cols,
+                     int entries_per_column) {
+  MTRandom random(12345);
+  FILE* const file = fopen(file_name.c_str(), "w");
+  CHECK(file != nullptr) << "Cannot open " << file_name;
+  fprintf(file, "NAME RANDOM\nROWS\n N COST\n");
+  const char kRowTypes[] = {'L', 'G', 'E'};
+  for (int row = 0; row < num_rows; ++row) {
+    fprintf(file, " %c R%d\n", kRowTypes[random.Uniform(3)], row);
+  }
+  fprintf(file, "COLUMNS\n");
+  for (int col = 0; col < num_cols; ++col) {
+    if (col == num_cols / 2) {
+      fprintf(file, "    MARKER 'MARKER' 'INTORG'\n");
+    }
+    fprintf(file, "    C%d COST %.6g\n", col, random.UniformDouble(-10, 10));
+    for (int i = 0; i < entries_per_column; ++i) {
+      fprintf(file, "    C%d R%d %.17g\n", col, random.Uniform(num_rows),
+              random.UniformDouble(-100, 100));
+    }
+    if (col == num_cols / 2 + num_cols / 10) {
+      fprintf(file, "    MARKER 'MARKER' 'INTEND'\n");
+    }
+  }
+  fprintf(file, "RHS\n");
+  for (int row = 0; row < num_rows; ++row) {
+    fprintf(file, "    RHS R%d %.3f\n", row, random.UniformDouble(-50, 50));
+  }
+  fprintf(file, "BOUNDS\n");
+  for (int col = 0; col < num_cols; col += 7) {
+    fprintf(file, " UP BND C%d %d\n", col, random.Uniform(100) + 1);
+  }
+  fprintf(file, "ENDATA\n");
+  fclose(file);
+}
+
+uint64 FingerprintDouble(uint64 fp, double value) {
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return FingerprintCat2011(fp, bits);
+}
+
+uint64 FingerprintString(uint64 fp, const std::string& str) {
+  return FingerprintCat2011(fp, Fingerprint2011(str.data(), str.size()));
+}
+
+// Returns a fingerprint of everything the MPS reader fills in a
+// LinearProgram.
+uint64 FingerprintLinearProgram(const LinearProgram& lp) {
+  uint64 fp = 0;
+  for (RowIndex row(0); row < lp.num_constraints(); ++row) {
+    fp = FingerprintString(fp, lp.GetConstraintName(row));
+    fp = FingerprintDouble(fp, lp.constraint_lower_bounds()[row]);
+    fp = FingerprintDouble(fp, lp.constraint_upper_bounds()[row]);
+  }
+  for (ColIndex col(0); col < lp.num_variables(); ++col) {
+    fp = FingerprintString(fp, lp.GetVariableName(col));
+    fp = FingerprintDouble(fp, lp.variable_lower_bounds()[col]);
+    fp = FingerprintDouble(fp, lp.variable_upper_bounds()[col]);
+    fp = FingerprintDouble(fp, lp.objective_coefficients()[col]);
+    fp = FingerprintCat2011(fp, lp.is_variable_integer()[col]);
+    for (const SparseColumn::Entry e : lp.GetSparseColumn(col)) {
+      fp = FingerprintCat2011(fp, e.row().value());
+      fp = FingerprintDouble(fp, e.coefficient());
+    }
+  }
+  return fp;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  std::string file_name = FLAGS_input;
+  bool free_form = FLAGS_free_form;
+  if (file_name.empty()) {
+    file_name = FLAGS_generated_file;
+    free_form = true;
+    GenerateMpsFile(file_name, FLAGS_num_rows, FLAGS_num_cols,
+                    FLAGS_entries_per_column);
+  }
+  FILE* const file = fopen(file_name.c_str(), "r");
+  CHECK(file != nullptr) << "Cannot open " << file_name;
+  fseek(file, 0, SEEK_END);
+  const double size_in_mb = ftell(file) / (1024.0 * 1024.0);
+  fclose(file);
+
+  struct Mode {
+    const char* name;
+    bool use_mmap;
+    int num_threads;
+  };
+  const Mode kModes[] = {{"line reader", false, 1},
+                         {"mmap", true, 1},
+                         {"mmap parallel", true, FLAGS_threads}};
+  printf("%s: %.1f MB\n", file_name.c_str(), size_in_mb);
+  printf("%-16s %8s %10s %10s\n", "mode", "threads", "time(s)", "MB/s");
+  uint64 reference_fingerprint = 0;
+  for (const Mode& mode : kModes) {
+    FLAGS_mps_use_mmap = mode.use_mmap;
+    FLAGS_mps_num_threads = mode.num_threads;
+    double best_time = 0.0;
+    for (int run = 0; run < FLAGS_num_runs; ++run) {
+      LinearProgram linear_program;
+      MPSReader mps_reader;
+      WallTimer timer;
+      timer.Start();
+      CHECK(mps_reader.LoadFileWithMode(file_name, free_form, &linear_program))
+          << "Error while reading " << file_name;
+      timer.Stop();
+      if (run == 0 || timer.Get() < best_time) best_time = timer.Get();
+      if (run == 0) {
+        const uint64 fingerprint = FingerprintLinearProgram(linear_program);
+        if (&mode == &kModes[0]) reference_fingerprint = fingerprint;
+        CHECK_EQ(reference_fingerprint, fingerprint)
+            << mode.name << " gives a different LinearProgram.";
+      }
+    }
+    printf("%-16s %8d %10.3f %10.1f\n", mode.name, mode.num_threads, best_time,
+           size_in_mb / best_time);
+  }
+  return EXIT_SUCCESS;
+}
@@ -14,6 +14,8 @@
 #ifndef OR_TOOLS_SAT_OPB_READER_H_
 #define OR_TOOLS_SAT_OPB_READER_H_
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -24,6 +26,7 @@
 #include "base/split.h"
 #include "sat/boolean_problem.pb.h"
 #include "util/filelineiter.h"
+#include "cpp/mapped_file.h"
 
 namespace operations_research {
 namespace sat {
@@ -33,7 +36,14 @@ namespace sat {
 //   http://www.cril.univ-artois.fr/PB12/format.pdf
 class OpbReader {
  public:
-  OpbReader() {}
+  OpbReader() : num_parsing_threads_(1) {}
+
+  // If positive, the file is memory-mapped and its lines are parsed by this
+  // number of threads. Otherwise, or if the file can't be mapped (for instance
+  // if it is compressed), it is read line by line.
+  void SetNumParsingThreads(int num_threads) {
+    num_parsing_threads_ = num_threads;
+  }
 
   // Loads the given opb filename into the given problem.
   bool Load(const std::string& filename, LinearBooleanProblem* problem) {
@@ -41,13 +51,18 @@ class OpbReader {
     problem->set_name(ExtractProblemName(filename));
 
     num_variables_ = 0;
-    int num_lines = 0;
-    for (const std::string& line : FileLines(filename)) {
-      ++num_lines;
-      ProcessNewLine(problem, line);
-    }
-    if (num_lines == 0) {
-      LOG(FATAL) << "File '" << filename << "' is empty or can't be read.";
+    MappedFile mapped_file;
+    if (num_parsing_threads_ > 0 && mapped_file.Open(filename)) {
+      LoadFromMappedFile(mapped_file, problem);
+    } else {
+      int num_lines = 0;
+      for (const std::string& line : FileLines(filename)) {
+        ++num_lines;
+        ProcessNewLine(problem, line);
+      }
+      if (num_lines == 0) {
+        LOG(FATAL) << "File '" << filename << "' is empty or can't be read.";
+      }
     }
     problem->set_num_variables(num_variables_);
     return true;
@@ -117,7 +132,138 @@ class OpbReader {
     }
   }
 
+  // Parses the lines of a part of an opb file with the same rules as
+  // ProcessNewLine(), see LoadFromMappedFile().
+  struct ChunkParser {
+    ChunkParser() : num_variables(0) {}
+    void Parse(const char* begin, const char* end) {
+      const char* p = begin;
+      while (p < end) {
+        p = SkipBlanks(p, end);
+        if (p == end) break;
+        if (*p == '\n') {
+          ++p;
+          continue;
+        }
+        if (*p == '*') {
+          p = SkipLine(p, end);
+          continue;
+        }
+        Row row;
+        row.line_begin = p;
+        row.is_objective = end - p >= 4 && strncmp(p, "min:", 4) == 0 &&
+                           (end - p == 4 || IsBlank(p[4]) || p[4] == '\n');
+        if (row.is_objective) p = SkipBlanks(p + 4, end);
+        row.relation = NONE;
+        row.rhs = 0;
+        row.literals_begin = literals.size();
+        row.coefficients_begin = coefficients.size();
+        while (p < end && *p != '\n') {
+          const char* word_end = p;
+          while (word_end < end && !IsBlank(*word_end) && *word_end != '\n') {
+            ++word_end;
+          }
+          int64 value;
+          if (*p == 'x') {
+            ParseInt64(p + 1, word_end, &value);
+            num_variables = std::max(num_variables, static_cast<int>(value));
+            literals.push_back(value);
+          } else if (row.is_objective && *p == ';') {
+            // Ignored.
+          } else if (!row.is_objective && (word_end - p == 2 && p[0] == '>' &&
+                                           p[1] == '=')) {
+            row.relation = GREATER_OR_EQUAL;
+          } else if (!row.is_objective && word_end - p == 1 && *p == '=') {
+            row.relation = EQUAL;
+          } else {
+            ParseInt64(p, word_end, &value);
+            coefficients.push_back(value);
+          }
+          p = SkipBlanks(word_end, end);
+          if (row.relation != NONE) {
+            // The right-hand side is the word following the relation.
+            CHECK(p < end && *p != '\n') << "Missing right-hand side.";
+            ParseInt64(p, end, &row.rhs);
+            p = SkipLine(p, end);
+            break;
+          }
+        }
+        row.literals_end = literals.size();
+        row.coefficients_end = coefficients.size();
+        rows.push_back(row);
+      }
+    }
+
+    enum Relation { NONE, GREATER_OR_EQUAL, EQUAL };
+    struct Row {
+      // Only used to display parsing errors.
+      const char* line_begin;
+      bool is_objective;
+      Relation relation;
+      int64 rhs;
+      int64 literals_begin;
+      int64 literals_end;
+      int64 coefficients_begin;
+      int64 coefficients_end;
+    };
+    std::vector<Row> rows;
+    std::vector<int32> literals;
+    std::vector<int64> coefficients;
+    int num_variables;
+  };
+
+  // The lines are split among num_parsing_threads_ ChunkParser, and then
+  // added to the problem in order.
+  void LoadFromMappedFile(const MappedFile& mapped_file,
+                          LinearBooleanProblem* problem) {
+    std::vector<ChunkParser> chunks(num_parsing_threads_);
+    ParseLinesInParallel(mapped_file.begin(), mapped_file.end(), &chunks);
+    int num_constraints = 0;
+    for (const ChunkParser& chunk : chunks) {
+      num_constraints += chunk.rows.size();
+    }
+    problem->mutable_constraints()->Reserve(num_constraints);
+    for (const ChunkParser& chunk : chunks) {
+      num_variables_ = std::max(num_variables_, chunk.num_variables);
+      for (const ChunkParser::Row& row : chunk.rows) {
+        const int num_literals = row.literals_end - row.literals_begin;
+        if (num_literals != row.coefficients_end - row.coefficients_begin) {
+          const char* const line_end =
+              SkipLine(row.line_begin, mapped_file.end());
+          LOG(FATAL) << "Failed to parse "
+                     << (row.is_objective ? "objective" : "constraint")
+                     << ":\n " << std::string(row.line_begin, line_end);
+        }
+        google::protobuf::RepeatedField<google::protobuf::int32>* literals;
+        google::protobuf::RepeatedField<google::protobuf::int64>* coefficients;
+        if (row.is_objective) {
+          LinearObjective* objective = problem->mutable_objective();
+          literals = objective->mutable_literals();
+          coefficients = objective->mutable_coefficients();
+        } else {
+          LinearBooleanConstraint* constraint = problem->add_constraints();
+          if (row.relation == ChunkParser::EQUAL) {
+            constraint->set_upper_bound(row.rhs);
+          }
+          if (row.relation != ChunkParser::NONE) {
+            constraint->set_lower_bound(row.rhs);
+          }
+          literals = constraint->mutable_literals();
+          coefficients = constraint->mutable_coefficients();
+        }
+        literals->Reserve(literals->size() + num_literals);
+        coefficients->Reserve(coefficients->size() + num_literals);
+        for (int i = 0; i < num_literals; ++i) {
+          literals->AddAlreadyReserved(chunk.literals[row.literals_begin + i]);
+          coefficients->AddAlreadyReserved(
+              chunk.coefficients[row.coefficients_begin + i]);
+        }
+      }
+    }
+  }
+
   int num_variables_;
+  int num_parsing_threads_;
   DISALLOW_COPY_AND_ASSIGN(OpbReader);
 };
 
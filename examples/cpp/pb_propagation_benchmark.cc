@@ -0,0 +1,141 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the propagation of the pseudo-Boolean constraints. It creates
+// random constraints "sum coefficient * literal <= rhs" with a rhs of about
+// half the sum of their coefficients, and then performs random dives: random
+// decisions are propagated by PbConstraints::PropagateNext() until a conflict
+// or until all the variables are assigned, and everything is then untrailed.
+// For each instruction set supported by the CPU, it prints the time of the
+// dives and the number of threshold updates per microsecond, and checks that
+// all the instruction sets give the same propagations.
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "sat/pb_constraint.h"
+#include "sat/sat_base.h"
+
+DEFINE_int32(num_variables, 2000, "Number of variables.");
+DEFINE_int32(num_constraints, 2000, "Number of pseudo-Boolean constraints.");
+DEFINE_int32(num_terms, 200, "Number of terms of each constraint.");
+DEFINE_int32(max_coefficient, 100, "The coefficients are in [1, this].");
+DEFINE_int32(num_dives, 2000, "Number of random dives.");
+DEFINE_int32(seed, 0, "Seed of the random constraints and dives.");
+
+namespace operations_research {
+namespace sat {
+namespace {
+
+void AddRandomConstraints(ACMRandom* random, PbConstraints* pb_constraints) {
+  std::vector<LiteralWithCoeff> cst;
+  std::vector<bool> is_used(FLAGS_num_variables, false);
+  for (int c = 0; c < FLAGS_num_constraints; ++c) {
+    cst.clear();
+    int64 sum = 0;
+    while (cst.size() < FLAGS_num_terms) {
+      const int var = random->Uniform(FLAGS_num_variables);
+      if (is_used[var]) continue;
+      is_used[var] = true;
+      const int64 coefficient = 1 + random->Uniform(FLAGS_max_coefficient);
+      cst.push_back(LiteralWithCoeff(
+          Literal(VariableIndex(var), random->OneIn(2)), coefficient));
+      sum += coefficient;
+    }
+    for (const LiteralWithCoeff& term : cst) {
+      is_used[term.literal.Variable().value()] = false;
+    }
+    Coefficient bound_shift;
+    Coefficient max_value;
+    CHECK(ComputeBooleanLinearExpressionCanonicalForm(&cst, &bound_shift,
+                                                      &max_value));
+    const Coefficient rhs =
+        ComputeCanonicalRhs(Coefficient(sum / 2), bound_shift, max_value);
+    CHECK(pb_constraints->AddConstraint(cst, rhs, /*node=*/nullptr));
+  }
+}
+
+// Returns the sum of the trail sizes at the end of the dives, plus the number
+// of conflicts times the number of variables, which must not depend on the
+// instruction set.
+int64 Dive(ACMRandom* random, Trail* trail, PbConstraints* pb_constraints) {
+  int64 checksum = 0;
+  std::vector<int> variables(FLAGS_num_variables);
+  for (int i = 0; i < FLAGS_num_variables; ++i) variables[i] = i;
+  for (int dive = 0; dive < FLAGS_num_dives; ++dive) {
+    std::random_shuffle(variables.begin(), variables.end(), *random);
+    bool conflict = false;
+    for (int i = 0; i < variables.size() && !conflict; ++i) {
+      const VariableIndex var(variables[i]);
+      if (trail->Assignment().IsVariableAssigned(var)) continue;
+      trail->SetDecisionLevel(trail->CurrentDecisionLevel() + 1);
+      trail->Enqueue(Literal(var, random->OneIn(2)),
+                     AssignmentInfo::SEARCH_DECISION);
+      while (pb_constraints->PropagationNeeded()) {
+        if (!pb_constraints->PropagateNext()) {
+          conflict = true;
+          break;
+        }
+      }
+    }
+    checksum += trail->Index();
+    if (conflict) checksum += FLAGS_num_variables;
+    pb_constraints->Untrail(0);
+    while (trail->Index() > 0) trail->Dequeue();
+    trail->SetDecisionLevel(0);
+  }
+  return checksum;
+}
+
+void Benchmark() {
+  const PbInstructionSet kInstructionSets[] = {PbInstructionSet::SCALAR,
+                                               PbInstructionSet::AVX2,
+                                               PbInstructionSet::AVX512};
+  int64 reference_checksum = -1;
+  for (const PbInstructionSet instruction_set : kInstructionSets) {
+    if (!IsPbInstructionSetSupported(instruction_set)) continue;
+    ACMRandom random(FLAGS_seed);
+    Trail trail;
+    trail.Resize(FLAGS_num_variables);
+    PbConstraints pb_constraints(&trail);
+    pb_constraints.SetInstructionSet(instruction_set);
+    AddRandomConstraints(&random, &pb_constraints);
+
+    WallTimer timer;
+    timer.Start();
+    const int64 checksum = Dive(&random, &trail, &pb_constraints);
+    timer.Stop();
+    printf("%-7s %8.3f s %8.1f threshold updates/us (checksum %lld)\n",
+           GetPbInstructionSetString(instruction_set).c_str(), timer.Get(),
+           pb_constraints.num_threshold_updates() / (timer.Get() * 1e6),
+           static_cast<long long>(checksum));
+    if (reference_checksum == -1) reference_checksum = checksum;
+    CHECK_EQ(reference_checksum, checksum);
+  }
+}
+
+}  // namespace
+}  // namespace sat
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::sat::Benchmark();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Micro-benchmarks of the propagation engine of the constraint solver. Each
+// benchmark solves a small model whose running time is dominated by the
+// propagation queue and the dispatch of demons, and prints its running time,
+// the number of demons run per priority and the number of demons run per
+// microsecond, as well as the largest size of the trail, the number of bytes
+// copied on the trail and, with --cp_copy_restoration, the time spent
+// restoring it. The search statistics are checked to be the same in all the
+// runs of a benchmark.
+//   - queens: all the solutions of the n-queens problem, with the three
+//     AllDifferent constraints on the rows and diagonals.
+//   - golomb: optimal Golomb ruler, with one AllDifferent on all the
+//     differences.
+//   - chain: a long chain of precedences, pushed by each value of its first
+//     variable, which stresses the queue of the variables.
+//   - sums: all the solutions of a system of sums, whose propagation is done
+//     by delayed demons.
+//   - table: all the solutions of one large table constraint, whose bitset of
+//     active tuples is modified at each node.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "constraint_solver/constraint_solver.h"
+#include "util/tuple_set.h"
+
+DEFINE_string(benchmarks, "queens,golomb,chain,sums,table",
+              "Comma-separated list of the benchmarks to run.");
+DEFINE_int32(num_runs, 3, "Number of runs of each benchmark. The best time is "
+             "reported.");
+DEFINE_int32(queens_size, 10, "Size of the n-queens problem.");
+DEFINE_int32(golomb_size, 9, "Number of marks of the Golomb ruler.");
+DEFINE_int32(chain_length, 1000, "Number of variables of the chain.");
+DEFINE_int32(chain_steps, 1000,
+             "Number of values of the first variable of the chain.");
+DEFINE_int32(sums_size, 12, "Number of variables of the sums.");
+DEFINE_int32(table_arity, 5, "Number of variables of the table constraint.");
+DEFINE_int32(table_size, 20000,
+             "Number of random tuples of the table constraint.");
+
+namespace operations_research {
+namespace {
+
+// Statistics of one run of a benchmark.
+struct RunStats {
+  double seconds;
+  int64 solutions;
+  int64 branches;
+  int64 demon_runs[Solver::kNumPriorities];
+  int64 max_trail_size;
+  int64 copied_bytes;
+  double backtrack_seconds;
+};
+
+void RunSearch(Solver* const solver, DecisionBuilder* const db,
+               const std::vector<SearchMonitor*>& monitors,
+               RunStats* const stats) {
+  WallTimer timer;
+  timer.Start();
+  stats->solutions = 0;
+  solver->NewSearch(db, monitors);
+  while (solver->NextSolution()) {
+    stats->solutions++;
+  }
+  solver->EndSearch();
+  timer.Stop();
+  stats->seconds = timer.Get();
+  stats->branches = solver->branches();
+  for (int i = 0; i < Solver::kNumPriorities; ++i) {
+    stats->demon_runs[i] =
+        solver->demon_runs(static_cast<Solver::DemonPriority>(i));
+  }
+  stats->max_trail_size = solver->max_trail_size();
+  stats->copied_bytes = solver->copied_bytes();
+  stats->backtrack_seconds = solver->backtrack_time() * 1e-9;
+}
+
+void Queens(RunStats* const stats) {
+  const int size = FLAGS_queens_size;
+  Solver solver("queens");
+  std::vector<IntVar*> queens;
+  solver.MakeIntVarArray(size, 0, size - 1, "queen_", &queens);
+  std::vector<IntVar*> up;
+  std::vector<IntVar*> down;
+  for (int i = 0; i < size; ++i) {
+    up.push_back(solver.MakeSum(queens[i], i)->Var());
+    down.push_back(solver.MakeSum(queens[i], -i)->Var());
+  }
+  solver.AddConstraint(solver.MakeAllDifferent(queens));
+  solver.AddConstraint(solver.MakeAllDifferent(up));
+  solver.AddConstraint(solver.MakeAllDifferent(down));
+  DecisionBuilder* const db = solver.MakePhase(
+      queens, Solver::CHOOSE_MIN_SIZE_LOWEST_MIN, Solver::ASSIGN_MIN_VALUE);
+  RunSearch(&solver, db, std::vector<SearchMonitor*>(), stats);
+}
+
+void Golomb(RunStats* const stats) {
+  const int size = FLAGS_golomb_size;
+  Solver solver("golomb");
+  std::vector<IntVar*> ticks(size);
+  ticks[0] = solver.MakeIntConst(0);
+  const int64 max = 1 + size * size * size;
+  for (int i = 1; i < size; ++i) {
+    ticks[i] = solver.MakeIntVar(1, max, StringPrintf("tick_%d", i));
+  }
+  std::vector<IntVar*> diffs;
+  for (int i = 0; i < size; ++i) {
+    for (int j = i + 1; j < size; ++j) {
+      IntVar* const diff = solver.MakeDifference(ticks[j], ticks[i])->Var();
+      diff->SetMin(1);
+      diffs.push_back(diff);
+    }
+  }
+  solver.AddConstraint(solver.MakeAllDifferent(diffs));
+  std::vector<SearchMonitor*> monitors;
+  monitors.push_back(solver.MakeMinimize(ticks[size - 1], 1));
+  DecisionBuilder* const db = solver.MakePhase(
+      ticks, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MIN_VALUE);
+  RunSearch(&solver, db, monitors, stats);
+}
+
+void Chain(RunStats* const stats) {
+  const int length = FLAGS_chain_length;
+  Solver solver("chain");
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(length, 0, length + FLAGS_chain_steps, "x_", &vars);
+  for (int i = 0; i + 1 < length; ++i) {
+    solver.AddConstraint(
+        solver.MakeGreaterOrEqual(vars[i + 1], solver.MakeSum(vars[i], 1)));
+  }
+  // Each value of the first variable, and each refutation of a value, pushes
+  // the whole chain.
+  std::vector<IntVar*> decision_vars;
+  decision_vars.push_back(vars[0]);
+  DecisionBuilder* const db =
+      solver.MakePhase(decision_vars, Solver::CHOOSE_FIRST_UNBOUND,
+                       Solver::ASSIGN_MIN_VALUE);
+  RunSearch(&solver, db, std::vector<SearchMonitor*>(), stats);
+}
+
+void Sums(RunStats* const stats) {
+  const int size = FLAGS_sums_size;
+  Solver solver("sums");
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(size, 0, 3, "x_", &vars);
+  for (int offset = 0; offset < 3; ++offset) {
+    std::vector<int64> coefficients;
+    for (int i = 0; i < size; ++i) {
+      coefficients.push_back(1 + (i + offset) % 5);
+    }
+    solver.AddConstraint(solver.MakeScalProdEquality(vars, coefficients,
+                                                     4 * size + offset));
+  }
+  DecisionBuilder* const db = solver.MakePhase(
+      vars, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MIN_VALUE);
+  RunSearch(&solver, db, std::vector<SearchMonitor*>(), stats);
+}
+
+void Table(RunStats* const stats) {
+  const int arity = FLAGS_table_arity;
+  const int domain_size = 10;
+  Solver solver("table");
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(arity, 0, domain_size - 1, "x_", &vars);
+  ACMRandom random(0);
+  IntTupleSet tuples(arity);
+  std::vector<int64> tuple(arity);
+  for (int i = 0; i < FLAGS_table_size; ++i) {
+    for (int j = 0; j < arity; ++j) {
+      tuple[j] = random.Uniform(domain_size);
+    }
+    tuples.Insert(tuple);
+  }
+  solver.AddConstraint(solver.MakeAllowedAssignments(vars, tuples));
+  DecisionBuilder* const db = solver.MakePhase(
+      vars, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MIN_VALUE);
+  RunSearch(&solver, db, std::vector<SearchMonitor*>(), stats);
+}
+
+typedef void (*Benchmark)(RunStats* const stats);
+
+void RunBenchmark(const std::string& name, Benchmark benchmark) {
+  RunStats best;
+  for (int run = 0; run < FLAGS_num_runs; ++run) {
+    RunStats stats;
+    benchmark(&stats);
+    if (run == 0) {
+      best = stats;
+    } else {
+      CHECK_EQ(best.solutions, stats.solutions) << name;
+      CHECK_EQ(best.branches, stats.branches) << name;
+      if (stats.seconds < best.seconds) best.seconds = stats.seconds;
+      if (stats.backtrack_seconds < best.backtrack_seconds) {
+        best.backtrack_seconds = stats.backtrack_seconds;
+      }
+    }
+  }
+  int64 total_runs = 0;
+  for (int i = 0; i < Solver::kNumPriorities; ++i) {
+    total_runs += best.demon_runs[i];
+  }
+  printf("%-8s %9.3f %10lld %10lld %11lld %11lld %11lld %8.1f %9lld %10lld "
+         "%9.3f\n",
+         name.c_str(), best.seconds, static_cast<long long>(best.solutions),
+         static_cast<long long>(best.branches),
+         static_cast<long long>(best.demon_runs[Solver::VAR_PRIORITY]),
+         static_cast<long long>(best.demon_runs[Solver::NORMAL_PRIORITY]),
+         static_cast<long long>(best.demon_runs[Solver::DELAYED_PRIORITY]),
+         total_runs / (best.seconds * 1e6),
+         static_cast<long long>(best.max_trail_size),
+         static_cast<long long>(best.copied_bytes), best.backtrack_seconds);
+}
+
+}  // namespace
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  struct NamedBenchmark {
+    const char* name;
+    operations_research::Benchmark benchmark;
+  };
+  const NamedBenchmark kBenchmarks[] = {
+      {"queens", &operations_research::Queens},
+      {"golomb", &operations_research::Golomb},
+      {"chain", &operations_research::Chain},
+      {"sums", &operations_research::Sums},
+      {"table", &operations_research::Table}};
+  const std::string benchmarks = "," + FLAGS_benchmarks + ",";
+  printf("%-8s %9s %10s %10s %11s %11s %11s %8s %9s %10s %9s\n", "name",
+         "time(s)", "solutions", "branches", "var_demons", "normal", "delayed",
+         "runs/us", "trail", "copied", "backtrack");
+  for (const NamedBenchmark& benchmark : kBenchmarks) {
+    if (benchmarks.find("," + std::string(benchmark.name) + ",") !=
+        std::string::npos) {
+      operations_research::RunBenchmark(benchmark.name, benchmark.benchmark);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,380 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the propagation of the cumulative constraint on resource
+// constrained project scheduling problems (RCPSP).
+//
+// An RCPSP is a set of jobs of fixed durations, linked by precedences, which
+// require a constant amount of a set of renewable resources of limited
+// capacities. The model has one interval per job, one precedence constraint
+// per precedence and one cumulative constraint per resource, and minimizes the
+// makespan with a depth first search that schedules the intervals forward,
+// within a limit on the number of branches.
+//
+// The instances are either read from a single mode PSPLIB file (--input, see
+// http://www.om-db.wi.tum.de/psplib/), or generated randomly in the same
+// spirit for each of the sizes of --sizes. Each instance is solved once per
+// propagation configuration of --configs:
+//   - tt: the cumulative time table only.
+//   - ttef: the time table and the timetable edge finding.
+//   - ef: the edge finder and the time table (the default configuration).
+//   - ef_ttef: the edge finder, the time table and the timetable edge
+//     finding.
+// For each run, the benchmark prints the running time, the number of branches
+// and failures, the time per branch, the deterministic time accounted by the
+// propagators and the best makespan found. The sequence constraints and the
+// disjunctions posted by the cumulative constraints are disabled, so that the
+// propagation is done only by the configured algorithms.
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "base/strtoint.h"
+#include "base/timer.h"
+#include "base/filelinereader.h"
+#include "base/split.h"
+#include "constraint_solver/constraint_solver.h"
+
+DEFINE_string(input, "", "Single mode PSPLIB file (.sm) to solve. If empty, "
+              "random instances are generated.");
+DEFINE_string(sizes, "30,60,120,240",
+              "Comma-separated list of the numbers of jobs of the random "
+              "instances.");
+DEFINE_int32(num_resources, 4, "Number of resources of the random instances.");
+DEFINE_int32(seed, 0, "Seed of the random instances.");
+DEFINE_double(resource_strength, 0.25,
+              "Resource strength of the random instances, between 0 (the "
+              "capacity of a resource is its largest demand) and 1 (the "
+              "capacity is its peak usage in the earliest start schedule).");
+DEFINE_string(configs, "tt,ttef,ef,ef_ttef",
+              "Comma-separated list of the propagation configurations to "
+              "compare.");
+DEFINE_int64(branch_limit, 20000, "Maximum number of branches of each run.");
+
+DECLARE_bool(cp_use_cumulative_edge_finder);
+DECLARE_bool(cp_use_cumulative_time_table);
+DECLARE_bool(cp_use_cumulative_tt_edge_finder);
+DECLARE_bool(cp_use_sequence_high_demand_tasks);
+DECLARE_bool(cp_use_all_possible_disjunctions);
+
+namespace operations_research {
+namespace {
+
+// A single mode RCPSP.
+struct Rcpsp {
+  std::string name;
+  std::vector<int64> durations;
+  // demands[job][resource]
+  std::vector<std::vector<int64> > demands;
+  std::vector<std::vector<int> > successors;
+  std::vector<int64> capacities;
+};
+
+// ----- PSPLIB parser -----
+
+// Parses the single mode PSPLIB format. Note that the format is only
+// partially checked: bad inputs might cause undefined behavior.
+class PsplibParser {
+ public:
+  explicit PsplibParser(Rcpsp* const problem)
+      : problem_(problem), section_(HEADER), num_jobs_(0), num_resources_(0) {}
+
+  bool Load(const std::string& filename) {
+    problem_->name = filename;
+    FileLineReader reader(filename.c_str());
+    reader.set_line_callback(
+        NewPermanentCallback(this, &PsplibParser::ProcessNewLine));
+    reader.Reload();
+    return reader.loaded_successfully() && num_jobs_ > 0 &&
+           problem_->capacities.size() == num_resources_;
+  }
+
+ private:
+  enum Section {
+    HEADER,
+    PRECEDENCES,
+    REQUESTS,
+    AVAILABILITIES
+  };
+
+  void ProcessNewLine(char* const line) {
+    const std::string text(line);
+    const std::vector<std::string> words =
+        strings::Split(line, " \t:", strings::SkipEmpty());
+    if (words.empty() || text[0] == '*' || text[0] == '-') {
+      return;
+    }
+    if (text.find("jobs (incl. supersource/sink )") != std::string::npos) {
+      num_jobs_ = atoi32(words.back());
+      problem_->durations.resize(num_jobs_, 0);
+      problem_->demands.resize(num_jobs_);
+      problem_->successors.resize(num_jobs_);
+    } else if (text.find("- renewable") != std::string::npos) {
+      num_resources_ = atoi32(words[2]);
+    } else if (text.find("PRECEDENCE RELATIONS") != std::string::npos) {
+      section_ = PRECEDENCES;
+    } else if (text.find("REQUESTS/DURATIONS") != std::string::npos) {
+      section_ = REQUESTS;
+    } else if (text.find("RESOURCEAVAILABILITIES") != std::string::npos) {
+      section_ = AVAILABILITIES;
+    } else if (words[0] == "jobnr." || words[0] == "R") {
+      // Column headers.
+      return;
+    } else if (section_ == PRECEDENCES) {
+      // jobnr. #modes #successors successors
+      const int job = atoi32(words[0]) - 1;
+      CHECK_GE(job, 0);
+      CHECK_LT(job, num_jobs_);
+      const int num_successors = atoi32(words[2]);
+      CHECK_EQ(3 + num_successors, words.size());
+      for (int i = 0; i < num_successors; ++i) {
+        problem_->successors[job].push_back(atoi32(words[3 + i]) - 1);
+      }
+    } else if (section_ == REQUESTS) {
+      // jobnr. mode duration demands
+      CHECK_EQ(3 + num_resources_, words.size());
+      const int job = atoi32(words[0]) - 1;
+      CHECK_GE(job, 0);
+      CHECK_LT(job, num_jobs_);
+      problem_->durations[job] = atoi32(words[2]);
+      for (int r = 0; r < num_resources_; ++r) {
+        problem_->demands[job].push_back(atoi32(words[3 + r]));
+      }
+    } else if (section_ == AVAILABILITIES) {
+      CHECK_EQ(num_resources_, words.size());
+      for (int r = 0; r < num_resources_; ++r) {
+        problem_->capacities.push_back(atoi32(words[r]));
+      }
+    }
+  }
+
+  Rcpsp* const problem_;
+  Section section_;
+  int num_jobs_;
+  int num_resources_;
+
+  DISALLOW_COPY_AND_ASSIGN(PsplibParser);
+};
+
+// ----- Random instances -----
+
+// Generates an instance with the given number of jobs, in the spirit of the
+// PSPLIB generator: each job has between 1 and 3 successors among the next
+// jobs, a duration between 1 and 10, and requires each resource with a
+// probability of 1/2, with a demand between 1 and 10. The capacity of a
+// resource is its largest demand plus resource_strength times the difference
+// between its peak usage in the earliest start schedule and its largest
+// demand.
+void GenerateRcpsp(int num_jobs, int num_resources, double resource_strength,
+                   int seed, Rcpsp* const problem) {
+  ACMRandom random(seed);
+  problem->name = StringPrintf("random_%d", num_jobs);
+  problem->durations.resize(num_jobs);
+  problem->demands.assign(num_jobs, std::vector<int64>(num_resources, 0));
+  problem->successors.assign(num_jobs, std::vector<int>());
+  const int window = 10;
+  for (int job = 0; job < num_jobs; ++job) {
+    problem->durations[job] = 1 + random.Uniform(10);
+    for (int r = 0; r < num_resources; ++r) {
+      if (random.OneIn(2)) {
+        problem->demands[job][r] = 1 + random.Uniform(10);
+      }
+    }
+    const int last_successor = std::min(num_jobs - 1, job + window);
+    if (last_successor > job) {
+      const int num_successors = 1 + random.Uniform(3);
+      for (int i = 0; i < num_successors; ++i) {
+        const int successor = job + 1 + random.Uniform(last_successor - job);
+        std::vector<int>* const successors = &problem->successors[job];
+        if (std::find(successors->begin(), successors->end(), successor) ==
+            successors->end()) {
+          successors->push_back(successor);
+        }
+      }
+    }
+  }
+  // Earliest start schedule; the successors of a job have larger indices.
+  std::vector<int64> starts(num_jobs, 0);
+  int64 horizon = 0;
+  for (int job = 0; job < num_jobs; ++job) {
+    const int64 end = starts[job] + problem->durations[job];
+    horizon = std::max(horizon, end);
+    for (const int successor : problem->successors[job]) {
+      starts[successor] = std::max(starts[successor], end);
+    }
+  }
+  problem->capacities.clear();
+  for (int r = 0; r < num_resources; ++r) {
+    std::vector<int64> usage(horizon, 0);
+    int64 max_demand = 0;
+    for (int job = 0; job < num_jobs; ++job) {
+      const int64 demand = problem->demands[job][r];
+      max_demand = std::max(max_demand, demand);
+      for (int64 t = starts[job]; t < starts[job] + problem->durations[job];
+           ++t) {
+        usage[t] += demand;
+      }
+    }
+    const int64 peak = *std::max_element(usage.begin(), usage.end());
+    problem->capacities.push_back(
+        max_demand +
+        static_cast<int64>(resource_strength * (peak - max_demand)));
+  }
+}
+
+// ----- Benchmark -----
+
+// Statistics of one run.
+struct RunStats {
+  double seconds;
+  int64 branches;
+  int64 failures;
+  double deterministic_time;
+  int64 makespan;
+};
+
+void SolveRcpsp(const Rcpsp& problem, RunStats* const stats) {
+  Solver solver(problem.name);
+  const int num_jobs = problem.durations.size();
+  int64 horizon = 0;
+  for (int job = 0; job < num_jobs; ++job) {
+    horizon += problem.durations[job];
+  }
+  std::vector<IntervalVar*> intervals;
+  std::vector<IntVar*> ends;
+  for (int job = 0; job < num_jobs; ++job) {
+    IntervalVar* const interval = solver.MakeFixedDurationIntervalVar(
+        0, horizon, problem.durations[job], false, StringPrintf("J%d", job));
+    intervals.push_back(interval);
+    ends.push_back(interval->EndExpr()->Var());
+  }
+  for (int job = 0; job < num_jobs; ++job) {
+    for (const int successor : problem.successors[job]) {
+      solver.AddConstraint(solver.MakeIntervalVarRelation(
+          intervals[successor], Solver::STARTS_AFTER_END, intervals[job]));
+    }
+  }
+  for (int r = 0; r < problem.capacities.size(); ++r) {
+    std::vector<int64> demands;
+    for (int job = 0; job < num_jobs; ++job) {
+      demands.push_back(problem.demands[job][r]);
+    }
+    solver.AddConstraint(solver.MakeCumulative(
+        intervals, demands, problem.capacities[r], StringPrintf("R%d", r)));
+  }
+  IntVar* const makespan = solver.MakeMax(ends)->Var();
+  std::vector<SearchMonitor*> monitors;
+  monitors.push_back(solver.MakeMinimize(makespan, 1));
+  monitors.push_back(solver.MakeBranchesLimit(FLAGS_branch_limit));
+  DecisionBuilder* const db =
+      solver.MakePhase(intervals, Solver::INTERVAL_SET_TIMES_FORWARD);
+  WallTimer timer;
+  timer.Start();
+  stats->makespan = -1;
+  solver.NewSearch(db, monitors);
+  while (solver.NextSolution()) {
+    stats->makespan = makespan->Value();
+  }
+  solver.EndSearch();
+  timer.Stop();
+  stats->seconds = timer.Get();
+  stats->branches = solver.branches();
+  stats->failures = solver.failures();
+  stats->deterministic_time = solver.deterministic_time();
+}
+
+// Sets the cumulative flags of the given configuration. Returns false if the
+// configuration is unknown.
+bool SetConfig(const std::string& config) {
+  FLAGS_cp_use_cumulative_time_table = true;
+  FLAGS_cp_use_sequence_high_demand_tasks = false;
+  FLAGS_cp_use_all_possible_disjunctions = false;
+  if (config == "tt") {
+    FLAGS_cp_use_cumulative_edge_finder = false;
+    FLAGS_cp_use_cumulative_tt_edge_finder = false;
+  } else if (config == "ttef") {
+    FLAGS_cp_use_cumulative_edge_finder = false;
+    FLAGS_cp_use_cumulative_tt_edge_finder = true;
+  } else if (config == "ef") {
+    FLAGS_cp_use_cumulative_edge_finder = true;
+    FLAGS_cp_use_cumulative_tt_edge_finder = false;
+  } else if (config == "ef_ttef") {
+    FLAGS_cp_use_cumulative_edge_finder = true;
+    FLAGS_cp_use_cumulative_tt_edge_finder = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void RunBenchmark(const Rcpsp& problem) {
+  const std::vector<std::string> configs =
+      strings::Split(FLAGS_configs, ",", strings::SkipEmpty());
+  for (const std::string& config : configs) {
+    if (!SetConfig(config)) {
+      LOG(FATAL) << "Unknown configuration " << config;
+    }
+    RunStats stats;
+    SolveRcpsp(problem, &stats);
+    printf("%-16s %5d %-8s %9.3f %9lld %9lld %10.2f %10.4f %9lld\n",
+           problem.name.c_str(), static_cast<int>(problem.durations.size()),
+           config.c_str(), stats.seconds,
+           static_cast<long long>(stats.branches),
+           static_cast<long long>(stats.failures),
+           stats.seconds * 1e6 / std::max<int64>(1, stats.branches),
+           stats.deterministic_time, static_cast<long long>(stats.makespan));
+  }
+}
+
+void RunPsplibInstance(const std::string& filename) {
+  Rcpsp problem;
+  PsplibParser parser(&problem);
+  if (!parser.Load(filename)) {
+    LOG(FATAL) << "Could not read PSPLIB file " << filename;
+  }
+  RunBenchmark(problem);
+}
+
+void RunRandomInstances() {
+  const std::vector<std::string> sizes =
+      strings::Split(FLAGS_sizes, ",", strings::SkipEmpty());
+  for (const std::string& size : sizes) {
+    Rcpsp problem;
+    GenerateRcpsp(atoi32(size), FLAGS_num_resources, FLAGS_resource_strength,
+                  FLAGS_seed, &problem);
+    RunBenchmark(problem);
+  }
+}
+
+}  // namespace
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  printf("%-16s %5s %-8s %9s %9s %9s %10s %10s %9s\n", "instance", "jobs",
+         "config", "time(s)", "branches", "failures", "us/branch", "det_time",
+         "makespan");
+  if (!FLAGS_input.empty()) {
+    operations_research::RunPsplibInstance(FLAGS_input);
+  } else {
+    operations_research::RunRandomInstances();
+  }
+  return EXIT_SUCCESS;
+}
@@ -14,6 +14,7 @@
 #ifndef OR_TOOLS_SAT_SAT_CNF_READER_H_
 #define OR_TOOLS_SAT_SAT_CNF_READER_H_
 
+#include <cstring>
 #include <map>
 #include <string>
 #include <vector>
@@ -23,8 +24,10 @@
 #include "base/logging.h"
 #include "base/strtoint.h"
 #include "base/split.h"
+#include "base/unique_ptr.h"
 #include "sat/boolean_problem.pb.h"
 #include "util/filelineiter.h"
+#include "cpp/mapped_file.h"
 
 DEFINE_bool(wcnf_use_strong_slack, true,
             "If true, when we add a slack variable to reify a soft clause, we "
@@ -40,12 +43,19 @@ namespace sat {
 // It also support the wcnf input format for partial weighted max-sat problems.
 class SatCnfReader {
  public:
-  SatCnfReader() : interpret_cnf_as_max_sat_(false) {}
+  SatCnfReader() : interpret_cnf_as_max_sat_(false), num_parsing_threads_(1) {}
 
   // If called with true, then a cnf file will be converted to the max-sat
   // problem: Try to minimize the number of unsatisfiable clauses.
   void InterpretCnfAsMaxSat(bool v) { interpret_cnf_as_max_sat_ = v; }
 
+  // If positive, the file is memory-mapped and its clauses are parsed by this
+  // number of threads. Otherwise, or if the file can't be mapped (for instance
+  // if it is compressed), it is read line by line.
+  void SetNumParsingThreads(int num_threads) {
+    num_parsing_threads_ = num_threads;
+  }
+
   // Loads the given cnf filename into the given problem.
   bool Load(const std::string& filename, LinearBooleanProblem* problem) {
     positive_literal_to_weight_.clear();
@@ -60,13 +70,18 @@ class SatCnfReader {
     num_slack_variables_ = 0;
     num_slack_binary_clauses_ = 0;
 
-    int num_lines = 0;
-    for (const std::string& line : FileLines(filename)) {
-      ++num_lines;
-      ProcessNewLine(line, problem);
-    }
-    if (num_lines == 0) {
-      LOG(FATAL) << "File '" << filename << "' is empty or can't be read.";
+    MappedFile mapped_file;
+    if (num_parsing_threads_ > 0 && mapped_file.Open(filename)) {
+      LoadFromMappedFile(mapped_file, problem);
+    } else {
+      int num_lines = 0;
+      for (const std::string& line : FileLines(filename)) {
+        ++num_lines;
+        ProcessNewLine(line, problem);
+      }
+      if (num_lines == 0) {
+        LOG(FATAL) << "File '" << filename << "' is empty or can't be read.";
+      }
     }
     problem->set_original_num_variables(num_variables_);
     problem->set_num_variables(num_variables_ + num_slack_variables_);
@@ -134,93 +149,235 @@ class SatCnfReader {
     } else {
       // In the cnf file format, the last words should always be 0.
       DCHECK_EQ("0", words_.back());
-      const int size = words_.size() - 1;
-      const int reserved_size =
-          (!is_wcnf_ && interpret_cnf_as_max_sat_) ? size + 1 : size;
-
-      LinearBooleanConstraint* constraint = problem->add_constraints();
-      constraint->mutable_literals()->Reserve(reserved_size);
-      constraint->mutable_coefficients()->Reserve(reserved_size);
-      constraint->set_lower_bound(1);
-
-      int64 weight =
-          (!is_wcnf_ && interpret_cnf_as_max_sat_) ? 1 : hard_weight_;
-      for (int i = 0; i < size; ++i) {
+      int64 weight = 0;
+      literals_.clear();
+      for (int i = 0; i + 1 < words_.size(); ++i) {
         const int64 signed_value = StringPieceAtoi(words_[i]);
         if (i == 0 && is_wcnf_) {
-          // Mathematically, a soft clause of weight 0 can be removed.
-          if (signed_value == 0) {
-            ++num_skipped_soft_clauses_;
-            problem->mutable_constraints()->RemoveLast();
-            break;
-          }
           weight = signed_value;
         } else {
-          DCHECK_NE(signed_value, 0);
-          constraint->add_literals(signed_value);
-          constraint->add_coefficients(1);
+          literals_.push_back(signed_value);
         }
       }
-      if (weight != hard_weight_) {
-        if (constraint->literals_size() == 1) {
-          // The max-sat formulation of an optimization sat problem with a
-          // linear objective introduces many singleton soft clauses. Because we
-          // natively work with a linear objective, we can just put the cost on
-          // the unique variable of such clause and remove the clause.
-          ++num_singleton_soft_clauses_;
-          const int literal = -constraint->literals(0);
-          if (literal > 0) {
-            positive_literal_to_weight_[literal] += weight;
-          } else {
-            positive_literal_to_weight_[-literal] -= weight;
-            objective_offset_ += weight;
-          }
-          problem->mutable_constraints()->RemoveLast();
+      ProcessClause(weight, literals_.data(), literals_.size(), problem);
+    }
+  }
+
+  // Adds a clause to the problem. The weight is only used for the wcnf format.
+  void ProcessClause(int64 weight, const int32* literals, int size,
+                     LinearBooleanProblem* problem) {
+    if (is_wcnf_) {
+      // Mathematically, a soft clause of weight 0 can be removed.
+      if (weight == 0) {
+        ++num_skipped_soft_clauses_;
+        return;
+      }
+    } else {
+      weight = interpret_cnf_as_max_sat_ ? 1 : hard_weight_;
+    }
+    const int reserved_size = weight != hard_weight_ ? size + 1 : size;
+
+    LinearBooleanConstraint* constraint = problem->add_constraints();
+    constraint->mutable_literals()->Reserve(reserved_size);
+    constraint->mutable_coefficients()->Reserve(reserved_size);
+    constraint->set_lower_bound(1);
+    for (int i = 0; i < size; ++i) {
+      DCHECK_NE(literals[i], 0);
+      constraint->add_literals(literals[i]);
+      constraint->add_coefficients(1);
+    }
+    if (weight != hard_weight_) {
+      if (constraint->literals_size() == 1) {
+        // The max-sat formulation of an optimization sat problem with a
+        // linear objective introduces many singleton soft clauses. Because we
+        // natively work with a linear objective, we can just put the cost on
+        // the unique variable of such clause and remove the clause.
+        ++num_singleton_soft_clauses_;
+        const int literal = -constraint->literals(0);
+        if (literal > 0) {
+          positive_literal_to_weight_[literal] += weight;
+        } else {
+          positive_literal_to_weight_[-literal] -= weight;
+          objective_offset_ += weight;
+        }
+        problem->mutable_constraints()->RemoveLast();
+      } else {
+        // The +1 is because a positive literal is the same as the 1-based
+        // variable index.
+        const int slack_literal = num_variables_ + num_slack_variables_ + 1;
+        ++num_slack_variables_;
+        constraint->add_literals(slack_literal);
+        constraint->add_coefficients(1);
+        DCHECK_EQ(constraint->literals_size(), reserved_size);
+
+        if (slack_literal > 0) {
+          positive_literal_to_weight_[slack_literal] += weight;
         } else {
-          // The +1 is because a positive literal is the same as the 1-based
-          // variable index.
-          const int slack_literal = num_variables_ + num_slack_variables_ + 1;
-          ++num_slack_variables_;
-          constraint->add_literals(slack_literal);
-          constraint->add_coefficients(1);
-          DCHECK_EQ(constraint->literals_size(), reserved_size);
-
-          if (slack_literal > 0) {
-            positive_literal_to_weight_[slack_literal] += weight;
+          positive_literal_to_weight_[-slack_literal] -= weight;
+          objective_offset_ += weight;
+        }
+
+        if (FLAGS_wcnf_use_strong_slack) {
+          // Add the binary implications slack_literal true => all the other
+          // clause literals are false.
+          for (int i = 0; i + 1 < constraint->literals_size(); ++i) {
+            LinearBooleanConstraint* bc = problem->add_constraints();
+            bc->set_lower_bound(1);
+            bc->add_literals(-slack_literal);
+            bc->add_literals(-constraint->literals(i));
+            bc->add_coefficients(1);
+            bc->add_coefficients(1);
+            ++num_slack_binary_clauses_;
+          }
+        }
+      }
+    }
+  }
+
+  // Parses the clause lines of a part of a cnf file, see LoadFromMappedFile().
+  struct ChunkParser {
+    ChunkParser() : is_wcnf(false), only_hard_clauses(false) {}
+    void Parse(const char* begin, const char* end) {
+      const char* p = begin;
+      while (p < end) {
+        p = SkipBlanks(p, end);
+        if (p == end) break;
+        if (*p == '\n') {
+          ++p;
+          continue;
+        }
+        if (*p == 'c') {
+          p = SkipLine(p, end);
+          continue;
+        }
+        CHECK_NE(*p, 'p') << "The header must appear before the clauses.";
+        const int64 clause_start = literals.size();
+        bool first = true;
+        while (p < end && *p != '\n') {
+          int64 value;
+          const char* const next = ParseInt64(p, end, &value);
+          CHECK(next != p) << "Failed to parse: "
+                           << std::string(p, SkipLine(p, end));
+          if (first && is_wcnf) {
+            weights.push_back(value);
           } else {
-            positive_literal_to_weight_[-slack_literal] -= weight;
-            objective_offset_ += weight;
+            literals.push_back(value);
           }
+          first = false;
+          p = SkipBlanks(next, end);
+        }
 
-          if (FLAGS_wcnf_use_strong_slack) {
-            // Add the binary implications slack_literal true => all the other
-            // clause literals are false.
-            for (int i = 0; i + 1 < constraint->literals_size(); ++i) {
-              LinearBooleanConstraint* bc = problem->add_constraints();
-              bc->set_lower_bound(1);
-              bc->add_literals(-slack_literal);
-              bc->add_literals(-constraint->literals(i));
-              bc->add_coefficients(1);
-              bc->add_coefficients(1);
-              ++num_slack_binary_clauses_;
-            }
+        // In the cnf file format, the last number should always be 0.
+        DCHECK(!literals.empty() && literals.back() == 0);
+        if (!literals.empty()) literals.pop_back();
+        if (only_hard_clauses) {
+          // The constraint can be built here, which is most of the work.
+          LinearBooleanConstraint* constraint = new LinearBooleanConstraint();
+          const int size = literals.size() - clause_start;
+          constraint->mutable_literals()->Reserve(size);
+          constraint->mutable_coefficients()->Reserve(size);
+          constraint->set_lower_bound(1);
+          for (int64 i = clause_start; i < literals.size(); ++i) {
+            DCHECK_NE(literals[i], 0);
+            constraint->mutable_literals()->AddAlreadyReserved(literals[i]);
+            constraint->mutable_coefficients()->AddAlreadyReserved(1);
           }
+          constraints.emplace_back(constraint);
+          literals.resize(clause_start);
+        } else {
+          clause_ends.push_back(literals.size());
         }
-      } else {
-        // If wcnf is true, we currently reserve one more literals than needed
-        // for the hard clauses.
-        DCHECK_EQ(constraint->literals_size(), is_wcnf_ ? size - 1 : size);
+      }
+    }
+
+    bool is_wcnf;
+    bool only_hard_clauses;
+
+    // If only_hard_clauses is true, the clauses are directly added to
+    // constraints. Otherwise, the literals of the i-th clause are in
+    // [clause_ends[i - 1], clause_ends[i]) and its weight is weights[i] if
+    // is_wcnf is true.
+    std::vector<std::unique_ptr<LinearBooleanConstraint>> constraints;
+    std::vector<int32> literals;
+    std::vector<int64> clause_ends;
+    std::vector<int64> weights;
+  };
+
+  // Returns the start of the first line of [begin, end) that starts with the
+  // '%' end marker (possibly after some blanks), or end if there is none. Since
+  // '%' only appears in the end marker or in comments, this is a fast memchr()
+  // scan in practice.
+  static const char* FindEndMarkerLine(const char* begin, const char* end) {
+    const char* p = begin;
+    while (p < end) {
+      const char* const marker =
+          static_cast<const char*>(memchr(p, '%', end - p));
+      if (marker == nullptr) return end;
+      const char* line_start = marker;
+      while (line_start > begin && IsBlank(line_start[-1])) --line_start;
+      if (line_start == begin || line_start[-1] == '\n') return line_start;
+      p = marker + 1;
+    }
+    return end;
+  }
+
+  // The lines before the first clause, which contain the header, are
+  // processed by ProcessNewLine(). The clause lines up to the end marker, if
+  // any, are split among num_parsing_threads_ ChunkParser, and then added to
+  // the problem in order. What follows the end marker is ignored, it can be
+  // any text.
+  void LoadFromMappedFile(const MappedFile& mapped_file,
+                          LinearBooleanProblem* problem) {
+    const char* p = mapped_file.begin();
+    const char* const end = mapped_file.end();
+    while (p < end && !end_marker_seen_) {
+      const char* const first = SkipBlanks(p, end);
+      if (first < end && (*first == '-' || (*first >= '0' && *first <= '9'))) {
+        break;
+      }
+      const char* const next = SkipLine(p, end);
+      const char* line_end = next;
+      while (line_end > p && (line_end[-1] == '\n' || line_end[-1] == '\r')) {
+        --line_end;
+      }
+      ProcessNewLine(std::string(p, line_end), problem);
+      p = next;
+    }
+    if (end_marker_seen_) return;
+    problem->mutable_constraints()->Reserve(num_clauses_);
+
+    // This is the same as the hard_weight_ test in ProcessClause().
+    const bool only_hard_clauses = !is_wcnf_ && !interpret_cnf_as_max_sat_;
+    std::vector<ChunkParser> chunks(num_parsing_threads_);
+    for (ChunkParser& chunk : chunks) {
+      chunk.is_wcnf = is_wcnf_;
+      chunk.only_hard_clauses = only_hard_clauses;
+    }
+    ParseLinesInParallel(p, FindEndMarkerLine(p, end), &chunks);
+    for (ChunkParser& chunk : chunks) {
+      for (std::unique_ptr<LinearBooleanConstraint>& constraint :
+           chunk.constraints) {
+        problem->mutable_constraints()->AddAllocated(constraint.release());
+      }
+      int64 start = 0;
+      for (int i = 0; i < chunk.clause_ends.size(); ++i) {
+        ProcessClause(is_wcnf_ ? chunk.weights[i] : 0,
+                      chunk.literals.data() + start,
+                      chunk.clause_ends[i] - start, problem);
+        start = chunk.clause_ends[i];
       }
     }
   }
 
   bool interpret_cnf_as_max_sat_;
+  int num_parsing_threads_;
 
   int num_clauses_;
   int num_variables_;
 
   // Temporary storage for ProcessNewLine().
   std::vector<StringPiece> words_;
+  std::vector<int32> literals_;
 
   // We stores the objective in a map because we want the variables to appear
   // only once in the LinearObjective proto.
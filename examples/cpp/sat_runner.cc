@@ -11,6 +11,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -26,11 +27,14 @@
 #include "google/protobuf/text_format.h"
 #include "base/strutil.h"
 // TODO(user): Move sat_cnf_reader.h and sat_runner.cc to examples?
+#include "cpp/mapped_file.h"
 #include "cpp/opb_reader.h"
 #include "cpp/sat_cnf_reader.h"
 #include "base/random.h"
 #include "sat/boolean_problem.h"
+#include "sat/drat_writer.h"
 #include "sat/optimization.h"
+#include "sat/sat_portfolio.h"
 #include "sat/sat_solver.h"
 #include "sat/simplification.h"
 #include "util/time_limit.h"
@@ -86,7 +90,8 @@ DEFINE_bool(qmaxsat, false,
 
 DEFINE_bool(core_enc, false,
             "If true, search the optimal solution with the core-based "
-            "cardinality encoding algo.");
+            "cardinality encoding algo. With more than one search worker, a "
+            "linear scan also runs in parallel in a second thread.");
 
 DEFINE_bool(linear_scan, false,
             "If true, search the optimal solution with the linear scan algo.");
@@ -110,6 +115,31 @@ DEFINE_bool(refine_core, false,
             "UNSAT, refine as much as possible its UNSAT core in order to get "
             "a small one.");
 
+DEFINE_string(drat_output, "",
+              "If non-empty, write a DRAT proof of the clauses learned and "
+              "deleted by the solver to this file, so that an UNSAT result "
+              "can be checked with an external checker like drat-trim. This "
+              "only works for the decision version of a pure SAT problem.");
+
+DEFINE_bool(drat_binary, false,
+            "If true, the --drat_output proof uses the binary DRAT format.");
+
+DEFINE_int32(propagation_benchmark, 0,
+             "If positive, do not solve the problem but run this number of "
+             "rounds of random decisions and propagation on it, and display "
+             "the number of propagations per second. Nothing is learned, so "
+             "this measures the raw speed of the propagation.");
+
+DEFINE_int32(num_parsing_threads, 4,
+             "Number of threads used to parse a .cnf, .wcnf or .opb input "
+             "file. If zero, the file is read line by line instead of being "
+             "memory-mapped.");
+
+DEFINE_int32(loading_benchmark, 0,
+             "If positive, do not solve the problem but load it this number "
+             "of times line by line and then this number of times with "
+             "--num_parsing_threads, and display the loading speed.");
+
 namespace operations_research {
 namespace sat {
 namespace {
@@ -125,10 +155,12 @@ double GetScaledTrivialBestBound(const LinearBooleanProblem& problem) {
   return AddOffsetAndScaleObjectiveValue(problem, best_bound);
 }
 
-void LoadBooleanProblem(std::string filename, LinearBooleanProblem* problem) {
+void LoadBooleanProblem(std::string filename, int num_parsing_threads,
+                        LinearBooleanProblem* problem) {
   if (HasSuffixString(filename, ".opb") ||
       HasSuffixString(filename, ".opb.bz2")) {
     OpbReader reader;
+    reader.SetNumParsingThreads(num_parsing_threads);
     if (!reader.Load(filename, problem)) {
       LOG(FATAL) << "Cannot load file '" << filename << "'.";
     }
@@ -137,6 +169,7 @@ void LoadBooleanProblem(std::string filename, LinearBooleanProblem* problem) {
              HasSuffixString(filename, ".wcnf") ||
              HasSuffixString(filename, ".wcnf.gz")) {
     SatCnfReader reader;
+    reader.SetNumParsingThreads(num_parsing_threads);
     if (FLAGS_fu_malik || FLAGS_linear_scan || FLAGS_wpm1 || FLAGS_qmaxsat ||
         FLAGS_core_enc) {
       reader.InterpretCnfAsMaxSat(true);
@@ -161,6 +194,70 @@ std::string SolutionString(const LinearBooleanProblem& problem,
   return output;
 }
 
+// Assigns all the variables of the solver by taking random decisions until all
+// of them are assigned, num_rounds times, and displays the propagation speed.
+// A decision that leads to a conflict is just skipped.
+void RunPropagationBenchmark(int num_rounds, int32 seed, SatSolver* solver) {
+  ACMRandom random(seed);
+  std::vector<VariableIndex> variables;
+  for (VariableIndex var(0); var < solver->NumVariables(); ++var) {
+    variables.push_back(var);
+  }
+  int64 num_decisions = 0;
+  int64 num_conflicts = 0;
+  const int64 initial_num_propagations = solver->num_propagations();
+  WallTimer timer;
+  timer.Start();
+  for (int round = 0; round < num_rounds; ++round) {
+    solver->Backtrack(0);
+    std::random_shuffle(variables.begin(), variables.end(), random);
+    for (const VariableIndex var : variables) {
+      if (solver->Assignment().IsVariableAssigned(var)) continue;
+      ++num_decisions;
+      if (!solver->EnqueueDecisionIfNotConflicting(
+              Literal(var, random.OneIn(2)))) {
+        ++num_conflicts;
+      }
+    }
+  }
+  solver->Backtrack(0);
+  timer.Stop();
+  const int64 num_propagations =
+      solver->num_propagations() - initial_num_propagations;
+  printf("c decisions: %lld\n", num_decisions);
+  printf("c conflicts: %lld\n", num_conflicts);
+  printf("c propagations: %lld\n", num_propagations);
+  printf("c walltime: %f\n", timer.Get());
+  printf("c propagations per second: %.0f\n", num_propagations / timer.Get());
+}
+
+// Loads the given file num_rounds times line by line, and then num_rounds
+// times with FLAGS_num_parsing_threads threads, and displays the loading speed.
+void RunLoadingBenchmark(const std::string& filename, int num_rounds) {
+  MappedFile mapped_file;
+  const double size_in_mb =
+      mapped_file.Open(filename) ? mapped_file.size() / 1e6 : 0.0;
+  const int num_threads[2] = {0, FLAGS_num_parsing_threads};
+  for (int i = 0; i < 2; ++i) {
+    int num_constraints = 0;
+    WallTimer timer;
+    timer.Start();
+    for (int round = 0; round < num_rounds; ++round) {
+      LinearBooleanProblem problem;
+      LoadBooleanProblem(filename, num_threads[i], &problem);
+      num_constraints = problem.constraints_size();
+    }
+    timer.Stop();
+    const double time_per_load = timer.Get() / num_rounds;
+    printf("c parsing threads: %d\n", num_threads[i]);
+    printf("c constraints: %d\n", num_constraints);
+    printf("c walltime per load: %f\n", time_per_load);
+    if (size_in_mb > 0.0) {
+      printf("c MB per second: %.1f\n", size_in_mb / time_per_load);
+    }
+  }
+}
+
 // To benefit from the operations_research namespace, we put all the main() code
 // here.
 int Run() {
@@ -184,13 +281,36 @@ int Run() {
     parameters.set_treat_binary_clauses_separately(false);
   }
 
+  // The DRAT proof is only produced by a single worker, without any
+  // technique that is not based on clauses.
+  std::unique_ptr<DratWriter> drat_writer;
+  if (!FLAGS_drat_output.empty()) {
+    CHECK(!FLAGS_fu_malik && !FLAGS_linear_scan && !FLAGS_wpm1 &&
+          !FLAGS_qmaxsat && !FLAGS_core_enc)
+        << "--drat_output only works for the decision version of a problem.";
+    CHECK(!FLAGS_use_symmetry && !FLAGS_probing)
+        << "--drat_output is incompatible with --use_symmetry and --probing.";
+    File* const output = File::Open(FLAGS_drat_output, "w");
+    CHECK(output != nullptr) << "Cannot open '" << FLAGS_drat_output << "'.";
+    drat_writer.reset(new DratWriter(FLAGS_drat_binary, output));
+    if (parameters.num_search_workers() > 1) {
+      LOG(WARNING) << "Using only one search worker for the DRAT proof.";
+      parameters.set_num_search_workers(1);
+    }
+  }
+
   // Initialize the solver.
   std::unique_ptr<SatSolver> solver(new SatSolver());
   solver->SetParameters(parameters);
+  solver->SetDratWriter(drat_writer.get());
 
   // Read the problem.
   LinearBooleanProblem problem;
-  LoadBooleanProblem(FLAGS_input, &problem);
+  if (FLAGS_loading_benchmark > 0) {
+    RunLoadingBenchmark(FLAGS_input, FLAGS_loading_benchmark);
+    return EXIT_SUCCESS;
+  }
+  LoadBooleanProblem(FLAGS_input, FLAGS_num_parsing_threads, &problem);
   if (FLAGS_strict_validity) {
     const util::Status status = ValidateBooleanProblem(problem);
     if (!status.ok()) {
@@ -234,6 +354,12 @@ int Run() {
     solver->AddSymmetries(&generators);
   }
 
+  if (FLAGS_propagation_benchmark > 0) {
+    RunPropagationBenchmark(FLAGS_propagation_benchmark,
+                            parameters.random_seed(), solver.get());
+    return EXIT_SUCCESS;
+  }
+
   // Optimize?
   std::vector<bool> solution;
   SatSolver::Status result = SatSolver::LIMIT_REACHED;
@@ -250,6 +376,18 @@ int Run() {
         CHECK(LoadBooleanProblem(problem, solver.get()));
         result = SolveWithCardinalityEncoding(STDOUT_LOG, problem, solver.get(),
                                               &solution);
+      } else if (FLAGS_core_enc && parameters.num_search_workers() > 1) {
+        // The second solver runs a linear scan in parallel with the core-based
+        // algorithm.
+        SatSolver linear_solver;
+        linear_solver.SetParameters(parameters);
+        CHECK(LoadBooleanProblem(problem, &linear_solver));
+        AddObjectiveConstraint(
+            problem, !FLAGS_lower_bound.empty(),
+            Coefficient(atoi64(FLAGS_lower_bound)), !FLAGS_upper_bound.empty(),
+            Coefficient(atoi64(FLAGS_upper_bound)), &linear_solver);
+        result = SolveWithParallelCoreAndLinearScan(
+            STDOUT_LOG, problem, solver.get(), &linear_solver, &solution);
       } else if (FLAGS_core_enc) {
         result = SolveWithCardinalityEncodingAndCore(STDOUT_LOG, problem,
                                                      solver.get(), &solution);
@@ -293,6 +431,7 @@ int Run() {
         SatPresolver presolver(&postsolver);
         presolver.SetParameters(parameters);
         presolver.SetEquivalentLiteralMapping(equiv_map);
+        presolver.SetDratWriter(drat_writer.get());
         solver->ExtractClauses(&presolver);
         solver.release();
         if (!presolver.Presolve()) {
@@ -304,9 +443,14 @@ int Run() {
           break;
         }
 
-        // Load the presolved problem in a new solver.
+        // Load the presolved problem in a new solver. Note that the mapping of
+        // the DRAT proof must be updated before the new solver uses it.
         solver.reset(new SatSolver());
         solver->SetParameters(parameters);
+        if (drat_writer != nullptr) {
+          drat_writer->ApplyMapping(presolver.VariableMapping());
+          solver->SetDratWriter(drat_writer.get());
+        }
         presolver.LoadProblemIntoSatSolver(solver.get());
         postsolver.ApplyMapping(presolver.VariableMapping());
 
@@ -337,7 +481,38 @@ int Run() {
       return EXIT_SUCCESS;
     }
 
-    result = solver->Solve();
+    if (parameters.num_search_workers() > 1) {
+      // Load the same problem in the other workers of the portfolio. The
+      // first worker is the solver already loaded above.
+      std::vector<std::unique_ptr<SatSolver>> other_workers;
+      std::vector<SatSolver*> workers(1, solver.get());
+      for (int i = 1; i < parameters.num_search_workers(); ++i) {
+        other_workers.emplace_back(new SatSolver());
+        SatSolver* worker = other_workers.back().get();
+        worker->SetParameters(parameters);
+        LoadBooleanProblem(problem, worker);
+        AddObjectiveConstraint(
+            problem, !FLAGS_lower_bound.empty(),
+            Coefficient(atoi64(FLAGS_lower_bound)), !FLAGS_upper_bound.empty(),
+            Coefficient(atoi64(FLAGS_upper_bound)), worker);
+        if (FLAGS_use_symmetry) {
+          std::vector<std::unique_ptr<SparsePermutation>> generators;
+          FindLinearBooleanProblemSymmetries(problem, &generators);
+          worker->AddSymmetries(&generators);
+        }
+        workers.push_back(worker);
+      }
+      int first_to_finish = -1;
+      result = SolveWithPortfolio(parameters, workers, &first_to_finish);
+
+      // From now on, solver is the worker that finished first so the
+      // solution and the statistics below are the ones of this worker.
+      if (first_to_finish > 0) {
+        solver.reset(other_workers[first_to_finish - 1].release());
+      }
+    } else {
+      result = solver->Solve();
+    }
     if (result == SatSolver::MODEL_SAT) {
       ExtractAssignment(problem, *solver, &solution);
       CHECK(IsAssignmentValid(problem, solution));
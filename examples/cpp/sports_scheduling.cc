@@ -54,20 +54,29 @@
 //     the home_away var and the aggregated var (see third matrix of variables)
 //     is also maintained using a AllowedAssignment constraint.
 //
+// With --num_workers > 0, the model is instead solved by a parallel tree
+// search (see constraint_solver/parallel_search.h) on that many threads, using
+// a deterministic search on the signed_opponent variables.
+//
 // Usage: run this with --helpshort for a short usage manual.
 
 #include "base/commandlineflags.h"
 #include "base/commandlineflags.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/callback.h"
 #include "constraint_solver/constraint_solver.h"
 #include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/parallel_search.h"
 
 // Problem main flags.
 DEFINE_int32(num_teams, 10, "Number of teams in the problem.");
 
 // General solving parameters.
 DEFINE_int32(time_limit, 20000, "Time limit in ms.");
+DEFINE_int32(num_workers, 0,
+             "If positive, solve the problem with a parallel tree search on "
+             "that many threads.");
 
 // Search tweaking parameters. These are defined to illustrate their effect.
 DEFINE_bool(run_all_heuristics, true,
@@ -261,6 +270,52 @@ void ComputeOneTeamHomeAwayTuples(int num_teams,
             << " combination of home_aways for a team on the full season";
 }
 
+// ---------- Parallel search ----------
+
+// Builds the search of a worker of the parallel search on its copy of the
+// signed_opponent variables.
+DecisionBuilder* BuildWorkerSearch(Solver* const solver,
+                                   const DecisionVariables& variables) {
+  return solver->MakePhase(variables.vars, Solver::CHOOSE_FIRST_UNBOUND,
+                           Solver::ASSIGN_MIN_VALUE);
+}
+
+// Solves the model with a parallel tree search. The opponents and home_aways
+// are decoded from the signed_opponents of the best solution.
+void ParallelSportsScheduling(
+    Solver* const solver, const std::vector<IntVar*>& all_signed_opponents,
+    IntVar* const objective_var, const std::vector<SearchMonitor*>& monitors,
+    int num_teams) {
+  const int full_season = 2 * (num_teams - 1);
+  DecisionBuilder* const db = BuildWorkerSearch(
+      solver, DecisionVariables{all_signed_opponents, {}, {}});
+  ParallelSearch search(solver, db, monitors,
+                        NewPermanentCallback(&BuildWorkerSearch),
+                        FLAGS_num_workers);
+  ParallelSolutionCollector collector(solver, false);
+  collector.Add(all_signed_opponents);
+  collector.AddObjective(objective_var);
+  if (search.Solve(&collector)) {
+    LOG(INFO) << "Best solution with " << search.best_objective()
+              << " breaks found in " << collector.wall_time(0) << " ms with "
+              << FLAGS_num_workers << " workers, " << search.branches()
+              << " branches, " << search.failures() << " failures and "
+              << search.steals() << " steals.";
+    for (int team_index = 0; team_index < num_teams; ++team_index) {
+      std::string line;
+      for (int day = 0; day < full_season; ++day) {
+        const int signed_opponent = collector.Value(
+            0, all_signed_opponents[team_index * full_season + day]);
+        line += StringPrintf("%2d%s ", signed_opponent % num_teams,
+                             signed_opponent >= num_teams ? "@" : " ");
+      }
+      LOG(INFO) << line;
+    }
+  } else {
+    LOG(INFO) << "No solution found.";
+  }
+}
+
 // ---------- Main solving method ----------
 
 // Solves the sports scheduling problem with a given number of teams.
@@ -345,6 +400,13 @@ void SportsScheduling(int num_teams) {
     }
   }
 
+  if (FLAGS_num_workers > 0) {
+    monitors.push_back(solver.MakeTimeLimit(FLAGS_time_limit));
+    ParallelSportsScheduling(&solver, all_signed_opponents, objective_var,
+                             monitors, num_teams);
+    return;
+  }
+
   // Build default phase decision builder.
   DefaultPhaseParameters parameters;
   parameters.run_all_heuristics = FLAGS_run_all_heuristics;
@@ -0,0 +1,103 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the adaptive copy restoration of the arrays of reversible words with
+// nested searches. The backtrack of a nested search, or the end of a nested
+// search which does not backtrack, leaves the parent search in the same state
+// with a new trail stamp. The words of an array saved on the trail before it
+// and the copies of the same array after it must still restore the array.
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+// The bitsets of the tests have 4 words, so that modifying one word is
+// enough for the adaptive mode to copy them at their next modification.
+static const int kBitSetSize = 256;
+
+// Sets the given bit of the bitset.
+class SetBit : public DecisionBuilder {
+ public:
+  SetBit(RevBitSet* const bits, int index) : bits_(bits), index_(index) {}
+  virtual ~SetBit() {}
+
+  virtual Decision* Next(Solver* const s) {
+    bits_->SetToOne(s, index_);
+    return nullptr;
+  }
+
+ private:
+  RevBitSet* const bits_;
+  const int index_;
+};
+
+// Sets bits in three different words of the bitset: the first one before a
+// nested search which sets the second one, and the third one after it. The
+// nested search restores the state on exit or not.
+class SetBitsAroundNestedSearch : public DecisionBuilder {
+ public:
+  SetBitsAroundNestedSearch(RevBitSet* const bits, bool restore)
+      : bits_(bits), restore_(restore) {}
+  virtual ~SetBitsAroundNestedSearch() {}
+
+  virtual Decision* Next(Solver* const s) {
+    bits_->SetToOne(s, 0);
+    SetBit nested(bits_, 64);
+    if (restore_) {
+      CHECK(s->Solve(&nested));
+      CHECK(!bits_->IsSet(64));
+    } else {
+      CHECK(s->SolveAndCommit(&nested));
+      CHECK(bits_->IsSet(64));
+    }
+    bits_->SetToOne(s, 128);
+    CHECK(bits_->IsSet(0));
+    CHECK(bits_->IsSet(128));
+    return nullptr;
+  }
+
+ private:
+  RevBitSet* const bits_;
+  const bool restore_;
+};
+
+class CopyRestorationTest {
+ public:
+  void TestNestedSearch(bool restore) {
+    RevBitSet bits(kBitSetSize);
+    Solver solver("CopyRestorationTest", Parameters());
+    SetBitsAroundNestedSearch db(&bits, restore);
+    CHECK(solver.Solve(&db));
+    CHECK(bits.IsCardinalityZero());
+  }
+
+ private:
+  static SolverParameters Parameters() {
+    SolverParameters parameters;
+    parameters.state_restoration = SolverParameters::ADAPTIVE_COPY_RESTORATION;
+    return parameters;
+  }
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::CopyRestorationTest test;
+  test.TestNestedSearch(true);
+  test.TestNestedSearch(false);
+  return 0;
+}
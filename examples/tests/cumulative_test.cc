@@ -0,0 +1,169 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the timetable edge finding of the cumulative time table against the
+// time table alone. The other cumulative propagators are disabled, so that
+// the difference can only come from the timetable edge finding.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+
+DECLARE_bool(cp_use_cumulative_edge_finder);
+DECLARE_bool(cp_use_cumulative_time_table);
+DECLARE_bool(cp_use_cumulative_tt_edge_finder);
+DECLARE_bool(cp_use_sequence_high_demand_tasks);
+DECLARE_bool(cp_use_all_possible_disjunctions);
+
+namespace operations_research {
+
+// Records the start min of an interval after the initial propagation.
+class RecordStartMin : public DecisionBuilder {
+ public:
+  RecordStartMin(IntervalVar* const interval, int64* const start_min)
+      : interval_(interval), start_min_(start_min) {}
+  virtual ~RecordStartMin() {}
+
+  virtual Decision* Next(Solver* const s) {
+    *start_min_ = interval_->StartMin();
+    return nullptr;
+  }
+
+ private:
+  IntervalVar* const interval_;
+  int64* const start_min_;
+};
+
+class CumulativeTest {
+ public:
+  // Three tasks of demands 2, 1 and 2 and of duration 2 must run in [0, 4)
+  // on a resource of capacity 3, which leaves 2 units of energy in this
+  // window. A fourth task of demand 2 and duration 2 can then only start at 3.
+  // The three tasks have no compulsory part, so the time table alone does not
+  // push it.
+  void TestTimeTableEdgeFindingPushes() {
+    for (const bool use_tt_edge_finding : {false, true}) {
+      SetFlags(use_tt_edge_finding);
+      Solver solver("CumulativeTest");
+      std::vector<IntervalVar*> intervals;
+      for (int i = 0; i < 3; ++i) {
+        intervals.push_back(
+            solver.MakeFixedDurationIntervalVar(0, 2, 2, false, "window"));
+      }
+      intervals.push_back(
+          solver.MakeFixedDurationIntervalVar(0, 10, 2, false, "pushed"));
+      solver.AddConstraint(
+          solver.MakeCumulative(intervals, std::vector<int64>({2, 1, 2, 2}), 3,
+                                "cumulative"));
+      int64 start_min = -1;
+      RecordStartMin db(intervals.back(), &start_min);
+      CHECK(solver.Solve(&db));
+      CHECK_EQ(use_tt_edge_finding ? 3 : 0, start_min);
+    }
+  }
+
+  // Four tasks of demands 2, 2, 1 and 2 and of duration 2 must run in [0, 4)
+  // on a resource of capacity 3: they need 14 units of energy, and only 12
+  // are available. None of them has a compulsory part, so only the timetable
+  // edge finding detects the failure at the root.
+  void TestTimeTableEdgeFindingFails() {
+    for (const bool use_tt_edge_finding : {false, true}) {
+      SetFlags(use_tt_edge_finding);
+      Solver solver("CumulativeTest");
+      std::vector<IntervalVar*> intervals;
+      for (int i = 0; i < 4; ++i) {
+        intervals.push_back(
+            solver.MakeFixedDurationIntervalVar(0, 2, 2, false, "task"));
+      }
+      solver.AddConstraint(
+          solver.MakeCumulative(intervals, std::vector<int64>({2, 2, 1, 2}), 3,
+                                "cumulative"));
+      int64 start_min = -1;
+      RecordStartMin db(intervals.back(), &start_min);
+      CHECK_EQ(!use_tt_edge_finding, solver.Solve(&db));
+    }
+  }
+
+  // On small random instances, the timetable edge finding keeps all the
+  // solutions and does not explore more branches than the time table.
+  void TestSameSolutions() {
+    int64 num_solutions = 0;
+    int64 branches = 0;
+    int64 tt_edge_finding_branches = 0;
+    for (int seed = 0; seed < 20; ++seed) {
+      const int64 solutions = CountSolutions(seed, false, &branches);
+      CHECK_EQ(solutions,
+               CountSolutions(seed, true, &tt_edge_finding_branches));
+      num_solutions += solutions;
+    }
+    CHECK_GT(num_solutions, 0);
+    CHECK_LT(tt_edge_finding_branches, branches);
+  }
+
+ private:
+  static void SetFlags(bool use_tt_edge_finding) {
+    FLAGS_cp_use_cumulative_time_table = true;
+    FLAGS_cp_use_cumulative_tt_edge_finder = use_tt_edge_finding;
+    FLAGS_cp_use_cumulative_edge_finder = false;
+    FLAGS_cp_use_sequence_high_demand_tasks = false;
+    FLAGS_cp_use_all_possible_disjunctions = false;
+  }
+
+  // Counts the solutions of a random instance of 6 tasks, and adds the
+  // number of branches of the search to 'branches'.
+  static int64 CountSolutions(int seed, bool use_tt_edge_finding,
+                              int64* const branches) {
+    const int kNumTasks = 6;
+    const int kHorizon = 7;
+    const int kCapacity = 4;
+    SetFlags(use_tt_edge_finding);
+    ACMRandom random(seed);
+    Solver solver("CumulativeTest");
+    std::vector<IntervalVar*> intervals;
+    std::vector<int64> demands;
+    std::vector<IntVar*> starts;
+    for (int i = 0; i < kNumTasks; ++i) {
+      const int64 duration = 1 + random.Uniform(3);
+      IntervalVar* const interval = solver.MakeFixedDurationIntervalVar(
+          0, kHorizon - duration, duration, false, "task");
+      intervals.push_back(interval);
+      demands.push_back(1 + random.Uniform(3));
+      starts.push_back(interval->StartExpr()->Var());
+    }
+    solver.AddConstraint(
+        solver.MakeCumulative(intervals, demands, kCapacity, "cumulative"));
+    DecisionBuilder* const db = solver.MakePhase(
+        starts, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MIN_VALUE);
+    int64 num_solutions = 0;
+    solver.NewSearch(db);
+    while (solver.NextSolution()) ++num_solutions;
+    solver.EndSearch();
+    *branches += solver.branches();
+    return num_solutions;
+  }
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::CumulativeTest test;
+  test.TestTimeTableEdgeFindingPushes();
+  test.TestTimeTableEdgeFindingFails();
+  test.TestSameSolutions();
+  return 0;
+}
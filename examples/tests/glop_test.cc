@@ -0,0 +1,387 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "glop/basis_representation.h"
+#include "glop/lp_solver.h"
+#include "glop/parameters.pb.h"
+#include "glop/preprocessor.h"
+#include "glop/status.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/permutation.h"
+#include "lp_data/sparse.h"
+
+namespace operations_research {
+namespace glop {
+
+class GlopTest {
+ public:
+  // Solves small random LPs with the interior point method followed by the
+  // crossover, and with the primal simplex only. When the optimal basis is
+  // unique, both must find the same objective value and the same basis.
+  void TestInteriorPointCrossover() {
+    int num_compared_bases = 0;
+    for (int seed = 0; seed < 10; ++seed) {
+      ACMRandom random(seed);
+      LinearProgram lp;
+      lp.SetMaximizationProblem(true);
+      AddRandomBlock(12, 8, &random, &lp);
+      lp.CleanUp();
+
+      GlopParameters parameters;
+      parameters.set_use_preprocessing(false);
+      parameters.set_use_dual_simplex(false);
+      LPSolver simplex_solver;
+      simplex_solver.SetParameters(parameters);
+      CHECK_EQ(ProblemStatus::OPTIMAL, simplex_solver.Solve(lp));
+
+      parameters.set_use_interior_point(true);
+      LPSolver interior_point_solver;
+      interior_point_solver.SetParameters(parameters);
+      CHECK_EQ(ProblemStatus::OPTIMAL, interior_point_solver.Solve(lp));
+      CHECK_GT(interior_point_solver.GetNumberOfInteriorPointIterations(), 0);
+      CHECK_LE(std::abs(simplex_solver.GetObjectiveValue() -
+                        interior_point_solver.GetObjectiveValue()),
+               1e-6 * (1.0 + std::abs(simplex_solver.GetObjectiveValue())));
+
+      if (simplex_solver.MayHaveMultipleOptimalSolutions()) continue;
+      ++num_compared_bases;
+      CHECK(simplex_solver.variable_statuses() ==
+            interior_point_solver.variable_statuses());
+      CHECK(simplex_solver.constraint_statuses() ==
+            interior_point_solver.constraint_statuses());
+    }
+    CHECK_GT(num_compared_bases, 0);
+  }
+
+  // Replaces several columns of a basis with the Forrest-Tomlin update, and
+  // compares the right and left solves with the ones of a fresh LU
+  // factorization of the final basis.
+  void TestForrestTomlinUpdate() {
+    const int kNumRows = 30;
+    const int kNumUpdates = 8;
+    ACMRandom random(0);
+
+    // The first kNumRows columns are diagonally dominant and form the initial
+    // basis. The entering columns are the next kNumRows random sparse ones.
+    SparseMatrix matrix;
+    matrix.SetNumRows(RowIndex(kNumRows));
+    for (int j = 0; j < 2 * kNumRows; ++j) {
+      const ColIndex col = matrix.AppendEmptyColumn();
+      for (RowIndex row(0); row < kNumRows; ++row) {
+        if (j == row.value()) {
+          matrix.mutable_column(col)->SetCoefficient(row, 100.0);
+        } else if (random.OneIn(6)) {
+          matrix.mutable_column(col)->SetCoefficient(
+              row, (1.0 + random.Uniform(9)) * (random.OneIn(2) ? 1 : -1));
+        }
+      }
+    }
+    const MatrixView matrix_view(matrix);
+    RowToColMapping basis;
+    for (ColIndex col(0); col < kNumRows; ++col) basis.push_back(col);
+
+    // Like the RevisedSimplex, the column permutation of the initial LU
+    // factorization is applied to the basis, which the Forrest-Tomlin update
+    // requires.
+    GlopParameters parameters;
+    parameters.set_use_forrest_tomlin_update(true);
+    parameters.set_basis_refactorization_period(2 * kNumUpdates);
+    BasisFactorization factorization(matrix_view, basis);
+    factorization.SetParameters(parameters);
+    CHECK(factorization.Initialize().ok());
+    if (!factorization.GetColumnPermutation().empty()) {
+      ApplyColumnPermutationToRowIndexedVector(
+          factorization.GetColumnPermutation(), &basis);
+      factorization.SetColumnPermutationToIdentity();
+    }
+
+    int num_updates = 0;
+    for (ColIndex entering_col(kNumRows); entering_col < 2 * kNumRows;
+         ++entering_col) {
+      if (num_updates == kNumUpdates) break;
+      DenseColumn direction;
+      std::vector<RowIndex> non_zeros;
+      factorization.RightSolveForProblemColumn(entering_col, &direction,
+                                               &non_zeros);
+      RowIndex leaving_row(0);
+      for (RowIndex row(0); row < kNumRows; ++row) {
+        if (std::abs(direction[row]) > std::abs(direction[leaving_row])) {
+          leaving_row = row;
+        }
+      }
+      if (std::abs(direction[leaving_row]) < 1e-2) continue;
+      basis[leaving_row] = entering_col;
+      CHECK(factorization.Update(entering_col, leaving_row, non_zeros,
+                                 &direction).ok());
+      CHECK(!factorization.IsRefactorized());
+      ++num_updates;
+    }
+    CHECK_EQ(kNumUpdates, num_updates);
+
+    // The fresh factorization may permute its basis, so the positions of the
+    // basic columns are compared through position_in_fresh_basis.
+    RowToColMapping fresh_basis = basis;
+    BasisFactorization fresh_factorization(matrix_view, fresh_basis);
+    fresh_factorization.SetParameters(GlopParameters());
+    CHECK(fresh_factorization.Initialize().ok());
+    const ColumnPermutation& col_perm =
+        fresh_factorization.GetColumnPermutation();
+    if (!col_perm.empty()) {
+      ApplyColumnPermutationToRowIndexedVector(col_perm, &fresh_basis);
+      fresh_factorization.SetColumnPermutationToIdentity();
+    }
+    StrictITIVector<ColIndex, RowIndex> position_in_fresh_basis(
+        matrix.num_cols(), kInvalidRow);
+    for (RowIndex row(0); row < kNumRows; ++row) {
+      position_in_fresh_basis[fresh_basis[row]] = row;
+    }
+
+    for (int test = 0; test < 5; ++test) {
+      DenseColumn rhs(RowIndex(kNumRows), 0.0);
+      DenseRow costs(ColIndex(kNumRows), 0.0);
+      DenseRow fresh_costs(ColIndex(kNumRows), 0.0);
+      for (RowIndex row(0); row < kNumRows; ++row) {
+        rhs[row] = random.Uniform(21) - 10.0;
+        const Fractional cost = random.Uniform(21) - 10.0;
+        costs[RowToColIndex(row)] = cost;
+        fresh_costs[RowToColIndex(position_in_fresh_basis[basis[row]])] = cost;
+      }
+
+      // B^{-1}.rhs gives the values of the basic variables.
+      DenseColumn x = rhs;
+      DenseColumn fresh_x = rhs;
+      factorization.RightSolve(&x);
+      fresh_factorization.RightSolve(&fresh_x);
+      for (RowIndex row(0); row < kNumRows; ++row) {
+        CHECK_LE(std::abs(fresh_x[position_in_fresh_basis[basis[row]]] -
+                          x[row]),
+                 1e-6 * (1.0 + std::abs(x[row])));
+      }
+
+      // costs.B^{-1} is indexed by the rows of the matrix.
+      DenseRow y = costs;
+      DenseRow fresh_y = fresh_costs;
+      factorization.LeftSolve(&y);
+      fresh_factorization.LeftSolve(&fresh_y);
+      for (ColIndex col(0); col < kNumRows; ++col) {
+        CHECK_LE(std::abs(fresh_y[col] - y[col]),
+                 1e-6 * (1.0 + std::abs(y[col])));
+      }
+    }
+  }
+
+  // Solves an LP made of independent random blocks as a whole, and block by
+  // block with one or several threads. The results must be the same, and the
+  // deterministic time of a decomposed solve must not depend on the previous
+  // ones.
+  void TestIndependentBlocks() {
+    const int kNumBlocks = 6;
+    ACMRandom random(0);
+    LinearProgram lp;
+    lp.SetMaximizationProblem(true);
+    for (int i = 0; i < kNumBlocks; ++i) AddRandomBlock(10, 6, &random, &lp);
+    lp.CleanUp();
+
+    GlopParameters parameters;
+    parameters.set_use_preprocessing(false);
+    LPSolver whole_solver;
+    whole_solver.SetParameters(parameters);
+    CHECK_EQ(ProblemStatus::OPTIMAL, whole_solver.Solve(lp));
+
+    parameters.set_solve_independent_blocks(true);
+    DenseRow single_thread_values;
+    for (const int num_threads : {1, 4}) {
+      parameters.set_num_block_threads(num_threads);
+      LPSolver block_solver;
+      block_solver.SetParameters(parameters);
+      CHECK_EQ(ProblemStatus::OPTIMAL, block_solver.Solve(lp));
+      const double deterministic_time = block_solver.DeterministicTime();
+      CHECK_GT(deterministic_time, 0.0);
+      CHECK_EQ(ProblemStatus::OPTIMAL, block_solver.Solve(lp));
+      CHECK_EQ(deterministic_time, block_solver.DeterministicTime());
+
+      CHECK_LE(std::abs(whole_solver.GetObjectiveValue() -
+                        block_solver.GetObjectiveValue()),
+               1e-6 * (1.0 + std::abs(whole_solver.GetObjectiveValue())));
+      if (!whole_solver.MayHaveMultipleOptimalSolutions()) {
+        CHECK(whole_solver.variable_statuses() ==
+              block_solver.variable_statuses());
+        CHECK(whole_solver.constraint_statuses() ==
+              block_solver.constraint_statuses());
+      }
+      if (num_threads == 1) {
+        single_thread_values = block_solver.variable_values();
+      } else {
+        CHECK(single_thread_values == block_solver.variable_values());
+      }
+    }
+  }
+
+  // Runs the BoundPropagationPreprocessor on min -y with y - x <= 0,
+  // x in [0, 3] and y in [0, 10]. The propagation tightens the upper bound of
+  // y to 3, so y is never at its upper bound and its reduced cost is
+  // non-negative, which implies a negative reduced cost for x: x is fixed at
+  // its upper bound. The postsolved solution must be the optimal one.
+  void TestBoundPropagationFixesDominatedColumn() {
+    LinearProgram lp;
+    const ColIndex x = lp.CreateNewVariable();
+    const ColIndex y = lp.CreateNewVariable();
+    lp.SetVariableBounds(x, 0.0, 3.0);
+    lp.SetVariableBounds(y, 0.0, 10.0);
+    lp.SetObjectiveCoefficient(y, -1.0);
+    const RowIndex row = lp.CreateNewConstraint();
+    lp.SetConstraintBounds(row, -kInfinity, 0.0);
+    lp.SetCoefficient(row, x, -1.0);
+    lp.SetCoefficient(row, y, 1.0);
+    lp.CleanUp();
+
+    BoundPropagationPreprocessor preprocessor;
+    preprocessor.SetParameters(GlopParameters());
+    CHECK(preprocessor.Run(&lp));
+    CHECK(preprocessor.status() == ProblemStatus::INIT);
+    CHECK_EQ(ColIndex(1), lp.num_variables());
+    CHECK_EQ(3.0, lp.constraint_upper_bounds()[row]);
+
+    GlopParameters parameters;
+    parameters.set_use_preprocessing(false);
+    LPSolver solver;
+    solver.SetParameters(parameters);
+    CHECK_EQ(ProblemStatus::OPTIMAL, solver.Solve(lp));
+    ProblemSolution solution(lp.num_constraints(), lp.num_variables());
+    solution.primal_values = solver.variable_values();
+    solution.dual_values = solver.dual_values();
+    solution.variable_statuses = solver.variable_statuses();
+    solution.constraint_statuses = solver.constraint_statuses();
+    preprocessor.StoreSolution(&solution);
+    CHECK_EQ(ColIndex(2), solution.primal_values.size());
+    CHECK_EQ(3.0, solution.primal_values[x]);
+    CHECK(solution.variable_statuses[x] == VariableStatus::AT_UPPER_BOUND);
+    CHECK_EQ(3.0, solution.primal_values[y]);
+  }
+
+  // The rows x - y >= 5 and y + z >= 12 with x, y, z in [0, 10] and z <= 5
+  // are infeasible, which is only found by propagating the bound of y
+  // implied by the first row into the second one.
+  void TestBoundPropagationDetectsInfeasibility() {
+    LinearProgram lp;
+    const ColIndex x = lp.CreateNewVariable();
+    const ColIndex y = lp.CreateNewVariable();
+    const ColIndex z = lp.CreateNewVariable();
+    lp.SetVariableBounds(x, 0.0, 10.0);
+    lp.SetVariableBounds(y, 0.0, 10.0);
+    lp.SetVariableBounds(z, 0.0, 5.0);
+    const RowIndex first_row = lp.CreateNewConstraint();
+    lp.SetConstraintBounds(first_row, 5.0, kInfinity);
+    lp.SetCoefficient(first_row, x, 1.0);
+    lp.SetCoefficient(first_row, y, -1.0);
+    const RowIndex second_row = lp.CreateNewConstraint();
+    lp.SetConstraintBounds(second_row, 12.0, kInfinity);
+    lp.SetCoefficient(second_row, y, 1.0);
+    lp.SetCoefficient(second_row, z, 1.0);
+    lp.CleanUp();
+
+    BoundPropagationPreprocessor preprocessor;
+    preprocessor.SetParameters(GlopParameters());
+    CHECK(!preprocessor.Run(&lp));
+    CHECK(preprocessor.status() == ProblemStatus::PRIMAL_INFEASIBLE);
+  }
+
+  // Solves random LPs with and without use_bound_propagation. The optimal
+  // objective values must be the same, and the bound propagation must remove
+  // some columns on some of them.
+  void TestBoundPropagationPreservesOptimality() {
+    int64 num_removed_cols = 0;
+    for (int seed = 0; seed < 20; ++seed) {
+      ACMRandom random(seed);
+      LinearProgram lp;
+      lp.SetMaximizationProblem(true);
+      for (int i = 0; i < 3; ++i) AddRandomBlock(8, 5, &random, &lp);
+      // Variables that only appear with a negative coefficient in a
+      // <= constraint are dominated at their upper bound.
+      for (int j = 0; j < 5; ++j) {
+        const ColIndex col = lp.CreateNewVariable();
+        lp.SetVariableBounds(col, 0.0, 10.0);
+        lp.SetObjectiveCoefficient(col, 1.0 + random.Uniform(5));
+        lp.SetCoefficient(RowIndex(random.Uniform(15)), col,
+                          -1.0 - random.Uniform(3));
+      }
+      lp.CleanUp();
+
+      GlopParameters parameters;
+      LPSolver solver;
+      solver.SetParameters(parameters);
+      CHECK_EQ(ProblemStatus::OPTIMAL, solver.Solve(lp));
+      parameters.set_use_bound_propagation(true);
+      LPSolver propagation_solver;
+      propagation_solver.SetParameters(parameters);
+      CHECK_EQ(ProblemStatus::OPTIMAL, propagation_solver.Solve(lp));
+      CHECK_LE(std::abs(solver.GetObjectiveValue() -
+                        propagation_solver.GetObjectiveValue()),
+               1e-6 * (1.0 + std::abs(solver.GetObjectiveValue())));
+      for (const LPSolver::PreprocessorStats& stats :
+           propagation_solver.preprocessor_stats()) {
+        if (stats.name == "BoundPropagationPreprocessor") {
+          num_removed_cols += stats.num_removed_cols;
+        }
+      }
+    }
+    CHECK_GT(num_removed_cols, 0);
+  }
+
+ private:
+  // Adds to lp the given number of new variables in [0, 10] with random
+  // objective coefficients between 1 and 20, and of new constraints
+  // sum a_ij x_j <= b_i over them with positive coefficients. The problem
+  // stays feasible, and bounded if it is a maximization.
+  static void AddRandomBlock(int num_variables, int num_constraints,
+                             ACMRandom* random, LinearProgram* lp) {
+    const ColIndex first_col = lp->num_variables();
+    for (int j = 0; j < num_variables; ++j) {
+      const ColIndex col = lp->CreateNewVariable();
+      lp->SetVariableBounds(col, 0.0, 10.0);
+      lp->SetObjectiveCoefficient(col, 1.0 + random->Uniform(20));
+    }
+    for (int i = 0; i < num_constraints; ++i) {
+      const RowIndex row = lp->CreateNewConstraint();
+      lp->SetConstraintBounds(row, -kInfinity, 20.0 + random->Uniform(40));
+      for (int j = 0; j < num_variables; ++j) {
+        if (random->OneIn(2)) {
+          lp->SetCoefficient(row, first_col + ColIndex(j),
+                             1.0 + random->Uniform(9));
+        }
+      }
+    }
+  }
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::GlopTest test;
+  test.TestInteriorPointCrossover();
+  test.TestForrestTomlinUpdate();
+  test.TestIndependentBlocks();
+  test.TestBoundPropagationFixesDominatedColumn();
+  test.TestBoundPropagationDetectsInfeasibility();
+  test.TestBoundPropagationPreservesOptimality();
+  return 0;
+}
@@ -0,0 +1,233 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the parallel search against the sequential search of the same model,
+// and the shared incumbent of the parallel local search.
+
+#include <set>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/parallel_search.h"
+
+namespace operations_research {
+
+// Builds the search of a worker, which is the same as the one of the
+// original models of the tests.
+DecisionBuilder* BuildWorkerSearch(Solver* const solver,
+                                   const DecisionVariables& variables) {
+  return solver->MakePhase(variables.vars, Solver::CHOOSE_FIRST_UNBOUND,
+                           Solver::ASSIGN_MIN_VALUE);
+}
+
+// Builds a local search which starts from the largest values and decrements
+// one variable at a time.
+DecisionBuilder* MakeDecrementSearch(Solver* const solver,
+                                     const std::vector<IntVar*>& vars,
+                                     SolutionPool* const pool) {
+  DecisionBuilder* const first_solution = solver->MakePhase(
+      vars, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MAX_VALUE);
+  LocalSearchPhaseParameters* const parameters =
+      solver->MakeLocalSearchPhaseParameters(
+          pool, solver->MakeOperator(vars, Solver::DECREMENT),
+          solver->MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                            Solver::ASSIGN_MIN_VALUE));
+  return solver->MakeLocalSearchPhase(vars, first_solution, parameters);
+}
+
+DecisionBuilder* BuildWorkerLocalSearch(Solver* const solver,
+                                        const DecisionVariables& variables,
+                                        SolutionPool* const pool) {
+  return MakeDecrementSearch(solver, variables.vars, pool);
+}
+
+class ParallelSearchTest {
+ public:
+  // All the solutions of the 10-queens problem are found once, whatever the
+  // way the workers split the search tree.
+  void TestAllSolutions() {
+    Solver solver("queens");
+    std::vector<IntVar*> queens;
+    MakeQueens(&solver, 10, &queens);
+    DecisionBuilder* const db = BuildWorkerSearch(&solver, {queens, {}, {}});
+
+    SolutionCollector* const all = solver.MakeAllSolutionCollector();
+    all->Add(queens);
+    solver.Solve(db, all);
+    CHECK_EQ(724, all->solution_count());
+
+    ParallelSearch search(&solver, db, {},
+                          NewPermanentCallback(&BuildWorkerSearch),
+                          kNumWorkers);
+    ParallelSolutionCollector collector(&solver, true);
+    collector.Add(queens);
+    CHECK(search.Solve(&collector));
+    CHECK_GT(search.steals(), 0);
+    CHECK_EQ(all->solution_count(), search.solutions());
+    CHECK_EQ(all->solution_count(), collector.solution_count());
+    CHECK(Solutions(all, queens) == Solutions(&collector, queens));
+  }
+
+  // The workers share the best objective, and reach the optimum of the
+  // sequential search.
+  void TestOptimization() {
+    Solver solver("weighted_queens");
+    std::vector<IntVar*> queens;
+    MakeQueens(&solver, 10, &queens);
+    const std::vector<int64> weights = {7, 3, 9, 1, 8, 2, 6, 4, 10, 5};
+    IntVar* const cost = solver.MakeScalProd(queens, weights)->Var();
+    DecisionBuilder* const db = BuildWorkerSearch(&solver, {queens, {}, {}});
+
+    OptimizeVar* const minimize = solver.MakeMinimize(cost, 1);
+    SolutionCollector* const best = solver.MakeLastSolutionCollector();
+    best->AddObjective(cost);
+    CHECK(solver.Solve(db, minimize, best));
+    const int64 optimum = best->objective_value(0);
+
+    ParallelSearch search(&solver, db, {minimize},
+                          NewPermanentCallback(&BuildWorkerSearch),
+                          kNumWorkers);
+    ParallelSolutionCollector collector(&solver, false);
+    collector.Add(queens);
+    collector.AddObjective(cost);
+    CHECK(search.Solve(&collector));
+    CHECK_EQ(optimum, search.best_objective());
+    CHECK_EQ(1, collector.solution_count());
+    CHECK_EQ(optimum, collector.objective_value(0));
+    int64 value = 0;
+    for (int i = 0; i < queens.size(); ++i) {
+      value += weights[i] * collector.Value(0, queens[i]);
+    }
+    CHECK_EQ(optimum, value);
+  }
+
+  // A search limit exported with the model stops all the workers once the
+  // total of their counts crosses it. The workers report their branches in
+  // batches, so each of them can exceed the limit by one batch.
+  void TestSearchLimit() {
+    Solver solver("limited_queens");
+    std::vector<IntVar*> queens;
+    MakeQueens(&solver, 12, &queens);
+    DecisionBuilder* const db = BuildWorkerSearch(&solver, {queens, {}, {}});
+    const int64 kNumSolutions = 14200;
+
+    const int64 kMaxSolutions = 100;
+    SearchLimit* const solution_limit =
+        solver.MakeLimit(kint64max, kint64max, kint64max, kMaxSolutions);
+    ParallelSearch limited_solutions(&solver, db, {solution_limit},
+                                     NewPermanentCallback(&BuildWorkerSearch),
+                                     kNumWorkers);
+    CHECK(limited_solutions.Solve(nullptr));
+    CHECK_GE(limited_solutions.solutions(), kMaxSolutions);
+    CHECK_LT(limited_solutions.solutions(), kNumSolutions / 10);
+
+    const int64 kMaxBranches = 2000;
+    SearchLimit* const branch_limit =
+        solver.MakeLimit(kint64max, kMaxBranches, kint64max, kint64max);
+    ParallelSearch limited_branches(&solver, db, {branch_limit},
+                                    NewPermanentCallback(&BuildWorkerSearch),
+                                    kNumWorkers);
+    limited_branches.Solve(nullptr);
+    CHECK_GE(limited_branches.branches(), kMaxBranches);
+    CHECK_LE(limited_branches.branches(),
+             kMaxBranches + kNumWorkers * kReportPeriod);
+    CHECK_LT(limited_branches.solutions(), kNumSolutions);
+  }
+
+  // Minimizes the sum of 6 different values in [0, 9] by local search. Every
+  // incumbent reported to the collector improves the previous one, and the
+  // last one is the optimum 0 + 1 + ... + 5, where no variable can be
+  // decremented. The objective never reaches its lower bound 0, so the search
+  // only ends because all the workers wait for a better incumbent.
+  void TestLocalSearch() {
+    Solver solver("decrement");
+    std::vector<IntVar*> vars;
+    solver.MakeIntVarArray(6, 0, 9, "x_", &vars);
+    solver.AddConstraint(solver.MakeAllDifferent(vars));
+    IntVar* const sum = solver.MakeSum(vars)->Var();
+    CHECK_EQ(0, sum->Min());
+    OptimizeVar* const minimize = solver.MakeMinimize(sum, 1);
+    DecisionBuilder* const db =
+        MakeDecrementSearch(&solver, vars, solver.MakeDefaultSolutionPool());
+
+    ParallelLocalSearch search(&solver, db, {minimize},
+                               NewPermanentCallback(&BuildWorkerLocalSearch),
+                               kNumWorkers);
+    ParallelSolutionCollector collector(&solver, true);
+    collector.Add(vars);
+    collector.AddObjective(sum);
+    CHECK(search.Solve(&collector));
+    CHECK_EQ(15, search.best_objective());
+    CHECK_EQ(search.solutions(), collector.solution_count());
+    CHECK_GT(collector.solution_count(), 1);
+    for (int n = 0; n < collector.solution_count(); ++n) {
+      int64 value = 0;
+      for (IntVar* const var : vars) value += collector.Value(n, var);
+      CHECK_EQ(value, collector.objective_value(n));
+      if (n > 0) {
+        CHECK_LT(collector.objective_value(n),
+                 collector.objective_value(n - 1));
+      }
+    }
+    CHECK_EQ(15, collector.objective_value(collector.solution_count() - 1));
+  }
+
+ private:
+  static const int kNumWorkers = 4;
+  // The number of branches and failures after which a worker reports them to
+  // the shared limit.
+  static const int64 kReportPeriod = 256;
+
+  // The n-queens problem, with one queen per column.
+  static void MakeQueens(Solver* const solver, int size,
+                         std::vector<IntVar*>* const queens) {
+    solver->MakeIntVarArray(size, 0, size - 1, "queen_", queens);
+    std::vector<IntVar*> up_diagonals;
+    std::vector<IntVar*> down_diagonals;
+    for (int i = 0; i < size; ++i) {
+      up_diagonals.push_back(solver->MakeSum((*queens)[i], i)->Var());
+      down_diagonals.push_back(solver->MakeSum((*queens)[i], -i)->Var());
+    }
+    solver->AddConstraint(solver->MakeAllDifferent(*queens));
+    solver->AddConstraint(solver->MakeAllDifferent(up_diagonals));
+    solver->AddConstraint(solver->MakeAllDifferent(down_diagonals));
+  }
+
+  // Returns the solutions of the collector, on the given variables.
+  static std::set<std::vector<int64>> Solutions(
+      SolutionCollector* const collector, const std::vector<IntVar*>& vars) {
+    std::set<std::vector<int64>> solutions;
+    for (int n = 0; n < collector->solution_count(); ++n) {
+      std::vector<int64> values;
+      for (IntVar* const var : vars) values.push_back(collector->Value(n, var));
+      solutions.insert(values);
+    }
+    return solutions;
+  }
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::ParallelSearchTest test;
+  test.TestAllSolutions();
+  test.TestOptimization();
+  test.TestSearchLimit();
+  test.TestLocalSearch();
+  return 0;
+}
@@ -0,0 +1,187 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the order in which the propagation queue runs the demons: the demons
+// of the same priority are run in the order in which they were enqueued, and
+// a delayed demon is only run when no variable demon is waiting.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+class DemonTree;
+
+// Records its index when it is run, and lets the tree enqueue its children.
+class RecordingDemon : public Demon {
+ public:
+  RecordingDemon(DemonTree* const tree, int index,
+                 Solver::DemonPriority priority)
+      : tree_(tree), index_(index), priority_(priority) {}
+  virtual ~RecordingDemon() {}
+
+  virtual void Run(Solver* const s);
+  virtual Solver::DemonPriority priority() const { return priority_; }
+  virtual std::string DebugString() const {
+    return StringPrintf("RecordingDemon(%d)", index_);
+  }
+
+ private:
+  DemonTree* const tree_;
+  const int index_;
+  const Solver::DemonPriority priority_;
+};
+
+// Enqueues a binary tree of variable demons from its root: variable demon i
+// enqueues the variable demons 2i + 1 and 2i + 2, so a FIFO runs them in the
+// order of their indices. The queue grows to half the tree while it is
+// consumed, so it wraps around and is reallocated. Every kDelayedPeriod
+// variable demons, one of them also enqueues the next delayed demon, twice.
+// Delayed demon j then enqueues variable demon num_variable_demons + j, which
+// must run before the next delayed demon.
+class DemonTree : public Constraint {
+ public:
+  static const int kDelayedPeriod = 50;
+
+  DemonTree(Solver* const s, int num_variable_demons)
+      : Constraint(s),
+        num_variable_demons_(num_variable_demons),
+        fail_at_(kint32max) {
+    const int num_delayed_demons = num_variable_demons / kDelayedPeriod;
+    for (int i = 0; i < num_variable_demons + num_delayed_demons; ++i) {
+      variable_demons_.push_back(
+          s->RevAlloc(new RecordingDemon(this, i, Solver::VAR_PRIORITY)));
+    }
+    for (int j = 0; j < num_delayed_demons; ++j) {
+      delayed_demons_.push_back(s->RevAlloc(new RecordingDemon(
+          this, -1 - j, Solver::DELAYED_PRIORITY)));
+    }
+  }
+  virtual ~DemonTree() {}
+
+  virtual void Post() {}
+
+  virtual void InitialPropagate() {
+    runs_.clear();
+    FreezeQueue();
+    EnqueueVar(variable_demons_[0]);
+    UnfreezeQueue();
+  }
+
+  void OnRun(int index) {
+    runs_.push_back(index);
+    if (index == fail_at_) solver()->Fail();
+    if (index < 0) {
+      EnqueueVar(variable_demons_[num_variable_demons_ - 1 - index]);
+      return;
+    }
+    if (index >= num_variable_demons_) return;
+    for (int child = 2 * index + 1;
+         child <= 2 * index + 2 && child < num_variable_demons_; ++child) {
+      EnqueueVar(variable_demons_[child]);
+    }
+    if (index % kDelayedPeriod == 0) {
+      Demon* const delayed = delayed_demons_[index / kDelayedPeriod];
+      EnqueueDelayedDemon(delayed);
+      EnqueueDelayedDemon(delayed);
+    }
+  }
+
+  // The indices of the demons, in the order in which they were run. Delayed
+  // demon j is recorded as -1 - j.
+  const std::vector<int>& runs() const { return runs_; }
+  // Makes the demon of the given index fail when it is run.
+  void set_fail_at(int index) { fail_at_ = index; }
+
+  virtual std::string DebugString() const { return "DemonTree"; }
+
+ private:
+  const int num_variable_demons_;
+  std::vector<Demon*> variable_demons_;
+  std::vector<Demon*> delayed_demons_;
+  std::vector<int> runs_;
+  int fail_at_;
+};
+
+void RecordingDemon::Run(Solver* const s) { tree_->OnRun(index_); }
+
+class PropagationQueueTest {
+ public:
+  void TestOrder() {
+    const int kNumVariableDemons = 500;
+    Solver solver("PropagationQueueTest");
+    DemonTree* const tree =
+        solver.RevAlloc(new DemonTree(&solver, kNumVariableDemons));
+    solver.AddConstraint(tree);
+    CHECK(solver.Solve(MakeSearch(&solver)));
+    CheckRuns(tree->runs(), kNumVariableDemons);
+  }
+
+  // A failure empties the queues: the demons queued when the propagation
+  // failed are not run by the next propagation, which runs in order.
+  void TestFailure() {
+    const int kNumVariableDemons = 500;
+    Solver solver("PropagationQueueTest");
+    DemonTree* const tree =
+        solver.RevAlloc(new DemonTree(&solver, kNumVariableDemons));
+    solver.AddConstraint(tree);
+    DecisionBuilder* const db = MakeSearch(&solver);
+    tree->set_fail_at(100);
+    CHECK(!solver.Solve(db));
+    CHECK_EQ(101, tree->runs().size());
+    CHECK_EQ(100, tree->runs().back());
+    tree->set_fail_at(kint32max);
+    CHECK(solver.Solve(db));
+    CheckRuns(tree->runs(), kNumVariableDemons);
+  }
+
+ private:
+  // The demons are run by the initial propagation, so the search has nothing
+  // to decide.
+  static DecisionBuilder* MakeSearch(Solver* const solver) {
+    return solver->MakePhase(solver->MakeIntConst(0),
+                             Solver::CHOOSE_FIRST_UNBOUND,
+                             Solver::ASSIGN_MIN_VALUE);
+  }
+
+  // The variable demons of the tree run in the order of their indices, then
+  // each delayed demon runs once, followed by the variable demon it enqueues.
+  static void CheckRuns(const std::vector<int>& runs,
+                        int num_variable_demons) {
+    const int num_delayed_demons =
+        num_variable_demons / DemonTree::kDelayedPeriod;
+    CHECK_EQ(num_variable_demons + 2 * num_delayed_demons, runs.size());
+    for (int i = 0; i < num_variable_demons; ++i) {
+      CHECK_EQ(i, runs[i]);
+    }
+    for (int j = 0; j < num_delayed_demons; ++j) {
+      CHECK_EQ(-1 - j, runs[num_variable_demons + 2 * j]);
+      CHECK_EQ(num_variable_demons + j, runs[num_variable_demons + 2 * j + 1]);
+    }
+  }
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::PropagationQueueTest test;
+  test.TestOrder();
+  test.TestFailure();
+  return 0;
+}
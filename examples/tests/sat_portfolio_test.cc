@@ -0,0 +1,183 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/unique_ptr.h"
+#include "sat/sat_base.h"
+#include "sat/sat_parameters.pb.h"
+#include "sat/sat_portfolio.h"
+#include "sat/sat_solver.h"
+
+namespace operations_research {
+namespace sat {
+
+class SatPortfolioTest {
+ public:
+  // Exchanges clauses through a pool whose ring buffers hold 8 words. A worker
+  // never reads its own clauses, a reader lapped by a writer skips the
+  // overwritten clauses and then reads the new ones, and a clause larger than
+  // a ring buffer is ignored.
+  void TestSharedClausePool() {
+    SharedClausePool pool(3, 8);
+    const std::vector<Literal> binary = {Literal(LiteralIndex(0)),
+                                         Literal(LiteralIndex(3))};
+    const std::vector<Literal> ternary = {Literal(LiteralIndex(1)),
+                                          Literal(LiteralIndex(4)),
+                                          Literal(LiteralIndex(6))};
+    std::vector<std::vector<Literal>> clauses;
+
+    pool.AddClause(0, ClauseRef(binary));
+    pool.AddClause(0, ClauseRef(ternary));
+    pool.GetNewClauses(0, &clauses);
+    CHECK(clauses.empty());
+    pool.GetNewClauses(1, &clauses);
+    CHECK_EQ(2, clauses.size());
+    CHECK(clauses[0] == binary);
+    CHECK(clauses[1] == ternary);
+    clauses.clear();
+    pool.GetNewClauses(1, &clauses);
+    CHECK(clauses.empty());
+
+    // Worker 2 did not read anything yet, and 3 + 4 + 3 + 4 words are written
+    // in a buffer of 8 words: it is lapped.
+    pool.AddClause(0, ClauseRef(binary));
+    pool.AddClause(0, ClauseRef(ternary));
+    pool.GetNewClauses(2, &clauses);
+    CHECK(clauses.empty());
+    CHECK_EQ(1, pool.num_skipped_clauses(2));
+    pool.AddClause(0, ClauseRef(binary));
+    pool.GetNewClauses(2, &clauses);
+    CHECK_EQ(1, clauses.size());
+    CHECK(clauses[0] == binary);
+
+    std::vector<Literal> large;
+    for (int i = 0; i < 8; ++i) large.push_back(Literal(LiteralIndex(2 * i)));
+    pool.AddClause(1, ClauseRef(large));
+    CHECK_EQ(0, pool.num_published_clauses(1));
+    CHECK_EQ(5, pool.num_published_clauses(0));
+  }
+
+  // The pigeon hole problem with 7 pigeons and 6 holes is UNSAT.
+  void TestPortfolioUnsat() {
+    const int kNumHoles = 6;
+    const int kNumPigeons = kNumHoles + 1;
+    std::vector<std::vector<Literal>> clauses;
+    for (int p = 0; p < kNumPigeons; ++p) {
+      std::vector<Literal> clause;
+      for (int h = 0; h < kNumHoles; ++h) {
+        clause.push_back(Literal(VariableIndex(p * kNumHoles + h), true));
+      }
+      clauses.push_back(clause);
+    }
+    for (int h = 0; h < kNumHoles; ++h) {
+      for (int p = 0; p < kNumPigeons; ++p) {
+        for (int q = p + 1; q < kNumPigeons; ++q) {
+          clauses.push_back(
+              {Literal(VariableIndex(p * kNumHoles + h), false),
+               Literal(VariableIndex(q * kNumHoles + h), false)});
+        }
+      }
+    }
+    int first_to_finish = -1;
+    CHECK_EQ(SatSolver::MODEL_UNSAT,
+             Solve(kNumPigeons * kNumHoles, clauses, &first_to_finish));
+    CHECK_GE(first_to_finish, 0);
+  }
+
+  // Random 3-SAT instances below the satisfiability threshold are SAT, and
+  // the assignment of the winner must satisfy all their clauses.
+  void TestPortfolioSat() {
+    const int kNumVariables = 300;
+    const int kNumClauses = 3.8 * kNumVariables;
+    for (int seed = 0; seed < 3; ++seed) {
+      ACMRandom random(seed);
+      std::vector<std::vector<Literal>> clauses(kNumClauses);
+      for (std::vector<Literal>& clause : clauses) {
+        while (clause.size() < 3) {
+          const Literal literal(VariableIndex(random.Uniform(kNumVariables)),
+                                random.OneIn(2));
+          bool is_new = true;
+          for (const Literal other : clause) {
+            if (other.Variable() == literal.Variable()) is_new = false;
+          }
+          if (is_new) clause.push_back(literal);
+        }
+      }
+      SatSolver reference_solver;
+      reference_solver.SetNumVariables(kNumVariables);
+      for (const std::vector<Literal>& clause : clauses) {
+        CHECK(reference_solver.AddProblemClause(clause));
+      }
+      if (reference_solver.Solve() != SatSolver::MODEL_SAT) continue;
+
+      std::vector<std::unique_ptr<SatSolver>> solvers;
+      int first_to_finish = -1;
+      CHECK_EQ(SatSolver::MODEL_SAT,
+               Solve(kNumVariables, clauses, &first_to_finish, &solvers));
+      CHECK_GE(first_to_finish, 0);
+      const VariablesAssignment& assignment =
+          solvers[first_to_finish]->Assignment();
+      for (const std::vector<Literal>& clause : clauses) {
+        bool is_satisfied = false;
+        for (const Literal literal : clause) {
+          if (assignment.IsLiteralTrue(literal)) is_satisfied = true;
+        }
+        CHECK(is_satisfied);
+      }
+    }
+  }
+
+ private:
+  static const int kNumWorkers = 4;
+
+  // Solves the given clauses with a portfolio of kNumWorkers solvers, which
+  // are returned in solvers if it is not null.
+  static SatSolver::Status Solve(
+      int num_variables, const std::vector<std::vector<Literal>>& clauses,
+      int* first_to_finish,
+      std::vector<std::unique_ptr<SatSolver>>* solvers = nullptr) {
+    std::vector<std::unique_ptr<SatSolver>> owned_solvers;
+    if (solvers == nullptr) solvers = &owned_solvers;
+    std::vector<SatSolver*> workers;
+    for (int i = 0; i < kNumWorkers; ++i) {
+      solvers->emplace_back(new SatSolver());
+      SatSolver* const solver = solvers->back().get();
+      solver->SetNumVariables(num_variables);
+      for (const std::vector<Literal>& clause : clauses) {
+        CHECK(solver->AddProblemClause(clause));
+      }
+      workers.push_back(solver);
+    }
+    SatParameters parameters;
+    parameters.set_num_search_workers(kNumWorkers);
+    parameters.set_log_search_progress(false);
+    return SolveWithPortfolio(parameters, workers, first_to_finish);
+  }
+};
+
+}  // namespace sat
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::sat::SatPortfolioTest test;
+  test.TestSharedClausePool();
+  test.TestPortfolioUnsat();
+  test.TestPortfolioSat();
+  return 0;
+}
@@ -0,0 +1,513 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/file.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/split.h"
+#include "base/strtoint.h"
+#include "base/unique_ptr.h"
+#include "sat/clause.h"
+#include "sat/drat_writer.h"
+#include "sat/sat_base.h"
+#include "sat/sat_parameters.pb.h"
+#include "sat/sat_solver.h"
+#include "sat/simplification.h"
+
+DEFINE_string(drat_file, "/tmp/sat_solver_test.drat",
+              "Temporary file used to store the DRAT proofs of the tests.");
+
+namespace operations_research {
+namespace sat {
+
+// A forward checker of a DRAT proof in text format: each added clause must be
+// implied by unit propagation ("reverse unit propagation") from the clauses of
+// the problem and the previously added clauses that are not deleted. The
+// deletions must refer to a clause of the database. Like drat-trim, the
+// deletion of a clause that is the reason of a literal fixed at level zero is
+// ignored. The literals use the signed convention of Literal::SignedValue().
+class DratChecker {
+ public:
+  explicit DratChecker(int num_variables)
+      : num_variables_(num_variables),
+        assignment_(2 * num_variables + 1, 0),
+        occurrences_(2 * num_variables + 1),
+        is_unsat_(false) {}
+
+  void AddProblemClause(const std::vector<int>& clause) { Add(clause); }
+
+  // Checks the proof and returns true if it contains the empty clause.
+  bool CheckProof(const std::string& proof) {
+    for (const std::string& line :
+         strings::Split(proof, "\n", strings::SkipEmpty())) {
+      std::vector<std::string> tokens =
+          strings::Split(line, " ", strings::SkipEmpty());
+      const bool is_deletion = tokens[0] == "d";
+      if (is_deletion) tokens.erase(tokens.begin());
+      CHECK_EQ("0", tokens.back()) << line;
+      tokens.pop_back();
+      std::vector<int> clause;
+      for (const std::string& token : tokens) {
+        clause.push_back(atoi32(token));
+        CHECK_LE(abs(clause.back()), num_variables_) << line;
+      }
+      if (is_deletion) {
+        Delete(clause);
+        continue;
+      }
+      CHECK(IsImpliedByUnitPropagation(clause)) << "Wrong lemma: " << line;
+      if (clause.empty()) return true;
+      Add(clause);
+    }
+    return false;
+  }
+
+ private:
+  int Code(int literal) const { return num_variables_ + literal; }
+
+  // Adds the clause and propagates it at level zero.
+  void Add(const std::vector<int>& clause) {
+    const int id = clauses_.size();
+    std::vector<int> key = clause;
+    std::sort(key.begin(), key.end());
+    ids_[key].push_back(id);
+    for (const int literal : clause) {
+      occurrences_[Code(literal)].push_back(id);
+    }
+    clauses_.push_back(clause);
+    is_deleted_.push_back(false);
+    if (is_unsat_) return;
+    const int head = trail_.size();
+    if (!Propagate(id) || !PropagateFrom(head)) is_unsat_ = true;
+  }
+
+  void Delete(const std::vector<int>& clause) {
+    std::vector<int> key = clause;
+    std::sort(key.begin(), key.end());
+    std::vector<int>& ids = ids_[key];
+    CHECK(!ids.empty()) << "Deletion of an unknown clause.";
+    int num_false = 0;
+    for (const int literal : clause) {
+      if (assignment_[Code(literal)] == -1) ++num_false;
+    }
+    if (num_false + 1 == clause.size() && !is_unsat_) {
+      for (const int literal : clause) {
+        if (assignment_[Code(literal)] == 1) return;
+      }
+    }
+    is_deleted_[ids.back()] = true;
+    ids.pop_back();
+  }
+
+  // Assigns the negation of the clause on top of the level zero assignment and
+  // returns true if unit propagation then finds a conflict.
+  bool IsImpliedByUnitPropagation(const std::vector<int>& clause) {
+    if (is_unsat_) return true;
+    const int num_fixed = trail_.size();
+    bool conflict = false;
+    for (const int literal : clause) {
+      if (!Assign(-literal)) conflict = true;
+    }
+    if (!conflict) conflict = !PropagateFrom(num_fixed);
+    while (trail_.size() > num_fixed) {
+      assignment_[Code(trail_.back())] = 0;
+      assignment_[Code(-trail_.back())] = 0;
+      trail_.pop_back();
+    }
+    return conflict;
+  }
+
+  // Returns false if the literal is already false.
+  bool Assign(int literal) {
+    if (assignment_[Code(literal)] == 1) return true;
+    if (assignment_[Code(literal)] == -1) return false;
+    assignment_[Code(literal)] = 1;
+    assignment_[Code(-literal)] = -1;
+    trail_.push_back(literal);
+    return true;
+  }
+
+  // Propagates the clauses containing the negation of the literals of the
+  // trail starting at the given position. Returns false on conflict.
+  bool PropagateFrom(int head) {
+    for (; head < trail_.size(); ++head) {
+      for (const int id : occurrences_[Code(-trail_[head])]) {
+        if (!is_deleted_[id] && !Propagate(id)) return false;
+      }
+    }
+    return true;
+  }
+
+  // Propagates the given clause if it is unit, returns false if it is false.
+  bool Propagate(int id) {
+    int num_unassigned = 0;
+    int unassigned = 0;
+    for (const int literal : clauses_[id]) {
+      if (assignment_[Code(literal)] == 1) return true;
+      if (assignment_[Code(literal)] == 0) {
+        ++num_unassigned;
+        unassigned = literal;
+      }
+    }
+    if (num_unassigned == 0) return false;
+    if (num_unassigned == 1) Assign(unassigned);
+    return true;
+  }
+
+  const int num_variables_;
+  std::vector<int8> assignment_;
+  std::vector<int> trail_;
+  std::vector<std::vector<int>> clauses_;
+  std::vector<bool> is_deleted_;
+  std::vector<std::vector<int>> occurrences_;
+  std::map<std::vector<int>, std::vector<int>> ids_;
+  bool is_unsat_;
+};
+
+class SatSolverTest {
+ public:
+  // Solves random 3-SAT instances over the threshold, so that they are UNSAT,
+  // and checks their DRAT proof. The clause database is cleaned at each
+  // conflict, so the clauses subsumed during a conflict analysis are freed
+  // while the learned clause is added, before their deletion is written to the
+  // proof.
+  void TestDratProofWithSubsumptionAndCleanup() {
+    const int kNumVariables = 200;
+    const int kNumClauses = 5.5 * kNumVariables;
+    for (int seed = 0; seed < 3; ++seed) {
+      ACMRandom random(seed);
+      SatParameters parameters;
+      parameters.set_subsumption_during_conflict_analysis(true);
+      parameters.set_clause_cleanup_min_target(1);
+      parameters.set_clause_cleanup_ratio(1.0);
+      parameters.set_clause_cleanup_lbd_bound(0);
+      parameters.set_log_search_progress(false);
+
+      File* const output = File::Open(FLAGS_drat_file, "w");
+      CHECK(output != nullptr);
+      std::unique_ptr<DratWriter> drat_writer(new DratWriter(false, output));
+      SatSolver solver;
+      solver.SetParameters(parameters);
+      solver.SetDratWriter(drat_writer.get());
+      solver.SetNumVariables(kNumVariables);
+
+      DratChecker checker(kNumVariables);
+      std::vector<Literal> literals;
+      std::vector<int> clause;
+      for (int i = 0; i < kNumClauses; ++i) {
+        literals.clear();
+        clause.clear();
+        while (literals.size() < 3) {
+          const Literal literal(VariableIndex(random.Uniform(kNumVariables)),
+                                random.OneIn(2));
+          if (std::find(clause.begin(), clause.end(), literal.SignedValue()) !=
+                  clause.end() ||
+              std::find(clause.begin(), clause.end(),
+                        -literal.SignedValue()) != clause.end()) {
+            continue;
+          }
+          literals.push_back(literal);
+          clause.push_back(literal.SignedValue());
+        }
+        checker.AddProblemClause(clause);
+        if (!solver.AddProblemClause(literals)) break;
+      }
+      CHECK_EQ(SatSolver::MODEL_UNSAT, solver.Solve());
+      CHECK_GT(solver.num_failures(), 1000);
+      drat_writer.reset();
+
+      std::string proof;
+      CHECK(file::ReadFileToString(FLAGS_drat_file, &proof));
+      CHECK(checker.CheckProof(proof)) << "No empty clause in the proof.";
+    }
+    File::Delete(FLAGS_drat_file.c_str());
+  }
+
+  // Pushes two nested scopes with contradictory constraints and pops them. Each
+  // PopScope() must fix the selector of its scope to false at level zero, even
+  // if an enclosing scope is still open.
+  void TestNestedScopes() {
+    SatSolver solver;
+    solver.SetNumVariables(1);
+    const Literal x(VariableIndex(0), true);
+    const std::vector<Literal> no_assumptions;
+
+    // The selector of a scope is a new variable.
+    solver.PushScope();
+    const Literal outer_selector(VariableIndex(1), true);
+    CHECK(solver.AddUnitClause(x));
+    solver.PushScope();
+    const Literal inner_selector(VariableIndex(2), true);
+    CHECK(solver.AddUnitClause(x.Negated()));
+    CHECK_EQ(3, solver.NumVariables());
+    CHECK_EQ(2, solver.NumScopes());
+    CHECK_EQ(SatSolver::ASSUMPTIONS_UNSAT,
+             solver.SolveWithAssumptions(no_assumptions));
+
+    solver.PopScope();
+    CHECK(solver.Assignment().IsLiteralFalse(inner_selector));
+    CHECK(!solver.Assignment().IsVariableAssigned(outer_selector.Variable()));
+    CHECK_EQ(SatSolver::MODEL_SAT,
+             solver.SolveWithAssumptions(no_assumptions));
+    CHECK(solver.Assignment().IsLiteralTrue(x));
+
+    solver.PopScope();
+    CHECK_EQ(0, solver.NumScopes());
+    CHECK(solver.Assignment().IsLiteralFalse(inner_selector));
+    CHECK(solver.Assignment().IsLiteralFalse(outer_selector));
+    CHECK_EQ(SatSolver::MODEL_SAT,
+             solver.SolveWithAssumptions(std::vector<Literal>(1, x.Negated())));
+  }
+
+  // Presolves random 3-SAT instances close to the satisfiability threshold
+  // with several threads. The presolved problem must not depend on the number
+  // of threads, and it must have the same status as the initial one, with a
+  // solution that is postsolved into a solution of the initial problem.
+  void TestParallelPresolve() {
+    const int kNumVariables = 200;
+    const int kNumClauses = 4.2 * kNumVariables;
+    for (int seed = 0; seed < 5; ++seed) {
+      ACMRandom random(seed);
+      std::vector<std::vector<Literal>> clauses(kNumClauses);
+      for (std::vector<Literal>& clause : clauses) {
+        while (clause.size() < 3) {
+          const Literal literal(VariableIndex(random.Uniform(kNumVariables)),
+                                random.OneIn(2));
+          bool is_new = true;
+          for (const Literal other : clause) {
+            if (other.Variable() == literal.Variable()) is_new = false;
+          }
+          if (is_new) clause.push_back(literal);
+        }
+      }
+
+      SatSolver reference_solver;
+      reference_solver.SetNumVariables(kNumVariables);
+      for (const std::vector<Literal>& clause : clauses) {
+        if (!reference_solver.AddProblemClause(clause)) break;
+      }
+      const SatSolver::Status reference_status = reference_solver.Solve();
+
+      std::vector<std::vector<Literal>> first_presolved_clauses;
+      for (const int num_threads : {2, 4}) {
+        SatParameters parameters;
+        parameters.set_presolve_num_threads(num_threads);
+        parameters.set_log_search_progress(false);
+        SatPostsolver postsolver(kNumVariables);
+        SatPresolver presolver(&postsolver);
+        presolver.SetParameters(parameters);
+        for (const std::vector<Literal>& clause : clauses) {
+          presolver.AddClause(ClauseRef(clause));
+        }
+        if (!presolver.Presolve()) {
+          CHECK_EQ(SatSolver::MODEL_UNSAT, reference_status);
+          continue;
+        }
+        const std::vector<std::vector<Literal>> presolved_clauses(
+            presolver.begin(), presolver.end());
+        if (num_threads == 2) {
+          first_presolved_clauses = presolved_clauses;
+        } else {
+          CHECK(presolved_clauses == first_presolved_clauses);
+        }
+
+        SatSolver solver;
+        solver.SetParameters(parameters);
+        presolver.LoadProblemIntoSatSolver(&solver);
+        postsolver.ApplyMapping(presolver.VariableMapping());
+        const SatSolver::Status status = solver.Solve();
+        CHECK_EQ(reference_status, status);
+        if (status != SatSolver::MODEL_SAT) continue;
+        const std::vector<bool> solution =
+            postsolver.ExtractAndPostsolveSolution(solver);
+        for (const std::vector<Literal>& clause : clauses) {
+          bool is_satisfied = false;
+          for (const Literal literal : clause) {
+            if (solution[literal.Variable().value()] == literal.IsPositive()) {
+              is_satisfied = true;
+            }
+          }
+          CHECK(is_satisfied);
+        }
+      }
+    }
+  }
+  // Solves random 3-SAT instances at the satisfiability threshold with and
+  // without inprocessing, which is triggered as often as possible. The two
+  // solvers must agree on the status, and the model found with inprocessing
+  // must satisfy the original clauses.
+  void TestInprocessing() {
+    const int kNumVariables = 100;
+    const int kNumClauses = 4.26 * kNumVariables;
+    int num_sat = 0;
+    int num_unsat = 0;
+    bool inprocessing_ran = false;
+    for (int seed = 0; seed < 10; ++seed) {
+      ACMRandom random(seed);
+      std::vector<std::vector<Literal>> clauses(kNumClauses);
+      for (std::vector<Literal>& clause : clauses) {
+        while (clause.size() < 3) {
+          const Literal literal(VariableIndex(random.Uniform(kNumVariables)),
+                                random.OneIn(2));
+          bool is_new = true;
+          for (const Literal other : clause) {
+            if (other.Variable() == literal.Variable()) is_new = false;
+          }
+          if (is_new) clause.push_back(literal);
+        }
+      }
+
+      SatSolver::Status statuses[2];
+      for (const bool use_inprocessing : {false, true}) {
+        SatParameters parameters;
+        parameters.set_use_inprocessing(use_inprocessing);
+        parameters.set_inprocessing_dtime_ratio(1.0);
+        parameters.set_min_inprocessing_dtime(0.0);
+        parameters.set_random_seed(seed);
+        parameters.set_log_search_progress(false);
+        SatSolver solver;
+        solver.SetParameters(parameters);
+        solver.SetNumVariables(kNumVariables);
+        for (const std::vector<Literal>& clause : clauses) {
+          if (!solver.AddProblemClause(clause)) break;
+        }
+        const SatSolver::Status status = solver.Solve();
+        statuses[use_inprocessing] = status;
+        if (solver.num_inprocessing_rounds() > 0) inprocessing_ran = true;
+        if (status != SatSolver::MODEL_SAT) continue;
+        const VariablesAssignment& assignment = solver.Assignment();
+        for (const std::vector<Literal>& clause : clauses) {
+          bool is_satisfied = false;
+          for (const Literal literal : clause) {
+            if (assignment.IsLiteralTrue(literal)) is_satisfied = true;
+          }
+          CHECK(is_satisfied);
+        }
+      }
+      CHECK_EQ(statuses[false], statuses[true]);
+      if (statuses[true] == SatSolver::MODEL_SAT) ++num_sat;
+      if (statuses[true] == SatSolver::MODEL_UNSAT) ++num_unsat;
+    }
+    CHECK_GT(num_sat, 0);
+    CHECK_GT(num_unsat, 0);
+    CHECK(inprocessing_ran);
+  }
+  // Compacts a ClauseArena while its clauses are watched by LiteralWatchers.
+  // The watched clauses form the chain x_i and z_i => x_{i+1}, which ends with
+  // x_n => z_n and x_n => not(z_n). They are interleaved with freed clauses,
+  // so that they all move. The propagation after the compaction must follow
+  // the whole chain through the relocated watchers, and then detect the
+  // conflict at its end.
+  void TestClauseArenaCompaction() {
+    const int kChainLength = 1000;
+    const int kNumVariables = 3 * kChainLength;
+    ACMRandom random(0);
+    ClauseArena arena;
+    Trail trail;
+    trail.Resize(kNumVariables);
+    LiteralWatchers watchers(&arena);
+    watchers.Resize(kNumVariables);
+    auto x = [](int i) { return Literal(VariableIndex(i), true); };
+    auto z = [](int i) {
+      return Literal(VariableIndex(kChainLength + i), true);
+    };
+    std::vector<std::vector<Literal>> chain_literals;
+    for (int i = 0; i + 1 < kChainLength; ++i) {
+      chain_literals.push_back({x(i).Negated(), z(i).Negated(), x(i + 1)});
+    }
+    chain_literals.push_back({x(kChainLength - 1).Negated(),
+                              z(kChainLength - 1)});
+    chain_literals.push_back({x(kChainLength - 1).Negated(),
+                              z(kChainLength - 1).Negated()});
+
+    std::vector<SatClause*> chain;
+    std::vector<SatClause*> freed;
+    std::vector<Literal> literals;
+    for (const std::vector<Literal>& chain_clause : chain_literals) {
+      for (int j = random.Uniform(3); j >= 0; --j) {
+        literals.clear();
+        while (literals.size() < 4) {
+          const Literal literal(
+              VariableIndex(2 * kChainLength + random.Uniform(kChainLength)),
+              random.OneIn(2));
+          bool is_new = true;
+          for (const Literal other : literals) {
+            if (other.Variable() == literal.Variable()) is_new = false;
+          }
+          if (is_new) literals.push_back(literal);
+        }
+        freed.push_back(SatClause::Create(literals, /*is_redundant=*/true,
+                                          /*node=*/nullptr, &arena));
+        CHECK(watchers.AttachAndPropagate(freed.back(), &trail));
+      }
+      chain.push_back(SatClause::Create(chain_clause, /*is_redundant=*/false,
+                                        /*node=*/nullptr, &arena));
+      CHECK(watchers.AttachAndPropagate(chain.back(), &trail));
+    }
+    for (SatClause* clause : freed) watchers.LazyDetach(clause);
+    watchers.CleanUpWatchers();
+    for (SatClause* clause : freed) arena.Free(clause);
+    const std::vector<SatClause*> old_chain = chain;
+    arena.StartCompaction();
+    for (SatClause*& clause : chain) clause = arena.Relocate(clause);
+    watchers.RelocateWatchers();
+    arena.FinishCompaction();
+    CHECK_EQ(1, arena.num_compactions());
+    CHECK_EQ(chain.size(), watchers.num_watched_clauses());
+    CHECK_EQ(arena.num_used_bytes(), arena.num_live_bytes());
+    for (int i = 0; i < chain.size(); ++i) {
+      CHECK_NE(old_chain[i], chain[i]);
+      CHECK(std::vector<Literal>(chain[i]->begin(), chain[i]->end()) ==
+            chain_literals[i]);
+    }
+
+    for (int i = 0; i + 1 < kChainLength; ++i) {
+      trail.Enqueue(z(i), AssignmentInfo::SEARCH_DECISION);
+    }
+    trail.Enqueue(x(0), AssignmentInfo::SEARCH_DECISION);
+    bool conflict = false;
+    for (int index = 0; index < trail.Index() && !conflict; ++index) {
+      conflict = !watchers.PropagateOnFalse(trail[index].Negated(), &trail);
+    }
+    CHECK(conflict);
+    for (int i = 1; i < kChainLength; ++i) {
+      CHECK(trail.Assignment().IsLiteralTrue(x(i)));
+      CHECK_EQ(chain[i - 1], trail.Info(x(i).Variable()).sat_clause);
+    }
+    const SatClause* const failing_clause = trail.FailingSatClause();
+    CHECK(failing_clause == chain[kChainLength - 1] ||
+          failing_clause == chain[kChainLength]);
+  }
+};
+
+}  // namespace sat
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::sat::SatSolverTest test;
+  test.TestDratProofWithSubsumptionAndCleanup();
+  test.TestNestedScopes();
+  test.TestParallelPresolve();
+  test.TestInprocessing();
+  test.TestClauseArenaCompaction();
+  return 0;
+}
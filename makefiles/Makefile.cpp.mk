@@ -292,8 +292,10 @@ STATIC_ALL_LNK = \
 # Binaries
 
 CPBINARIES = \
+	$(BIN_DIR)/copy_restoration_test$E \
 	$(BIN_DIR)/costas_array$E \
 	$(BIN_DIR)/cryptarithm$E \
+	$(BIN_DIR)/cumulative_test$E \
 	$(BIN_DIR)/cvrptw$E \
 	$(BIN_DIR)/cvrptw_with_refueling$E \
 	$(BIN_DIR)/cvrptw_with_resources$E \
@@ -310,17 +312,24 @@ CPBINARIES = \
 	$(BIN_DIR)/multidim_knapsack$E \
 	$(BIN_DIR)/network_routing$E \
 	$(BIN_DIR)/nqueens$E \
+	$(BIN_DIR)/parallel_search_test$E \
 	$(BIN_DIR)/pdptw$E \
+	$(BIN_DIR)/propagation_benchmark$E \
+	$(BIN_DIR)/propagation_queue_test$E \
+	$(BIN_DIR)/rcpsp_benchmark$E \
 	$(BIN_DIR)/dimacs_assignment$E \
 	$(BIN_DIR)/sports_scheduling$E \
 	$(BIN_DIR)/tsp$E
 
 LPBINARIES = \
+	$(BIN_DIR)/dense_kernels_benchmark$E \
+	$(BIN_DIR)/glop_test$E \
 	$(BIN_DIR)/integer_programming$E \
 	$(BIN_DIR)/linear_programming$E \
 	$(BIN_DIR)/linear_solver_protocol_buffers$E \
 	$(BIN_DIR)/strawberry_fields_with_column_generation$E \
 	$(BIN_DIR)/mps_driver$E \
+	$(BIN_DIR)/mps_reader_benchmark$E \
 	$(BIN_DIR)/solve$E
 
 
@@ -382,6 +391,10 @@ clean_cc:
 	-$(DEL) $(BIN_DIR)$Sfz2$E
 	-$(DEL) $(BIN_DIR)$Sparser_main$E
 	-$(DEL) $(BIN_DIR)$Ssat_runner$E
+	-$(DEL) $(BIN_DIR)$Sclause_arena_benchmark$E
+	-$(DEL) $(BIN_DIR)$Spb_propagation_benchmark$E
+	-$(DEL) $(BIN_DIR)$Ssat_solver_test$E
+	-$(DEL) $(BIN_DIR)$Ssat_portfolio_test$E
 	-$(DEL) $(CPBINARIES)
 	-$(DEL) $(LPBINARIES)
 	-$(DEL) $(GEN_DIR)$Sconstraint_solver$S*.pb.*
@@ -457,6 +470,7 @@ CONSTRAINT_SOLVER_LIB_OBJS = \
 	$(OBJ_DIR)/constraint_solver/model_cache.$O\
 	$(OBJ_DIR)/constraint_solver/nogoods.$O\
 	$(OBJ_DIR)/constraint_solver/pack.$O\
+	$(OBJ_DIR)/constraint_solver/parallel_search.$O\
 	$(OBJ_DIR)/constraint_solver/range_cst.$O\
 	$(OBJ_DIR)/constraint_solver/resource.$O\
 	$(OBJ_DIR)/constraint_solver/sat_constraint.$O\
@@ -574,6 +588,9 @@ $(OBJ_DIR)/constraint_solver/nogoods.$O:$(SRC_DIR)/constraint_solver/nogoods.cc
 $(OBJ_DIR)/constraint_solver/pack.$O:$(SRC_DIR)/constraint_solver/pack.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/pack.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Spack.$O
 
+$(OBJ_DIR)/constraint_solver/parallel_search.$O:$(SRC_DIR)/constraint_solver/parallel_search.cc $(SRC_DIR)/constraint_solver/parallel_search.h $(GEN_DIR)/constraint_solver/model.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/parallel_search.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Sparallel_search.$O
+
 $(OBJ_DIR)/constraint_solver/range_cst.$O:$(SRC_DIR)/constraint_solver/range_cst.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/range_cst.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Srange_cst.$O
 
@@ -954,6 +971,7 @@ endif
 # Glop library.
 
 LP_DATA_OBJS= \
+  $(OBJ_DIR)/lp_data/dense_vector_kernels.$O \
   $(OBJ_DIR)/lp_data/lp_data.$O \
   $(OBJ_DIR)/lp_data/lp_decomposer.$O \
   $(OBJ_DIR)/lp_data/lp_print_utils.$O \
@@ -965,6 +983,9 @@ LP_DATA_OBJS= \
   $(OBJ_DIR)/lp_data/sparse.$O \
   $(OBJ_DIR)/lp_data/sparse_column.$O \
 
+$(OBJ_DIR)/lp_data/dense_vector_kernels.$O:$(SRC_DIR)/lp_data/dense_vector_kernels.cc
+	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Slp_data$Sdense_vector_kernels.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_data$Sdense_vector_kernels.$O
+
 $(OBJ_DIR)/lp_data/lp_data.$O:$(SRC_DIR)/lp_data/lp_data.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Slp_data$Slp_data.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_data$Slp_data.$O
 
@@ -986,7 +1007,7 @@ $(OBJ_DIR)/lp_data/matrix_scaler.$O:$(SRC_DIR)/lp_data/matrix_scaler.cc
 $(OBJ_DIR)/lp_data/matrix_utils.$O:$(SRC_DIR)/lp_data/matrix_utils.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Slp_data$Smatrix_utils.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_data$Smatrix_utils.$O
 
-$(OBJ_DIR)/lp_data/mps_reader.$O:$(SRC_DIR)/lp_data/mps_reader.cc
+$(OBJ_DIR)/lp_data/mps_reader.$O:$(SRC_DIR)/lp_data/mps_reader.cc $(SRC_DIR)/base/mapped_file.h
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Slp_data$Smps_reader.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_data$Smps_reader.$O
 
 $(OBJ_DIR)/lp_data/mps_to_png.$O:$(SRC_DIR)/lp_data/mps_to_png.cc
@@ -1002,10 +1023,13 @@ $(OBJ_DIR)/lp_data/sparse_column.$O:$(SRC_DIR)/lp_data/sparse_column.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Slp_data$Ssparse_column.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_data$Ssparse_column.$O
 
 GLOP_LIB_OBJS= $(LP_DATA_OBJS) \
+  $(OBJ_DIR)/glop/basis_cache.$O \
   $(OBJ_DIR)/glop/basis_representation.$O \
   $(OBJ_DIR)/glop/dual_edge_norms.$O \
   $(OBJ_DIR)/glop/entering_variable.$O \
+  $(OBJ_DIR)/glop/forrest_tomlin_update.$O \
   $(OBJ_DIR)/glop/initial_basis.$O \
+  $(OBJ_DIR)/glop/interior_point.$O \
   $(OBJ_DIR)/glop/lp_solver.$O \
   $(OBJ_DIR)/glop/lu_factorization.$O \
   $(OBJ_DIR)/glop/markowitz.$O \
@@ -1028,6 +1052,9 @@ $(GEN_DIR)/glop/parameters.pb.h:$(GEN_DIR)/glop/parameters.pb.cc
 $(OBJ_DIR)/glop/parameters.pb.$O:$(GEN_DIR)/glop/parameters.pb.cc
 	 $(CCC) $(CFLAGS) -c $(GEN_DIR)$Sglop$Sparameters.pb.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sparameters.pb.$O
 
+$(OBJ_DIR)/glop/basis_cache.$O:$(SRC_DIR)/glop/basis_cache.cc
+	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sbasis_cache.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sbasis_cache.$O
+
 $(OBJ_DIR)/glop/basis_representation.$O:$(SRC_DIR)/glop/basis_representation.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sbasis_representation.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sbasis_representation.$O
 
@@ -1037,9 +1064,15 @@ $(OBJ_DIR)/glop/dual_edge_norms.$O:$(SRC_DIR)/glop/dual_edge_norms.cc
 $(OBJ_DIR)/glop/entering_variable.$O:$(SRC_DIR)/glop/entering_variable.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sentering_variable.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sentering_variable.$O
 
+$(OBJ_DIR)/glop/forrest_tomlin_update.$O:$(SRC_DIR)/glop/forrest_tomlin_update.cc
+	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sforrest_tomlin_update.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sforrest_tomlin_update.$O
+
 $(OBJ_DIR)/glop/initial_basis.$O:$(SRC_DIR)/glop/initial_basis.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sinitial_basis.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sinitial_basis.$O
 
+$(OBJ_DIR)/glop/interior_point.$O:$(SRC_DIR)/glop/interior_point.cc
+	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sinterior_point.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sinterior_point.$O
+
 $(OBJ_DIR)/glop/lp_solver.$O:$(SRC_DIR)/glop/lp_solver.cc  $(GEN_DIR)/linear_solver/linear_solver2.pb.h
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Slp_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Slp_solver.$O
 
@@ -1096,12 +1129,30 @@ $(OBJ_DIR)/glop/mps_driver.$O:$(EX_DIR)/cpp/mps_driver.cc $(GEN_DIR)/glop/parame
 $(BIN_DIR)/mps_driver$E: $(OBJ_DIR)/glop/mps_driver.$O $(STATIC_LP_DEPS)
 	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Smps_driver.$O $(STATIC_LP_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smps_driver$E
 
+$(OBJ_DIR)/glop/dense_kernels_benchmark.$O:$(EX_DIR)/cpp/dense_kernels_benchmark.cc $(SRC_DIR)/lp_data/dense_vector_kernels.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Sdense_kernels_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sdense_kernels_benchmark.$O
+
+$(BIN_DIR)/dense_kernels_benchmark$E: $(OBJ_DIR)/glop/dense_kernels_benchmark.$O $(STATIC_LP_DEPS)
+	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Sdense_kernels_benchmark.$O $(STATIC_LP_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sdense_kernels_benchmark$E
+
+$(OBJ_DIR)/glop/mps_reader_benchmark.$O:$(EX_DIR)/cpp/mps_reader_benchmark.cc $(SRC_DIR)/lp_data/mps_reader.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Smps_reader_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Smps_reader_benchmark.$O
+
+$(BIN_DIR)/mps_reader_benchmark$E: $(OBJ_DIR)/glop/mps_reader_benchmark.$O $(STATIC_LP_DEPS)
+	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Smps_reader_benchmark.$O $(STATIC_LP_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smps_reader_benchmark$E
+
 $(OBJ_DIR)/glop/solve.$O:$(EX_DIR)/cpp/solve.cc $(GEN_DIR)/glop/parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Ssolve.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Ssolve.$O
 
 $(BIN_DIR)/solve$E: $(OBJ_DIR)/glop/solve.$O $(STATIC_LP_DEPS)
 	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Ssolve.$O $(STATIC_LP_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssolve$E
 
+$(OBJ_DIR)/glop/glop_test.$O:$(EX_DIR)/tests/glop_test.cc $(GEN_DIR)/glop/parameters.pb.h $(SRC_DIR)/glop/lp_solver.h $(SRC_DIR)/glop/basis_representation.h $(SRC_DIR)/glop/preprocessor.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests$Sglop_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sglop_test.$O
+
+$(BIN_DIR)/glop_test$E: $(OBJ_DIR)/glop/glop_test.$O $(STATIC_LP_DEPS)
+	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Sglop_test.$O $(STATIC_LP_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sglop_test$E
+
 
 # DIMACS challenge problem format library
 
@@ -1302,7 +1353,7 @@ $(OBJ_DIR)/acp_challenge_routing.$O:$(EX_DIR)/cpp/acp_challenge_routing.cc $(SRC
 $(BIN_DIR)/acp_challenge_routing$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/acp_challenge_routing.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/acp_challenge_routing.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sacp_challenge_routing$E
 
-$(OBJ_DIR)/costas_array.$O: $(EX_DIR)/cpp/costas_array.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+$(OBJ_DIR)/costas_array.$O: $(EX_DIR)/cpp/costas_array.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/parallel_search.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/costas_array.cc $(OBJ_OUT)$(OBJ_DIR)$Scostas_array.$O
 
 $(BIN_DIR)/costas_array$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/costas_array.$O
@@ -1416,7 +1467,19 @@ $(OBJ_DIR)/pdptw.$O: $(EX_DIR)/cpp/pdptw.cc $(SRC_DIR)/constraint_solver/constra
 $(BIN_DIR)/pdptw$E: $(DYNAMIC_ROUTING_DEPS) $(OBJ_DIR)/pdptw.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/pdptw.$O $(DYNAMIC_ROUTING_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spdptw$E
 
-$(OBJ_DIR)/sports_scheduling.$O:$(EX_DIR)/cpp/sports_scheduling.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+$(OBJ_DIR)/propagation_benchmark.$O: $(EX_DIR)/cpp/propagation_benchmark.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/propagation_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Spropagation_benchmark.$O
+
+$(BIN_DIR)/propagation_benchmark$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/propagation_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/propagation_benchmark.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spropagation_benchmark$E
+
+$(OBJ_DIR)/rcpsp_benchmark.$O: $(EX_DIR)/cpp/rcpsp_benchmark.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/rcpsp_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Srcpsp_benchmark.$O
+
+$(BIN_DIR)/rcpsp_benchmark$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/rcpsp_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/rcpsp_benchmark.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Srcpsp_benchmark$E
+
+$(OBJ_DIR)/sports_scheduling.$O:$(EX_DIR)/cpp/sports_scheduling.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/parallel_search.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/sports_scheduling.cc $(OBJ_OUT)$(OBJ_DIR)$Ssports_scheduling.$O
 
 $(BIN_DIR)/sports_scheduling$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/sports_scheduling.$O
@@ -1478,6 +1541,30 @@ $(OBJ_DIR)/boolean_test.$O:$(EX_DIR)/tests/boolean_test.cc $(SRC_DIR)/constraint
 $(BIN_DIR)/boolean_test$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/boolean_test.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/boolean_test.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sboolean_test$E
 
+$(OBJ_DIR)/copy_restoration_test.$O:$(EX_DIR)/tests/copy_restoration_test.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/constraint_solveri.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/copy_restoration_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scopy_restoration_test.$O
+
+$(BIN_DIR)/copy_restoration_test$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/copy_restoration_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/copy_restoration_test.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scopy_restoration_test$E
+
+$(OBJ_DIR)/parallel_search_test.$O:$(EX_DIR)/tests/parallel_search_test.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/parallel_search.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/parallel_search_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sparallel_search_test.$O
+
+$(BIN_DIR)/parallel_search_test$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/parallel_search_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/parallel_search_test.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sparallel_search_test$E
+
+$(OBJ_DIR)/propagation_queue_test.$O:$(EX_DIR)/tests/propagation_queue_test.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/propagation_queue_test.cc $(OBJ_OUT)$(OBJ_DIR)$Spropagation_queue_test.$O
+
+$(BIN_DIR)/propagation_queue_test$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/propagation_queue_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/propagation_queue_test.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spropagation_queue_test$E
+
+$(OBJ_DIR)/cumulative_test.$O:$(EX_DIR)/tests/cumulative_test.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/cumulative_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scumulative_test.$O
+
+$(BIN_DIR)/cumulative_test$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/cumulative_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/cumulative_test.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scumulative_test$E
+
 $(OBJ_DIR)/ls_api.$O:$(EX_DIR)/cpp/ls_api.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/ls_api.cc $(OBJ_OUT)$(OBJ_DIR)$Sls_api.$O
 
@@ -1526,17 +1613,19 @@ $(BIN_DIR)/integer_programming$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/integer_programm
 
 # Sat solver
 
-sat: bin/sat_runner$E
+sat: bin/sat_runner$E $(BIN_DIR)/clause_arena_benchmark$E $(BIN_DIR)/pb_propagation_benchmark$E $(BIN_DIR)/sat_solver_test$E $(BIN_DIR)/sat_portfolio_test$E
 
 SAT_LIB_OBJS = \
 	$(OBJ_DIR)/sat/boolean_problem.$O\
 	$(OBJ_DIR)/sat/boolean_problem.pb.$O \
 	$(OBJ_DIR)/sat/clause.$O\
+	$(OBJ_DIR)/sat/drat_writer.$O\
 	$(OBJ_DIR)/sat/encoding.$O\
 	$(OBJ_DIR)/sat/lp_utils.$O\
 	$(OBJ_DIR)/sat/optimization.$O\
 	$(OBJ_DIR)/sat/pb_constraint.$O\
 	$(OBJ_DIR)/sat/sat_parameters.pb.$O\
+	$(OBJ_DIR)/sat/sat_portfolio.$O\
 	$(OBJ_DIR)/sat/sat_solver.$O\
 	$(OBJ_DIR)/sat/simplification.$O\
 	$(OBJ_DIR)/sat/symmetry.$O\
@@ -1544,13 +1633,16 @@ SAT_LIB_OBJS = \
 
 satlibs: $(DYNAMIC_SAT_DEPS) $(STATIC_SAT_DEPS)
 
-$(OBJ_DIR)/sat/sat_solver.$O: $(SRC_DIR)/sat/sat_solver.cc $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/clause.h $(SRC_DIR)/sat/encoding.h $(SRC_DIR)/sat/unsat_proof.h $(GEN_DIR)/sat/sat_parameters.pb.h
+$(OBJ_DIR)/sat/sat_solver.$O: $(SRC_DIR)/sat/sat_solver.cc $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/clause.h $(SRC_DIR)/sat/drat_writer.h $(SRC_DIR)/sat/encoding.h $(SRC_DIR)/sat/unsat_proof.h $(SRC_DIR)/sat/sat_portfolio.h $(SRC_DIR)/sat/simplification.h $(GEN_DIR)/sat/sat_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/sat_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_solver.$O
 
+$(OBJ_DIR)/sat/sat_portfolio.$O: $(SRC_DIR)/sat/sat_portfolio.cc $(SRC_DIR)/sat/sat_portfolio.h $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/sat_portfolio.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_portfolio.$O
+
 $(OBJ_DIR)/sat/lp_utils.$O: $(SRC_DIR)/sat/lp_utils.cc $(SRC_DIR)/sat/lp_utils.h $(SRC_DIR)/sat/sat_solver.h $(GEN_DIR)/sat/sat_parameters.pb.h $(GEN_DIR)/glop/parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/lp_utils.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Slp_utils.$O
 
-$(OBJ_DIR)/sat/simplification.$O: $(SRC_DIR)/sat/simplification.cc  $(SRC_DIR)/sat/simplification.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
+$(OBJ_DIR)/sat/simplification.$O: $(SRC_DIR)/sat/simplification.cc  $(SRC_DIR)/sat/simplification.h $(SRC_DIR)/sat/drat_writer.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/simplification.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssimplification.$O
 
 $(OBJ_DIR)/sat/boolean_problem.$O: $(SRC_DIR)/sat/boolean_problem.cc  $(SRC_DIR)/sat/boolean_problem.h $(GEN_DIR)/sat/boolean_problem.pb.h  $(SRC_DIR)/sat/sat_solver.h  $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
@@ -1567,6 +1659,9 @@ $(OBJ_DIR)/sat/boolean_problem.pb.$O: $(GEN_DIR)/sat/boolean_problem.pb.cc $(GEN
 $(OBJ_DIR)/sat/clause.$O: $(SRC_DIR)/sat/clause.cc $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/clause.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/clause.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Sclause.$O
 
+$(OBJ_DIR)/sat/drat_writer.$O: $(SRC_DIR)/sat/drat_writer.cc $(SRC_DIR)/sat/drat_writer.h $(SRC_DIR)/sat/sat_base.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/drat_writer.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Sdrat_writer.$O
+
 $(OBJ_DIR)/sat/encoding.$O: $(SRC_DIR)/sat/encoding.cc $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/encoding.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/encoding.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Sencoding.$O
 
@@ -1598,12 +1693,36 @@ $(LIB_DIR)/$(LIBPREFIX)sat.$(STATIC_LIB_SUFFIX): $(SAT_LIB_OBJS)
 	$(STATIC_LINK_CMD) $(STATIC_LINK_PREFIX)$(LIB_DIR)$S$(LIBPREFIX)sat.$(STATIC_LIB_SUFFIX) $(SAT_LIB_OBJS)
 endif
 
-$(OBJ_DIR)/sat/sat_runner.$O:$(EX_DIR)/cpp/sat_runner.cc $(SRC_DIR)/sat/sat_solver.h $(EX_DIR)/cpp/opb_reader.h $(EX_DIR)/cpp/sat_cnf_reader.h $(GEN_DIR)/sat/sat_parameters.pb.h  $(GEN_DIR)/sat/boolean_problem.pb.h  $(SRC_DIR)/sat/boolean_problem.h  $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/simplification.h
+$(OBJ_DIR)/sat/sat_runner.$O:$(EX_DIR)/cpp/sat_runner.cc $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_portfolio.h $(SRC_DIR)/base/mapped_file.h $(EX_DIR)/cpp/mapped_file.h $(EX_DIR)/cpp/opb_reader.h $(EX_DIR)/cpp/sat_cnf_reader.h $(GEN_DIR)/sat/sat_parameters.pb.h  $(GEN_DIR)/sat/boolean_problem.pb.h  $(SRC_DIR)/sat/boolean_problem.h  $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/simplification.h $(SRC_DIR)/sat/drat_writer.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Ssat_runner.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_runner.$O
 
 $(BIN_DIR)/sat_runner$E: $(STATIC_SAT_DEPS) $(OBJ_DIR)/sat/sat_runner.$O
 	$(CCC) $(CFLAGS) $(FZ_STATIC) $(OBJ_DIR)$Ssat$Ssat_runner.$O $(STATIC_SAT_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssat_runner$E
 
+$(OBJ_DIR)/sat/sat_solver_test.$O:$(EX_DIR)/tests/sat_solver_test.cc $(SRC_DIR)/sat/drat_writer.h $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/simplification.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests$Ssat_solver_test.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_solver_test.$O
+
+$(BIN_DIR)/sat_solver_test$E: $(STATIC_SAT_DEPS) $(OBJ_DIR)/sat/sat_solver_test.$O
+	$(CCC) $(CFLAGS) $(FZ_STATIC) $(OBJ_DIR)$Ssat$Ssat_solver_test.$O $(STATIC_SAT_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssat_solver_test$E
+
+$(OBJ_DIR)/sat/sat_portfolio_test.$O:$(EX_DIR)/tests/sat_portfolio_test.cc $(SRC_DIR)/sat/sat_portfolio.h $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests$Ssat_portfolio_test.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_portfolio_test.$O
+
+$(BIN_DIR)/sat_portfolio_test$E: $(STATIC_SAT_DEPS) $(OBJ_DIR)/sat/sat_portfolio_test.$O
+	$(CCC) $(CFLAGS) $(FZ_STATIC) $(OBJ_DIR)$Ssat$Ssat_portfolio_test.$O $(STATIC_SAT_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssat_portfolio_test$E
+
+$(OBJ_DIR)/sat/clause_arena_benchmark.$O:$(EX_DIR)/cpp/clause_arena_benchmark.cc $(SRC_DIR)/sat/clause.h $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Sclause_arena_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Sclause_arena_benchmark.$O
+
+$(BIN_DIR)/clause_arena_benchmark$E: $(STATIC_SAT_DEPS) $(OBJ_DIR)/sat/clause_arena_benchmark.$O
+	$(CCC) $(CFLAGS) $(FZ_STATIC) $(OBJ_DIR)$Ssat$Sclause_arena_benchmark.$O $(STATIC_SAT_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sclause_arena_benchmark$E
+
+$(OBJ_DIR)/sat/pb_propagation_benchmark.$O:$(EX_DIR)/cpp/pb_propagation_benchmark.cc $(SRC_DIR)/sat/pb_constraint.h $(SRC_DIR)/sat/sat_base.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp$Spb_propagation_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Spb_propagation_benchmark.$O
+
+$(BIN_DIR)/pb_propagation_benchmark$E: $(STATIC_SAT_DEPS) $(OBJ_DIR)/sat/pb_propagation_benchmark.$O
+	$(CCC) $(CFLAGS) $(FZ_STATIC) $(OBJ_DIR)$Ssat$Spb_propagation_benchmark.$O $(STATIC_SAT_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spb_propagation_benchmark$E
+
 # Bop solver
 BOP_LIB_OBJS = \
 	$(OBJ_DIR)/bop/bop_base.$O\
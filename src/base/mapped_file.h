@@ -0,0 +1,92 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A read-only memory mapping of a whole file, used by the readers of the big
+// text files (MPS, cnf, opb...) to parse them without copying them line by
+// line.
+
+#ifndef OR_TOOLS_BASE_MAPPED_FILE_H_
+#define OR_TOOLS_BASE_MAPPED_FILE_H_
+
+#if defined(__GNUC__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
+
+#include <string>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strutil.h"
+
+namespace operations_research {
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  MappedFile() : data_(nullptr), size_(0) {}
+  ~MappedFile() {
+#ifdef HAVE_MMAP
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+#endif
+  }
+
+  // Returns false if the file can't be mapped, in which case the callers
+  // should fall back to reading it line by line. This is always the case for
+  // compressed or empty files, and if mmap() is not available.
+  bool Open(const std::string& filename) {
+#ifdef HAVE_MMAP
+    if (HasSuffixString(filename, ".gz") || HasSuffixString(filename, ".bz2")) {
+      return false;
+    }
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    struct stat sbuf;
+    if (fstat(fd, &sbuf) == -1 || sbuf.st_size == 0) {
+      close(fd);
+      return false;
+    }
+    void* const data =
+        mmap(nullptr, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      LOG(WARNING) << "Cannot mmap file " << filename;
+      return false;
+    }
+    madvise(data, sbuf.st_size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+    size_ = sbuf.st_size;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  int64 size() const { return size_; }
+
+ private:
+  const char* data_;
+  int64 size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_BASE_MAPPED_FILE_H_
@@ -25,6 +25,7 @@
 #include "sat/boolean_problem.h"
 #include "sat/lp_utils.h"
 #include "sat/optimization.h"
+#include "sat/sat_portfolio.h"
 #include "sat/sat_solver.h"
 #include "util/bitset.h"
 
@@ -136,14 +137,43 @@ BopOptimizerBase::Status BopSatObjectiveFirstSolutionGenerator::Optimize(
   sat_parameters.set_max_deterministic_time(
       std::min(time_limit->GetDeterministicTimeLeft(),
           time_limit_ratio_ * time_limit->GetDeterministicTimeLeft()));
+  sat_parameters.set_num_search_workers(parameters.num_sat_search_workers());
   sat_solver_->SetParameters(sat_parameters);
 
   // Doubling the time limit for the next call to Optimize().
   if (first_solve_) time_limit_ratio_ *= 2.0;
 
-  const sat::SatSolver::Status sat_status = sat_solver_->Solve();
-  time_limit->AdvanceDeterministicTime(sat_solver_->deterministic_time() -
-                                       initial_deterministic_time);
+  // In portfolio mode, sat_solver_ is the first worker, and the other ones
+  // are loaded with the same problem just for this solve.
+  sat::SatSolver* solution_solver = sat_solver_.get();
+  std::vector<std::unique_ptr<sat::SatSolver>> other_workers;
+  sat::SatSolver::Status sat_status = sat::SatSolver::LIMIT_REACHED;
+  if (sat_parameters.num_search_workers() > 1) {
+    std::vector<sat::SatSolver*> workers(1, sat_solver_.get());
+    for (int i = 1; i < sat_parameters.num_search_workers(); ++i) {
+      other_workers.emplace_back(new sat::SatSolver());
+      const BopOptimizerBase::Status load_status = LoadStateProblemToSatSolver(
+          problem_state, other_workers.back().get());
+      if (load_status != BopOptimizerBase::CONTINUE) return load_status;
+      UseObjectiveForSatAssignmentPreference(problem_state.original_problem(),
+                                             other_workers.back().get());
+      workers.push_back(other_workers.back().get());
+    }
+    int first_to_finish = -1;
+    sat_status =
+        sat::SolveWithPortfolio(sat_parameters, workers, &first_to_finish);
+    if (first_to_finish >= 0) solution_solver = workers[first_to_finish];
+  } else {
+    sat_status = sat_solver_->Solve();
+  }
+  // All the workers of a portfolio worked for this solve, so their
+  // deterministic times are all charged.
+  double deterministic_time =
+      sat_solver_->deterministic_time() - initial_deterministic_time;
+  for (const std::unique_ptr<sat::SatSolver>& worker : other_workers) {
+    deterministic_time += worker->deterministic_time();
+  }
+  time_limit->AdvanceDeterministicTime(deterministic_time);
 
   if (sat_status == sat::SatSolver::MODEL_UNSAT) {
     if (upper_bound_ != kint64max) {
@@ -155,8 +185,8 @@ BopOptimizerBase::Status BopSatObjectiveFirstSolutionGenerator::Optimize(
     return BopOptimizerBase::INFEASIBLE;
   }
   if (sat_status == sat::SatSolver::MODEL_SAT) {
-    ExtractLearnedInfoFromSatSolver(sat_solver_.get(), learned_info);
-    SatAssignmentToBopSolution(sat_solver_->Assignment(),
+    ExtractLearnedInfoFromSatSolver(solution_solver, learned_info);
+    SatAssignmentToBopSolution(solution_solver->Assignment(),
                                &learned_info->solution);
     return SolutionStatus(learned_info->solution, lower_bound_);
   }
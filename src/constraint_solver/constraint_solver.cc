@@ -55,6 +55,9 @@ DEFINE_bool(cp_verbose_fail, false, "Verbose output when failing.");
 DEFINE_bool(cp_name_variables, false, "Force all variables to have names.");
 DEFINE_bool(cp_name_cast_variables, false,
             "Name variables casted from expressions");
+DEFINE_bool(cp_copy_restoration, false,
+            "Restore the arrays of reversible words by adaptive copies "
+            "instead of saving each modified word on the trail.");
 
 void ConstraintSolverFailsHere() { VLOG(3) << "Fail"; }
 
@@ -73,7 +76,8 @@ SolverParameters::SolverParameters()
       store_names(kDefaultNameStoring),
       profile_level(kDefaultProfileLevel),
       trace_level(kDefaultTraceLevel),
-      name_all_variables(kDefaultNameAllVariables) {}
+      name_all_variables(kDefaultNameAllVariables),
+      state_restoration(kDefaultStateRestoration) {}
 
 // ----- Forward Declarations and Profiling Support -----
 extern DemonProfiler* BuildDemonProfiler(Solver* const solver);
@@ -128,76 +132,66 @@ std::string Action::DebugString() const { return "Action"; }
 // ------------------ Queue class ------------------
 
 namespace {
-class FifoPriorityQueue {
+// A FIFO of demons stored in a ring buffer whose capacity is a power of two.
+// The buffer only grows, so a warm queue never allocates, and clearing it
+// after a failure only resets two indices. Contrary to a linked list of
+// cells, consecutive demons are contiguous in memory.
+class DemonFifo {
  public:
-  struct Cell {
-    explicit Cell(Demon* const d) : demon(d), next(nullptr) {}
-    Demon* demon;
-    Cell* next;
-  };
+  static const int kInitialCapacity = 64;
 
-  FifoPriorityQueue() : first_(nullptr), last_(nullptr), free_cells_(nullptr) {}
+  DemonFifo()
+      : demons_(new Demon* [kInitialCapacity]),
+        mask_(kInitialCapacity - 1),
+        head_(0),
+        size_(0) {}
 
-  ~FifoPriorityQueue() {
-    while (first_ != nullptr) {
-      Cell* const tmp = first_;
-      first_ = tmp->next;
-      delete tmp;
-    }
-    while (free_cells_ != nullptr) {
-      Cell* const tmp = free_cells_;
-      free_cells_ = tmp->next;
-      delete tmp;
-    }
-  }
+  ~DemonFifo() { delete[] demons_; }
 
   Demon* Next() {
-    if (first_ != nullptr) {
-      DCHECK(last_ != nullptr);
-      Cell* const tmp_cell = first_;
-      Demon* const demon = tmp_cell->demon;
-      first_ = tmp_cell->next;
-      if (first_ == nullptr) {
-        last_ = nullptr;
-      }
-      tmp_cell->next = free_cells_;
-      free_cells_ = tmp_cell;
-      return demon;
+    if (size_ == 0) {
+      return nullptr;
     }
-    return nullptr;
+    Demon* const demon = demons_[head_];
+    head_ = (head_ + 1) & mask_;
+    --size_;
+    return demon;
   }
 
   void Enqueue(Demon* const d) {
-    Cell* cell = free_cells_;
-    if (cell != nullptr) {
-      cell->demon = d;
-      free_cells_ = cell->next;
-      cell->next = nullptr;
-    } else {
-      cell = new Cell(d);
-    }
-    if (last_ != nullptr) {
-      last_->next = cell;
-      last_ = cell;
-    } else {
-      first_ = cell;
-      last_ = cell;
+    if (size_ > mask_) {
+      Grow();
     }
+    demons_[(head_ + size_) & mask_] = d;
+    ++size_;
   }
 
   void AfterFailure() {
-    if (first_ != nullptr) {
-      last_->next = free_cells_;
-      free_cells_ = first_;
-      first_ = nullptr;
-      last_ = nullptr;
-    }
+    head_ = 0;
+    size_ = 0;
   }
 
  private:
-  Cell* first_;
-  Cell* last_;
-  Cell* free_cells_;
+  // Doubles the capacity of the buffer, and moves the demons at its
+  // beginning.
+  void Grow() {
+    const uint32 capacity = mask_ + 1;
+    Demon** const demons = new Demon* [2 * capacity];
+    for (uint32 i = 0; i < size_; ++i) {
+      demons[i] = demons_[(head_ + i) & mask_];
+    }
+    delete[] demons_;
+    demons_ = demons;
+    mask_ = 2 * capacity - 1;
+    head_ = 0;
+  }
+
+  Demon** demons_;
+  uint32 mask_;
+  uint32 head_;
+  uint32 size_;
+
+  DISALLOW_COPY_AND_ASSIGN(DemonFifo);
 };
 }  // namespace
 
@@ -212,18 +206,9 @@ class Queue {
         in_process_(false),
         clear_action_(nullptr),
         in_add_(false),
-        instruments_demons_(s->InstrumentsDemons()) {
-    for (int i = 0; i < Solver::kNumPriorities; ++i) {
-      containers_[i] = new FifoPriorityQueue();
-    }
-  }
+        instruments_demons_(s->InstrumentsDemons()) {}
 
-  ~Queue() {
-    for (int i = 0; i < Solver::kNumPriorities; ++i) {
-      delete containers_[i];
-      containers_[i] = nullptr;
-    }
-  }
+  ~Queue() {}
 
   void Freeze() {
     freeze_level_++;
@@ -236,17 +221,20 @@ class Queue {
     }
   }
 
-  void ProcessOneDemon(Demon* const demon) {
+  // Runs a demon popped from the queue of the given priority. The priority
+  // is known from the queue, which saves a virtual call per demon.
+  void ProcessOneDemon(Demon* const demon, Solver::DemonPriority priority) {
+    DCHECK_EQ(demon->priority(), priority);
     demon->set_stamp(stamp_ - 1);
     if (!instruments_demons_) {
-      if (++solver_->demon_runs_[demon->priority()] % kTestPeriod == 0) {
+      if (++solver_->demon_runs_[priority] % kTestPeriod == 0) {
         solver_->TopPeriodicCheck();
       }
       demon->Run(solver_);
       solver_->CheckFail();
     } else {
       solver_->GetPropagationMonitor()->BeginDemonRun(demon);
-      if (++solver_->demon_runs_[demon->priority()] % kTestPeriod == 0) {
+      if (++solver_->demon_runs_[priority] % kTestPeriod == 0) {
         solver_->TopPeriodicCheck();
       }
       demon->Run(solver_);
@@ -276,10 +264,17 @@ class Queue {
   void Process() {
     if (!in_process_) {
       in_process_ = true;
-      Demon* d = nullptr;
-      while ((d = containers_[Solver::VAR_PRIORITY]->Next()) != nullptr ||
-             (d = containers_[Solver::DELAYED_PRIORITY]->Next()) != nullptr) {
-        ProcessOneDemon(d);
+      // Variable demons are run first, and a delayed demon is only run when
+      // the queue of the variables is empty.
+      for (;;) {
+        Demon* d = var_queue_.Next();
+        if (d != nullptr) {
+          ProcessOneDemon(d, Solver::VAR_PRIORITY);
+          continue;
+        }
+        d = delayed_queue_.Next();
+        if (d == nullptr) break;
+        ProcessOneDemon(d, Solver::DELAYED_PRIORITY);
       }
       in_process_ = false;
     }
@@ -296,7 +291,7 @@ class Queue {
       } else {
         DCHECK_EQ(demon->priority(), Solver::DELAYED_PRIORITY);
         demon->set_stamp(stamp_);
-        containers_[Solver::DELAYED_PRIORITY]->Enqueue(demon);
+        delayed_queue_.Enqueue(demon);
       }
     }
   }
@@ -331,7 +326,7 @@ class Queue {
       Demon* const demon = *it;
       DCHECK_EQ(demon->priority(), Solver::DELAYED_PRIORITY);
       demon->set_stamp(stamp_);
-      containers_[Solver::DELAYED_PRIORITY]->Enqueue(demon);
+      delayed_queue_.Enqueue(demon);
     }
   }
 
@@ -339,7 +334,7 @@ class Queue {
     DCHECK(demon->priority() == Solver::VAR_PRIORITY);
     if (demon->stamp() < stamp_) {
       demon->set_stamp(stamp_);
-      containers_[Solver::VAR_PRIORITY]->Enqueue(demon);
+      var_queue_.Enqueue(demon);
       if (freeze_level_ == 0) {
         Process();
       }
@@ -350,14 +345,13 @@ class Queue {
     DCHECK(demon->priority() == Solver::DELAYED_PRIORITY);
     if (demon->stamp() < stamp_) {
       demon->set_stamp(stamp_);
-      containers_[Solver::DELAYED_PRIORITY]->Enqueue(demon);
+      delayed_queue_.Enqueue(demon);
     }
   }
 
   void AfterFailure() {
-    for (int i = 0; i < Solver::kNumPriorities; ++i) {
-      containers_[i]->AfterFailure();
-    }
+    var_queue_.AfterFailure();
+    delayed_queue_.AfterFailure();
     if (clear_action_ != nullptr) {
       clear_action_->Run(solver_);
       clear_action_ = nullptr;
@@ -398,7 +392,10 @@ class Queue {
 
  private:
   Solver* const solver_;
-  FifoPriorityQueue* containers_[Solver::kNumPriorities];
+  // The demons waiting to be run. Demons of normal priority are run as soon
+  // as they are executed, and are never queued.
+  DemonFifo var_queue_;
+  DemonFifo delayed_queue_;
   uint64 stamp_;
   // The number of nested freeze levels. The queue is frozen if and only if
   // freeze_level_ > 0.
@@ -448,6 +445,8 @@ struct StateMarker {
   int rev_object_array_memory_index_;
   int rev_memory_index_;
   int rev_memory_array_index_;
+  int rev_block_index_;
+  uint64 previous_marker_stamp_;
   StateInfo info_;
 };
 
@@ -465,6 +464,8 @@ StateMarker::StateMarker(Solver::MarkerType t, const StateInfo& info)
       rev_double_memory_index_(0),
       rev_object_memory_index_(0),
       rev_object_array_memory_index_(0),
+      rev_block_index_(0),
+      previous_marker_stamp_(0),
       info_(info) {}
 
 // ---------- Trail and Reversibility ----------
@@ -696,6 +697,14 @@ class CompressedTrail {
 
 extern void RestoreBoolValue(IntVar* const var);
 
+// A block of memory copied on the trail by Solver::SaveArray(). The copies
+// of the blocks are stored contiguously, in the same order, in
+// Trail::rev_block_data_.
+struct RevBlock {
+  void* address;
+  int size;
+};
+
 struct Trail {
   CompressedTrail<int> rev_ints_;
   CompressedTrail<int64> rev_int64s_;
@@ -712,6 +721,8 @@ struct Trail {
   std::vector<BaseObject**> rev_object_array_memory_;
   std::vector<void*> rev_memory_;
   std::vector<void**> rev_memory_array_;
+  std::vector<RevBlock> rev_blocks_;
+  std::vector<char> rev_block_data_;
 
   Trail(int block_size, SolverParameters::TrailCompression compression_level)
       : rev_ints_(block_size, compression_level),
@@ -768,6 +779,16 @@ struct Trail {
     }
     rev_boolvar_list_.resize(target);
 
+    target = m->rev_block_index_;
+    int data_size = rev_block_data_.size();
+    for (int curr = rev_blocks_.size() - 1; curr >= target; --curr) {
+      const RevBlock& block = rev_blocks_[curr];
+      data_size -= block.size;
+      memcpy(block.address, rev_block_data_.data() + data_size, block.size);
+    }
+    rev_blocks_.resize(target);
+    rev_block_data_.resize(data_size);
+
     DCHECK_EQ(rev_bools_.size(), rev_bool_value_.size());
     target = m->rev_bools_index_;
     for (int curr = rev_bools_.size() - 1; curr >= target; --curr) {
@@ -825,6 +846,16 @@ struct Trail {
     }
     rev_memory_array_.resize(target);
   }
+
+  // Number of entries of the trail.
+  int64 size() const {
+    return rev_ints_.size() + rev_int64s_.size() + rev_uint64s_.size() +
+           rev_doubles_.size() + rev_ptrs_.size() + rev_boolvar_list_.size() +
+           rev_bools_.size() + rev_int_memory_.size() +
+           rev_int64_memory_.size() + rev_double_memory_.size() +
+           rev_object_memory_.size() + rev_object_array_memory_.size() +
+           rev_memory_.size() + rev_memory_array_.size() + rev_blocks_.size();
+  }
 };
 
 void Solver::InternalSaveValue(int* valptr) {
@@ -855,6 +886,17 @@ void Solver::InternalSaveValue(bool* valptr) {
   trail_->rev_bool_value_.push_back(*valptr);
 }
 
+void Solver::InternalSaveBlock(void* address, int size) {
+  RevBlock block;
+  block.address = address;
+  block.size = size;
+  trail_->rev_blocks_.push_back(block);
+  const char* const data = reinterpret_cast<const char*>(address);
+  trail_->rev_block_data_.insert(trail_->rev_block_data_.end(), data,
+                                 data + size);
+  copied_bytes_ += size;
+}
+
 BaseObject* Solver::SafeRevAlloc(BaseObject* ptr) {
   check_alloc_state();
   trail_->rev_object_memory_.push_back(ptr);
@@ -1424,6 +1466,17 @@ void Solver::Init() {
   neighbors_ = 0;
   filtered_neighbors_ = 0;
   accepted_neighbors_ = 0;
+  max_trail_size_ = 0;
+  copied_bytes_ = 0;
+  backtracks_ = 0;
+  backtrack_time_ = 0;
+  trail_stamp_ = GG_ULONGLONG(1);
+  marker_stamp_ = trail_stamp_;
+  use_copy_restoration_ =
+      parameters_.state_restoration ==
+          SolverParameters::ADAPTIVE_COPY_RESTORATION ||
+      FLAGS_cp_copy_restoration;
+  deterministic_time_ = 0.0;
   variable_cleaner_.reset(NewDomainIntVarCleaner());
   timer_.reset(new ClockTimer);
   searches_.assign(1, new Search(this, 0));
@@ -1482,6 +1535,9 @@ const SolverParameters::ProfileLevel SolverParameters::kDefaultProfileLevel =
 const SolverParameters::TraceLevel SolverParameters::kDefaultTraceLevel =
     SolverParameters::NO_TRACE;
 const bool SolverParameters::kDefaultNameAllVariables = false;
+const SolverParameters::StateRestoration
+SolverParameters::kDefaultStateRestoration =
+    SolverParameters::TRAIL_RESTORATION;
 
 std::string Solver::DebugString() const {
   std::string out = "Solver(name = \"" + name_ + "\", state = ";
@@ -1510,10 +1566,16 @@ std::string Solver::DebugString() const {
                       "d, delayed demon runs = %" GG_LL_FORMAT
                       "d, var demon runs = %" GG_LL_FORMAT
                       "d, normal demon runs = %" GG_LL_FORMAT
-                      "d, Run time = %" GG_LL_FORMAT "d ms)",
+                      "d, trail size = %" GG_LL_FORMAT
+                      "d, max trail size = %" GG_LL_FORMAT
+                      "d, copied bytes = %" GG_LL_FORMAT
+                      "d, backtracks = %" GG_LL_FORMAT
+                      "d, backtrack time = %" GG_LL_FORMAT
+                      "d us, Run time = %" GG_LL_FORMAT "d ms)",
                 branches_, fails_, decisions_, demon_runs_[DELAYED_PRIORITY],
                 demon_runs_[VAR_PRIORITY], demon_runs_[NORMAL_PRIORITY],
-                wall_time());
+                trail_size(), max_trail_size_, copied_bytes_, backtracks_,
+                backtrack_time_ / 1000, wall_time());
   return out;
 }
 
@@ -1524,6 +1586,8 @@ int64 Solver::MemoryUsage() {
 
 int64 Solver::wall_time() const { return timer_->GetInMs(); }
 
+int64 Solver::trail_size() const { return trail_->size(); }
+
 int64 Solver::solutions() const { return TopLevelSearch()->solution_counter(); }
 
 void Solver::TopPeriodicCheck() { TopLevelSearch()->PeriodicCheck(); }
@@ -1558,6 +1622,15 @@ void Solver::PushState(Solver::MarkerType t, const StateInfo& info) {
     m->rev_object_array_memory_index_ = trail_->rev_object_array_memory_.size();
     m->rev_memory_index_ = trail_->rev_memory_.size();
     m->rev_memory_array_index_ = trail_->rev_memory_array_.size();
+    m->rev_block_index_ = trail_->rev_blocks_.size();
+    max_trail_size_ = std::max(max_trail_size_, trail_->size());
+    m->previous_marker_stamp_ = marker_stamp_;
+    trail_stamp_++;
+    // The states of a search which does not backtrack at its end are merged
+    // into the parent state.
+    if (searches_.back()->backtrack_at_the_end_of_the_search()) {
+      marker_stamp_ = trail_stamp_;
+    }
   }
   searches_.back()->marker_stack_.push_back(m);
   queue_->increase_stamp();
@@ -1574,7 +1647,16 @@ Solver::MarkerType Solver::PopState(StateInfo* info) {
   CHECK(info != nullptr);
   StateMarker* m = searches_.back()->marker_stack_.back();
   if (m->type_ != REVERSIBLE_ACTION || m->info_.int_info == 0) {
-    trail_->BacktrackTo(m);
+    if (use_copy_restoration_ || IsProfilingEnabled()) {
+      const int64 start_time = base::GetCurrentTimeNanos();
+      trail_->BacktrackTo(m);
+      backtrack_time_ += base::GetCurrentTimeNanos() - start_time;
+    } else {
+      trail_->BacktrackTo(m);
+    }
+    backtracks_++;
+    trail_stamp_++;
+    marker_stamp_ = m->previous_marker_stamp_;
   }
   Solver::MarkerType t = m->type_;
   (*info) = m->info_;
@@ -2428,6 +2510,9 @@ bool Solver::SolveAndCommit(DecisionBuilder* const db,
   NewSearch(db, monitors);
   searches_.back()->set_created_by_solve(true);  // Overwrites default.
   searches_.back()->set_backtrack_at_the_end_of_the_search(false);
+  // Merges the initial sentinel pushed by NewSearch() into the parent state.
+  marker_stamp_ =
+      searches_.back()->marker_stack_.back()->previous_marker_stamp_;
   NextSolution();
   const bool solution_found = searches_.back()->solution_counter() > 0;
   EndSearch();
@@ -174,6 +174,8 @@ struct SolverParameters {
 
   enum TraceLevel { NO_TRACE, NORMAL_TRACE };
 
+  enum StateRestoration { TRAIL_RESTORATION, ADAPTIVE_COPY_RESTORATION };
+
   static const TrailCompression kDefaultTrailCompression;
   static const int kDefaultTrailBlockSize;
   static const int kDefaultArraySplitSize;
@@ -181,6 +183,7 @@ struct SolverParameters {
   static const ProfileLevel kDefaultProfileLevel;
   static const TraceLevel kDefaultTraceLevel;
   static const bool kDefaultNameAllVariables;
+  static const StateRestoration kDefaultStateRestoration;
 
   SolverParameters();
 
@@ -211,6 +214,15 @@ struct SolverParameters {
 
   // Should anonymous variables be given a name.
   bool name_all_variables;
+
+  // This parameter indicates how the arrays of reversible words (domains of
+  // the variables stored as bitsets, reversible bitsets, active tuples of the
+  // table constraints) are restored upon backtrack. With TRAIL_RESTORATION,
+  // each modified word is saved on the trail. With ADAPTIVE_COPY_RESTORATION,
+  // an array whose words were densely modified after the previous choice
+  // point is copied as a whole at its first modification after the current
+  // one, and the trail is only used for the sparsely modified arrays.
+  StateRestoration state_restoration;
 };
 
 // This struct holds all parameters for the default search.
@@ -867,6 +879,14 @@ class Solver {
     InternalSaveValue(o);
   }
 
+  // SaveArray() will save a copy of the 'size' first elements of 'array',
+  //   which will be restored as a whole upon backtrack. It must be called
+  //   before modifying any of them. T must be a plain old data type.
+  template <class T>
+  void SaveArray(T* array, int size) {
+    InternalSaveBlock(array, size * sizeof(*array));
+  }
+
   // Registers the given object as being reversible. By calling this method, the
   // caller gives ownership of the object to the solver, which will delete it
   // when there is a backtrack out of the current state.
@@ -1061,6 +1081,16 @@ class Solver {
   // Loads the model into the solver, appends search monitors to monitors,
   // and returns true upon success.
   bool LoadModel(const CPModelProto& proto, std::vector<SearchMonitor*>* monitors);
+  // Loads the model into the solver, appends search monitors to monitors,
+  // and appends to the three vectors the variables of the variable groups of
+  // the model, i.e. the variables of the decision builder given to
+  // ExportModel(), in the order in which it visited them. Each of monitors,
+  // decision_vars, decision_intervals and decision_sequences can be nullptr.
+  // Returns true upon success.
+  bool LoadModel(const CPModelProto& proto, std::vector<SearchMonitor*>* monitors,
+                 std::vector<IntVar*>* decision_vars,
+                 std::vector<IntervalVar*>* decision_intervals,
+                 std::vector<SequenceVar*>* decision_sequences);
   // Upgrades the model to the latest version.
   static bool UpgradeModel(CPModelProto* const proto);
 
@@ -1120,6 +1150,18 @@ class Solver {
   // wall_time() in ms since the creation of the solver.
   int64 wall_time() const;
 
+  // deterministic time, in seconds, accounted for by the propagators that
+  // measure their work since the creation of the solver. Contrary to
+  // wall_time(), it only depends on the model and on the search.
+  double deterministic_time() const { return deterministic_time_; }
+
+  // Advances the deterministic time of the solver by the given duration, in
+  // seconds. This is called by the propagators to account for their work.
+  void AdvanceDeterministicTime(double duration) {
+    DCHECK_GE(duration, 0.0);
+    deterministic_time_ += duration;
+  }
+
   // number of branches explored since the creation of the solver.
   int64 branches() const { return branches_; }
 
@@ -1141,6 +1183,33 @@ class Solver {
   // number of accepted neighbors
   int64 accepted_neighbors() const { return accepted_neighbors_; }
 
+  // number of entries currently stored on the trail.
+  int64 trail_size() const;
+
+  // largest number of entries stored on the trail when a state was pushed.
+  int64 max_trail_size() const { return max_trail_size_; }
+
+  // number of bytes copied on the trail by SaveArray().
+  int64 copied_bytes() const { return copied_bytes_; }
+
+  // number of times the trail was restored to a previous state, and total
+  // time spent restoring it, in nanoseconds. The time is only measured when
+  // profiling or with SolverParameters::ADAPTIVE_COPY_RESTORATION.
+  int64 backtracks() const { return backtracks_; }
+  int64 backtrack_time() const { return backtrack_time_; }
+
+  // The trail_stamp() is incremented each time a state is pushed on or
+  // restored from the trail. Contrary to stamp(), it does not change during
+  // the propagation.
+  uint64 trail_stamp() const { return trail_stamp_; }
+
+  // The marker_stamp() is the trail_stamp() of the innermost state pushed on
+  // the trail: the next backtrack restores all the entries saved since the
+  // trail stamp reached it. The states of a nested search which does not
+  // backtrack at its end are merged into the parent state when it ends, so
+  // the marker_stamp() stays the one of the parent state during this search.
+  uint64 marker_stamp() const { return marker_stamp_; }
+
   // The stamp indicates how many moves in the search tree we have performed.
   // It is useful to detect if we need to update same lazy structures.
   uint64 stamp() const;
@@ -2876,6 +2945,9 @@ class Solver {
   bool InstrumentsVariables() const;
   // Returns whether all variables should be named.
   bool NameAllVariables() const;
+  // Returns whether the arrays of reversible words are restored by adaptive
+  // copies (see SolverParameters::state_restoration).
+  bool UseCopyRestoration() const { return use_copy_restoration_; }
   // Returns the name of the model.
   std::string model_name() const;
   // Returns the dependency graph of the solver.
@@ -2974,6 +3046,7 @@ class Solver {
   void InternalSaveValue(int64** valptr) {
     InternalSaveValue(reinterpret_cast<void**>(valptr));
   }
+  void InternalSaveBlock(void* address, int size);
 
   BaseObject* SafeRevAlloc(BaseObject* ptr);
 
@@ -3049,6 +3122,14 @@ class Solver {
   int64 neighbors_;
   int64 filtered_neighbors_;
   int64 accepted_neighbors_;
+  int64 max_trail_size_;
+  int64 copied_bytes_;
+  int64 backtracks_;
+  int64 backtrack_time_;
+  uint64 trail_stamp_;
+  uint64 marker_stamp_;
+  bool use_copy_restoration_;
+  double deterministic_time_;
   std::unique_ptr<Action> variable_cleaner_;
   std::unique_ptr<ClockTimer> timer_;
   std::vector<Search*> searches_;
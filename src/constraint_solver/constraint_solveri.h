@@ -415,6 +415,55 @@ class RevSwitch {
   bool value_;
 };
 
+// Saves the words of a reversible array of 64 bit words before they are
+// modified, as requested by SolverParameters::state_restoration. In the
+// adaptive mode, the array is copied as a whole at its first modification
+// after a state was pushed or restored if at least 1/kCopyDensity of its
+// words were modified the last time it was modified, and each modified word
+// is saved on the trail otherwise. The mode is only changed when the trail
+// stamp changes. As the saved words of an array are restored before its
+// copies, the array is never copied once one of its words was saved since
+// the state that the next backtrack restores was pushed, see
+// Solver::marker_stamp().
+class RevWordArraySaver {
+ public:
+  static const int kCopyDensity = 4;
+
+  RevWordArraySaver()
+      : trail_stamp_(0), word_stamp_(0), modified_words_(0), copied_(false) {}
+
+  // Saves words[offset], where words is an array of 'size' words, before its
+  // first modification since the last increment of the solver stamp.
+  void SaveWord(Solver* const solver, uint64* const words, int size,
+                int offset) {
+    if (!solver->UseCopyRestoration()) {
+      solver->SaveValue(&words[offset]);
+      return;
+    }
+    if (solver->trail_stamp() != trail_stamp_) {
+      trail_stamp_ = solver->trail_stamp();
+      copied_ = modified_words_ * kCopyDensity >= size &&
+                word_stamp_ < solver->marker_stamp();
+      modified_words_ = 0;
+      if (copied_) {
+        solver->SaveArray(words, size);
+      }
+    }
+    ++modified_words_;
+    if (!copied_) {
+      word_stamp_ = trail_stamp_;
+      solver->SaveValue(&words[offset]);
+    }
+  }
+
+ private:
+  uint64 trail_stamp_;
+  // Trail stamp of the last word saved on the trail.
+  uint64 word_stamp_;
+  int modified_words_;
+  bool copied_;
+};
+
 // This class represents a small reversible bitset (size <= 64).
 // This class is useful to maintain supports.
 class SmallRevBitSet {
@@ -474,6 +523,7 @@ class RevBitSet {
   const int64 length_;
   uint64* bits_;
   uint64* stamps_;
+  RevWordArraySaver saver_;
 };
 
 // Matrix version of the RevBitSet class.
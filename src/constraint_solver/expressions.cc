@@ -1723,7 +1723,7 @@ class SimpleBitSet : public DomainIntVar::BitSet {
     const uint64 current_stamp = solver_->stamp();
     if (stamps_[offset] < current_stamp) {
       stamps_[offset] = current_stamp;
-      solver_->SaveValue(&bits_[offset]);
+      saver_.SaveWord(solver_, bits_, bsize_, offset);
     }
     const int pos = BitPos64(val_offset);
     bits_[offset] &= ~OneBit64(pos);
@@ -1812,6 +1812,7 @@ class SimpleBitSet : public DomainIntVar::BitSet {
  private:
   uint64* bits_;
   uint64* stamps_;
+  RevWordArraySaver saver_;
   const int64 omin_;
   const int64 omax_;
   NumericalRev<int64> size_;
@@ -62,6 +62,8 @@ class CPModelLoader {
   IntExpr* IntegerExpression(int index) const;
   // Returns stored interval variable.
   IntervalVar* IntervalVariable(int index) const;
+  // Returns stored sequence variable.
+  SequenceVar* SequenceVariable(int index) const;
 
   bool ScanOneArgument(int type_index, const CPArgumentProto& arg_proto,
                        int64* to_fill);
@@ -2361,6 +2363,13 @@ IntervalVar* CPModelLoader::IntervalVariable(int index) const {
   return intervals_[index];
 }
 
+SequenceVar* CPModelLoader::SequenceVariable(int index) const {
+  CHECK_GE(index, 0);
+  CHECK_LT(index, sequences_.size());
+  CHECK(sequences_[index] != nullptr);
+  return sequences_[index];
+}
+
 bool CPModelLoader::ScanOneArgument(int type_index,
                                     const CPArgumentProto& arg_proto,
                                     int64* to_fill) {
@@ -2528,6 +2537,14 @@ bool Solver::LoadModel(const CPModelProto& model_proto) {
 
 bool Solver::LoadModel(const CPModelProto& model_proto,
                        std::vector<SearchMonitor*>* monitors) {
+  return LoadModel(model_proto, monitors, nullptr, nullptr, nullptr);
+}
+
+bool Solver::LoadModel(const CPModelProto& model_proto,
+                       std::vector<SearchMonitor*>* monitors,
+                       std::vector<IntVar*>* decision_vars,
+                       std::vector<IntervalVar*>* decision_intervals,
+                       std::vector<SequenceVar*>* decision_sequences) {
   if (model_proto.version() > kModelVersion) {
     LOG(ERROR) << "Model protocol buffer version is greater than"
                << " the one compiled in the reader (" << model_proto.version()
@@ -2588,6 +2605,25 @@ bool Solver::LoadModel(const CPModelProto& model_proto,
       monitors->push_back(objective);
     }
   }
+  for (const CPVariableGroup& group_proto : model_proto.variable_groups()) {
+    for (const CPArgumentProto& arg_proto : group_proto.arguments()) {
+      if (decision_vars != nullptr) {
+        for (const int index : arg_proto.integer_expression_array()) {
+          decision_vars->push_back(builder.IntegerExpression(index)->Var());
+        }
+      }
+      if (decision_intervals != nullptr) {
+        for (const int index : arg_proto.interval_array()) {
+          decision_intervals->push_back(builder.IntervalVariable(index));
+        }
+      }
+      if (decision_sequences != nullptr) {
+        for (const int index : arg_proto.sequence_array()) {
+          decision_sequences->push_back(builder.SequenceVariable(index));
+        }
+      }
+    }
+  }
   return true;
 }
 
@@ -2996,6 +2996,16 @@ void LocalSearch::Accept(ModelVisitor* const visitor) const {
     visitor->VisitIntervalArrayArgument(ModelVisitor::kIntervalsArgument,
                                         interval_vars);
   }
+  const std::vector<SequenceVarElement>& sequence_elements =
+      assignment_->SequenceVarContainer().elements();
+  if (!sequence_elements.empty()) {
+    std::vector<SequenceVar*> sequence_vars;
+    for (const SequenceVarElement& elem : sequence_elements) {
+      sequence_vars.push_back(elem.Var());
+    }
+    visitor->VisitSequenceArrayArgument(ModelVisitor::kSequencesArgument,
+                                        sequence_vars);
+  }
   visitor->EndVisitExtension(ModelVisitor::kVariableGroupExtension);
 }
 
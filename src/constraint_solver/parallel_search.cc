@@ -0,0 +1,1305 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "constraint_solver/parallel_search.h"
+
+#include <atomic>
+#include <deque>
+#include "base/hash.h"
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/map_util.h"
+#include "base/mutex.h"
+#include "base/stringprintf.h"
+#include "base/threadpool.h"
+#include "base/time_support.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+
+namespace operations_research {
+
+namespace {
+
+// ---------- Copies between the solvers of the workers ----------
+
+// These copy the values of an element of an assignment to the element of
+// another solver, whose variable is left unchanged.
+
+void CopyElementValue(const IntVarElement& element,
+                      IntVarElement* const target) {
+  target->SetRange(element.Min(), element.Max());
+}
+
+void CopyElementValue(const IntervalVarElement& element,
+                      IntervalVarElement* const target) {
+  target->SetStartRange(element.StartMin(), element.StartMax());
+  target->SetDurationRange(element.DurationMin(), element.DurationMax());
+  target->SetEndRange(element.EndMin(), element.EndMax());
+  target->SetPerformedRange(element.PerformedMin(), element.PerformedMax());
+}
+
+void CopyElementValue(const SequenceVarElement& element,
+                      SequenceVarElement* const target) {
+  target->SetSequence(element.ForwardSequence(), element.BackwardSequence(),
+                      element.Unperformed());
+}
+
+// Copies the values of the elements of a container to the elements at the
+// same positions of a container of another solver.
+template <class V, class E>
+void CopyContainerValues(const AssignmentContainer<V, E>& container,
+                         AssignmentContainer<V, E>* const target) {
+  CHECK_EQ(container.Size(), target->Size());
+  for (int i = 0; i < container.Size(); ++i) {
+    CopyElementValue(container.Element(i), target->MutableElement(i));
+  }
+}
+
+// Copies the values of an assignment to an assignment with the same layout
+// on the variables of another solver.
+void CopyAssignmentValues(const Assignment& assignment,
+                          Assignment* const target) {
+  CopyContainerValues(assignment.IntVarContainer(),
+                      target->MutableIntVarContainer());
+  CopyContainerValues(assignment.IntervalVarContainer(),
+                      target->MutableIntervalVarContainer());
+  CopyContainerValues(assignment.SequenceVarContainer(),
+                      target->MutableSequenceVarContainer());
+  if (target->HasObjective()) {
+    target->SetObjectiveRange(assignment.ObjectiveMin(),
+                              assignment.ObjectiveMax());
+  }
+}
+
+}  // namespace
+
+// ---------- ParallelSolutionCollector ----------
+
+ParallelSolutionCollector::ParallelSolutionCollector(Solver* const solver,
+                                                     bool keep_all_solutions)
+    : SolutionCollector(solver), keep_all_solutions_(keep_all_solutions) {}
+
+ParallelSolutionCollector::~ParallelSolutionCollector() {}
+
+void ParallelSolutionCollector::AddSolution(const Assignment& solution,
+                                            int64 wall_time, int64 branches,
+                                            int64 failures) {
+  MutexLock lock(&mutex_);
+  Assignment* new_solution = nullptr;
+  if (!keep_all_solutions_ && !solutions_.empty()) {
+    new_solution = solutions_.back();
+    solutions_.pop_back();
+    times_.pop_back();
+    branches_.pop_back();
+    failures_.pop_back();
+    objective_values_.pop_back();
+  } else {
+    new_solution = new Assignment(prototype_.get());
+  }
+  CopyAssignmentValues(solution, new_solution);
+  solutions_.push_back(new_solution);
+  times_.push_back(wall_time);
+  branches_.push_back(branches);
+  failures_.push_back(failures);
+  objective_values_.push_back(
+      new_solution->HasObjective() ? new_solution->ObjectiveValue() : 0);
+}
+
+namespace {
+
+// ---------- Decision paths ----------
+
+// A decision of a decision path, and the branch taken for it.
+struct PathStep {
+  enum Type {
+    SET_VALUE,         // var == value, refuted by var != value.
+    SPLIT_LOWER_HALF,  // var <= value, refuted by var > value.
+    SPLIT_UPPER_HALF,  // var > value, refuted by var <= value.
+    RANK_FIRST,        // Ranks the interval 'value' of a sequence first.
+    RANK_LAST          // Ranks the interval 'value' of a sequence last.
+  };
+
+  Type type;
+  // Index of the variable (or sequence) in the DecisionVariables.
+  int index;
+  int64 value;
+  bool refuted;
+};
+
+typedef std::vector<PathStep> DecisionPath;
+
+// Applies the given step on the given copy of the model.
+void ApplyPathStep(const PathStep& step, const DecisionVariables& variables) {
+  switch (step.type) {
+    case PathStep::SET_VALUE: {
+      IntVar* const var = variables.vars[step.index];
+      if (step.refuted) {
+        var->RemoveValue(step.value);
+      } else {
+        var->SetValue(step.value);
+      }
+      break;
+    }
+    case PathStep::SPLIT_LOWER_HALF: {
+      IntVar* const var = variables.vars[step.index];
+      if (step.refuted) {
+        var->SetMin(step.value + 1);
+      } else {
+        var->SetMax(step.value);
+      }
+      break;
+    }
+    case PathStep::SPLIT_UPPER_HALF: {
+      IntVar* const var = variables.vars[step.index];
+      if (step.refuted) {
+        var->SetMax(step.value);
+      } else {
+        var->SetMin(step.value + 1);
+      }
+      break;
+    }
+    case PathStep::RANK_FIRST: {
+      SequenceVar* const sequence = variables.sequences[step.index];
+      if (step.refuted) {
+        sequence->RankNotFirst(step.value);
+      } else {
+        sequence->RankFirst(step.value);
+      }
+      break;
+    }
+    case PathStep::RANK_LAST: {
+      SequenceVar* const sequence = variables.sequences[step.index];
+      if (step.refuted) {
+        sequence->RankNotLast(step.value);
+      } else {
+        sequence->RankLast(step.value);
+      }
+      break;
+    }
+  }
+}
+
+// Translates the decisions of a worker into path steps.
+class PathStepBuilder : public DecisionVisitor {
+ public:
+  explicit PathStepBuilder(const DecisionVariables& variables)
+      : step_(nullptr), num_visits_(0), unknown_(false) {
+    for (int i = 0; i < variables.vars.size(); ++i) {
+      var_indices_.insert(std::make_pair(variables.vars[i], i));
+    }
+    for (int i = 0; i < variables.sequences.size(); ++i) {
+      sequence_indices_.insert(std::make_pair(variables.sequences[i], i));
+    }
+  }
+  virtual ~PathStepBuilder() {}
+
+  // Fills the step describing the left branch of the given decision, and
+  // returns false if it cannot be described in a solver independent way.
+  bool Build(Decision* const decision, PathStep* const step) {
+    step_ = step;
+    num_visits_ = 0;
+    unknown_ = false;
+    decision->Accept(this);
+    step->refuted = false;
+    return num_visits_ == 1 && !unknown_;
+  }
+
+  virtual void VisitSetVariableValue(IntVar* const var, int64 value) {
+    SetVarStep(PathStep::SET_VALUE, var, value);
+  }
+  virtual void VisitSplitVariableDomain(IntVar* const var, int64 value,
+                                        bool start_with_lower_half) {
+    SetVarStep(start_with_lower_half ? PathStep::SPLIT_LOWER_HALF
+                                     : PathStep::SPLIT_UPPER_HALF,
+               var, value);
+  }
+  virtual void VisitRankFirstInterval(SequenceVar* const sequence,
+                                      int index) {
+    SetSequenceStep(PathStep::RANK_FIRST, sequence, index);
+  }
+  virtual void VisitRankLastInterval(SequenceVar* const sequence, int index) {
+    SetSequenceStep(PathStep::RANK_LAST, sequence, index);
+  }
+  // Schedule-or-postpone decisions are refuted by changing the state of their
+  // decision builder, not the domains, so they are not transferable.
+  virtual void VisitScheduleOrPostpone(IntervalVar* const var, int64 est) {
+    unknown_ = true;
+  }
+  virtual void VisitScheduleOrExpedite(IntervalVar* const var, int64 est) {
+    unknown_ = true;
+  }
+  virtual void VisitUnknownDecision() { unknown_ = true; }
+
+ private:
+  void SetVarStep(PathStep::Type type, IntVar* const var, int64 value) {
+    num_visits_++;
+    step_->type = type;
+    step_->index = FindWithDefault(var_indices_, var, -1);
+    step_->value = value;
+    unknown_ |= step_->index == -1;
+  }
+
+  void SetSequenceStep(PathStep::Type type, SequenceVar* const sequence,
+                       int index) {
+    num_visits_++;
+    step_->type = type;
+    step_->index = FindWithDefault(sequence_indices_, sequence, -1);
+    step_->value = index;
+    unknown_ |= step_->index == -1;
+  }
+
+  hash_map<const IntVar*, int> var_indices_;
+  hash_map<const SequenceVar*, int> sequence_indices_;
+  PathStep* step_;
+  int num_visits_;
+  bool unknown_;
+};
+
+// Replays a decision path at the root of the search of a worker.
+class ReplayPath : public DecisionBuilder {
+ public:
+  ReplayPath(const DecisionVariables& variables, const DecisionPath* path)
+      : variables_(variables), path_(path) {}
+  virtual ~ReplayPath() {}
+
+  virtual Decision* Next(Solver* const s) {
+    for (const PathStep& step : *path_) {
+      ApplyPathStep(step, variables_);
+    }
+    return nullptr;
+  }
+
+  virtual std::string DebugString() const {
+    return StringPrintf("ReplayPath(%d steps)",
+                        static_cast<int>(path_->size()));
+  }
+
+ private:
+  const DecisionVariables& variables_;
+  const DecisionPath* const path_;
+};
+
+// Collects the variables of the variable groups of a decision builder.
+class VariableGroupCollector : public ModelVisitor {
+ public:
+  explicit VariableGroupCollector(DecisionVariables* const variables)
+      : variables_(variables), in_group_(false) {}
+  virtual ~VariableGroupCollector() {}
+
+  virtual void BeginVisitExtension(const std::string& type) {
+    in_group_ = type == ModelVisitor::kVariableGroupExtension;
+  }
+  virtual void EndVisitExtension(const std::string& type) {
+    in_group_ = false;
+  }
+  virtual void VisitIntegerVariableArrayArgument(
+      const std::string& arg_name, const std::vector<IntVar*>& arguments) {
+    if (in_group_) {
+      variables_->vars.insert(variables_->vars.end(), arguments.begin(),
+                              arguments.end());
+    }
+  }
+  virtual void VisitIntervalArrayArgument(
+      const std::string& arg_name, const std::vector<IntervalVar*>& arguments) {
+    if (in_group_) {
+      variables_->intervals.insert(variables_->intervals.end(),
+                                   arguments.begin(), arguments.end());
+    }
+  }
+  virtual void VisitSequenceArrayArgument(
+      const std::string& arg_name, const std::vector<SequenceVar*>& arguments) {
+    if (in_group_) {
+      variables_->sequences.insert(variables_->sequences.end(),
+                                   arguments.begin(), arguments.end());
+    }
+  }
+
+ private:
+  DecisionVariables* const variables_;
+  bool in_group_;
+};
+
+// Returns the variable of the OptimizeVar of the given monitors, or nullptr.
+IntVar* FindObjective(const std::vector<SearchMonitor*>& monitors) {
+  for (SearchMonitor* const monitor : monitors) {
+    OptimizeVar* const optimize_var = dynamic_cast<OptimizeVar*>(monitor);
+    if (optimize_var != nullptr) {
+      return optimize_var->Var();
+    }
+  }
+  return nullptr;
+}
+
+// Index of the objective in SolutionLayout::vars.
+const int kObjectiveIndex = -1;
+
+// Positions in the DecisionVariables of the elements of the prototype of a
+// ParallelSolutionCollector.
+struct SolutionLayout {
+  std::vector<int> vars;
+  std::vector<int> intervals;
+  std::vector<int> sequences;
+  bool has_objective;
+};
+
+template <class V>
+int FindIndexOrDie(const std::vector<V*>& vars, const V* const var) {
+  for (int i = 0; i < vars.size(); ++i) {
+    if (vars[i] == var) return i;
+  }
+  LOG(FATAL) << var->DebugString()
+             << " is not a variable of the decision builder.";
+  return -1;
+}
+
+// Locates the elements of the prototype of a collector in the decision
+// variables of the original model.
+void BuildSolutionLayout(const Assignment& prototype,
+                         const DecisionVariables& variables,
+                         IntVar* const objective,
+                         SolutionLayout* const layout) {
+  const Assignment::IntContainer& ints = prototype.IntVarContainer();
+  for (int i = 0; i < ints.Size(); ++i) {
+    const IntVar* const var = ints.Element(i).Var();
+    layout->vars.push_back(var == objective ? kObjectiveIndex
+                                            : FindIndexOrDie(variables.vars,
+                                                             var));
+  }
+  const Assignment::IntervalContainer& intervals =
+      prototype.IntervalVarContainer();
+  for (int i = 0; i < intervals.Size(); ++i) {
+    layout->intervals.push_back(
+        FindIndexOrDie(variables.intervals, intervals.Element(i).Var()));
+  }
+  const Assignment::SequenceContainer& sequences =
+      prototype.SequenceVarContainer();
+  for (int i = 0; i < sequences.Size(); ++i) {
+    layout->sequences.push_back(
+        FindIndexOrDie(variables.sequences, sequences.Element(i).Var()));
+  }
+  if (prototype.HasObjective()) {
+    CHECK_EQ(objective, prototype.Objective());
+    layout->has_objective = true;
+  }
+}
+
+// Returns an assignment with the given layout on the variables of a worker.
+Assignment* MakeWorkerSolution(Solver* const solver,
+                               const SolutionLayout& layout,
+                               const DecisionVariables& variables,
+                               IntVar* const objective) {
+  Assignment* const solution = solver->MakeAssignment();
+  for (const int index : layout.vars) {
+    solution->Add(index == kObjectiveIndex ? objective : variables.vars[index]);
+  }
+  for (const int index : layout.intervals) {
+    solution->Add(variables.intervals[index]);
+  }
+  for (const int index : layout.sequences) {
+    solution->Add(variables.sequences[index]);
+  }
+  if (layout.has_objective) {
+    solution->AddObjective(objective);
+  }
+  return solution;
+}
+
+// ---------- State shared by the workers ----------
+
+// The best objective value found by the workers. It is only modified under
+// the mutex of its owner, but read without it by the busy workers.
+class SharedObjective {
+ public:
+  explicit SharedObjective(bool maximize)
+      : maximize_(maximize), has_value_(false), best_(0) {}
+
+  // Returns true and fills 'value' if a solution was found.
+  bool Get(int64* const value) const {
+    if (!has_value_.load(std::memory_order_acquire)) return false;
+    *value = best_.load(std::memory_order_relaxed);
+    return true;
+  }
+
+  // Returns true if 'value' is better than the best value.
+  bool IsImprovement(int64 value) const {
+    int64 best = 0;
+    if (!Get(&best)) return true;
+    return maximize_ ? value > best : value < best;
+  }
+
+  void Set(int64 value) {
+    best_.store(value, std::memory_order_relaxed);
+    has_value_.store(true, std::memory_order_release);
+  }
+
+ private:
+  const bool maximize_;
+  std::atomic<bool> has_value_;
+  std::atomic<int64> best_;
+};
+
+// The search limit exported with the model, applied to the whole parallel
+// search. A RegularLimit starts again at each search (see
+// RegularLimit::Init()), and a worker starts a new search for each subtree it
+// steals or after each new incumbent, so the limit loaded in each worker would
+// only bound one of these searches. Instead, the time is counted from the
+// creation of this object, and the branches, failures and solutions are
+// summed over all the workers. The workers add their counts in batches (see
+// SharedSearchLimit), so the branches and failures limits can be exceeded by a
+// few hundred per worker.
+class SharedLimit {
+ public:
+  explicit SharedLimit(const CPModelProto& model)
+      : deadline_ns_(kint64max),
+        max_branches_(model.search_limit().branches()),
+        max_failures_(model.search_limit().failures()),
+        max_solutions_(model.search_limit().solutions()),
+        branches_(0),
+        failures_(0),
+        solutions_(0) {
+    const int64 time_ms = model.search_limit().time();
+    const int64 now_ns = base::GetCurrentTimeNanos();
+    if (time_ms < (kint64max - now_ns) / 1000000) {
+      deadline_ns_ = now_ns + time_ms * 1000000;
+    }
+  }
+
+  // Adds counts of a worker. This can be called concurrently.
+  void Add(int64 branches, int64 failures, int64 solutions) {
+    branches_.fetch_add(branches, std::memory_order_relaxed);
+    failures_.fetch_add(failures, std::memory_order_relaxed);
+    solutions_.fetch_add(solutions, std::memory_order_relaxed);
+  }
+
+  bool Crossed() const {
+    return branches_.load(std::memory_order_relaxed) >= max_branches_ ||
+           failures_.load(std::memory_order_relaxed) >= max_failures_ ||
+           solutions_.load(std::memory_order_relaxed) >= max_solutions_ ||
+           (deadline_ns_ != kint64max &&
+            base::GetCurrentTimeNanos() >= deadline_ns_);
+  }
+
+ private:
+  int64 deadline_ns_;
+  const int64 max_branches_;
+  const int64 max_failures_;
+  const int64 max_solutions_;
+  std::atomic<int64> branches_;
+  std::atomic<int64> failures_;
+  std::atomic<int64> solutions_;
+};
+
+class SharedSearchState {
+ public:
+  SharedSearchState(const CPModelProto& model,
+                    ParallelSearch::DecisionBuilderFactory* const factory,
+                    int num_workers, int64 solution_limit,
+                    ParallelSolutionCollector* const collector,
+                    const SolutionLayout& layout)
+      : model_(model),
+        factory_(factory),
+        num_workers_(num_workers),
+        solution_limit_(solution_limit),
+        collector_(collector),
+        layout_(layout),
+        num_idle_workers_(0),
+        num_pending_paths_(1),
+        should_finish_(false),
+        objective_(model.has_objective() && model.objective().maximize()),
+        limit_(model),
+        branches_(0),
+        failures_(0),
+        num_solutions_(0),
+        num_steals_(0) {
+    // The whole tree is described by the empty path.
+    paths_.push_back(DecisionPath());
+  }
+
+  void RunWorker(int worker_id);
+
+  // Blocks until a decision path is available and moves it into 'path', or
+  // returns false when the search is over.
+  bool GetWork(DecisionPath* const path) {
+    MutexLock lock(&mutex_);
+    num_idle_workers_++;
+    while (paths_.empty() && !should_finish_) {
+      if (num_idle_workers_ == num_workers_) {
+        // Nobody is left to explore or give away a subtree.
+        should_finish_ = true;
+        work_available_.SignalAll();
+        break;
+      }
+      work_available_.Wait(&mutex_);
+    }
+    if (should_finish_) return false;
+    num_idle_workers_--;
+    path->swap(paths_.front());
+    paths_.pop_front();
+    num_pending_paths_--;
+    return true;
+  }
+
+  // Returns true if a worker waits for a subtree and none is available.
+  bool WorkIsRequested() const {
+    return num_idle_workers_.load(std::memory_order_relaxed) > 0 &&
+           num_pending_paths_.load(std::memory_order_relaxed) == 0;
+  }
+
+  void AddWork(DecisionPath* const path) {
+    MutexLock lock(&mutex_);
+    paths_.push_back(DecisionPath());
+    paths_.back().swap(*path);
+    num_pending_paths_++;
+    num_steals_++;
+    work_available_.Signal();
+  }
+
+  void Finish() {
+    MutexLock lock(&mutex_);
+    should_finish_ = true;
+    work_available_.SignalAll();
+  }
+
+  const SharedObjective* objective() const { return &objective_; }
+
+  // Reports a solution found by a worker, on the variables of the worker. For
+  // a model with objective, solutions that do not improve the best shared one
+  // are ignored. Returns false if the search must stop.
+  bool ReportSolution(Solver* const solver, const Assignment& solution,
+                      int64 objective_value) {
+    MutexLock lock(&mutex_);
+    if (model_.has_objective()) {
+      if (!objective_.IsImprovement(objective_value)) {
+        return !should_finish_;
+      }
+      objective_.Set(objective_value);
+    }
+    if (collector_ != nullptr) {
+      collector_->AddSolution(solution, solver->wall_time(),
+                              solver->branches(), solver->failures());
+    }
+    if (++num_solutions_ >= solution_limit_) {
+      should_finish_ = true;
+      work_available_.SignalAll();
+    }
+    return !should_finish_;
+  }
+
+  const CPModelProto& model() const { return model_; }
+  int64 branches() const { return branches_; }
+  int64 failures() const { return failures_; }
+  int64 num_solutions() const { return num_solutions_; }
+  int64 num_steals() const { return num_steals_; }
+
+ private:
+  const CPModelProto& model_;
+  ParallelSearch::DecisionBuilderFactory* const factory_;
+  const int num_workers_;
+  const int64 solution_limit_;
+  ParallelSolutionCollector* const collector_;
+  const SolutionLayout& layout_;
+
+  Mutex mutex_;
+  CondVar work_available_;
+  std::deque<DecisionPath> paths_ GUARDED_BY(mutex_);
+  // These are only modified under the mutex, but read without it by the busy
+  // workers.
+  std::atomic<int> num_idle_workers_;
+  std::atomic<int> num_pending_paths_;
+  std::atomic<bool> should_finish_;
+  SharedObjective objective_;
+  SharedLimit limit_;
+
+  int64 branches_ GUARDED_BY(mutex_);
+  int64 failures_ GUARDED_BY(mutex_);
+  int64 num_solutions_ GUARDED_BY(mutex_);
+  int64 num_steals_ GUARDED_BY(mutex_);
+};
+
+// ---------- Search monitors of the workers ----------
+
+// An OptimizeVar that reads the best objective value found by all the
+// workers, at the root of each search, at each refutation and before
+// accepting a solution. If poll_before_first_solution is false, the shared
+// value is only read once the worker has found a solution of its own, so that
+// a local search can always build its first solution.
+class SharedOptimizeVar : public OptimizeVar {
+ public:
+  SharedOptimizeVar(Solver* const s, bool maximize, IntVar* const var,
+                    int64 step, const SharedObjective* const objective,
+                    bool poll_before_first_solution)
+      : OptimizeVar(s, maximize, var, step),
+        objective_(objective),
+        poll_before_first_solution_(poll_before_first_solution) {}
+  virtual ~SharedOptimizeVar() {}
+
+  virtual void EnterSearch() {
+    OptimizeVar::EnterSearch();
+    PollBestObjective();
+  }
+
+  virtual void RefuteDecision(Decision* const d) {
+    PollBestObjective();
+    OptimizeVar::RefuteDecision(d);
+  }
+
+  virtual bool AcceptSolution() {
+    PollBestObjective();
+    return OptimizeVar::AcceptSolution();
+  }
+
+ private:
+  void PollBestObjective() {
+    if (!found_initial_solution_ && !poll_before_first_solution_) return;
+    int64 polled_best = 0;
+    if (objective_->Get(&polled_best) &&
+        (!found_initial_solution_ ||
+         (maximize_ ? polled_best > best_ : polled_best < best_))) {
+      best_ = polled_best;
+      found_initial_solution_ = true;
+    }
+  }
+
+  const SharedObjective* const objective_;
+  const bool poll_before_first_solution_;
+};
+
+// Stops the search of a worker when the whole search must stop, or when the
+// shared limit is crossed. The branches and failures of the worker are added
+// to the shared limit every kReportPeriod of them and at the end of each
+// search, and its solutions as soon as they are found.
+class SharedSearchLimit : public SearchLimit {
+ public:
+  SharedSearchLimit(Solver* const s, const std::atomic<bool>* const finish,
+                    SharedLimit* const limit)
+      : SearchLimit(s),
+        finish_(finish),
+        limit_(limit),
+        reported_branches_(0),
+        reported_failures_(0),
+        reported_solutions_(0) {}
+  virtual ~SharedSearchLimit() {}
+
+  virtual bool Check() {
+    if (finish_->load(std::memory_order_relaxed)) return true;
+    Solver* const s = solver();
+    if (s->branches() - reported_branches_ + s->failures() -
+                reported_failures_ >=
+            kReportPeriod ||
+        s->solutions() != reported_solutions_) {
+      Report();
+    }
+    return limit_->Crossed();
+  }
+
+  virtual void Init() {
+    Solver* const s = solver();
+    reported_branches_ = s->branches();
+    reported_failures_ = s->failures();
+    reported_solutions_ = s->solutions();
+  }
+
+  virtual void ExitSearch() { Report(); }
+  virtual void Copy(const SearchLimit* const limit) {}
+  virtual SearchLimit* MakeClone() const { return nullptr; }
+
+ private:
+  static const int64 kReportPeriod = 256;
+
+  void Report() {
+    Solver* const s = solver();
+    limit_->Add(s->branches() - reported_branches_,
+                s->failures() - reported_failures_,
+                s->solutions() - reported_solutions_);
+    Init();
+  }
+
+  const std::atomic<bool>* const finish_;
+  SharedLimit* const limit_;
+  // The counts of the solver already added to the shared limit.
+  int64 reported_branches_;
+  int64 reported_failures_;
+  int64 reported_solutions_;
+};
+
+// Keeps track of the decisions leading from the root of the subtree of a
+// worker to the current node, and gives away the right branch of the
+// shallowest open choice point when another worker waits for work. The given
+// away branches fail when the worker backtracks to them.
+class WorkSharingMonitor : public SearchMonitor {
+ public:
+  WorkSharingMonitor(Solver* const s, const DecisionVariables& variables,
+                     SharedSearchState* const state)
+      : SearchMonitor(s),
+        step_builder_(variables),
+        state_(state),
+        base_path_(nullptr) {}
+  virtual ~WorkSharingMonitor() {}
+
+  // Sets the path from the root of the tree to the root of the subtree
+  // explored by the next search.
+  void set_base_path(const DecisionPath* const path) { base_path_ = path; }
+
+  virtual void EnterSearch() { nodes_.clear(); }
+
+  virtual void BeginNextDecision(DecisionBuilder* const db) {
+    if (state_->WorkIsRequested()) {
+      GiveAwayWork();
+    }
+  }
+
+  virtual void ApplyDecision(Decision* const d) {
+    // Choice points are indexed by the search depth, which is restored on
+    // backtrack.
+    nodes_.resize(solver()->SearchDepth());
+    nodes_.push_back(Node());
+    Node* const node = &nodes_.back();
+    node->transferable = step_builder_.Build(d, &node->step);
+  }
+
+  virtual void RefuteDecision(Decision* const d) {
+    const int depth = solver()->SearchDepth();
+    nodes_.resize(depth + 1);
+    Node* const node = &nodes_[depth];
+    node->step.refuted = true;
+    if (node->given_away) {
+      solver()->Fail();
+    }
+  }
+
+  virtual std::string DebugString() const { return "WorkSharingMonitor"; }
+
+ private:
+  struct Node {
+    Node() : transferable(false), given_away(false) {}
+    PathStep step;
+    bool transferable;
+    bool given_away;
+  };
+
+  void GiveAwayWork() {
+    const int depth = std::min<int>(solver()->SearchDepth(), nodes_.size());
+    for (int i = 0; i < depth; ++i) {
+      Node* const node = &nodes_[i];
+      if (!node->transferable) return;
+      if (node->step.refuted || node->given_away) continue;
+      DecisionPath path(*base_path_);
+      for (int j = 0; j <= i; ++j) {
+        path.push_back(nodes_[j].step);
+      }
+      path.back().refuted = true;
+      node->given_away = true;
+      state_->AddWork(&path);
+      return;
+    }
+  }
+
+  PathStepBuilder step_builder_;
+  SharedSearchState* const state_;
+  const DecisionPath* base_path_;
+  std::vector<Node> nodes_;
+};
+
+// ---------- Workers ----------
+
+// Replaces the objective and the search limit loaded in the solver of a
+// worker by ones shared with the other workers. The shared search limit also
+// stops the worker when the whole search must stop. Fills the monitors of the
+// worker and its search limit, and returns its objective variable (nullptr if
+// the model has none).
+IntVar* BuildWorkerMonitors(Solver* const solver, const CPModelProto& model,
+                            const std::vector<SearchMonitor*>& loaded_monitors,
+                            const SharedObjective* const shared_objective,
+                            bool poll_before_first_solution,
+                            const std::atomic<bool>* const finish,
+                            SharedLimit* const shared_limit,
+                            std::vector<SearchMonitor*>* const monitors,
+                            SearchLimit** const limit) {
+  IntVar* objective = nullptr;
+  for (SearchMonitor* const monitor : loaded_monitors) {
+    OptimizeVar* const optimize_var = dynamic_cast<OptimizeVar*>(monitor);
+    if (optimize_var != nullptr) {
+      objective = optimize_var->Var();
+      monitors->push_back(solver->RevAlloc(new SharedOptimizeVar(
+          solver, model.objective().maximize(), objective,
+          model.objective().step(), shared_objective,
+          poll_before_first_solution)));
+      continue;
+    }
+    // The loaded limit would only bound each search of the worker.
+    if (dynamic_cast<SearchLimit*>(monitor) != nullptr) continue;
+    monitors->push_back(monitor);
+  }
+  *limit =
+      solver->RevAlloc(new SharedSearchLimit(solver, finish, shared_limit));
+  monitors->push_back(*limit);
+  return objective;
+}
+
+void SharedSearchState::RunWorker(int worker_id) {
+  Solver solver(StringPrintf("%s_%d", model_.model().c_str(), worker_id));
+  std::vector<SearchMonitor*> loaded_monitors;
+  DecisionVariables variables;
+  CHECK(solver.LoadModel(model_, &loaded_monitors, &variables.vars,
+                         &variables.intervals, &variables.sequences));
+
+  std::vector<SearchMonitor*> monitors;
+  SearchLimit* limit = nullptr;
+  IntVar* const objective =
+      BuildWorkerMonitors(&solver, model_, loaded_monitors, &objective_, true,
+                          &should_finish_, &limit_, &monitors, &limit);
+  WorkSharingMonitor* const work_sharing =
+      solver.RevAlloc(new WorkSharingMonitor(&solver, variables, this));
+  monitors.push_back(work_sharing);
+
+  // The solution, on the variables of this worker.
+  Assignment* const solution =
+      MakeWorkerSolution(&solver, layout_, variables, objective);
+
+  DecisionPath path;
+  DecisionBuilder* const db = solver.Compose(
+      solver.RevAlloc(new ReplayPath(variables, &path)),
+      factory_->Run(&solver, variables));
+  work_sharing->set_base_path(&path);
+  while (GetWork(&path)) {
+    VLOG(1) << "Worker " << worker_id << " explores a subtree of depth "
+            << path.size();
+    solver.NewSearch(db, monitors);
+    while (solver.NextSolution()) {
+      solution->Store();
+      if (!ReportSolution(&solver, *solution,
+                          objective == nullptr ? 0 : objective->Value())) {
+        break;
+      }
+    }
+    solver.EndSearch();
+    if (limit->crossed()) Finish();
+  }
+
+  MutexLock lock(&mutex_);
+  branches_ += solver.branches();
+  failures_ += solver.failures();
+  VLOG(1) << "Worker " << worker_id << ": " << solver.branches()
+          << " branches, " << solver.failures() << " failures";
+}
+
+}  // namespace
+
+// ---------- ParallelSearch ----------
+
+ParallelSearch::ParallelSearch(Solver* const solver, DecisionBuilder* const db,
+                               const std::vector<SearchMonitor*>& monitors,
+                               DecisionBuilderFactory* const factory,
+                               int num_workers)
+    : factory_(factory),
+      num_workers_(num_workers),
+      solution_limit_(kint64max),
+      objective_(nullptr),
+      branches_(0),
+      failures_(0),
+      num_solutions_(0),
+      num_steals_(0),
+      best_objective_(0) {
+  CHECK_GT(num_workers, 0);
+  CHECK(factory != nullptr);
+  factory->CheckIsRepeatable();
+  solver->ExportModel(monitors, &model_, db);
+  VariableGroupCollector collector(&decision_variables_);
+  db->Accept(&collector);
+  objective_ = FindObjective(monitors);
+}
+
+ParallelSearch::~ParallelSearch() {}
+
+bool ParallelSearch::Solve(ParallelSolutionCollector* const collector) {
+  SolutionLayout layout;
+  layout.has_objective = false;
+  if (collector != nullptr) {
+    BuildSolutionLayout(*collector->prototype(), decision_variables_,
+                        objective_, &layout);
+    collector->EnterSearch();
+  }
+
+  SharedSearchState state(model_, factory_.get(), num_workers_,
+                          solution_limit_, collector, layout);
+  {
+    ThreadPool thread_pool("ParallelSearch", num_workers_);
+    for (int worker_id = 0; worker_id < num_workers_; ++worker_id) {
+      thread_pool.Add(
+          NewCallback(&state, &SharedSearchState::RunWorker, worker_id));
+    }
+    thread_pool.StartWorkers();
+  }
+  branches_ = state.branches();
+  failures_ = state.failures();
+  num_solutions_ = state.num_solutions();
+  num_steals_ = state.num_steals();
+  state.objective()->Get(&best_objective_);
+  return num_solutions_ > 0;
+}
+
+// ---------- Parallel local search ----------
+
+namespace {
+
+// Positions in the DecisionVariables of the variables of a worker.
+struct VariableIndices {
+  explicit VariableIndices(const DecisionVariables& variables) {
+    for (int i = 0; i < variables.vars.size(); ++i) {
+      vars.insert(std::make_pair(variables.vars[i], i));
+    }
+    for (int i = 0; i < variables.intervals.size(); ++i) {
+      intervals.insert(std::make_pair(variables.intervals[i], i));
+    }
+    for (int i = 0; i < variables.sequences.size(); ++i) {
+      sequences.insert(std::make_pair(variables.sequences[i], i));
+    }
+  }
+
+  hash_map<const IntVar*, int> vars;
+  hash_map<const IntervalVar*, int> intervals;
+  hash_map<const SequenceVar*, int> sequences;
+};
+
+// Copies the values of the elements of 'source', which contains all the
+// decision variables in order, to the elements of 'target', which can contain
+// any of them on the variables of a worker.
+template <class V, class E>
+void CopyDecisionValues(const AssignmentContainer<V, E>& source,
+                        const hash_map<const V*, int>& indices,
+                        AssignmentContainer<V, E>* const target) {
+  for (int i = 0; i < target->Size(); ++i) {
+    E* const element = target->MutableElement(i);
+    CopyElementValue(source.Element(FindOrDie(indices, element->Var())),
+                     element);
+  }
+}
+
+class WorkerSolutionPool;
+
+class SharedLocalSearchState {
+ public:
+  SharedLocalSearchState(
+      const CPModelProto& model,
+      ParallelLocalSearch::LocalSearchFactory* const factory, int num_workers,
+      ParallelSolutionCollector* const collector, const SolutionLayout& layout,
+      Assignment* const incumbent)
+      : model_(model),
+        factory_(factory),
+        num_workers_(num_workers),
+        collector_(collector),
+        layout_(layout),
+        incumbent_(incumbent),
+        version_(0),
+        should_finish_(false),
+        objective_(model.objective().maximize()),
+        limit_(model),
+        num_idle_workers_(0),
+        branches_(0),
+        failures_(0),
+        neighbors_(0),
+        accepted_neighbors_(0),
+        num_solutions_(0),
+        num_imports_(0) {}
+
+  void RunWorker(int worker_id);
+
+  // The version of the incumbent is incremented each time it is improved. It
+  // is 0 until a first solution is found.
+  int64 version() const { return version_.load(std::memory_order_relaxed); }
+
+  // Copies the incumbent into 'solution', on the variables of a worker, and
+  // returns its version.
+  int64 ReadIncumbent(const VariableIndices& indices,
+                      Assignment* const solution) {
+    MutexLock lock(&mutex_);
+    CopyDecisionValues(incumbent_->IntVarContainer(), indices.vars,
+                       solution->MutableIntVarContainer());
+    CopyDecisionValues(incumbent_->IntervalVarContainer(), indices.intervals,
+                       solution->MutableIntervalVarContainer());
+    CopyDecisionValues(incumbent_->SequenceVarContainer(), indices.sequences,
+                       solution->MutableSequenceVarContainer());
+    if (solution->HasObjective()) {
+      int64 best = 0;
+      CHECK(objective_.Get(&best));
+      solution->SetObjectiveValue(best);
+    }
+    return version_;
+  }
+
+  // Reports a solution found by a worker: 'decision_values' contains all the
+  // decision variables of the worker and 'solution' has the layout of the
+  // collector. The solution becomes the incumbent if it improves it, in which
+  // case its version is recorded in the pool of the worker. Returns false if
+  // the search must stop.
+  bool ReportSolution(Solver* const solver, const Assignment& decision_values,
+                      const Assignment& solution, int64 objective_value,
+                      WorkerSolutionPool* const pool);
+
+  // Blocks until the incumbent is newer than the given version, and returns
+  // false if the search is over. The search ends when all the workers wait
+  // for the same version.
+  bool WaitForNewIncumbent(int64 version) {
+    MutexLock lock(&mutex_);
+    if (version_ == version) {
+      if (++num_idle_workers_ == num_workers_) {
+        should_finish_ = true;
+        incumbent_changed_.SignalAll();
+      }
+      while (version_ == version && !should_finish_) {
+        incumbent_changed_.Wait(&mutex_);
+      }
+    }
+    return !should_finish_;
+  }
+
+  void Finish() {
+    MutexLock lock(&mutex_);
+    should_finish_ = true;
+    incumbent_changed_.SignalAll();
+  }
+
+  const SharedObjective* objective() const { return &objective_; }
+  int64 branches() const { return branches_; }
+  int64 failures() const { return failures_; }
+  int64 neighbors() const { return neighbors_; }
+  int64 accepted_neighbors() const { return accepted_neighbors_; }
+  int64 num_solutions() const { return num_solutions_; }
+  int64 num_imports() const { return num_imports_; }
+
+ private:
+  const CPModelProto& model_;
+  ParallelLocalSearch::LocalSearchFactory* const factory_;
+  const int num_workers_;
+  ParallelSolutionCollector* const collector_;
+  const SolutionLayout& layout_;
+
+  Mutex mutex_;
+  CondVar incumbent_changed_;
+  // The best solution, on all the decision variables of the original model.
+  Assignment* const incumbent_ GUARDED_BY(mutex_);
+  // These are only modified under the mutex, but read without it by the
+  // busy workers.
+  std::atomic<int64> version_;
+  std::atomic<bool> should_finish_;
+  SharedObjective objective_;
+  SharedLimit limit_;
+  // Number of workers waiting for an incumbent newer than version_.
+  int num_idle_workers_ GUARDED_BY(mutex_);
+
+  int64 branches_ GUARDED_BY(mutex_);
+  int64 failures_ GUARDED_BY(mutex_);
+  int64 neighbors_ GUARDED_BY(mutex_);
+  int64 accepted_neighbors_ GUARDED_BY(mutex_);
+  int64 num_solutions_ GUARDED_BY(mutex_);
+  int64 num_imports_ GUARDED_BY(mutex_);
+};
+
+// The solution pool of the local search of a worker. It keeps the last
+// solution of the worker as reference, unless another worker has improved the
+// incumbent since the worker last reported or imported a solution, in which
+// case the local search is synchronized with the incumbent.
+class WorkerSolutionPool : public SolutionPool {
+ public:
+  WorkerSolutionPool(SharedLocalSearchState* const state,
+                     const DecisionVariables& variables)
+      : state_(state), indices_(variables), seen_version_(0), num_imports_(0) {}
+  virtual ~WorkerSolutionPool() {}
+
+  virtual void Initialize(Assignment* const assignment) {
+    reference_assignment_.reset(new Assignment(assignment));
+  }
+
+  virtual void RegisterNewSolution(Assignment* const assignment) {
+    reference_assignment_->Copy(assignment);
+  }
+
+  virtual void GetNextSolution(Assignment* const assignment) {
+    if (SyncNeeded(assignment)) {
+      seen_version_ =
+          state_->ReadIncumbent(indices_, reference_assignment_.get());
+      num_imports_++;
+    }
+    assignment->Copy(reference_assignment_.get());
+  }
+
+  virtual bool SyncNeeded(Assignment* const local_assignment) {
+    return state_->version() != seen_version_;
+  }
+
+  virtual std::string DebugString() const { return "WorkerSolutionPool"; }
+
+  int64 seen_version() const { return seen_version_; }
+  void set_seen_version(int64 version) { seen_version_ = version; }
+  int64 num_imports() const { return num_imports_; }
+
+ private:
+  SharedLocalSearchState* const state_;
+  const VariableIndices indices_;
+  std::unique_ptr<Assignment> reference_assignment_;
+  int64 seen_version_;
+  int64 num_imports_;
+};
+
+bool SharedLocalSearchState::ReportSolution(Solver* const solver,
+                                            const Assignment& decision_values,
+                                            const Assignment& solution,
+                                            int64 objective_value,
+                                            WorkerSolutionPool* const pool) {
+  MutexLock lock(&mutex_);
+  if (objective_.IsImprovement(objective_value)) {
+    objective_.Set(objective_value);
+    CopyAssignmentValues(decision_values, incumbent_);
+    pool->set_seen_version(++version_);
+    num_solutions_++;
+    // All the waiting workers restart from the new incumbent.
+    num_idle_workers_ = 0;
+    incumbent_changed_.SignalAll();
+    if (collector_ != nullptr) {
+      collector_->AddSolution(solution, solver->wall_time(),
+                              solver->branches(), solver->failures());
+    }
+  }
+  return !should_finish_;
+}
+
+void SharedLocalSearchState::RunWorker(int worker_id) {
+  Solver solver(StringPrintf("%s_%d", model_.model().c_str(), worker_id));
+  solver.ReSeed(worker_id);
+  std::vector<SearchMonitor*> loaded_monitors;
+  DecisionVariables variables;
+  CHECK(solver.LoadModel(model_, &loaded_monitors, &variables.vars,
+                         &variables.intervals, &variables.sequences));
+
+  // The first solution of a worker is not bound by the shared objective.
+  std::vector<SearchMonitor*> monitors;
+  SearchLimit* limit = nullptr;
+  IntVar* const objective =
+      BuildWorkerMonitors(&solver, model_, loaded_monitors, &objective_, false,
+                          &should_finish_, &limit_, &monitors, &limit);
+  CHECK(objective != nullptr);
+  const int64 objective_bound = model_.objective().maximize()
+                                    ? objective->Max()
+                                    : objective->Min();
+
+  WorkerSolutionPool* const pool =
+      solver.RevAlloc(new WorkerSolutionPool(this, variables));
+  DecisionBuilder* const db = factory_->Run(&solver, variables, pool);
+  Assignment* const decision_values = solver.MakeAssignment();
+  decision_values->Add(variables.vars);
+  decision_values->Add(variables.intervals);
+  decision_values->Add(variables.sequences);
+  Assignment* const solution =
+      MakeWorkerSolution(&solver, layout_, variables, objective);
+
+  do {
+    solver.NewSearch(db, monitors);
+    while (solver.NextSolution()) {
+      decision_values->Store();
+      solution->Store();
+      const int64 objective_value = objective->Value();
+      if (!ReportSolution(&solver, *decision_values, *solution,
+                          objective_value, pool)) {
+        break;
+      }
+      if (objective_value == objective_bound) {
+        Finish();
+        break;
+      }
+    }
+    solver.EndSearch();
+    if (limit->crossed()) Finish();
+    VLOG(1) << "Worker " << worker_id << " stopped at version "
+            << pool->seen_version();
+  } while (WaitForNewIncumbent(pool->seen_version()));
+
+  MutexLock lock(&mutex_);
+  branches_ += solver.branches();
+  failures_ += solver.failures();
+  neighbors_ += solver.neighbors();
+  accepted_neighbors_ += solver.accepted_neighbors();
+  num_imports_ += pool->num_imports();
+  VLOG(1) << "Worker " << worker_id << ": " << solver.neighbors()
+          << " neighbors, " << solver.accepted_neighbors() << " accepted, "
+          << pool->num_imports() << " imported solutions";
+}
+
+}  // namespace
+
+ParallelLocalSearch::ParallelLocalSearch(
+    Solver* const solver, DecisionBuilder* const db,
+    const std::vector<SearchMonitor*>& monitors,
+    LocalSearchFactory* const factory, int num_workers)
+    : solver_(solver),
+      factory_(factory),
+      num_workers_(num_workers),
+      objective_(nullptr),
+      branches_(0),
+      failures_(0),
+      neighbors_(0),
+      accepted_neighbors_(0),
+      num_solutions_(0),
+      num_imports_(0),
+      best_objective_(0) {
+  CHECK_GT(num_workers, 0);
+  CHECK(factory != nullptr);
+  factory->CheckIsRepeatable();
+  objective_ = FindObjective(monitors);
+  CHECK(objective_ != nullptr) << "The local search needs an objective.";
+  solver->ExportModel(monitors, &model_, db);
+  VariableGroupCollector collector(&decision_variables_);
+  db->Accept(&collector);
+}
+
+ParallelLocalSearch::~ParallelLocalSearch() {}
+
+bool ParallelLocalSearch::Solve(ParallelSolutionCollector* const collector) {
+  SolutionLayout layout;
+  layout.has_objective = false;
+  if (collector != nullptr) {
+    BuildSolutionLayout(*collector->prototype(), decision_variables_,
+                        objective_, &layout);
+    collector->EnterSearch();
+  }
+
+  // The incumbent is stored on the decision variables of the original model.
+  Assignment incumbent(solver_);
+  incumbent.Add(decision_variables_.vars);
+  incumbent.Add(decision_variables_.intervals);
+  incumbent.Add(decision_variables_.sequences);
+
+  SharedLocalSearchState state(model_, factory_.get(), num_workers_, collector,
+                               layout, &incumbent);
+  {
+    ThreadPool thread_pool("ParallelLocalSearch", num_workers_);
+    for (int worker_id = 0; worker_id < num_workers_; ++worker_id) {
+      thread_pool.Add(
+          NewCallback(&state, &SharedLocalSearchState::RunWorker, worker_id));
+    }
+    thread_pool.StartWorkers();
+  }
+  branches_ = state.branches();
+  failures_ = state.failures();
+  neighbors_ = state.neighbors();
+  accepted_neighbors_ = state.accepted_neighbors();
+  num_solutions_ = state.num_solutions();
+  num_imports_ = state.num_imports();
+  state.objective()->Get(&best_objective_);
+  return num_solutions_ > 0;
+}
+
+}  // namespace operations_research
@@ -0,0 +1,227 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Parallel tree search for the constraint solver.
+//
+// The model of a solver is exported to a CPModelProto, and each worker thread
+// loads it into its own Solver. The workers then explore disjoint parts of the
+// search tree of the same decision builder:
+//   - A subtree is described by a decision path, i.e. the list of the
+//     decisions (and of the branch taken for each of them) leading from the
+//     root to it. A path is made of solver independent decisions (assign a
+//     value, split a domain, rank a sequence) expressed on the indices of the
+//     decision variables, so it can be replayed in any worker.
+//   - Work is distributed by stealing: when a worker runs out of work, the
+//     busy workers give away the right branch of the shallowest open choice
+//     point of their search, which is then refuted locally.
+//   - The objective is shared through a subclass of OptimizeVar which reads
+//     the best objective value found by any worker at each refutation.
+//   - Solutions are copied, on the variables of the original model, into a
+//     thread-safe ParallelSolutionCollector.
+//
+// Only the right branches of decisions that can be described in a solver
+// independent way are given away. The decision builders of the workers must
+// be deterministic and complete from any node (this is the case of all the
+// builders returned by Solver::MakePhase()), and the search must not be
+// restarted nor its decisions modified by a search monitor.
+//
+// ParallelLocalSearch runs, in the same way, one local search (or large
+// neighborhood search) per worker on a copy of the model:
+//   - The workers share the best solution found through a thread-safe
+//     SolutionPool: the local search of a worker switches to the shared
+//     incumbent as soon as another worker has improved it, and an improving
+//     neighbor found by a worker is accepted as the new incumbent if nobody
+//     has found a better one in the meantime.
+//   - A worker that reaches a local optimum waits for another worker to
+//     improve the incumbent and then restarts from it. The search stops when
+//     all the workers are waiting, when a search limit is crossed, or when
+//     the objective reaches its lower (resp. upper) bound.
+
+#ifndef OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
+#define OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
+
+#include "base/unique_ptr.h"
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/model.pb.h"
+
+namespace operations_research {
+
+// The decision variables of one copy of a model, i.e. the variables of the
+// variable groups of its decision builder in the order in which
+// DecisionBuilder::Accept() visits them.
+struct DecisionVariables {
+  std::vector<IntVar*> vars;
+  std::vector<IntervalVar*> intervals;
+  std::vector<SequenceVar*> sequences;
+};
+
+// A thread-safe collector of the solutions found by the workers of a
+// ParallelSearch. The solutions are stored on the variables of the original
+// model, so the usual SolutionCollector accessors can be used once the search
+// is over. Only the variables of the decision builder and the objective can be
+// added to the collector.
+class ParallelSolutionCollector : public SolutionCollector {
+ public:
+  // If keep_all_solutions is false, only the best solution (the last one for
+  // a model without objective) is kept.
+  ParallelSolutionCollector(Solver* const solver, bool keep_all_solutions);
+  virtual ~ParallelSolutionCollector();
+
+  // Stores a copy of the given solution, which must contain the elements of
+  // the prototype of this collector, in the same order, on the variables of a
+  // worker. wall_time, branches and failures are the statistics of the worker
+  // when it found the solution. This method can be called concurrently.
+  void AddSolution(const Assignment& solution, int64 wall_time,
+                   int64 branches, int64 failures);
+
+  // Returns the prototype of the collected solutions.
+  const Assignment* prototype() const { return prototype_.get(); }
+
+  virtual std::string DebugString() const {
+    return "ParallelSolutionCollector()";
+  }
+
+ private:
+  const bool keep_all_solutions_;
+  Mutex mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelSolutionCollector);
+};
+
+class ParallelSearch {
+ public:
+  // Builds the decision builder of a worker from the copy of the model loaded
+  // in its solver. It must describe the same search as the decision builder
+  // of the original model.
+  typedef ResultCallback2<DecisionBuilder*, Solver*, const DecisionVariables&>
+      DecisionBuilderFactory;
+
+  // The model of 'solver' is exported with the given monitors (an
+  // OptimizeVar and a search limit are exported with it, the other monitors
+  // are ignored) and the variable groups of 'db'. Takes ownership of the
+  // factory.
+  ParallelSearch(Solver* const solver, DecisionBuilder* const db,
+                 const std::vector<SearchMonitor*>& monitors,
+                 DecisionBuilderFactory* const factory, int num_workers);
+  ~ParallelSearch();
+
+  // Stops the search after that many solutions were found by all the workers.
+  void set_solution_limit(int64 solution_limit) {
+    solution_limit_ = solution_limit;
+  }
+
+  // Explores the search tree with num_workers threads until it is exhausted
+  // (or until the solution limit or the exported search limit is reached),
+  // and reports all the solutions to the given collector, which can be
+  // nullptr. Returns true if at least one solution was found. The exported
+  // search limit applies to the whole parallel search: its time starts with
+  // Solve(), and its branches, failures and solutions are summed over all the
+  // workers.
+  bool Solve(ParallelSolutionCollector* const collector);
+
+  // Statistics of the last call to Solve(), summed over all the workers.
+  int64 branches() const { return branches_; }
+  int64 failures() const { return failures_; }
+  int64 solutions() const { return num_solutions_; }
+  // Number of subtrees given away by a worker to another one.
+  int64 steals() const { return num_steals_; }
+  // Best objective value found, only meaningful for a model with objective.
+  int64 best_objective() const { return best_objective_; }
+
+ private:
+  CPModelProto model_;
+  std::unique_ptr<DecisionBuilderFactory> factory_;
+  const int num_workers_;
+  int64 solution_limit_;
+  // The decision variables of the original model, and its objective.
+  DecisionVariables decision_variables_;
+  IntVar* objective_;
+
+  // Statistics of the last search.
+  int64 branches_;
+  int64 failures_;
+  int64 num_solutions_;
+  int64 num_steals_;
+  int64 best_objective_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelSearch);
+};
+
+class ParallelLocalSearch {
+ public:
+  // Builds the local search of a worker from the copy of the model loaded in
+  // its solver. The solution pool must be given to the
+  // LocalSearchPhaseParameters of the local search, which must search the
+  // decision variables of the original decision builder. The solver of each
+  // worker is reseeded with the index of the worker, so randomized operators
+  // seeded from Solver::Rand32() explore different neighborhoods.
+  typedef ResultCallback3<DecisionBuilder*, Solver*, const DecisionVariables&,
+                          SolutionPool*> LocalSearchFactory;
+
+  // The model of 'solver' is exported with the given monitors, which must
+  // contain an OptimizeVar and can contain a search limit, and the variable
+  // groups of 'db'. Takes ownership of the factory.
+  ParallelLocalSearch(Solver* const solver, DecisionBuilder* const db,
+                      const std::vector<SearchMonitor*>& monitors,
+                      LocalSearchFactory* const factory, int num_workers);
+  ~ParallelLocalSearch();
+
+  // Runs the local searches of the workers until they all reach a local
+  // optimum of the shared incumbent, or until the exported search limit is
+  // crossed, and reports each new incumbent to the given collector, which can
+  // be nullptr. Returns true if at least one solution was found. Like for
+  // ParallelSearch, the exported search limit applies to the whole search,
+  // including the restarts of the workers from a new incumbent.
+  bool Solve(ParallelSolutionCollector* const collector);
+
+  // Statistics of the last call to Solve(), summed over all the workers.
+  int64 branches() const { return branches_; }
+  int64 failures() const { return failures_; }
+  int64 neighbors() const { return neighbors_; }
+  int64 accepted_neighbors() const { return accepted_neighbors_; }
+  // Number of times the incumbent was improved.
+  int64 solutions() const { return num_solutions_; }
+  // Number of times a worker switched to an incumbent found by another one.
+  int64 imports() const { return num_imports_; }
+  int64 best_objective() const { return best_objective_; }
+
+ private:
+  Solver* const solver_;
+  CPModelProto model_;
+  std::unique_ptr<LocalSearchFactory> factory_;
+  const int num_workers_;
+  DecisionVariables decision_variables_;
+  IntVar* objective_;
+
+  // Statistics of the last search.
+  int64 branches_;
+  int64 failures_;
+  int64 neighbors_;
+  int64 accepted_neighbors_;
+  int64 num_solutions_;
+  int64 num_imports_;
+  int64 best_objective_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelLocalSearch);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
@@ -50,6 +50,17 @@ DEFINE_bool(cp_use_cumulative_edge_finder, true,
             "Resources in O(kn log n)' by Petr Vilim, CP 2009.");
 DEFINE_bool(cp_use_cumulative_time_table, true,
             "Use a O(n^2) cumulative time table propagation algorithm.");
+DEFINE_bool(cp_use_cumulative_tt_edge_finder, false,
+            "Use the O(n^2) timetable edge finding algorithm described in "
+            "'Timetable Edge Finding Filtering Algorithm for Discrete "
+            "Cumulative Resources' by Petr Vilim, CPAIOR 2011, in the "
+            "cumulative time table. Only used if "
+            "--cp_use_cumulative_time_table is true.");
+DEFINE_int64(cp_cumulative_tt_edge_finder_work_limit, 100,
+             "Maximum number of time windows examined by one call of the "
+             "cumulative timetable edge finding, per task: a call on n tasks "
+             "examines at most n times this number of windows, instead of "
+             "the O(n^2) windows of the full algorithm.");
 DEFINE_bool(cp_use_sequence_high_demand_tasks, true,
             "Use a sequence constraints for cumulative tasks that have a "
             "demand greater than half of the capacity of the resource.");
@@ -1638,33 +1649,143 @@ struct ProfileDelta {
   int64 delta;
 };
 
-bool TimeLessThan(const ProfileDelta& delta1, const ProfileDelta& delta2) {
-  return delta1.time < delta2.time;
+bool TimeLessThanDelta(int64 time, const ProfileDelta& delta) {
+  return time < delta.time;
 }
 
+// Sorts the given vector, which is expected to be nearly sorted, by insertion,
+// and falls back to std::sort when too many elements have moved. Returns the
+// number of moves done.
+template <class T, class Compare>
+int64 SortNearlySorted(std::vector<T>* const elements, Compare less_than) {
+  const int size = elements->size();
+  const int64 max_moves = 8 * size + 64;
+  int64 moves = 0;
+  for (int i = 1; i < size; ++i) {
+    if (!less_than((*elements)[i], (*elements)[i - 1])) {
+      continue;
+    }
+    const T element = (*elements)[i];
+    int j = i;
+    while (j > 0 && less_than(element, (*elements)[j - 1])) {
+      (*elements)[j] = (*elements)[j - 1];
+      --j;
+    }
+    (*elements)[j] = element;
+    moves += i - j;
+    if (moves > max_moves) {
+      std::sort(elements->begin() + i + 1, elements->end(), less_than);
+      std::inplace_merge(elements->begin(), elements->begin() + i + 1,
+                         elements->end(), less_than);
+      return moves + size;
+    }
+  }
+  return moves;
+}
+
+// The state of a task used by the timetable edge finding.
+struct EnergyTask {
+  // Earliest start time, latest completion time, duration and demand of the
+  // task. The demand is 0 if the task cannot be performed.
+  int64 est;
+  int64 lct;
+  int64 duration;
+  int64 demand;
+  // The energy of the task outside of its compulsory part, 0 if the task is
+  // optional.
+  int64 free_energy;
+  // The compulsory part of the task, [compulsory_start, compulsory_end),
+  // empty if the task is optional.
+  int64 compulsory_start;
+  int64 compulsory_end;
+  // The energy of the profile before est and lct.
+  int64 energy_before_est;
+  int64 energy_before_lct;
+};
+
+class EnergyTaskEstLessThan {
+ public:
+  explicit EnergyTaskEstLessThan(const std::vector<EnergyTask>* const tasks)
+      : tasks_(tasks) {}
+  bool operator()(int i, int j) const {
+    return (*tasks_)[i].est < (*tasks_)[j].est;
+  }
+
+ private:
+  const std::vector<EnergyTask>* const tasks_;
+};
+
+class EnergyTaskLctLessThan {
+ public:
+  explicit EnergyTaskLctLessThan(const std::vector<EnergyTask>* const tasks)
+      : tasks_(tasks) {}
+  bool operator()(int i, int j) const {
+    return (*tasks_)[i].lct < (*tasks_)[j].lct;
+  }
+
+ private:
+  const std::vector<EnergyTask>* const tasks_;
+};
+
+// Duration, in seconds of deterministic time, of an elementary step of the
+// cumulative time table.
+const double kTimeTableStepDuration = 1e-9;
+
 // Cumulative time-table.
 //
-// This class implements a propagator for the CumulativeConstraint which is not
-// incremental, and where a call to InitialPropagate() takes time which is
-// O(n^2) and Omega(n log n) with n the number of cumulative tasks.
+// This class implements a propagator for the CumulativeConstraint, where a
+// call to InitialPropagate() takes time which is O(n^2) and Omega(n) with n
+// the number of cumulative tasks.
 //
 // Despite the high complexity, this propagator is needed, because of those
 // implemented, it is the only one that satisfy that if all instantiated, no
 // contradiction will be detected if and only if the constraint is satisfied.
 //
-// The implementation is quite naive, and could certainly be improved, for
-// example by maintaining the profile incrementally.
+// The profile is rebuilt at each call, but the events it is built from (the
+// start and the end of the compulsory part of each task) and the tasks are
+// kept sorted between two calls, and their order is repaired by an insertion
+// sort, which is linear when only a few tasks have moved since the last call.
+//
+// If use_tt_edge_finding is true, the propagator also runs the timetable edge
+// finding described in "Timetable Edge Finding Filtering Algorithm for
+// Discrete Cumulative Resources" by Petr Vilim, CPAIOR 2011, which combines
+// the energy of the profile with the energy of the tasks contained in a time
+// window. It runs after the time table on a profile rebuilt with the new
+// start mins, in O(n^2), and examines at most n times
+// --cp_cumulative_tt_edge_finder_work_limit windows per call.
+//
+// The work of the propagator is accounted for in the deterministic time of
+// the solver.
 template <class Task>
 class CumulativeTimeTable : public Constraint {
  public:
   CumulativeTimeTable(Solver* const solver, const std::vector<Task*>& tasks,
-                      IntVar* const capacity)
-      : Constraint(solver), by_start_min_(tasks), capacity_(capacity) {
+                      IntVar* const capacity, bool use_tt_edge_finding)
+      : Constraint(solver),
+        tasks_(tasks),
+        by_start_min_(tasks),
+        capacity_(capacity),
+        use_tt_edge_finding_(use_tt_edge_finding),
+        work_(0) {
     // There may be up to 2 delta's per interval (one on each side),
     // plus two sentinels
     const int profile_max_size = 2 * by_start_min_.size() + 2;
-    profile_non_unique_time_.reserve(profile_max_size);
+    events_.reserve(2 * tasks.size());
+    for (Task* const task : tasks) {
+      events_.push_back(ProfileEvent(task, true));
+      events_.push_back(ProfileEvent(task, false));
+    }
     profile_unique_time_.reserve(profile_max_size);
+    if (use_tt_edge_finding_) {
+      profile_energy_.reserve(profile_max_size);
+      profile_usage_.reserve(profile_max_size);
+      energy_tasks_.resize(tasks.size());
+      new_start_min_.resize(tasks.size());
+      for (int i = 0; i < tasks.size(); ++i) {
+        by_est_.push_back(i);
+        by_lct_.push_back(i);
+      }
+    }
   }
 
   virtual ~CumulativeTimeTable() { STLDeleteElements(&by_start_min_); }
@@ -1672,6 +1793,12 @@ class CumulativeTimeTable : public Constraint {
   virtual void InitialPropagate() {
     BuildProfile();
     PushTasks();
+    if (use_tt_edge_finding_) {
+      // PushTasks() may have extended the compulsory parts of the tasks.
+      BuildProfile();
+      TimeTableEdgeFinding();
+    }
+    AccountWork();
     // TODO(user): When a task has a fixed part, we could propagate
     // max_demand from its current location.
   }
@@ -1693,37 +1820,61 @@ class CumulativeTimeTable : public Constraint {
   virtual std::string DebugString() const { return "CumulativeTimeTable"; }
 
  private:
-  // Build the usage profile. Runs in O(n log n).
+  // The start or the end of the compulsory part of a task. The time and the
+  // delta of the events are refreshed at each call, and the events are kept
+  // sorted by time between two calls.
+  struct ProfileEvent {
+    ProfileEvent(Task* const t, bool s)
+        : task(t), is_start(s), time(0), delta(0) {}
+    Task* task;
+    bool is_start;
+    int64 time;
+    int64 delta;
+  };
+
+  static bool EventTimeLessThan(const ProfileEvent& event1,
+                                const ProfileEvent& event2) {
+    return event1.time < event2.time;
+  }
+
+  // Adds the work done since the last call to the deterministic time of the
+  // solver. It is called before each operation that may fail.
+  void AccountWork() {
+    solver()->AdvanceDeterministicTime(work_ * kTimeTableStepDuration);
+    work_ = 0;
+  }
+
+  // Build the usage profile. Runs in O(n) when the order of the events did not
+  // change much since the last call, and in O(n log n) otherwise.
   void BuildProfile() {
-    // Build profile with non unique time
-    profile_non_unique_time_.clear();
-    for (const Task* const task : by_start_min_) {
-      const IntervalVar* const interval = task->interval;
+    // Refresh the events.
+    for (ProfileEvent& event : events_) {
+      const IntervalVar* const interval = event.task->interval;
       const int64 start_max = interval->StartMax();
       const int64 end_min = interval->EndMin();
+      event.time = event.is_start ? start_max : end_min;
+      event.delta = 0;
       if (interval->MustBePerformed() && start_max < end_min) {
-        const int64 demand_min = task->DemandMin();
-        if (demand_min > 0) {
-          profile_non_unique_time_.emplace_back(start_max, +demand_min);
-          profile_non_unique_time_.emplace_back(end_min, -demand_min);
-        }
+        const int64 demand_min = event.task->DemandMin();
+        event.delta = event.is_start ? demand_min : -demand_min;
       }
     }
-    // Sort
-    std::sort(profile_non_unique_time_.begin(), profile_non_unique_time_.end(),
-              TimeLessThan);
+    work_ += events_.size() + SortNearlySorted(&events_, EventTimeLessThan);
     // Build profile with unique times
     profile_unique_time_.clear();
     profile_unique_time_.emplace_back(kint64min, 0);
     int64 usage = 0;
-    for (const ProfileDelta& step : profile_non_unique_time_) {
-      if (step.time == profile_unique_time_.back().time) {
-        profile_unique_time_.back().delta += step.delta;
+    for (const ProfileEvent& event : events_) {
+      if (event.delta == 0) {
+        continue;
+      }
+      if (event.time == profile_unique_time_.back().time) {
+        profile_unique_time_.back().delta += event.delta;
       } else {
-        profile_unique_time_.push_back(step);
+        profile_unique_time_.emplace_back(event.time, event.delta);
       }
       // Update usage.
-      usage += step.delta;
+      usage += event.delta;
     }
     // Check final usage to be 0.
     DCHECK_EQ(0, usage);
@@ -1736,6 +1887,7 @@ class CumulativeTimeTable : public Constraint {
       }
     }
     DCHECK_EQ(0, usage);
+    AccountWork();
     capacity_->SetMin(max_usage);
     // Add a sentinel.
     profile_unique_time_.emplace_back(kint64max, 0);
@@ -1743,8 +1895,8 @@ class CumulativeTimeTable : public Constraint {
 
   // Update the start min for all tasks. Runs in O(n^2) and Omega(n).
   void PushTasks() {
-    std::sort(by_start_min_.begin(), by_start_min_.end(),
-              StartMinLessThan<Task>);
+    work_ += by_start_min_.size() +
+             SortNearlySorted(&by_start_min_, StartMinLessThan<Task>);
     int64 usage = 0;
     int profile_index = 0;
     for (const Task* const task : by_start_min_) {
@@ -1804,6 +1956,7 @@ class CumulativeTimeTable : public Constraint {
       delta_start.delta = +demand_min;
       delta_end.delta = -demand_min;
     }
+    const int first_profile_index = profile_index;
     while (profile_unique_time_[profile_index].time <
            duration + new_start_min) {
       const ProfileDelta& profile_delta = profile_unique_time_[profile_index];
@@ -1824,15 +1977,209 @@ class CumulativeTimeTable : public Constraint {
       }
       usage += profile_unique_time_[profile_index].delta;
     }
+    work_ += profile_index - first_profile_index + 1;
+    AccountWork();
     task->interval->SetStartMin(new_start_min);
   }
 
+  // ----- Timetable edge finding -----
+
+  // Computes the energy of the profile before each of its times, and the
+  // usage from each of them.
+  void BuildProfileEnergy() {
+    profile_energy_.clear();
+    profile_usage_.clear();
+    int64 energy = 0;
+    int64 usage = 0;
+    for (int i = 0; i < profile_unique_time_.size(); ++i) {
+      // The usage is 0 around the sentinels, whose times are kint64min and
+      // kint64max.
+      if (usage != 0) {
+        energy = CapAdd(
+            energy, CapProd(usage, profile_unique_time_[i].time -
+                                       profile_unique_time_[i - 1].time));
+      }
+      usage += profile_unique_time_[i].delta;
+      profile_energy_.push_back(energy);
+      profile_usage_.push_back(usage);
+    }
+    work_ += profile_unique_time_.size();
+  }
+
+  // Returns the energy of the profile before the given time. Runs in
+  // O(log n).
+  int64 ProfileEnergyBefore(int64 time) const {
+    // The first element of the profile is a sentinel at kint64min, so index
+    // is at least 0.
+    const int index =
+        std::upper_bound(profile_unique_time_.begin(),
+                         profile_unique_time_.end(), time, TimeLessThanDelta) -
+        profile_unique_time_.begin() - 1;
+    const int64 usage = profile_usage_[index];
+    if (usage == 0) {
+      return profile_energy_[index];
+    }
+    return CapAdd(profile_energy_[index],
+                  CapProd(usage, time - profile_unique_time_[index].time));
+  }
+
+  // Fills energy_tasks_ with the current state of the tasks.
+  void BuildEnergyTasks() {
+    for (int i = 0; i < tasks_.size(); ++i) {
+      const Task* const task = tasks_[i];
+      const IntervalVar* const interval = task->interval;
+      EnergyTask* const energy_task = &energy_tasks_[i];
+      energy_task->est = interval->StartMin();
+      energy_task->lct = interval->EndMax();
+      energy_task->duration = interval->DurationMin();
+      energy_task->demand =
+          interval->MayBePerformed() ? task->DemandMin() : 0;
+      energy_task->compulsory_start = interval->StartMax();
+      energy_task->compulsory_end = interval->StartMax();
+      energy_task->free_energy = 0;
+      if (interval->MustBePerformed()) {
+        int64 compulsory_duration = 0;
+        if (interval->StartMax() < interval->EndMin()) {
+          energy_task->compulsory_end = interval->EndMin();
+          compulsory_duration = interval->EndMin() - interval->StartMax();
+        }
+        energy_task->free_energy = CapProd(
+            energy_task->demand,
+            std::max<int64>(0, CapSub(energy_task->duration,
+                                      compulsory_duration)));
+      }
+      energy_task->energy_before_est = ProfileEnergyBefore(energy_task->est);
+      energy_task->energy_before_lct = ProfileEnergyBefore(energy_task->lct);
+      new_start_min_[i] = energy_task->est;
+    }
+    work_ += 2 * tasks_.size();
+    const EnergyTaskEstLessThan est_less_than(&energy_tasks_);
+    const EnergyTaskLctLessThan lct_less_than(&energy_tasks_);
+    work_ += SortNearlySorted(&by_est_, est_less_than) +
+             SortNearlySorted(&by_lct_, lct_less_than);
+  }
+
+  // Returns the energy of the compulsory part of a task before the given
+  // time.
+  static int64 CompulsoryEnergyBefore(const EnergyTask& task, int64 time) {
+    const int64 end = std::min(task.compulsory_end, time);
+    return end > task.compulsory_start
+               ? CapProd(task.demand, CapSub(end, task.compulsory_start))
+               : 0;
+  }
+
+  // For each window [begin, end) where begin is the earliest start time of a
+  // task and end the latest completion time of a task, the energy required in
+  // the window is at least the energy of the profile in it plus the free
+  // energy (outside their compulsory part) of the tasks contained in it. The
+  // propagator fails if this exceeds the available energy. Otherwise, among
+  // the tasks starting in the window but ending after it, the one which would
+  // require the most energy in the window if started at its earliest start
+  // time is pushed if it does not fit.
+  void TimeTableEdgeFinding() {
+    BuildProfileEnergy();
+    BuildEnergyTasks();
+    const int num_tasks = energy_tasks_.size();
+    const int64 capacity = capacity_->Max();
+    const int64 max_num_windows =
+        CapProd(num_tasks, FLAGS_cp_cumulative_tt_edge_finder_work_limit);
+    int64 num_windows = 0;
+    for (int j = num_tasks - 1; j >= 0; --j) {
+      const EnergyTask& end_task = energy_tasks_[by_lct_[j]];
+      const int64 end = end_task.lct;
+      // The windows ending at the same time are the same.
+      if (j + 1 < num_tasks && energy_tasks_[by_lct_[j + 1]].lct == end) {
+        continue;
+      }
+      int64 free_energy = 0;
+      int64 max_extra_energy = 0;
+      int pushed_task = -1;
+      for (int i = num_tasks - 1; i >= 0; --i) {
+        const int index = by_est_[i];
+        const EnergyTask& task = energy_tasks_[index];
+        if (task.est >= end) {
+          continue;
+        }
+        if (task.lct <= end) {
+          free_energy = CapAdd(free_energy, task.free_energy);
+        } else if (task.demand > 0) {
+          // The energy the task would require in the window, on top of its
+          // compulsory part, if it started at its earliest start time.
+          const int64 extra_energy = CapSub(
+              CapProd(task.demand,
+                      std::min(CapSub(end, task.est), task.duration)),
+              CompulsoryEnergyBefore(task, end));
+          if (extra_energy > max_extra_energy) {
+            max_extra_energy = extra_energy;
+            pushed_task = index;
+          }
+        }
+        // The window starting at task.est is only complete once all the
+        // tasks starting at the same time are seen.
+        if (i > 0 && energy_tasks_[by_est_[i - 1]].est == task.est) {
+          continue;
+        }
+        ++num_windows;
+        const int64 begin = task.est;
+        const int64 required_energy =
+            CapAdd(free_energy, CapSub(end_task.energy_before_lct,
+                                       task.energy_before_est));
+        const int64 available_energy = CapProd(capacity, CapSub(end, begin));
+        if (required_energy > available_energy) {
+          work_ += num_windows;
+          AccountWork();
+          // Fails, as the ratio is greater than the max of the capacity.
+          capacity_->SetMin(
+              MathUtil::CeilOfRatio(required_energy, end - begin));
+        }
+        const int64 free_available_energy =
+            CapSub(available_energy, required_energy);
+        if (pushed_task != -1 && max_extra_energy > free_available_energy) {
+          const EnergyTask& pushed = energy_tasks_[pushed_task];
+          const int64 slack = CapAdd(free_available_energy,
+                                     CompulsoryEnergyBefore(pushed, end));
+          const int64 new_start_min = CapSub(end, slack / pushed.demand);
+          if (new_start_min > new_start_min_[pushed_task]) {
+            new_start_min_[pushed_task] = new_start_min;
+          }
+        }
+      }
+      if (num_windows > max_num_windows) {
+        break;
+      }
+    }
+    work_ += num_windows;
+    AccountWork();
+    for (int i = 0; i < num_tasks; ++i) {
+      if (new_start_min_[i] > energy_tasks_[i].est) {
+        tasks_[i]->interval->SetStartMin(new_start_min_[i]);
+      }
+    }
+  }
+
   typedef std::vector<ProfileDelta> Profile;
 
+  // The tasks in their original order; by_start_min_ owns them.
+  const std::vector<Task*> tasks_;
+  std::vector<ProfileEvent> events_;
   Profile profile_unique_time_;
-  Profile profile_non_unique_time_;
   std::vector<Task*> by_start_min_;
   IntVar* const capacity_;
+  const bool use_tt_edge_finding_;
+  // Number of elementary steps done since the last call to AccountWork().
+  int64 work_;
+
+  // Timetable edge finding.
+  // profile_energy_[i] is the energy of the profile before
+  // profile_unique_time_[i].time, and profile_usage_[i] its usage from it.
+  std::vector<int64> profile_energy_;
+  std::vector<int64> profile_usage_;
+  std::vector<EnergyTask> energy_tasks_;
+  // Indices of energy_tasks_ sorted by earliest start time, and by latest
+  // completion time.
+  std::vector<int> by_est_;
+  std::vector<int> by_lct_;
+  std::vector<int64> new_start_min_;
 
   DISALLOW_COPY_AND_ASSIGN(CumulativeTimeTable);
 };
@@ -1988,7 +2335,8 @@ class CumulativeConstraint : public Constraint {
             new EdgeFinder<CumulativeTask>(s, useful_tasks, capacity_));
       } else {
         return s->RevAlloc(new CumulativeTimeTable<CumulativeTask>(
-            s, useful_tasks, capacity_));
+            s, useful_tasks, capacity_,
+            FLAGS_cp_use_cumulative_tt_edge_finder));
       }
     }
   }
@@ -2141,7 +2489,7 @@ class VariableDemandCumulativeConstraint : public Constraint {
       }
       // Add to the useful_task vector if it may be performed and that it
       // actually consumes some of the resource.
-      if (interval->MayBePerformed() && original_task.demand > 0) {
+      if (interval->MayBePerformed() && original_task.demand->Max() > 0) {
         Solver* const s = solver();
         IntervalVar* const original_interval = original_task.interval;
         IntervalVar* const interval =
@@ -2168,7 +2516,8 @@ class VariableDemandCumulativeConstraint : public Constraint {
             new EdgeFinder<VariableCumulativeTask>(s, useful_tasks, capacity_));
       } else {
         return s->RevAlloc(new CumulativeTimeTable<VariableCumulativeTask>(
-            s, useful_tasks, capacity_));
+            s, useful_tasks, capacity_,
+            FLAGS_cp_use_cumulative_tt_edge_finder));
       }
     }
   }
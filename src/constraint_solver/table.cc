@@ -416,7 +416,7 @@ class PositiveTableConstraint : public BasePositiveTableConstraint {
     const uint64 current_stamp = solver()->stamp();
     if (stamps_[offset] < current_stamp) {
       stamps_[offset] = current_stamp;
-      solver()->SaveValue(&active_tuples_[offset]);
+      saver_.SaveWord(solver(), active_tuples_.get(), length_, offset);
     }
     active_tuples_[offset] &= mask;
   }
@@ -425,6 +425,7 @@ class PositiveTableConstraint : public BasePositiveTableConstraint {
   // TODO(user): create bitset64 class and use it.
   std::unique_ptr<uint64[]> active_tuples_;
   std::unique_ptr<uint64[]> stamps_;
+  RevWordArraySaver saver_;
   std::vector<ValueBitset> masks_;
 };
 
@@ -890,7 +891,7 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
     const uint64 current_stamp = solver()->stamp();
     if (stamps_[offset] < current_stamp) {
       stamps_[offset] = current_stamp;
-      solver()->SaveValue(&active_tuples_[offset]);
+      saver_.SaveWord(solver(), active_tuples_.get(), length_, offset);
     }
     active_tuples_[offset] &= mask;
   }
@@ -901,6 +902,8 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
   std::unique_ptr<uint64[]> active_tuples_;
   // Array of stamps, one per 64 tuples.
   std::unique_ptr<uint64[]> stamps_;
+  // Saves the words of active_tuples_.
+  RevWordArraySaver saver_;
   // The masks per value per variable.
   std::vector<std::vector<uint64*>> masks_;
   // The min on the vars at creation time.
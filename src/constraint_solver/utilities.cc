@@ -75,7 +75,7 @@ void RevBitSet::Save(Solver* const solver, int offset) {
   const uint64 current_stamp = solver->stamp();
   if (current_stamp > stamps_[offset]) {
     stamps_[offset] = current_stamp;
-    solver->SaveValue(&bits_[offset]);
+    saver_.SaveWord(solver, bits_, length_, offset);
   }
 }
 
@@ -0,0 +1,238 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "glop/basis_cache.h"
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>  // NOLINT
+#include "base/unique_ptr.h"
+
+#include "base/file.h"
+#include "base/fingerprint2011.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "base/map_util.h"
+#include "base/stringprintf.h"
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+// A saved basis is a header line:
+//   glop_basis_cache_v1 <fingerprint> <num_rows> <num_cols> <num_iterations>
+// followed by the num_cols + num_rows statuses of BasisState::statuses, one
+// character '0' + status per variable.
+const char kFileHeader[] = "glop_basis_cache_v1";
+
+// Returns a suffix that is unique to the calling process and thread, so that
+// two concurrent writers of the same file never share a temporary file.
+std::string TemporaryFileSuffix() {
+#if !defined(_MSC_VER)
+  const int pid = getpid();
+#else
+  const int pid = _getpid();
+#endif
+  const size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return StringPrintf(".tmp-%d-%llx", pid,
+                      static_cast<unsigned long long>(tid));  // NOLINT
+}
+
+}  // namespace
+
+BasisCache::BasisCache(const std::string& directory)
+    : directory_(directory),
+      mutex_(),
+      entries_(),
+      num_lookups_(0),
+      num_hits_(0),
+      num_iterations_saved_(0) {}
+
+uint64 BasisCache::ComputeFingerprint(const LinearProgram& lp) {
+  uint64 fingerprint = FingerprintCat2011(lp.num_constraints().value(),
+                                          lp.num_variables().value());
+  const SparseMatrix& matrix = lp.GetSparseMatrix();
+  const ColIndex num_cols = lp.num_variables();
+  for (ColIndex col(0); col < num_cols; ++col) {
+    const SparseColumn& column = matrix.column(col);
+    fingerprint =
+        FingerprintCat2011(fingerprint, column.num_entries().value());
+    for (const SparseColumn::Entry e : column) {
+      const Fractional coefficient = e.coefficient();
+      uint64 coefficient_bits;
+      memcpy(&coefficient_bits, &coefficient, sizeof(coefficient_bits));
+      fingerprint = FingerprintCat2011(fingerprint, e.row().value());
+      fingerprint = FingerprintCat2011(fingerprint, coefficient_bits);
+    }
+  }
+  return fingerprint;
+}
+
+bool BasisCache::Lookup(uint64 fingerprint, BasisState* state) {
+  CHECK(state != nullptr);
+  {
+    MutexLock mutex_lock(&mutex_);
+    ++num_lookups_;
+    Entry* const entry = FindOrNull(entries_, fingerprint);
+    if (entry != nullptr) {
+      ++num_hits_;
+      entry->was_looked_up = true;
+      *state = entry->state;
+      return true;
+    }
+  }
+
+  // The file is read without holding the mutex so that the other threads are
+  // not blocked by the disk. If another thread stored or read an entry for the
+  // same fingerprint in the meantime, its entry is kept.
+  Entry saved_entry;
+  if (!ReadEntry(fingerprint, &saved_entry)) return false;
+  MutexLock mutex_lock(&mutex_);
+  Entry* const entry = &LookupOrInsert(&entries_, fingerprint, saved_entry);
+  ++num_hits_;
+  entry->was_looked_up = true;
+  *state = entry->state;
+  return true;
+}
+
+void BasisCache::Store(uint64 fingerprint, const BasisState& state,
+                       int num_iterations) {
+  Entry entry_to_write;
+  {
+    MutexLock mutex_lock(&mutex_);
+    Entry* entry = FindOrNull(entries_, fingerprint);
+    if (entry == nullptr) {
+      entry = &entries_[fingerprint];
+      entry->num_cold_iterations = num_iterations;
+    } else if (entry->was_looked_up) {
+      num_iterations_saved_ +=
+          std::max(0, entry->num_cold_iterations - num_iterations);
+    }
+    entry->state = state;
+    entry->was_looked_up = false;
+    if (directory_.empty()) return;
+    entry_to_write = *entry;
+  }
+
+  // Like in Lookup(), the disk is accessed without holding the mutex.
+  WriteEntry(fingerprint, entry_to_write);
+}
+
+int64 BasisCache::num_lookups() const {
+  MutexLock mutex_lock(&mutex_);
+  return num_lookups_;
+}
+
+int64 BasisCache::num_hits() const {
+  MutexLock mutex_lock(&mutex_);
+  return num_hits_;
+}
+
+int64 BasisCache::num_iterations_saved() const {
+  MutexLock mutex_lock(&mutex_);
+  return num_iterations_saved_;
+}
+
+std::string BasisCache::StatString() const {
+  MutexLock mutex_lock(&mutex_);
+  const double hit_rate =
+      num_lookups_ == 0 ? 0.0 : 100.0 * num_hits_ / num_lookups_;
+  return StringPrintf(
+      "BasisCache: %lld lookups, %lld hits (%.2f%%), %lld iterations saved\n",
+      num_lookups_, num_hits_, hit_rate, num_iterations_saved_);
+}
+
+std::string BasisCache::FileName(uint64 fingerprint) const {
+  return StringPrintf("%s/glop_basis_%016llx", directory_.c_str(),
+                      static_cast<unsigned long long>(fingerprint));  // NOLINT
+}
+
+bool BasisCache::ReadEntry(uint64 fingerprint, Entry* entry) const {
+  if (directory_.empty()) return false;
+  std::unique_ptr<File> file(File::Open(FileName(fingerprint), "rb"));
+  if (file == nullptr) return false;
+  std::string contents;
+  const int64 size = file->Size();
+  const bool read_ok = file->ReadToString(&contents, size) == size;
+  file->Close();
+  if (!read_ok) return false;
+
+  const size_t end_of_header = contents.find('\n');
+  if (end_of_header == std::string::npos) return false;
+  unsigned long long saved_fingerprint;  // NOLINT
+  int num_rows;
+  int num_cols;
+  int num_iterations;
+  const std::string format = StrCat(kFileHeader, " %llx %d %d %d");
+  if (sscanf(contents.substr(0, end_of_header).c_str(), format.c_str(),
+             &saved_fingerprint, &num_rows, &num_cols, &num_iterations) != 4 ||
+      saved_fingerprint != fingerprint || num_rows < 0 || num_cols < 0 ||
+      contents.size() != end_of_header + 1 + num_rows + num_cols) {
+    LOG(WARNING) << "Ignoring the invalid basis cache file "
+                 << FileName(fingerprint);
+    return false;
+  }
+  entry->state.num_rows = RowIndex(num_rows);
+  entry->state.num_cols = ColIndex(num_cols);
+  entry->state.statuses.clear();
+  for (size_t i = end_of_header + 1; i < contents.size(); ++i) {
+    const int status = contents[i] - '0';
+    if (status < static_cast<int>(VariableStatus::BASIC) ||
+        status > static_cast<int>(VariableStatus::FREE)) {
+      LOG(WARNING) << "Ignoring the invalid basis cache file "
+                   << FileName(fingerprint);
+      return false;
+    }
+    entry->state.statuses.push_back(static_cast<VariableStatus>(status));
+  }
+  entry->num_cold_iterations = num_iterations;
+  entry->was_looked_up = false;
+  return true;
+}
+
+void BasisCache::WriteEntry(uint64 fingerprint, const Entry& entry) const {
+  std::string contents = StringPrintf(
+      "%s %016llx %d %d %d\n", kFileHeader,
+      static_cast<unsigned long long>(fingerprint),  // NOLINT
+      entry.state.num_rows.value(), entry.state.num_cols.value(),
+      entry.num_cold_iterations);
+  for (const VariableStatus status : entry.state.statuses) {
+    contents.push_back('0' + static_cast<int>(status));
+  }
+
+  // Write to a temporary file first and rename it, which is atomic, so that the
+  // other processes and threads never see a partially written file.
+  const std::string file_name = FileName(fingerprint);
+  const std::string tmp_file_name = StrCat(file_name, TemporaryFileSuffix());
+  std::unique_ptr<File> file(File::Open(tmp_file_name, "wb"));
+  if (file == nullptr) {
+    LOG(WARNING) << "Could not write the basis cache file " << tmp_file_name;
+    return;
+  }
+  const bool write_ok = file->WriteString(contents) == contents.size();
+  if (!file->Close() || !write_ok ||
+      rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+    LOG(WARNING) << "Could not write the basis cache file " << file_name;
+  }
+}
+
+}  // namespace glop
+}  // namespace operations_research
@@ -0,0 +1,112 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OR_TOOLS_GLOP_BASIS_CACHE_H_
+#define OR_TOOLS_GLOP_BASIS_CACHE_H_
+
+#include <string>
+#include "base/hash.h"
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "glop/revised_simplex.h"
+#include "lp_data/lp_data.h"
+
+namespace operations_research {
+namespace glop {
+
+// A cache of the optimal bases found by the revised simplex, keyed by a
+// fingerprint of the constraint matrix of the solved problem. It is meant for
+// the clients that solve many problems with the same structure but different
+// bounds or costs: the basis found for one of them is a good warm-start for
+// the next ones, even if they are solved by another LPSolver or in another
+// process.
+//
+// The bases are kept in memory and, if a directory is given, also saved in
+// one file per fingerprint so they can be shared between processes. A file
+// is written to a temporary name unique to the writing process and thread and
+// then renamed, and a file with an unexpected content is simply ignored. The
+// files are read and written without holding the lock of the cache. Note that a cached basis is only used
+// as a starting point, so a stale basis (for instance one overwritten by
+// another process) can only change the solve time, never its result.
+//
+// This class is thread-safe.
+class BasisCache {
+ public:
+  // The bases are saved in the given directory which must exist. If it is
+  // empty, the cache only lives in memory.
+  explicit BasisCache(const std::string& directory);
+
+  // Returns a fingerprint of the dimensions and of the entries of the
+  // constraint matrix of the given problem. The bounds, the costs and the
+  // names are not used.
+  static uint64 ComputeFingerprint(const LinearProgram& lp);
+
+  // Returns true and fills state with the last basis stored for the given
+  // fingerprint, if any. The basis is searched in memory first and then in
+  // the cache directory.
+  bool Lookup(uint64 fingerprint, BasisState* state) LOCKS_EXCLUDED(mutex_);
+
+  // Stores the optimal basis found for the given fingerprint by a solve that
+  // took num_iterations. The number of iterations of the first solve of a
+  // fingerprint (in this process, or as read from the saved file) is used as
+  // the cost of a solve without the cache: if the given solve was warm-started
+  // by Lookup(), the difference is added to num_iterations_saved().
+  void Store(uint64 fingerprint, const BasisState& state, int num_iterations)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Counters about the use of the cache since its creation.
+  int64 num_lookups() const LOCKS_EXCLUDED(mutex_);
+  int64 num_hits() const LOCKS_EXCLUDED(mutex_);
+  int64 num_iterations_saved() const LOCKS_EXCLUDED(mutex_);
+
+  // Returns a std::string with the counters above and the hit rate.
+  std::string StatString() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    Entry() : state(), num_cold_iterations(0), was_looked_up(false) {}
+    BasisState state;
+
+    // The number of iterations of the first solve of this fingerprint.
+    int num_cold_iterations;
+
+    // Whether this entry was returned by Lookup() since the last Store(),
+    // i.e. if the next stored solve was warm-started.
+    bool was_looked_up;
+  };
+
+  // Returns the file used to save the basis of the given fingerprint.
+  std::string FileName(uint64 fingerprint) const;
+
+  // Reads or writes an entry in the format described in basis_cache.cc.
+  // ReadEntry() returns false if the file does not exist or is invalid.
+  bool ReadEntry(uint64 fingerprint, Entry* entry) const;
+  void WriteEntry(uint64 fingerprint, const Entry& entry) const;
+
+  const std::string directory_;
+
+  mutable Mutex mutex_;
+  hash_map<uint64, Entry> entries_ GUARDED_BY(mutex_);
+  int64 num_lookups_ GUARDED_BY(mutex_);
+  int64 num_hits_ GUARDED_BY(mutex_);
+  int64 num_iterations_saved_ GUARDED_BY(mutex_);
+
+  DISALLOW_COPY_AND_ASSIGN(BasisCache);
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_BASIS_CACHE_H_
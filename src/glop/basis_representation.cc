@@ -197,6 +197,7 @@ void BasisFactorization::Clear() {
   eta_factorization_.Clear();
   lu_factorization_.Clear();
   rank_one_factorization_.Clear();
+  forrest_tomlin_factorization_.Clear();
   storage_.Reset(matrix_.num_rows());
   right_storage_.Reset(matrix_.num_rows());
   left_pool_mapping_.assign(matrix_.num_cols(), kInvalidCol);
@@ -283,12 +284,41 @@ Status BasisFactorization::MiddleProductFormUpdate(
   return Status::OK;
 }
 
+Status BasisFactorization::ForrestTomlinUpdate(ColIndex entering_col,
+                                               RowIndex leaving_variable_row,
+                                               Fractional pivot) {
+  const ColIndex right_index = right_pool_mapping_[entering_col];
+  if (right_index == kInvalidCol) {
+    VLOG(0) << "The update vector is missing!!!";
+    return ForceRefactorization();
+  }
+  if (!forrest_tomlin_factorization_.IsInitialized()) {
+    // This only happens if the client did not remove the column permutation
+    // after the last refactorization, see SetColumnPermutationToIdentity().
+    if (!lu_factorization_.GetColumnPermutation().empty()) {
+      return ForceRefactorization();
+    }
+    forrest_tomlin_factorization_.Initialize(lu_factorization_,
+                                             matrix_.num_rows());
+  }
+  if (!forrest_tomlin_factorization_.Update(
+          leaving_variable_row, right_storage_.column(right_index), pivot)) {
+    return ForceRefactorization();
+  }
+  ++num_updates_;
+  return Status::OK;
+}
+
 Status BasisFactorization::Update(ColIndex entering_col,
                                   RowIndex leaving_variable_row,
                                   const std::vector<RowIndex>& eta_non_zeros,
                                   DenseColumn* dense_eta) {
   if (num_updates_ < max_num_updates_) {
     SCOPED_TIME_STAT(&stats_);
+    if (use_forrest_tomlin_update_) {
+      return ForrestTomlinUpdate(entering_col, leaving_variable_row,
+                                 (*dense_eta)[leaving_variable_row]);
+    }
     if (use_middle_product_form_update_) {
       RETURN_IF_ERROR(
           MiddleProductFormUpdate(entering_col, leaving_variable_row));
@@ -306,7 +336,13 @@ void BasisFactorization::LeftSolve(DenseRow* y) const {
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(y);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    // An empty non_zeros means that y is considered dense.
+    ColIndexVector non_zeros;
+    forrest_tomlin_factorization_.LeftSolveUWithNonZeros(y, &non_zeros);
+    forrest_tomlin_factorization_.LeftSolveRowEtas(y, &non_zeros);
+    lu_factorization_.LeftSolveL(y);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.LeftSolveU(y);
     rank_one_factorization_.LeftSolve(y);
     lu_factorization_.LeftSolveL(y);
@@ -321,9 +357,15 @@ void BasisFactorization::LeftSolveWithNonZeros(
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(y);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    non_zeros->clear();
+    forrest_tomlin_factorization_.LeftSolveUWithNonZeros(y, non_zeros);
+    forrest_tomlin_factorization_.LeftSolveRowEtas(y, non_zeros);
+    lu_factorization_.LeftSolveLWithNonZeros(y, non_zeros, nullptr);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.LeftSolveU(y);
     rank_one_factorization_.LeftSolve(y);
+    non_zeros->clear();
     lu_factorization_.LeftSolveLWithNonZeros(y, non_zeros, nullptr);
   } else {
     eta_factorization_.LeftSolve(y);
@@ -336,7 +378,12 @@ void BasisFactorization::RightSolve(DenseColumn* d) const {
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(d);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    RowIndexVector non_zeros;
+    lu_factorization_.RightSolveL(d);
+    forrest_tomlin_factorization_.RightSolveRowEtas(d, &non_zeros);
+    forrest_tomlin_factorization_.RightSolveU(d);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.RightSolveL(d);
     rank_one_factorization_.RightSolve(d);
     lu_factorization_.RightSolveU(d);
@@ -351,9 +398,15 @@ void BasisFactorization::RightSolveWithNonZeros(
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(d);
   BumpDeterministicTimeForSolve(non_zeros->size());
-  if (use_middle_product_form_update_) {
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    lu_factorization_.RightSolveL(d);
+    non_zeros->clear();
+    forrest_tomlin_factorization_.RightSolveRowEtas(d, non_zeros);
+    forrest_tomlin_factorization_.RightSolveUWithNonZeros(d, non_zeros);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.RightSolveL(d);
     rank_one_factorization_.RightSolve(d);
+    non_zeros->clear();
     lu_factorization_.RightSolveUWithNonZeros(d, non_zeros);
   } else {
     lu_factorization_.RightSolve(d);
@@ -367,10 +420,15 @@ DenseColumn* BasisFactorization::RightSolveForTau(ScatteredColumnReference a)
     const {
   SCOPED_TIME_STAT(&stats_);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
-    lu_factorization_.RightSolveLWithPermutedInput(a.dense_column, &tau_);
-    rank_one_factorization_.RightSolve(&tau_);
-    lu_factorization_.RightSolveU(&tau_);
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    lu_factorization_.RightSolveLWithPermutedInput(a, &tau_, &tau_non_zeros_);
+    forrest_tomlin_factorization_.RightSolveRowEtas(&tau_, &tau_non_zeros_);
+    forrest_tomlin_factorization_.RightSolveUWithNonZeros(&tau_,
+                                                          &tau_non_zeros_);
+  } else if (use_middle_product_form_update_) {
+    lu_factorization_.RightSolveLWithPermutedInput(a, &tau_, &tau_non_zeros_);
+    rank_one_factorization_.RightSolveWithNonZeros(&tau_, &tau_non_zeros_);
+    lu_factorization_.RightSolveUWithNonZeros(&tau_, &tau_non_zeros_);
   } else {
     tau_ = a.dense_column;
     lu_factorization_.RightSolve(&tau_);
@@ -395,6 +453,14 @@ void BasisFactorization::LeftSolveForUnitRow(ColIndex j, DenseRow* y,
     return;
   }
 
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    forrest_tomlin_factorization_.LeftSolveUForUnitRow(j, y, non_zeros);
+    forrest_tomlin_factorization_.LeftSolveRowEtas(y, non_zeros);
+    lu_factorization_.LeftSolveLWithNonZeros(
+        y, non_zeros, parameters_.use_dual_simplex() ? &tau_ : nullptr);
+    return;
+  }
+
   // If the leaving index is the same, we can reuse the column! Note also that
   // since we do a left solve for a unit row using an upper triangular matrix,
   // all positions in front of the unit will be zero (modulo the column
@@ -411,9 +477,11 @@ void BasisFactorization::LeftSolveForUnitRow(ColIndex j, DenseRow* y,
     }
   } else {
     DenseColumn* const x = reinterpret_cast<DenseColumn*>(y);
-    storage_.ColumnCopyToClearedDenseColumn(left_pool_mapping_[j], x);
+    storage_.ColumnCopyToClearedDenseColumnWithNonZeros(
+        left_pool_mapping_[j], x,
+        reinterpret_cast<std::vector<RowIndex>*>(non_zeros));
   }
-  rank_one_factorization_.LeftSolve(y);
+  rank_one_factorization_.LeftSolveWithNonZeros(y, non_zeros);
 
   // TODO(user): Find a better way to decide what version to use. We may
   // alternate primal and dual solves, and we only need tau_ if we update the
@@ -441,9 +509,18 @@ void BasisFactorization::RightSolveForProblemColumn(
   // TODO(user): if right_pool_mapping_[col] != kInvalidCol, we can reuse it and
   // just apply the last rank one update since it was computed.
   ClearAndResizeVectorWithNonZeros(matrix_.num_rows(), d, non_zeros);
-  lu_factorization_.RightSolveLForSparseColumn(matrix_.column(col), d);
-  rank_one_factorization_.RightSolve(d);
-  right_pool_mapping_[col] = right_storage_.AddDenseColumn(*d);
+  lu_factorization_.RightSolveLForSparseColumn(matrix_.column(col), d,
+                                               non_zeros);
+  if (forrest_tomlin_factorization_.IsInitialized()) {
+    forrest_tomlin_factorization_.RightSolveRowEtas(d, non_zeros);
+    right_pool_mapping_[col] =
+        right_storage_.AddDenseColumnWithNonZeros(*d, *non_zeros);
+    forrest_tomlin_factorization_.RightSolveUWithNonZeros(d, non_zeros);
+    return;
+  }
+  rank_one_factorization_.RightSolveWithNonZeros(d, non_zeros);
+  right_pool_mapping_[col] =
+      right_storage_.AddDenseColumnWithNonZeros(*d, *non_zeros);
   lu_factorization_.RightSolveUWithNonZeros(d, non_zeros);
 }
 
@@ -558,7 +635,9 @@ void BasisFactorization::BumpDeterministicTimeForSolve(int num_entries) const {
       (1.0 + density) * DeterministicTimeForFpOperations(
                             lu_factorization_.NumberOfEntries().value()) +
       DeterministicTimeForFpOperations(
-          rank_one_factorization_.num_entries().value());
+          rank_one_factorization_.num_entries().value()) +
+      DeterministicTimeForFpOperations(
+          forrest_tomlin_factorization_.num_entries().value());
 }
 
 }  // namespace glop
@@ -16,6 +16,7 @@
 #define OR_TOOLS_GLOP_BASIS_REPRESENTATION_H_
 
 #include "base/logging.h"
+#include "glop/forrest_tomlin_update.h"
 #include "glop/lu_factorization.h"
 #include "glop/parameters.pb.h"
 #include "glop/rank_one_update.h"
@@ -139,7 +140,8 @@ class EtaFactorization {
 
 // A basis factorization is the product of an eta factorization and
 // a L.U decomposition, i.e. B = L.U.E_0.E_1. ... .E_{k-1}
-// It is used to solve two systems:
+// With the Forrest-Tomlin update, the updates modify U instead, see
+// ForrestTomlinFactorization. It is used to solve two systems:
 //   - B.d = a where a is the entering column.
 //   - y.B = c where c is the objective row.
 //
@@ -153,8 +155,14 @@ class BasisFactorization {
   // Sets the parameters for this component.
   void SetParameters(const GlopParameters& parameters) {
     max_num_updates_ = parameters.basis_refactorization_period();
+    use_forrest_tomlin_update_ = parameters.use_forrest_tomlin_update();
+
+    // Before its first update, the Forrest-Tomlin factorization is just the LU
+    // factorization and the middle product form solves are used since they
+    // store the spikes needed by the first update.
     use_middle_product_form_update_ =
-        parameters.use_middle_product_form_update();
+        parameters.use_middle_product_form_update() ||
+        use_forrest_tomlin_update_;
     parameters_ = parameters;
     lu_factorization_.SetParameters(parameters);
   }
@@ -273,7 +281,8 @@ class BasisFactorization {
   // Note that ResetStats() could be const, but until needed it is not to
   // prevent anyone holding a const BasisFactorization& to call it.
   std::string StatString() const {
-    return stats_.StatString() + lu_factorization_.StatString();
+    return stats_.StatString() + lu_factorization_.StatString() +
+           forrest_tomlin_factorization_.StatString();
   }
   void ResetStats() { stats_.Reset(); }
 
@@ -292,6 +301,15 @@ class BasisFactorization {
   Status MiddleProductFormUpdate(ColIndex entering_col,
                                  RowIndex leaving_variable_row) MUST_USE_RESULT;
 
+  // Updates the factorization using the Forrest-Tomlin update, see
+  // ForrestTomlinFactorization. The pivot is the coefficient of the leaving
+  // row in B^{-1}.a. Unlike MiddleProductFormUpdate(), this also increments
+  // num_updates_ or refactorizes the basis if the update is not precise
+  // enough.
+  Status ForrestTomlinUpdate(ColIndex entering_col,
+                             RowIndex leaving_variable_row,
+                             Fractional pivot) MUST_USE_RESULT;
+
   // Increases the deterministic time for a solve operation with a vector having
   // this number of non-zero entries (it can be an approximation).
   void BumpDeterministicTimeForSolve(int num_entries) const;
@@ -323,22 +341,29 @@ class BasisFactorization {
   // the last LeftSolveForUnitRow() and also the final result of
   // RightSolveForTau().
   mutable DenseColumn tau_;
+  mutable std::vector<RowIndex> tau_non_zeros_;
 
   // Data structure to store partial solve results for the middle form product
   // update. See LeftSolveForUnitRow() and RightSolveForProblemColumn(). We use
   // two CompactSparseMatrix to have a better cache behavior when solving with
-  // the rank_one_factorization_.
+  // the rank_one_factorization_. The Forrest-Tomlin update uses the same
+  // right_storage_ to store its spikes.
   mutable CompactSparseMatrix storage_;
   mutable CompactSparseMatrix right_storage_;
   mutable ColMapping left_pool_mapping_;
   mutable ColMapping right_pool_mapping_;
 
   bool use_middle_product_form_update_;
+  bool use_forrest_tomlin_update_;
   int max_num_updates_;
   int num_updates_;
   EtaFactorization eta_factorization_;
   LuFactorization lu_factorization_;
 
+  // The updated U factor and the row etas of the Forrest-Tomlin update. It is
+  // only initialized by the first update after a refactorization.
+  ForrestTomlinFactorization forrest_tomlin_factorization_;
+
   // mutable because the Solve() functions are const but need to update this.
   mutable double deterministic_time_;
 
@@ -13,6 +13,7 @@
 
 #include "glop/dual_edge_norms.h"
 
+#include "glop/parallel_utils.h"
 #include "lp_data/lp_utils.h"
 
 namespace operations_research {
@@ -73,28 +74,45 @@ void DualEdgeNorms::UpdateBeforeBasisPivot(
   const Fractional new_leaving_squared_norm =
       leaving_squared_norm / Square(pivot);
 
-  // Update the norm.
-  int stat_lower_bounded_norms = 0;
-  for (const RowIndex row : direction.non_zero_rows) {
-    // Note that the update formula used is important to maximize the precision.
-    // See Koberstein's PhD section 8.2.2.1.
-    edge_squared_norms_[row] +=
-        direction[row] *
-        (direction[row] * new_leaving_squared_norm - 2.0 / pivot * (*tau)[row]);
-
-    // Avoid 0.0 norms (The 1e-4 is the value used by Koberstein).
-    // TODO(user): use a more precise lower bound depending on the column norm?
-    // We can do that with Cauchy-Swartz inequality:
-    //   (edge . leaving_column)^2 = 1.0 < ||edge||^2 * ||leaving_column||^2
-    const Fractional kLowerBound = 1e-4;
-    if (edge_squared_norms_[row] < kLowerBound) {
-      if (row == leaving_row) continue;
-      edge_squared_norms_[row] = kLowerBound;
-      ++stat_lower_bounded_norms;
+  // Update the norm. Each position is independent, so the loop can be split
+  // in chunks (see parallel_utils.h).
+  const int num_positions = direction.non_zero_rows.size();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_positions);
+  std::vector<int> chunk_lower_bounded_norms(num_chunks, 0);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    const int end = ChunkStart(num_positions, num_chunks, chunk + 1);
+    for (int i = ChunkStart(num_positions, num_chunks, chunk); i < end; ++i) {
+      const RowIndex row = direction.non_zero_rows[i];
+
+      // Note that the update formula used is important to maximize the
+      // precision. See Koberstein's PhD section 8.2.2.1.
+      edge_squared_norms_[row] +=
+          direction[row] * (direction[row] * new_leaving_squared_norm -
+                            2.0 / pivot * (*tau)[row]);
+
+      // Avoid 0.0 norms (The 1e-4 is the value used by Koberstein).
+      // TODO(user): use a more precise lower bound depending on the column
+      // norm? We can do that with Cauchy-Swartz inequality:
+      //   (edge . leaving_column)^2 = 1.0 < ||edge||^2 * ||leaving_column||^2
+      const Fractional kLowerBound = 1e-4;
+      if (edge_squared_norms_[row] < kLowerBound) {
+        if (row == leaving_row) continue;
+        edge_squared_norms_[row] = kLowerBound;
+        ++chunk_lower_bounded_norms[chunk];
+      }
     }
   }
   edge_squared_norms_[leaving_row] = new_leaving_squared_norm;
-  IF_STATS_ENABLED(stats_.lower_bounded_norms.Add(stat_lower_bounded_norms));
+  IF_STATS_ENABLED({
+    int stat_lower_bounded_norms = 0;
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      stat_lower_bounded_norms += chunk_lower_bounded_norms[chunk];
+    }
+    stats_.lower_bounded_norms.Add(stat_lower_bounded_norms);
+  });
 }
 
 void DualEdgeNorms::ComputeEdgeSquaredNorms() {
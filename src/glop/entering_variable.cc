@@ -86,32 +86,6 @@ Status EnteringVariable::PrimalChooseEnteringColumn(ColIndex* entering_col) {
   return Status::OK;
 }
 
-namespace {
-
-// Store a column with its update coefficient and ratio.
-// This is used during the dual phase I & II ratio tests.
-struct ColWithRatio {
-  ColWithRatio(ColIndex _col, Fractional reduced_cost, Fractional coeff_m)
-      : col(_col), ratio(reduced_cost / coeff_m), coeff_magnitude(coeff_m) {}
-
-  // Returns false if "this" is before "other" in a priority queue.
-  bool operator<(const ColWithRatio& other) const {
-    if (ratio == other.ratio) {
-      if (coeff_magnitude == other.coeff_magnitude) {
-        return col > other.col;
-      }
-      return coeff_magnitude < other.coeff_magnitude;
-    }
-    return ratio > other.ratio;
-  }
-
-  ColIndex col;
-  Fractional ratio;
-  Fractional coeff_magnitude;
-};
-
-}  // namespace
-
 Status EnteringVariable::DualChooseEnteringColumn(
     const UpdateRow& update_row, Fractional cost_variation,
     std::vector<ColIndex>* bound_flip_candidates, ColIndex* entering_col,
@@ -122,54 +96,57 @@ Status EnteringVariable::DualChooseEnteringColumn(
   const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
   SCOPED_TIME_STAT(&stats_);
 
-  std::vector<ColWithRatio> breakpoints;
-  breakpoints.reserve(update_row.GetNonZeroPositions().size());
   const Fractional threshold = parameters_.ratio_test_zero_threshold();
   const DenseBitRow& can_decrease = variables_info_.GetCanDecreaseBitRow();
-  const DenseBitRow& can_increase = variables_info_.GetCanIncreaseBitRow();
-
-  // Harris ratio test. See below for more explanation. Here this is used to
-  // prune the first pass by not enqueueing ColWithRatio for columns that have
-  // a ratio greater than the current harris_ratio.
   const VariableTypeRow& variable_type = variables_info_.GetTypeRow();
   const Fractional harris_tolerance =
       parameters_.harris_tolerance_ratio() *
       reduced_costs_->GetDualFeasibilityTolerance();
-  Fractional harris_ratio = std::numeric_limits<Fractional>::max();
-
-  for (const ColIndex col : update_row.GetNonZeroPositions()) {
-    // We will add ratio * coeff to this column with a ratio positive or zero.
-    // cost_variation makes sure the leaving variable will be dual-feasible
-    // (its update coeff is sign(cost_variation) * 1.0).
-    const Fractional coeff = (cost_variation > 0.0) ? update_coefficient[col]
-                                                    : -update_coefficient[col];
 
-    // In this case, at some point the reduced cost will be positive if not
-    // already, and the column will be dual-infeasible.
-    if (can_decrease.IsSet(col) && coeff > threshold) {
-      if (variable_type[col] != VariableType::UPPER_AND_LOWER_BOUNDED) {
-        if (-reduced_costs[col] > harris_ratio * coeff) continue;
-        harris_ratio =
-            std::min(harris_ratio, (-reduced_costs[col] + harris_tolerance) / coeff);
-        harris_ratio = std::max(0.0, harris_ratio);
-      }
-      breakpoints.push_back(ColWithRatio(col, -reduced_costs[col], coeff));
-      continue;
-    }
+  // First pass, see DualCollectBreakpoints().
+  const int num_positions = update_row.GetNonZeroPositions().size();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_positions);
+  chunk_breakpoints_.resize(num_chunks);
+  std::vector<Fractional> chunk_harris_ratios(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    chunk_breakpoints_[chunk].clear();
+    chunk_harris_ratios[chunk] = DualCollectBreakpoints(
+        update_row, cost_variation,
+        ChunkStart(num_positions, num_chunks, chunk),
+        ChunkStart(num_positions, num_chunks, chunk + 1),
+        &chunk_breakpoints_[chunk]);
+  }
+  Fractional harris_ratio = std::numeric_limits<Fractional>::max();
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    harris_ratio = std::min(harris_ratio, chunk_harris_ratios[chunk]);
+  }
 
-    // In this case, at some point the reduced cost will be negative if not
-    // already, and the column will be dual-infeasible.
-    if (can_increase.IsSet(col) && coeff < -threshold) {
-      if (variable_type[col] != VariableType::UPPER_AND_LOWER_BOUNDED) {
-        if (reduced_costs[col] > harris_ratio * -coeff) continue;
-        harris_ratio =
-            std::min(harris_ratio, (reduced_costs[col] + harris_tolerance) / -coeff);
-        harris_ratio = std::max(0.0, harris_ratio);
-      }
-      breakpoints.push_back(ColWithRatio(col, reduced_costs[col], -coeff));
-      continue;
+  // Merges the chunks in order. A chunk prunes its breakpoints with its own
+  // harris ratio, so we remove the ones that would have been pruned with the
+  // final harris_ratio. This way, the breakpoints do not depend on the chunks.
+  std::vector<ColWithRatio>& breakpoints = chunk_breakpoints_[0];
+  for (int chunk = 1; chunk < num_chunks; ++chunk) {
+    breakpoints.insert(breakpoints.end(), chunk_breakpoints_[chunk].begin(),
+                       chunk_breakpoints_[chunk].end());
+  }
+  int num_breakpoints = 0;
+  for (int i = 0; i < breakpoints.size(); ++i) {
+    const ColIndex col = breakpoints[i].col;
+    if (variable_type[col] != VariableType::UPPER_AND_LOWER_BOUNDED) {
+      const Fractional coeff = (cost_variation > 0.0)
+                                   ? update_coefficient[col]
+                                   : -update_coefficient[col];
+      const Fractional cost = (can_decrease.IsSet(col) && coeff > threshold)
+                                  ? -reduced_costs[col]
+                                  : reduced_costs[col];
+      if (cost > harris_ratio * breakpoints[i].coeff_magnitude) continue;
     }
+    breakpoints[num_breakpoints++] = breakpoints[i];
   }
+  breakpoints.erase(breakpoints.begin() + num_breakpoints, breakpoints.end());
 
   // Process the breakpoints in priority order as suggested by Maros in
   // I. Maros, "A generalized dual phase-2 simplex algorithm", European Journal
@@ -298,9 +275,136 @@ Status EnteringVariable::DualPhaseIChooseEnteringColumn(
   SCOPED_TIME_STAT(&stats_);
 
   // List of breakpoints where a variable change from feasibility to
-  // infeasibility or the opposite.
-  std::vector<ColWithRatio> breakpoints;
-  breakpoints.reserve(update_row.GetNonZeroPositions().size());
+  // infeasibility or the opposite, see DualPhaseICollectBreakpoints().
+  const int num_positions = update_row.GetNonZeroPositions().size();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_positions);
+  chunk_breakpoints_.resize(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    chunk_breakpoints_[chunk].clear();
+    DualPhaseICollectBreakpoints(
+        update_row, cost_variation,
+        ChunkStart(num_positions, num_chunks, chunk),
+        ChunkStart(num_positions, num_chunks, chunk + 1),
+        &chunk_breakpoints_[chunk]);
+  }
+  std::vector<ColWithRatio>& breakpoints = chunk_breakpoints_[0];
+  for (int chunk = 1; chunk < num_chunks; ++chunk) {
+    breakpoints.insert(breakpoints.end(), chunk_breakpoints_[chunk].begin(),
+                       chunk_breakpoints_[chunk].end());
+  }
+  const Fractional threshold = parameters_.ratio_test_zero_threshold();
+  const DenseBitRow& can_decrease = variables_info_.GetCanDecreaseBitRow();
+  const DenseBitRow& can_increase = variables_info_.GetCanIncreaseBitRow();
+
+  // Process the breakpoints in priority order.
+  std::make_heap(breakpoints.begin(), breakpoints.end());
+
+  // Because of our priority queue, it is easy to choose a sub-optimal step to
+  // have a stable pivot. The pivot with the highest magnitude and that reduces
+  // the infeasibility the most is chosen.
+  Fractional pivot_magnitude = 0.0;
+
+  // Select the last breakpoint that still improves the infeasibility and has a
+  // numerically stable pivot.
+  *entering_col = kInvalidCol;
+  *step = -1.0;
+  Fractional improvement = fabs(cost_variation);
+  while (!breakpoints.empty()) {
+    const ColWithRatio top = breakpoints.front();
+
+    // We keep the greatest coeff_magnitude for the same ratio.
+    DCHECK(top.ratio > *step ||
+           (top.ratio == *step && top.coeff_magnitude <= pivot_magnitude));
+    if (top.ratio > *step && top.coeff_magnitude >= pivot_magnitude) {
+      *entering_col = top.col;
+      *step = top.ratio;
+      pivot_magnitude = top.coeff_magnitude;
+    }
+    improvement -= top.coeff_magnitude;
+
+    // If the variable is free, then not only do we loose the infeasibility
+    // improvment, we also render it worse if we keep going in the same
+    // direction.
+    if (can_decrease.IsSet(top.col) && can_increase.IsSet(top.col) &&
+        fabs(reduced_costs[top.col]) > threshold) {
+      improvement -= top.coeff_magnitude;
+    }
+
+    if (improvement <= 0.0) break;
+    std::pop_heap(breakpoints.begin(), breakpoints.end());
+    breakpoints.pop_back();
+  }
+  *pivot =
+      (*entering_col == kInvalidCol) ? 0.0 : update_coefficient[*entering_col];
+  return Status::OK;
+}
+
+Fractional EnteringVariable::DualCollectBreakpoints(
+    const UpdateRow& update_row, Fractional cost_variation, int begin, int end,
+    std::vector<ColWithRatio>* breakpoints) const {
+  const ColIndexVector& positions = update_row.GetNonZeroPositions();
+  const DenseRow& update_coefficient = update_row.GetCoefficients();
+  const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
+  const Fractional threshold = parameters_.ratio_test_zero_threshold();
+  const DenseBitRow& can_decrease = variables_info_.GetCanDecreaseBitRow();
+  const DenseBitRow& can_increase = variables_info_.GetCanIncreaseBitRow();
+
+  // Harris ratio test. See DualChooseEnteringColumn() for more explanation.
+  // Here this is used to prune the first pass by not enqueueing ColWithRatio
+  // for columns that have a ratio greater than the current harris_ratio.
+  const VariableTypeRow& variable_type = variables_info_.GetTypeRow();
+  const Fractional harris_tolerance =
+      parameters_.harris_tolerance_ratio() *
+      reduced_costs_->GetDualFeasibilityTolerance();
+  Fractional harris_ratio = std::numeric_limits<Fractional>::max();
+
+  for (int i = begin; i < end; ++i) {
+    const ColIndex col = positions[i];
+
+    // We will add ratio * coeff to this column with a ratio positive or zero.
+    // cost_variation makes sure the leaving variable will be dual-feasible
+    // (its update coeff is sign(cost_variation) * 1.0).
+    const Fractional coeff = (cost_variation > 0.0) ? update_coefficient[col]
+                                                    : -update_coefficient[col];
+
+    // In this case, at some point the reduced cost will be positive if not
+    // already, and the column will be dual-infeasible.
+    if (can_decrease.IsSet(col) && coeff > threshold) {
+      if (variable_type[col] != VariableType::UPPER_AND_LOWER_BOUNDED) {
+        if (-reduced_costs[col] > harris_ratio * coeff) continue;
+        harris_ratio = std::min(
+            harris_ratio, (-reduced_costs[col] + harris_tolerance) / coeff);
+        harris_ratio = std::max(0.0, harris_ratio);
+      }
+      breakpoints->push_back(ColWithRatio(col, -reduced_costs[col], coeff));
+      continue;
+    }
+
+    // In this case, at some point the reduced cost will be negative if not
+    // already, and the column will be dual-infeasible.
+    if (can_increase.IsSet(col) && coeff < -threshold) {
+      if (variable_type[col] != VariableType::UPPER_AND_LOWER_BOUNDED) {
+        if (reduced_costs[col] > harris_ratio * -coeff) continue;
+        harris_ratio = std::min(
+            harris_ratio, (reduced_costs[col] + harris_tolerance) / -coeff);
+        harris_ratio = std::max(0.0, harris_ratio);
+      }
+      breakpoints->push_back(ColWithRatio(col, reduced_costs[col], -coeff));
+      continue;
+    }
+  }
+  return harris_ratio;
+}
+
+void EnteringVariable::DualPhaseICollectBreakpoints(
+    const UpdateRow& update_row, Fractional cost_variation, int begin, int end,
+    std::vector<ColWithRatio>* breakpoints) const {
+  const ColIndexVector& positions = update_row.GetNonZeroPositions();
+  const DenseRow& update_coefficient = update_row.GetCoefficients();
+  const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
 
   // Ratio test.
   const Fractional threshold = parameters_.ratio_test_zero_threshold();
@@ -309,7 +413,9 @@ Status EnteringVariable::DualPhaseIChooseEnteringColumn(
   const DenseBitRow& can_decrease = variables_info_.GetCanDecreaseBitRow();
   const DenseBitRow& can_increase = variables_info_.GetCanIncreaseBitRow();
   const VariableTypeRow& variable_type = variables_info_.GetTypeRow();
-  for (const ColIndex col : update_row.GetNonZeroPositions()) {
+  for (int i = begin; i < end; ++i) {
+    const ColIndex col = positions[i];
+
     // Boxed variables shouldn't be in the update position list because they
     // will be dealt with afterwards by MakeBoxedVariableDualFeasible().
     DCHECK_NE(variable_type[col], VariableType::UPPER_AND_LOWER_BOUNDED);
@@ -324,7 +430,7 @@ Status EnteringVariable::DualPhaseIChooseEnteringColumn(
     // the leaving variable will be dual-feasible (its update coeff is
     // sign(cost_variation) * 1.0).
     //
-    // TODO(user): This is the same in DualChooseEnteringColumn(), remove
+    // TODO(user): This is the same in DualCollectBreakpoints(), remove
     // duplication?
     const Fractional coeff = (cost_variation > 0.0) ? update_coefficient[col]
                                                     : -update_coefficient[col];
@@ -347,51 +453,9 @@ Status EnteringVariable::DualPhaseIChooseEnteringColumn(
     }
 
     // We are sure there is a transition, add it to the set of breakpoints.
-    breakpoints.push_back(
+    breakpoints->push_back(
         ColWithRatio(col, fabs(reduced_costs[col]), fabs(coeff)));
   }
-
-  // Process the breakpoints in priority order.
-  std::make_heap(breakpoints.begin(), breakpoints.end());
-
-  // Because of our priority queue, it is easy to choose a sub-optimal step to
-  // have a stable pivot. The pivot with the highest magnitude and that reduces
-  // the infeasibility the most is chosen.
-  Fractional pivot_magnitude = 0.0;
-
-  // Select the last breakpoint that still improves the infeasibility and has a
-  // numerically stable pivot.
-  *entering_col = kInvalidCol;
-  *step = -1.0;
-  Fractional improvement = fabs(cost_variation);
-  while (!breakpoints.empty()) {
-    const ColWithRatio top = breakpoints.front();
-
-    // We keep the greatest coeff_magnitude for the same ratio.
-    DCHECK(top.ratio > *step ||
-           (top.ratio == *step && top.coeff_magnitude <= pivot_magnitude));
-    if (top.ratio > *step && top.coeff_magnitude >= pivot_magnitude) {
-      *entering_col = top.col;
-      *step = top.ratio;
-      pivot_magnitude = top.coeff_magnitude;
-    }
-    improvement -= top.coeff_magnitude;
-
-    // If the variable is free, then not only do we loose the infeasibility
-    // improvment, we also render it worse if we keep going in the same
-    // direction.
-    if (can_decrease.IsSet(top.col) && can_increase.IsSet(top.col) &&
-        fabs(reduced_costs[top.col]) > threshold) {
-      improvement -= top.coeff_magnitude;
-    }
-
-    if (improvement <= 0.0) break;
-    std::pop_heap(breakpoints.begin(), breakpoints.end());
-    breakpoints.pop_back();
-  }
-  *pivot =
-      (*entering_col == kInvalidCol) ? 0.0 : update_coefficient[*entering_col];
-  return Status::OK;
 }
 
 void EnteringVariable::SetParameters(const GlopParameters& parameters) {
@@ -425,29 +489,47 @@ DenseBitRow* EnteringVariable::ResetUnusedColumns() {
 
 template <bool normalize, bool nested_pricing>
 void EnteringVariable::DantzigChooseEnteringColumn(ColIndex* entering_col) {
+  SCOPED_TIME_STAT(&stats_);
+  const int num_cols = variables_info_.GetNumberOfColumns().value();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_cols);
+  pricing_chunks_.resize(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    DantzigPriceChunk<normalize, nested_pricing>(
+        ColIndex(ChunkStart(num_cols, num_chunks, chunk)),
+        ColIndex(ChunkStart(num_cols, num_chunks, chunk + 1)),
+        &pricing_chunks_[chunk]);
+  }
+  *entering_col = MergePricingChunks(false);
+}
+
+template <bool normalize, bool nested_pricing>
+void EnteringVariable::DantzigPriceChunk(ColIndex begin, ColIndex end,
+                                         PricingChunk* chunk) const {
   DenseRow dummy;
   const DenseRow& matrix_column_norms =
       normalize ? primal_edge_norms_->GetMatrixColumnNorms() : dummy;
   const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
-  SCOPED_TIME_STAT(&stats_);
+  const DenseBitRow& candidates = reduced_costs_->GetDualInfeasiblePositions();
 
   Fractional best_price(0.0);
-  *entering_col = kInvalidCol;
-  for (const ColIndex col : reduced_costs_->GetDualInfeasiblePositions()) {
+  chunk->best_col = kInvalidCol;
+  for (DenseBitRow::Iterator it(candidates, begin);
+       it.Ok() && it.Index() < end; it.Next()) {
+    const ColIndex col = it.Index();
     if (nested_pricing && !unused_columns_.IsSet(col)) continue;
     const Fractional unormalized_price = fabs(reduced_costs[col]);
-    if (normalize) {
-      if (unormalized_price > best_price * matrix_column_norms[col]) {
-        best_price = unormalized_price / matrix_column_norms[col];
-        *entering_col = col;
-      }
-    } else {
-      if (unormalized_price > best_price) {
-        best_price = unormalized_price;
-        *entering_col = col;
-      }
+    const Fractional price = normalize
+                                 ? unormalized_price / matrix_column_norms[col]
+                                 : unormalized_price;
+    if (price > best_price) {
+      best_price = price;
+      chunk->best_col = col;
     }
   }
+  chunk->best_price = best_price;
 }
 
 // TODO(user): Here we could fill a priority queue with the normalized
@@ -457,41 +539,21 @@ void EnteringVariable::DantzigChooseEnteringColumn(ColIndex* entering_col) {
 //   the other parts of the simplex algorithm.
 template <bool use_steepest_edge>
 void EnteringVariable::NormalizedChooseEnteringColumn(ColIndex* entering_col) {
-  const DenseRow& weights = use_steepest_edge
-                                ? primal_edge_norms_->GetEdgeSquaredNorms()
-                                : primal_edge_norms_->GetDevexWeights();
-  const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
   SCOPED_TIME_STAT(&stats_);
-
-  Fractional best_price(0.0);
-  *entering_col = kInvalidCol;
-  equivalent_entering_choices_.clear();
-  for (const ColIndex col : reduced_costs_->GetDualInfeasiblePositions()) {
-    if (use_steepest_edge) {
-      // Note that here the weights are squared.
-      const Fractional squared_reduced_cost = Square(reduced_costs[col]);
-      if (squared_reduced_cost >= best_price * weights[col]) {
-        if (squared_reduced_cost == best_price * weights[col]) {
-          equivalent_entering_choices_.push_back(col);
-          continue;
-        }
-        equivalent_entering_choices_.clear();
-        best_price = squared_reduced_cost / weights[col];
-        *entering_col = col;
-      }
-    } else {
-      const Fractional positive_reduced_cost = fabs(reduced_costs[col]);
-      if (positive_reduced_cost >= best_price * weights[col]) {
-        if (positive_reduced_cost == best_price * weights[col]) {
-          equivalent_entering_choices_.push_back(col);
-          continue;
-        }
-        equivalent_entering_choices_.clear();
-        best_price = positive_reduced_cost / weights[col];
-        *entering_col = col;
-      }
-    }
+  const int num_cols = variables_info_.GetNumberOfColumns().value();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_cols);
+  pricing_chunks_.resize(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    NormalizedPriceChunk<use_steepest_edge>(
+        ColIndex(ChunkStart(num_cols, num_chunks, chunk)),
+        ColIndex(ChunkStart(num_cols, num_chunks, chunk + 1)),
+        &pricing_chunks_[chunk]);
   }
+  *entering_col = MergePricingChunks(true);
+
   // Break the ties randomly.
   if (!equivalent_entering_choices_.empty()) {
     equivalent_entering_choices_.push_back(*entering_col);
@@ -502,5 +564,65 @@ void EnteringVariable::NormalizedChooseEnteringColumn(ColIndex* entering_col) {
   }
 }
 
+template <bool use_steepest_edge>
+void EnteringVariable::NormalizedPriceChunk(ColIndex begin, ColIndex end,
+                                            PricingChunk* chunk) const {
+  const DenseRow& weights = use_steepest_edge
+                                ? primal_edge_norms_->GetEdgeSquaredNorms()
+                                : primal_edge_norms_->GetDevexWeights();
+  const DenseRow& reduced_costs = reduced_costs_->GetReducedCosts();
+  const DenseBitRow& candidates = reduced_costs_->GetDualInfeasiblePositions();
+
+  // Note that the price is always computed with a division (and not compared
+  // with a multiplication by the weight) so that the comparisons are
+  // consistent across chunks.
+  Fractional best_price(0.0);
+  chunk->best_col = kInvalidCol;
+  chunk->ties.clear();
+  for (DenseBitRow::Iterator it(candidates, begin);
+       it.Ok() && it.Index() < end; it.Next()) {
+    const ColIndex col = it.Index();
+
+    // Note that for the steepest edge, the weights are squared.
+    const Fractional price = use_steepest_edge
+                                 ? Square(reduced_costs[col]) / weights[col]
+                                 : fabs(reduced_costs[col]) / weights[col];
+    if (price >= best_price) {
+      if (price == best_price) {
+        chunk->ties.push_back(col);
+        continue;
+      }
+      chunk->ties.clear();
+      best_price = price;
+      chunk->best_col = col;
+    }
+  }
+  chunk->best_price = best_price;
+}
+
+ColIndex EnteringVariable::MergePricingChunks(bool keep_ties) {
+  Fractional best_price(0.0);
+  ColIndex entering_col = kInvalidCol;
+  equivalent_entering_choices_.clear();
+  for (const PricingChunk& chunk : pricing_chunks_) {
+    if (chunk.best_col == kInvalidCol) continue;
+    if (chunk.best_price > best_price) {
+      best_price = chunk.best_price;
+      entering_col = chunk.best_col;
+      equivalent_entering_choices_.clear();
+      if (keep_ties) {
+        equivalent_entering_choices_.assign(chunk.ties.begin(),
+                                            chunk.ties.end());
+      }
+    } else if (keep_ties && chunk.best_price == best_price) {
+      equivalent_entering_choices_.push_back(chunk.best_col);
+      equivalent_entering_choices_.insert(equivalent_entering_choices_.end(),
+                                          chunk.ties.begin(),
+                                          chunk.ties.end());
+    }
+  }
+  return entering_col;
+}
+
 }  // namespace glop
 }  // namespace operations_research
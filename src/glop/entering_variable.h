@@ -15,6 +15,7 @@
 #define OR_TOOLS_GLOP_ENTERING_VARIABLE_H_
 
 #include "glop/basis_representation.h"
+#include "glop/parallel_utils.h"
 #include "glop/parameters.pb.h"
 #include "glop/primal_edge_norms.h"
 #include "glop/reduced_costs.h"
@@ -111,6 +112,60 @@ class EnteringVariable {
   template <bool use_steepest_edge>
   void NormalizedChooseEnteringColumn(ColIndex* entering_col);
 
+  // The pricing loops above are split in chunks of columns (see
+  // parallel_utils.h). This is the result for one chunk: the column with the
+  // best price and the other columns with exactly the same price.
+  struct PricingChunk {
+    ColIndex best_col;
+    Fractional best_price;
+    std::vector<ColIndex> ties;
+  };
+
+  // Prices the candidate columns in [begin, end).
+  template <bool normalize, bool nested_pricing>
+  void DantzigPriceChunk(ColIndex begin, ColIndex end,
+                         PricingChunk* chunk) const;
+  template <bool use_steepest_edge>
+  void NormalizedPriceChunk(ColIndex begin, ColIndex end,
+                            PricingChunk* chunk) const;
+
+  // Merges pricing_chunks_ in order and returns the best column. If keep_ties
+  // is true, the other columns with the same price are stored in
+  // equivalent_entering_choices_.
+  ColIndex MergePricingChunks(bool keep_ties);
+
+  // A column with its update coefficient and ratio.
+  // This is used during the dual phase I & II ratio tests.
+  struct ColWithRatio {
+    ColWithRatio(ColIndex _col, Fractional reduced_cost, Fractional coeff_m)
+        : col(_col), ratio(reduced_cost / coeff_m), coeff_magnitude(coeff_m) {}
+
+    // Returns false if "this" is before "other" in a priority queue.
+    bool operator<(const ColWithRatio& other) const {
+      if (ratio == other.ratio) {
+        if (coeff_magnitude == other.coeff_magnitude) {
+          return col > other.col;
+        }
+        return coeff_magnitude < other.coeff_magnitude;
+      }
+      return ratio > other.ratio;
+    }
+
+    ColIndex col;
+    Fractional ratio;
+    Fractional coeff_magnitude;
+  };
+
+  // First pass of the dual ratio tests on the update row positions in
+  // [begin, end): appends the breakpoints to the given vector. The phase II
+  // version also returns the harris ratio used to prune them.
+  Fractional DualCollectBreakpoints(
+      const UpdateRow& update_row, Fractional cost_variation, int begin,
+      int end, std::vector<ColWithRatio>* breakpoints) const;
+  void DualPhaseICollectBreakpoints(
+      const UpdateRow& update_row, Fractional cost_variation, int begin,
+      int end, std::vector<ColWithRatio>* breakpoints) const;
+
   // Problem data that should be updated from outside.
   const VariablesInfo& variables_info_;
 
@@ -142,6 +197,10 @@ class EnteringVariable {
   // anyway.
   std::vector<ColIndex> equivalent_entering_choices_;
 
+  // Per-chunk results of the pricing and of the dual ratio tests.
+  std::vector<PricingChunk> pricing_chunks_;
+  std::vector<std::vector<ColWithRatio>> chunk_breakpoints_;
+
   DISALLOW_COPY_AND_ASSIGN(EnteringVariable);
 };
 
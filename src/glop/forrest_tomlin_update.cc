@@ -0,0 +1,388 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "glop/forrest_tomlin_update.h"
+
+#include <algorithm>
+
+#include "lp_data/lp_utils.h"
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+// Maximum relative difference between the new diagonal coefficient of U
+// computed by an update and the one implied by the pivot. Over this, the
+// update is considered numerically unstable.
+const Fractional kUpdateTolerance = 1e-8;
+
+// The factors are recomputed when their number of entries reaches this factor
+// times the one of a fresh factorization (counting the diagonal).
+const double kMaxNumEntriesGrowth = 2.0;
+
+// Sorts and removes the duplicates of non_zeros if it grew beyond its initial
+// size, or clears it if it contains more than 10% of the given number of
+// positions, in which case the vector is considered dense.
+void CleanUpIfGrown(size_t initial_size, RowIndex num_rows,
+                    RowIndexVector* non_zeros) {
+  if (non_zeros->size() == initial_size) return;
+  if (10 * non_zeros->size() > num_rows.value()) {
+    non_zeros->clear();
+    return;
+  }
+  std::sort(non_zeros->begin(), non_zeros->end());
+  non_zeros->erase(std::unique(non_zeros->begin(), non_zeros->end()),
+                   non_zeros->end());
+}
+
+}  // namespace
+
+ForrestTomlinFactorization::ForrestTomlinFactorization()
+    : is_initialized_(false),
+      num_rows_(0),
+      num_upper_entries_(0),
+      initial_num_entries_(0) {}
+
+void ForrestTomlinFactorization::Clear() {
+  if (!is_initialized_) return;
+  SCOPED_TIME_STAT(&stats_);
+  IF_STATS_ENABLED(
+      stats_.row_eta_num_entries.Add(row_etas_.num_entries().value()));
+  for (Line& line : columns_) line.clear();
+  for (Line& line : rows_) line.clear();
+  row_etas_.Reset(RowIndex(0));
+  eta_pivots_.clear();
+  num_upper_entries_ = EntryIndex(0);
+  is_initialized_ = false;
+}
+
+void ForrestTomlinFactorization::Initialize(const LuFactorization& lu,
+                                            RowIndex num_rows) {
+  SCOPED_TIME_STAT(&stats_);
+  DCHECK(!is_initialized_);
+  DCHECK(lu.GetColumnPermutation().empty());
+  num_rows_ = num_rows;
+  columns_.resize(num_rows, Line());
+  rows_.resize(num_rows, Line());
+  diagonal_.AssignToZero(num_rows);
+  position_.resize(num_rows, 0);
+  order_.clear();
+  num_upper_entries_ = EntryIndex(0);
+  for (RowIndex col(0); col < num_rows; ++col) {
+    position_[col] = order_.size();
+    order_.push_back(col);
+    for (const SparseColumn::Entry e : lu.GetColumnOfU(RowToColIndex(col))) {
+      if (e.row() == col) {
+        diagonal_[col] = e.coefficient();
+        continue;
+      }
+      columns_[col].push_back(Entry(e.row(), e.coefficient()));
+      rows_[e.row()].push_back(Entry(col, e.coefficient()));
+      ++num_upper_entries_;
+    }
+  }
+  row_etas_.Reset(num_rows);
+  eta_pivots_.clear();
+  initial_num_entries_ = num_upper_entries_;
+  dense_zero_scratchpad_.AssignToZero(num_rows);
+  is_initialized_ = true;
+}
+
+void ForrestTomlinFactorization::RemoveEntry(RowIndex index, Line* line) {
+  const int size = line->size();
+  for (int i = 0; i < size; ++i) {
+    if ((*line)[i].index == index) {
+      (*line)[i] = line->back();
+      line->pop_back();
+      return;
+    }
+  }
+  LOG(DFATAL) << "Entry " << index << " not found.";
+}
+
+bool ForrestTomlinFactorization::Update(
+    RowIndex leaving_row, const CompactSparseMatrix::ColumnView& spike,
+    Fractional pivot) {
+  SCOPED_TIME_STAT(&stats_);
+  DCHECK(is_initialized_);
+  const RowIndex p = leaving_row;
+
+  // The elimination multipliers m are the solution of m.U' = r where r is the
+  // row p of U without its diagonal entry and U' is U restricted to the
+  // positions after p. This is a left solve with U starting after p since the
+  // rows of these positions have no entry in the column p.
+  DenseColumn* const multipliers = &dense_zero_scratchpad_;
+  RowIndexVector* const non_zeros = &scratchpad_non_zeros_;
+  DCHECK(IsAllZero(*multipliers));
+  non_zeros->clear();
+  for (const Entry& e : rows_[p]) {
+    (*multipliers)[e.index] = e.coefficient;
+    non_zeros->push_back(e.index);
+  }
+  if (!non_zeros->empty()) {
+    TransposeSolve(position_[p] + 1, multipliers, non_zeros);
+    if (non_zeros->empty()) ComputeNonZeros(*multipliers, non_zeros);
+  }
+
+  // Eliminating the row p from the new column p gives the new diagonal entry.
+  // Since the determinant of B is multiplied by the pivot and the row etas
+  // have a unit diagonal, it should be equal to the old one times the pivot.
+  Fractional new_diagonal = 0.0;
+  const EntryIndex num_spike_entries = spike.num_entries();
+  for (EntryIndex i(0); i < num_spike_entries; ++i) {
+    const RowIndex row = spike.EntryRow(i);
+    if (row == p) {
+      new_diagonal += spike.EntryCoefficient(i);
+    } else {
+      new_diagonal -= (*multipliers)[row] * spike.EntryCoefficient(i);
+    }
+  }
+  const Fractional expected_diagonal = pivot * diagonal_[p];
+  const Fractional error = fabs(new_diagonal - expected_diagonal);
+  IF_STATS_ENABLED(stats_.update_error.Add(
+      error / std::max(Fractional(1.0), fabs(expected_diagonal))));
+  if (new_diagonal == 0.0 ||
+      error > kUpdateTolerance * fabs(expected_diagonal)) {
+    for (const RowIndex row : *non_zeros) (*multipliers)[row] = 0.0;
+    return false;
+  }
+  row_etas_.AddAndClearColumnWithNonZeros(multipliers, non_zeros);
+  eta_pivots_.push_back(p);
+
+  // Removes the old column p and the row p from U.
+  for (const Entry& e : columns_[p]) RemoveEntry(p, &rows_[e.index]);
+  num_upper_entries_ -= EntryIndex(columns_[p].size());
+  columns_[p].clear();
+  for (const Entry& e : rows_[p]) RemoveEntry(p, &columns_[e.index]);
+  num_upper_entries_ -= EntryIndex(rows_[p].size());
+  rows_[p].clear();
+
+  // Adds the spike as the new column p and moves p last in the order.
+  for (EntryIndex i(0); i < num_spike_entries; ++i) {
+    const RowIndex row = spike.EntryRow(i);
+    const Fractional coefficient = spike.EntryCoefficient(i);
+    if (row == p || coefficient == 0.0) continue;
+    columns_[p].push_back(Entry(row, coefficient));
+    rows_[row].push_back(Entry(p, coefficient));
+    ++num_upper_entries_;
+  }
+  diagonal_[p] = new_diagonal;
+  order_[position_[p]] = kInvalidRow;
+  position_[p] = order_.size();
+  order_.push_back(p);
+
+  return static_cast<double>(num_entries().value()) <=
+         kMaxNumEntriesGrowth *
+             static_cast<double>(initial_num_entries_.value() +
+                                 num_rows_.value());
+}
+
+void ForrestTomlinFactorization::RightSolveRowEtas(
+    DenseColumn* x, RowIndexVector* non_zeros) const {
+  SCOPED_TIME_STAT(&stats_);
+  const bool is_sparse = !non_zeros->empty();
+  const size_t initial_size = non_zeros->size();
+  const int num_etas = eta_pivots_.size();
+  for (int i = 0; i < num_etas; ++i) {
+    Fractional sum = 0.0;
+    for (const EntryIndex e : row_etas_.Column(ColIndex(i))) {
+      sum += row_etas_.EntryCoefficient(e) * (*x)[row_etas_.EntryRow(e)];
+    }
+    if (sum == 0.0) continue;
+    const RowIndex p = eta_pivots_[i];
+    if (is_sparse && (*x)[p] == 0.0) non_zeros->push_back(p);
+    (*x)[p] -= sum;
+  }
+  CleanUpIfGrown(initial_size, num_rows_, non_zeros);
+}
+
+void ForrestTomlinFactorization::LeftSolveRowEtas(
+    DenseRow* y, ColIndexVector* non_zeros) const {
+  SCOPED_TIME_STAT(&stats_);
+  DenseColumn* const x = reinterpret_cast<DenseColumn*>(y);
+  RowIndexVector* const non_zero_rows =
+      reinterpret_cast<RowIndexVector*>(non_zeros);
+  bool is_sparse = !non_zeros->empty();
+  const size_t initial_size = non_zeros->size();
+  for (int i = eta_pivots_.size() - 1; i >= 0; --i) {
+    const Fractional value = (*x)[eta_pivots_[i]];
+    if (value == 0.0) continue;
+    const ColIndex eta(i);
+    for (const EntryIndex e : row_etas_.Column(eta)) {
+      (*x)[row_etas_.EntryRow(e)] -= row_etas_.EntryCoefficient(e) * value;
+    }
+    if (is_sparse) {
+      if (10 * (non_zero_rows->size() + row_etas_.ColumnNumEntries(eta).value())
+          > num_rows_.value()) {
+        non_zero_rows->clear();
+        is_sparse = false;
+        continue;
+      }
+      for (const EntryIndex e : row_etas_.Column(eta)) {
+        non_zero_rows->push_back(row_etas_.EntryRow(e));
+      }
+    }
+  }
+  CleanUpIfGrown(initial_size, num_rows_, non_zero_rows);
+}
+
+void ForrestTomlinFactorization::RightSolveUWithNonZeros(
+    DenseColumn* x, RowIndexVector* non_zeros) const {
+  SCOPED_TIME_STAT(&stats_);
+  if (!non_zeros->empty() && ComputeRowsToConsider(columns_, non_zeros)) {
+    IF_STATS_ENABLED(stats_.hypersparse_solves.Add(1));
+    SparseSolve(columns_, *non_zeros, x);
+    std::sort(non_zeros->begin(), non_zeros->end());
+    int new_size = 0;
+    for (const RowIndex row : *non_zeros) {
+      if ((*x)[row] != 0.0) (*non_zeros)[new_size++] = row;
+    }
+    non_zeros->resize(new_size);
+    return;
+  }
+  IF_STATS_ENABLED(stats_.hypersparse_solves.Add(0));
+  RightSolveU(x);
+  ComputeNonZeros(*x, non_zeros);
+}
+
+void ForrestTomlinFactorization::LeftSolveUWithNonZeros(
+    DenseRow* y, ColIndexVector* non_zeros) const {
+  SCOPED_TIME_STAT(&stats_);
+  TransposeSolve(0, reinterpret_cast<DenseColumn*>(y),
+                 reinterpret_cast<RowIndexVector*>(non_zeros));
+}
+
+void ForrestTomlinFactorization::LeftSolveUForUnitRow(
+    ColIndex col, DenseRow* y, ColIndexVector* non_zeros) const {
+  SCOPED_TIME_STAT(&stats_);
+  DCHECK(IsAllZero(*y));
+  (*y)[col] = 1.0;
+  non_zeros->clear();
+  non_zeros->push_back(col);
+  TransposeSolve(position_[ColToRowIndex(col)],
+                 reinterpret_cast<DenseColumn*>(y),
+                 reinterpret_cast<RowIndexVector*>(non_zeros));
+}
+
+void ForrestTomlinFactorization::TransposeSolve(
+    int start, DenseColumn* x, RowIndexVector* non_zeros) const {
+  if (!non_zeros->empty() && ComputeRowsToConsider(rows_, non_zeros)) {
+    IF_STATS_ENABLED(stats_.hypersparse_solves.Add(1));
+    SparseSolve(rows_, *non_zeros, x);
+    return;
+  }
+  IF_STATS_ENABLED(stats_.hypersparse_solves.Add(0));
+  DenseLeftSolve(start, x);
+}
+
+void ForrestTomlinFactorization::RightSolveU(DenseColumn* x) const {
+  for (int i = order_.size() - 1; i >= 0; --i) {
+    const RowIndex col = order_[i];
+    if (col == kInvalidRow) continue;
+    const Fractional value = (*x)[col];
+    if (value == 0.0) continue;
+    const Fractional result = value / diagonal_[col];
+    (*x)[col] = result;
+    for (const Entry& e : columns_[col]) {
+      (*x)[e.index] -= e.coefficient * result;
+    }
+  }
+}
+
+void ForrestTomlinFactorization::DenseLeftSolve(int start,
+                                                DenseColumn* x) const {
+  const int end = order_.size();
+  for (int i = start; i < end; ++i) {
+    const RowIndex row = order_[i];
+    if (row == kInvalidRow) continue;
+    const Fractional value = (*x)[row];
+    if (value == 0.0) continue;
+    const Fractional result = value / diagonal_[row];
+    (*x)[row] = result;
+    for (const Entry& e : rows_[row]) {
+      (*x)[e.index] -= e.coefficient * result;
+    }
+  }
+}
+
+void ForrestTomlinFactorization::SparseSolve(const Lines& graph,
+                                             const RowIndexVector& non_zeros,
+                                             DenseColumn* x) const {
+  for (int i = non_zeros.size() - 1; i >= 0; --i) {
+    const RowIndex row = non_zeros[i];
+    const Fractional value = (*x)[row];
+    if (value == 0.0) continue;
+    const Fractional result = value / diagonal_[row];
+    (*x)[row] = result;
+    for (const Entry& e : graph[row]) {
+      (*x)[e.index] -= e.coefficient * result;
+    }
+  }
+}
+
+// This is the same algorithm as TriangularMatrix::TriangularComputeRowsToConsider()
+// on the mutable storage of U.
+bool ForrestTomlinFactorization::ComputeRowsToConsider(
+    const Lines& graph, RowIndexVector* non_zeros) const {
+  stored_.resize(num_rows_, false);
+
+  // We stop the depth-first search if the number of operations reaches this
+  // threshold since a dense solve is then as fast.
+  const int kHypersparseThreshold =
+      static_cast<int>(0.1 * static_cast<double>(num_rows_.value()));
+  int num_ops = non_zeros->size();
+  if (num_ops > kHypersparseThreshold) {
+    non_zeros->clear();
+    return false;
+  }
+
+  nodes_to_explore_.clear();
+  nodes_to_explore_.swap(*non_zeros);
+  while (!nodes_to_explore_.empty()) {
+    const RowIndex row = nodes_to_explore_.back();
+
+    // If the depth-first search from the current node is finished, we store the
+    // node. This will store the node in reverse topological order.
+    if (row < 0) {
+      nodes_to_explore_.pop_back();
+      const RowIndex explored_row = nodes_to_explore_.back();
+      nodes_to_explore_.pop_back();
+      stored_[explored_row] = true;
+      non_zeros->push_back(explored_row);
+      continue;
+    }
+    if (stored_[row]) {
+      nodes_to_explore_.pop_back();
+      continue;
+    }
+    nodes_to_explore_.push_back(kInvalidRow);
+    for (const Entry& e : graph[row]) {
+      ++num_ops;
+      if (!stored_[e.index]) nodes_to_explore_.push_back(e.index);
+    }
+    if (num_ops > kHypersparseThreshold) break;
+  }
+  for (const RowIndex row : *non_zeros) {
+    stored_[row] = false;
+  }
+  if (num_ops > kHypersparseThreshold) {
+    non_zeros->clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace glop
+}  // namespace operations_research
@@ -0,0 +1,215 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OR_TOOLS_GLOP_FORREST_TOMLIN_UPDATE_H_
+#define OR_TOOLS_GLOP_FORREST_TOMLIN_UPDATE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "glop/lu_factorization.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/sparse.h"
+#include "util/stats.h"
+
+namespace operations_research {
+namespace glop {
+
+// Forrest-Tomlin update of the LU factorization of the basis.
+//
+// Starting from P.B = L.U with an identity column permutation, after k updates
+// the basis is represented as:
+//   P.B_k = L.R_1^{-1}...R_k^{-1}.U_k
+// where each R_i = I - e_p.m^T is a row eta matrix and U_k is a triangular
+// matrix up to a symmetric permutation. When the column p of the basis is
+// replaced, the column p of U_k is replaced by the "spike"
+// s = R_k...R_1.L^{-1}.P.a, p is moved last in the triangular order of U and
+// the entries of the row p that are now on the wrong side of the diagonal are
+// eliminated using the rows below it. The elimination multipliers give the
+// next row eta matrix.
+//
+// Unlike the eta and the middle product form updates, U is modified in place
+// and only one sparse row eta is added per update, so the cost of the solves
+// stays almost constant between two refactorizations. To support this, U is
+// stored both by columns and by rows with entries that can be removed, and
+// the triangular order is kept in a separate vector.
+//
+// Only the solves with U and the R_i are implemented here, the ones with L and
+// P are still done by the LuFactorization.
+//
+// References:
+//
+// J. J. H. Forrest, J. A. Tomlin, "Updated triangular factors of the basis to
+// maintain sparsity in the product form simplex method", Mathematical
+// Programming, Vol. 2, pp. 263-278, 1972.
+//
+// Istvan Maros, "Computational Techniques of the Simplex Method", Kluwer
+// Academic Publishers, 2003, section 8.2.
+class ForrestTomlinFactorization {
+ public:
+  ForrestTomlinFactorization();
+
+  // Deletes all the updates. Initialize() must be called before the next
+  // Update().
+  void Clear();
+
+  // Returns true if Initialize() was called since the last Clear(). As long as
+  // this is false, the solves must use the U factor of the LuFactorization.
+  bool IsInitialized() const { return is_initialized_; }
+
+  // Copies the U factor of the given LU factorization of a matrix with
+  // num_rows rows. Its column permutation must be the identity.
+  void Initialize(const LuFactorization& lu, RowIndex num_rows);
+
+  // Replaces the column leaving_row of U by the given spike which must be the
+  // entering column after the solve with L and the current row etas (see
+  // RightSolveRowEtas()). The pivot is the coefficient of the leaving row in
+  // B^{-1}.a, it is only used to check the numerical accuracy of the update.
+  //
+  // Returns false if the update is not accurate enough or if the factors
+  // became too dense compared to a fresh factorization. The factorization is
+  // then not valid anymore and the basis must be refactorized.
+  bool Update(RowIndex leaving_row, const CompactSparseMatrix::ColumnView& spike,
+              Fractional pivot) MUST_USE_RESULT;
+
+  // Solves R_k...R_1.x with the initial x (a column vector), that is applies
+  // all the row etas in order. If non_zeros is not empty, it must contain all
+  // the non-zero positions of x and the new ones are added to it. It is
+  // cleared (i.e. x is considered dense) if it becomes too large.
+  void RightSolveRowEtas(DenseColumn* x, RowIndexVector* non_zeros) const;
+
+  // Solves U.x = initial x.
+  void RightSolveU(DenseColumn* x) const;
+
+  // Same as RightSolveU(), the given non_zeros is used like in
+  // LuFactorization::RightSolveUWithNonZeros(): if it is not empty it must
+  // contain all the non-zero positions of x and the solve is hyper-sparse when
+  // possible. On output, it contains the sorted non-zero positions of x.
+  void RightSolveUWithNonZeros(DenseColumn* x, RowIndexVector* non_zeros) const;
+
+  // Solves y.U = initial y. If non_zeros is not empty, it must contain all the
+  // non-zero positions of y and the solve is hyper-sparse when possible. On
+  // output, non_zeros contains a super-set of the non-zero positions of y, or
+  // is empty if the result is considered dense.
+  void LeftSolveUWithNonZeros(DenseRow* y, ColIndexVector* non_zeros) const;
+
+  // Same as LeftSolveUWithNonZeros() for an initial y equal to the unit vector
+  // e_col. Important: the given y must be all zero and of the correct size.
+  void LeftSolveUForUnitRow(ColIndex col, DenseRow* y,
+                            ColIndexVector* non_zeros) const;
+
+  // Solves y.R_k...R_1 = initial y (a row vector). The given non_zeros is
+  // handled like in RightSolveRowEtas().
+  void LeftSolveRowEtas(DenseRow* y, ColIndexVector* non_zeros) const;
+
+  // Returns the number of updates since the last Initialize().
+  int num_updates() const { return eta_pivots_.size(); }
+
+  // Returns the number of off-diagonal entries of U plus the number of entries
+  // of the row etas.
+  EntryIndex num_entries() const {
+    return num_upper_entries_ + row_etas_.num_entries();
+  }
+
+  // Returns a std::string containing the statistics for this class.
+  std::string StatString() const { return stats_.StatString(); }
+
+ private:
+  // Statistics about this class.
+  struct Stats : public StatsGroup {
+    Stats()
+        : StatsGroup("ForrestTomlinFactorization"),
+          update_error("update_error", this),
+          row_eta_num_entries("row_eta_num_entries", this),
+          hypersparse_solves("hypersparse_solves", this) {}
+    DoubleDistribution update_error;
+    IntegerDistribution row_eta_num_entries;
+    RatioDistribution hypersparse_solves;
+  };
+
+  // An off-diagonal entry of U. For a column of U, index is the row of the
+  // entry and for a row of U it is its column. Since the column permutation
+  // is the identity, both are in the same index space.
+  struct Entry {
+    Entry(RowIndex i, Fractional c) : index(i), coefficient(c) {}
+    RowIndex index;
+    Fractional coefficient;
+  };
+  typedef std::vector<Entry> Line;
+  typedef StrictITIVector<RowIndex, Line> Lines;
+
+  // Removes the entry with the given index from the given line. The order of
+  // the entries of a line does not matter, so this swaps it with the last one.
+  static void RemoveEntry(RowIndex index, Line* line);
+
+  // Computes the positions of the non-zeros of x after a solve with U (if
+  // graph is columns_) or with U^T (if graph is rows_) from the ones of the
+  // input with a depth-first search. The result is in reverse topological
+  // order. Returns false and clears non_zeros if there are too many of them,
+  // in which case a dense solve must be used.
+  bool ComputeRowsToConsider(const Lines& graph,
+                             RowIndexVector* non_zeros) const;
+
+  // Solves with U (if graph is columns_) or with U^T (if graph is rows_) on
+  // the positions computed by ComputeRowsToConsider(). The dense version
+  // solves with U^T for all the positions of order_ from the given start.
+  void SparseSolve(const Lines& graph, const RowIndexVector& non_zeros,
+                   DenseColumn* x) const;
+  void DenseLeftSolve(int start, DenseColumn* x) const;
+
+  // Same as LeftSolveUWithNonZeros() on a column.
+  void TransposeSolve(int start, DenseColumn* x,
+                      RowIndexVector* non_zeros) const;
+
+  bool is_initialized_;
+  RowIndex num_rows_;
+
+  // The off-diagonal entries of U by columns and by rows, and its diagonal.
+  Lines columns_;
+  Lines rows_;
+  DenseColumn diagonal_;
+  EntryIndex num_upper_entries_;
+
+  // The triangular order of U: the entries of the column order_[i] are all
+  // in rows order_[j] with j < i. The columns moved last by an update leave a
+  // kInvalidRow hole at their previous position, and position_ is the inverse
+  // of order_.
+  std::vector<RowIndex> order_;
+  StrictITIVector<RowIndex, int> position_;
+
+  // The multipliers m of the row etas R_i = I - e_p.m^T with p in eta_pivots_.
+  CompactSparseMatrix row_etas_;
+  std::vector<RowIndex> eta_pivots_;
+
+  // Number of entries of U and of the row etas just after Initialize().
+  EntryIndex initial_num_entries_;
+
+  // Work data for Update(), dense_zero_scratchpad_ is always reset to zero.
+  DenseColumn dense_zero_scratchpad_;
+  RowIndexVector scratchpad_non_zeros_;
+
+  // For the depth-first search of ComputeRowsToConsider().
+  mutable DenseBooleanColumn stored_;
+  mutable std::vector<RowIndex> nodes_to_explore_;
+
+  // Statistics, mutable so const functions can still update it.
+  mutable Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForrestTomlinFactorization);
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_FORREST_TOMLIN_UPDATE_H_
@@ -0,0 +1,677 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "glop/interior_point.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "lp_data/lp_utils.h"
+#include "util/return_macros.h"
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+// Pivots of the Cholesky factorization smaller than this factor times the
+// corresponding diagonal entry of A.W.A^T are replaced by kHugePivot.
+const Fractional kPivotTolerance = 1e-30;
+const Fractional kHugePivot = 1e128;
+
+// Regularizations used to make the normal equations well defined when there
+// are free variables or linearly dependent rows.
+const Fractional kPrimalRegularization = 1e-10;
+const Fractional kDualRegularization = 1e-10;
+
+// The fraction of the maximum step to the boundary that is taken at each
+// iteration so that the iterates stay strictly interior.
+const Fractional kStepFactor = 0.9995;
+
+// The iterates diverge on infeasible or unbounded problems. The algorithm stops
+// when they become larger than this or when they are no longer strictly
+// interior because of rounding errors, well before any division by zero or
+// overflow (which trigger an exception when they are enabled in LPSolver).
+const Fractional kMaxIterateMagnitude = 1e30;
+
+}  // namespace
+
+// --------------------------------------------------------
+// SparseCholeskyFactorization
+// --------------------------------------------------------
+
+SparseCholeskyFactorization::SparseCholeskyFactorization()
+    : num_rows_(0), num_replaced_pivots_(0), num_operations_(0) {}
+
+// This is the classical minimum degree algorithm on the explicit elimination
+// graph: the row of smallest degree is eliminated first and its neighbors
+// become a clique. The neighbors of a row when it is eliminated are exactly
+// the non-zeros of the corresponding column of L.
+//
+// TODO(user): Use a quotient graph with supervariables (approximate minimum
+// degree) to reduce the running time on problems with a lot of fill-in.
+void SparseCholeskyFactorization::ComputeOrderingAndPattern(
+    const CompactSparseMatrix& matrix, const CompactSparseMatrix& transpose) {
+  num_rows_ = matrix.num_rows();
+
+  // Computes the non-zero pattern of A.A^T without its diagonal.
+  std::vector<std::vector<RowIndex>> adjacency(num_rows_.value());
+  StrictITIVector<RowIndex, RowIndex> marker(num_rows_, kInvalidRow);
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    marker[row] = row;
+    for (const EntryIndex i : transpose.Column(RowToColIndex(row))) {
+      const ColIndex col = RowToColIndex(transpose.EntryRow(i));
+      for (const EntryIndex j : matrix.Column(col)) {
+        const RowIndex other = matrix.EntryRow(j);
+        if (marker[other] == row) continue;
+        marker[other] = row;
+        adjacency[row.value()].push_back(other);
+      }
+    }
+  }
+
+  // Lazy priority queue of (degree, row): an entry is stale if the row degree
+  // changed since it was pushed.
+  typedef std::pair<int, RowIndex> DegreeAndRow;
+  std::priority_queue<DegreeAndRow, std::vector<DegreeAndRow>,
+                      std::greater<DegreeAndRow>> queue;
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    queue.push(DegreeAndRow(adjacency[row.value()].size(), row));
+  }
+
+  // Eliminates the rows one by one. The column patterns of L are stored in
+  // rows_ using the original row indices for now.
+  row_perm_.assign(num_rows_, kInvalidRow);
+  inverse_row_perm_.assign(num_rows_, kInvalidRow);
+  starts_.assign(num_rows_ + 1, EntryIndex(0));
+  rows_.clear();
+  marker.assign(num_rows_, kInvalidRow);
+  RowIndex position(0);
+  while (!queue.empty()) {
+    const RowIndex pivot = queue.top().second;
+    const int degree = queue.top().first;
+    queue.pop();
+    std::vector<RowIndex>& neighbors = adjacency[pivot.value()];
+    if (row_perm_[pivot] != kInvalidRow || degree != neighbors.size()) continue;
+    row_perm_[pivot] = position;
+    inverse_row_perm_[position] = pivot;
+    ++position;
+    for (const RowIndex row : neighbors) {
+      rows_.push_back(row);
+      marker[row] = pivot;
+    }
+    starts_[position] = EntryIndex(rows_.size());
+
+    // Each neighbor loses the pivot and gains the other neighbors.
+    for (const RowIndex row : neighbors) {
+      std::vector<RowIndex>& list = adjacency[row.value()];
+      int new_size = 0;
+      for (const RowIndex other : list) {
+        if (other == pivot || marker[other] == pivot) continue;
+        list[new_size++] = other;
+      }
+      list.resize(new_size);
+      for (const RowIndex other : neighbors) {
+        if (other != row) list.push_back(other);
+      }
+      queue.push(DegreeAndRow(list.size(), row));
+    }
+    std::vector<RowIndex>().swap(neighbors);
+  }
+  DCHECK_EQ(position, num_rows_);
+
+  // Converts the pattern to the new row order.
+  for (EntryIndex i(0); i < rows_.size(); ++i) {
+    rows_[i] = row_perm_[rows_[i]];
+  }
+  for (RowIndex col(0); col < num_rows_; ++col) {
+    std::sort(rows_.begin() + starts_[col].value(),
+              rows_.begin() + starts_[col + 1].value());
+  }
+  values_.assign(rows_.size(), 0.0);
+  diagonal_.assign(num_rows_, 0.0);
+  work_.assign(num_rows_, 0.0);
+  first_.assign(num_rows_, EntryIndex(0));
+  link_head_.assign(num_rows_, kInvalidRow);
+  link_next_.assign(num_rows_, kInvalidRow);
+}
+
+void SparseCholeskyFactorization::Factorize(
+    const CompactSparseMatrix& matrix, const CompactSparseMatrix& transpose,
+    const DenseRow& weights, Fractional regularization) {
+  num_replaced_pivots_ = 0;
+  link_head_.assign(num_rows_, kInvalidRow);
+  for (RowIndex col(0); col < num_rows_; ++col) {
+    // Scatters the lower part of the column of A.W.A^T in work_.
+    const RowIndex row = inverse_row_perm_[col];
+    for (const EntryIndex i : transpose.Column(RowToColIndex(row))) {
+      const ColIndex matrix_col = RowToColIndex(transpose.EntryRow(i));
+      const Fractional factor =
+          transpose.EntryCoefficient(i) * weights[matrix_col];
+      if (factor == 0.0) continue;
+      for (const EntryIndex j : matrix.Column(matrix_col)) {
+        const RowIndex permuted_row = row_perm_[matrix.EntryRow(j)];
+        if (permuted_row < col) continue;
+        work_[permuted_row] += factor * matrix.EntryCoefficient(j);
+      }
+      num_operations_ += matrix.ColumnNumEntries(matrix_col).value();
+    }
+    work_[col] += regularization;
+    const Fractional original_pivot = work_[col];
+
+    // Left-looking update with the previous columns that have a non-zero on
+    // this row. They are then linked to the row of their next non-zero.
+    RowIndex previous = link_head_[col];
+    while (previous != kInvalidRow) {
+      const RowIndex next = link_next_[previous];
+      const EntryIndex end = starts_[previous + 1];
+      EntryIndex i = first_[previous];
+      DCHECK_EQ(rows_[i], col);
+      const Fractional factor = values_[i];
+      for (; i < end; ++i) {
+        work_[rows_[i]] -= factor * values_[i];
+      }
+      num_operations_ += (end - first_[previous]).value();
+      ++first_[previous];
+      if (first_[previous] < end) {
+        const RowIndex next_row = rows_[first_[previous]];
+        link_next_[previous] = link_head_[next_row];
+        link_head_[next_row] = previous;
+      }
+      previous = next;
+    }
+
+    // Computes the column of L.
+    Fractional pivot = work_[col];
+    work_[col] = 0.0;
+    if (pivot <= kPivotTolerance * original_pivot || pivot <= 0.0) {
+      pivot = kHugePivot;
+      ++num_replaced_pivots_;
+    }
+    const Fractional diagonal = sqrt(pivot);
+    diagonal_[col] = diagonal;
+    const EntryIndex start = starts_[col];
+    const EntryIndex end = starts_[col + 1];
+    for (EntryIndex i = start; i < end; ++i) {
+      values_[i] = work_[rows_[i]] / diagonal;
+      work_[rows_[i]] = 0.0;
+    }
+    if (start < end) {
+      first_[col] = start;
+      link_next_[col] = link_head_[rows_[start]];
+      link_head_[rows_[start]] = col;
+    }
+  }
+}
+
+void SparseCholeskyFactorization::Solve(DenseColumn* x) const {
+  RETURN_IF_NULL(x);
+  DenseColumn& y = solve_scratchpad_;
+  y.resize(num_rows_, 0.0);
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    y[row_perm_[row]] = (*x)[row];
+  }
+
+  // Solves L.z = y.
+  for (RowIndex col(0); col < num_rows_; ++col) {
+    const Fractional value = y[col] / diagonal_[col];
+    y[col] = value;
+    if (value == 0.0) continue;
+    for (EntryIndex i = starts_[col]; i < starts_[col + 1]; ++i) {
+      y[rows_[i]] -= values_[i] * value;
+    }
+  }
+
+  // Solves L^T.t = z.
+  for (RowIndex col(num_rows_ - 1); col >= 0; --col) {
+    Fractional sum = y[col];
+    for (EntryIndex i = starts_[col]; i < starts_[col + 1]; ++i) {
+      sum -= values_[i] * y[rows_[i]];
+    }
+    y[col] = sum / diagonal_[col];
+  }
+  num_operations_ += 2 * rows_.size().value() + 2 * num_rows_.value();
+
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    (*x)[row] = y[row_perm_[row]];
+  }
+}
+
+// --------------------------------------------------------
+// InteriorPointSolver
+// --------------------------------------------------------
+
+InteriorPointSolver::InteriorPointSolver()
+    : num_rows_(0),
+      num_cols_(0),
+      first_slack_col_(0),
+      num_finite_bounds_(0),
+      problem_status_(ProblemStatus::INIT),
+      num_iterations_(0) {}
+
+Status InteriorPointSolver::Solve(const LinearProgram& lp) {
+  TimeLimit time_limit(parameters_.max_time_in_seconds());
+  WallTimer timer;
+  timer.Start();
+  problem_status_ = ProblemStatus::INIT;
+  num_iterations_ = 0;
+
+  InitializeProblem(lp);
+  cholesky_.ComputeOrderingAndPattern(matrix_, transposed_matrix_);
+  IF_STATS_ENABLED(stats_.cholesky_density.Add(
+      num_rows_ == 0 ? 0.0
+                     : 2.0 * cholesky_.NumberOfEntries().value() /
+                           (static_cast<double>(num_rows_.value()) *
+                            num_rows_.value())));
+  VLOG(1) << "Interior point: " << num_rows_ << " rows, " << first_slack_col_
+          << " columns, " << cholesky_.NumberOfEntries()
+          << " entries in the Cholesky factor (" << timer.Get() << "s).";
+  InitializeStartingPoint();
+
+  const Fractional tolerance = parameters_.interior_point_tolerance();
+  const int max_iterations = parameters_.interior_point_max_iterations();
+  while (true) {
+    if (ComputeResidualsAndTestOptimality(tolerance)) {
+      problem_status_ = ProblemStatus::OPTIMAL;
+      break;
+    }
+    if (num_iterations_ >= max_iterations || time_limit.LimitReached()) {
+      problem_status_ = ProblemStatus::IMPRECISE;
+      break;
+    }
+    ++num_iterations_;
+
+    // Factorizes the normal equations for the current point.
+    for (ColIndex col(0); col < num_cols_; ++col) {
+      if (is_fixed_[col]) {
+        weights_[col] = 0.0;
+        continue;
+      }
+      Fractional diagonal = kPrimalRegularization;
+      if (HasLowerBound(col)) {
+        diagonal += lower_dual_[col] / (x_[col] - lower_bound_[col]);
+      }
+      if (HasUpperBound(col)) {
+        diagonal += upper_dual_[col] / (upper_bound_[col] - x_[col]);
+      }
+      weights_[col] = 1.0 / diagonal;
+    }
+    cholesky_.Factorize(matrix_, transposed_matrix_, weights_,
+                        kDualRegularization);
+    IF_STATS_ENABLED(
+        stats_.replaced_pivots.Add(cholesky_.NumberOfReplacedPivots()));
+
+    // Predictor (or affine scaling) direction, it targets mu = 0.
+    const Fractional mu = ComputeComplementarity();
+    for (ColIndex col(0); col < num_cols_; ++col) {
+      lower_rhs_[col] = HasLowerBound(col)
+                            ? -(x_[col] - lower_bound_[col]) * lower_dual_[col]
+                            : 0.0;
+      upper_rhs_[col] = HasUpperBound(col)
+                            ? -(upper_bound_[col] - x_[col]) * upper_dual_[col]
+                            : 0.0;
+    }
+    ComputeNewtonDirection(lower_rhs_, upper_rhs_);
+    Fractional primal_step;
+    Fractional dual_step;
+    ComputeMaxSteps(&primal_step, &dual_step);
+
+    // Mehrotra's heuristic for the centering parameter, using the
+    // complementarity that the predictor direction would reach.
+    Fractional affine_complementarity = 0.0;
+    for (ColIndex col(0); col < num_cols_; ++col) {
+      if (HasLowerBound(col)) {
+        affine_complementarity +=
+            (x_[col] + primal_step * dx_[col] - lower_bound_[col]) *
+            (lower_dual_[col] + dual_step * lower_dual_direction_[col]);
+      }
+      if (HasUpperBound(col)) {
+        affine_complementarity +=
+            (upper_bound_[col] - x_[col] - primal_step * dx_[col]) *
+            (upper_dual_[col] + dual_step * upper_dual_direction_[col]);
+      }
+    }
+    const Fractional affine_mu =
+        num_finite_bounds_ == 0 ? 0.0
+                                : affine_complementarity / num_finite_bounds_;
+    const Fractional ratio = mu > 0.0 ? std::min(1.0, affine_mu / mu) : 0.0;
+    const Fractional sigma = ratio * ratio * ratio;
+    IF_STATS_ENABLED(stats_.centering.Add(sigma));
+
+    // Corrector direction with the second order terms of the predictor.
+    for (ColIndex col(0); col < num_cols_; ++col) {
+      if (HasLowerBound(col)) {
+        lower_rhs_[col] += sigma * mu - dx_[col] * lower_dual_direction_[col];
+      }
+      if (HasUpperBound(col)) {
+        upper_rhs_[col] += sigma * mu + dx_[col] * upper_dual_direction_[col];
+      }
+    }
+    ComputeNewtonDirection(lower_rhs_, upper_rhs_);
+    ComputeMaxSteps(&primal_step, &dual_step);
+    primal_step *= kStepFactor;
+    dual_step *= kStepFactor;
+    IF_STATS_ENABLED({
+      stats_.primal_step.Add(primal_step);
+      stats_.dual_step.Add(dual_step);
+    });
+
+    if (!IsFinite(mu) || !IsFinite(primal_step) || !IsFinite(dual_step)) {
+      problem_status_ = ProblemStatus::ABNORMAL;
+      return Status(Status::ERROR_LU, "Numerical error in the interior point.");
+    }
+
+    // Moves to the new point.
+    Fractional max_magnitude = 0.0;
+    bool is_interior = true;
+    for (ColIndex col(0); col < num_cols_; ++col) {
+      if (is_fixed_[col]) continue;
+      x_[col] += primal_step * dx_[col];
+      lower_dual_[col] += dual_step * lower_dual_direction_[col];
+      upper_dual_[col] += dual_step * upper_dual_direction_[col];
+      max_magnitude = std::max(max_magnitude, fabs(x_[col]));
+      max_magnitude = std::max(
+          max_magnitude, std::max(lower_dual_[col], upper_dual_[col]));
+      if (HasLowerBound(col) &&
+          (x_[col] <= lower_bound_[col] || lower_dual_[col] <= 0.0)) {
+        is_interior = false;
+      }
+      if (HasUpperBound(col) &&
+          (x_[col] >= upper_bound_[col] || upper_dual_[col] <= 0.0)) {
+        is_interior = false;
+      }
+    }
+    AddMultiple(dual_step, dy_, &y_);
+    max_magnitude = std::max(max_magnitude, InfinityNorm(y_));
+    if (!is_interior || max_magnitude > kMaxIterateMagnitude) {
+      VLOG(1) << "The interior point iterates diverge, the problem is probably "
+                 "infeasible or unbounded.";
+      problem_status_ = ProblemStatus::IMPRECISE;
+      break;
+    }
+    VLOG(2) << StringPrintf(
+        "Interior point iteration %d: mu = %g, steps = %g %g, sigma = %g",
+        num_iterations_, mu, primal_step, dual_step, sigma);
+  }
+  VLOG(1) << "Interior point status: "
+          << GetProblemStatusString(problem_status_) << ", " << num_iterations_
+          << " iterations, " << timer.Get() << "s.";
+  return Status::OK;
+}
+
+void InteriorPointSolver::InitializeProblem(const LinearProgram& lp) {
+  num_rows_ = lp.num_constraints();
+  first_slack_col_ = lp.num_variables();
+  num_cols_ = first_slack_col_ + RowToColIndex(num_rows_);
+
+  SparseMatrix identity_matrix;
+  identity_matrix.PopulateFromIdentity(RowToColIndex(num_rows_));
+  MatrixView matrix_with_slack;
+  matrix_with_slack.PopulateFromMatrixPair(lp.GetSparseMatrix(),
+                                           identity_matrix);
+  matrix_.PopulateFromMatrixView(matrix_with_slack);
+  transposed_matrix_.PopulateFromTranspose(matrix_);
+
+  objective_.assign(num_cols_, 0.0);
+  lower_bound_.resize(num_cols_, 0.0);
+  upper_bound_.resize(num_cols_, 0.0);
+  for (ColIndex col(0); col < first_slack_col_; ++col) {
+    objective_[col] = lp.GetObjectiveCoefficientForMinimizationVersion(col);
+    lower_bound_[col] = lp.variable_lower_bounds()[col];
+    upper_bound_[col] = lp.variable_upper_bounds()[col];
+  }
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    const ColIndex col = first_slack_col_ + RowToColIndex(row);
+    lower_bound_[col] = -lp.constraint_upper_bounds()[row];
+    upper_bound_[col] = -lp.constraint_lower_bounds()[row];
+  }
+  is_fixed_.assign(num_cols_, false);
+  num_finite_bounds_ = 0;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    is_fixed_[col] = lower_bound_[col] == upper_bound_[col];
+    if (HasLowerBound(col)) ++num_finite_bounds_;
+    if (HasUpperBound(col)) ++num_finite_bounds_;
+  }
+
+  x_.assign(num_cols_, 0.0);
+  y_.assign(num_rows_, 0.0);
+  lower_dual_.assign(num_cols_, 0.0);
+  upper_dual_.assign(num_cols_, 0.0);
+  primal_residual_.assign(num_rows_, 0.0);
+  dual_residual_.assign(num_cols_, 0.0);
+  weights_.assign(num_cols_, 0.0);
+  dx_.assign(num_cols_, 0.0);
+  dy_.assign(num_rows_, 0.0);
+  lower_dual_direction_.assign(num_cols_, 0.0);
+  upper_dual_direction_.assign(num_cols_, 0.0);
+  lower_rhs_.assign(num_cols_, 0.0);
+  upper_rhs_.assign(num_cols_, 0.0);
+  reduced_rhs_.assign(num_cols_, 0.0);
+}
+
+// The primal values start at zero moved at least at a distance of 1.0 from
+// their bounds (or at the middle of their range if it is smaller than 2.0),
+// and the bound duals at 1.0 plus the cost magnitude in the direction that
+// reduces the dual residual. This is simpler than Mehrotra's least-square
+// starting point but works well on scaled problems.
+void InteriorPointSolver::InitializeStartingPoint() {
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    const Fractional lower = lower_bound_[col];
+    const Fractional upper = upper_bound_[col];
+    if (is_fixed_[col]) {
+      x_[col] = lower;
+      continue;
+    }
+    const Fractional distance = std::min(1.0, (upper - lower) / 2.0);
+    x_[col] = std::min(std::max(0.0, lower + distance), upper - distance);
+    const Fractional cost = objective_[col];
+    if (HasLowerBound(col)) lower_dual_[col] = 1.0 + std::max(0.0, cost);
+    if (HasUpperBound(col)) upper_dual_[col] = 1.0 + std::max(0.0, -cost);
+  }
+}
+
+bool InteriorPointSolver::ComputeResidualsAndTestOptimality(
+    Fractional tolerance) {
+  // Primal residual 0 - A.x and its norm.
+  primal_residual_.assign(num_rows_, 0.0);
+  Fractional max_primal_value = 0.0;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    matrix_.ColumnAddMultipleToDenseColumn(col, -x_[col], &primal_residual_);
+    max_primal_value = std::max(max_primal_value, fabs(x_[col]));
+  }
+  Fractional max_primal_residual = 0.0;
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    max_primal_residual =
+        std::max(max_primal_residual, fabs(primal_residual_[row]));
+  }
+
+  // Dual residual and the primal and dual objectives.
+  Fractional max_dual_residual = 0.0;
+  Fractional max_cost = 0.0;
+  Fractional primal_objective = 0.0;
+  Fractional dual_objective = 0.0;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    const Fractional reduced_cost =
+        objective_[col] - matrix_.ColumnScalarProduct(col, Transpose(y_));
+    primal_objective += objective_[col] * x_[col];
+    max_cost = std::max(max_cost, fabs(objective_[col]));
+    if (is_fixed_[col]) {
+      dual_residual_[col] = 0.0;
+      dual_objective += reduced_cost * x_[col];
+      continue;
+    }
+    dual_residual_[col] = reduced_cost - lower_dual_[col] + upper_dual_[col];
+    max_dual_residual = std::max(max_dual_residual, fabs(dual_residual_[col]));
+    if (HasLowerBound(col)) {
+      dual_objective += lower_bound_[col] * lower_dual_[col];
+    }
+    if (HasUpperBound(col)) {
+      dual_objective -= upper_bound_[col] * upper_dual_[col];
+    }
+  }
+  VLOG(2) << StringPrintf(
+      "Interior point residuals: primal = %g, dual = %g, objectives = %.12g "
+      "%.12g",
+      max_primal_residual, max_dual_residual, primal_objective,
+      dual_objective);
+  return max_primal_residual <= tolerance * (1.0 + max_primal_value) &&
+         max_dual_residual <= tolerance * (1.0 + max_cost) &&
+         fabs(primal_objective - dual_objective) <=
+             tolerance * (1.0 + fabs(primal_objective));
+}
+
+Fractional InteriorPointSolver::ComputeComplementarity() const {
+  if (num_finite_bounds_ == 0) return 0.0;
+  Fractional sum = 0.0;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    if (HasLowerBound(col)) {
+      sum += (x_[col] - lower_bound_[col]) * lower_dual_[col];
+    }
+    if (HasUpperBound(col)) {
+      sum += (upper_bound_[col] - x_[col]) * upper_dual_[col];
+    }
+  }
+  return sum / num_finite_bounds_;
+}
+
+// With sl = x - l and su = u - x, the Newton system is:
+//   A.dx = rp
+//   A^T.dy + dzl - dzu = rd
+//   zl.dx + sl.dzl = lower_rhs
+//   -zu.dx + su.dzu = upper_rhs
+// Eliminating dzl and dzu gives A^T.dy - D.dx = rd - lower_rhs / sl +
+// upper_rhs / su = r with D = zl / sl + zu / su = 1 / W, and so
+// dx = W.(A^T.dy - r) and A.W.A^T.dy = rp + A.W.r.
+void InteriorPointSolver::ComputeNewtonDirection(const DenseRow& lower_rhs,
+                                                 const DenseRow& upper_rhs) {
+  dy_ = primal_residual_;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    if (is_fixed_[col]) continue;
+    Fractional rhs = dual_residual_[col];
+    if (HasLowerBound(col)) {
+      rhs -= lower_rhs[col] / (x_[col] - lower_bound_[col]);
+    }
+    if (HasUpperBound(col)) {
+      rhs += upper_rhs[col] / (upper_bound_[col] - x_[col]);
+    }
+    reduced_rhs_[col] = rhs;
+    matrix_.ColumnAddMultipleToDenseColumn(col, weights_[col] * rhs, &dy_);
+  }
+  cholesky_.Solve(&dy_);
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    if (is_fixed_[col]) {
+      dx_[col] = 0.0;
+      continue;
+    }
+    dx_[col] = weights_[col] *
+               (matrix_.ColumnScalarProduct(col, Transpose(dy_)) -
+                reduced_rhs_[col]);
+    lower_dual_direction_[col] =
+        HasLowerBound(col) ? (lower_rhs[col] - lower_dual_[col] * dx_[col]) /
+                                 (x_[col] - lower_bound_[col])
+                           : 0.0;
+    upper_dual_direction_[col] =
+        HasUpperBound(col) ? (upper_rhs[col] + upper_dual_[col] * dx_[col]) /
+                                 (upper_bound_[col] - x_[col])
+                           : 0.0;
+  }
+}
+
+void InteriorPointSolver::ComputeMaxSteps(Fractional* primal_step,
+                                          Fractional* dual_step) const {
+  Fractional max_primal_step = 1.0;
+  Fractional max_dual_step = 1.0;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    if (HasLowerBound(col)) {
+      if (dx_[col] < 0.0) {
+        max_primal_step = std::min(max_primal_step,
+                                   (lower_bound_[col] - x_[col]) / dx_[col]);
+      }
+      if (lower_dual_direction_[col] < 0.0) {
+        max_dual_step = std::min(
+            max_dual_step, -lower_dual_[col] / lower_dual_direction_[col]);
+      }
+    }
+    if (HasUpperBound(col)) {
+      if (dx_[col] > 0.0) {
+        max_primal_step = std::min(max_primal_step,
+                                   (upper_bound_[col] - x_[col]) / dx_[col]);
+      }
+      if (upper_dual_direction_[col] < 0.0) {
+        max_dual_step = std::min(
+            max_dual_step, -upper_dual_[col] / upper_dual_direction_[col]);
+      }
+    }
+  }
+  *primal_step = max_primal_step;
+  *dual_step = max_dual_step;
+}
+
+void InteriorPointSolver::ComputeCrossoverState(BasisState* state) const {
+  RETURN_IF_NULL(state);
+  state->num_rows = num_rows_;
+  state->num_cols = first_slack_col_;
+  state->statuses.assign(num_cols_, VariableStatus::FREE);
+
+  // Note that x / z is large for a basic variable and goes to zero for a
+  // non-basic one as mu goes to zero.
+  const Fractional threshold =
+      parameters_.interior_point_crossover_ratio_threshold();
+  std::vector<std::pair<Fractional, ColIndex>> candidates;
+  for (ColIndex col(0); col < num_cols_; ++col) {
+    if (is_fixed_[col]) {
+      state->statuses[col] = VariableStatus::FIXED_VALUE;
+      continue;
+    }
+    Fractional lower_ratio = kInfinity;
+    Fractional upper_ratio = kInfinity;
+    if (HasLowerBound(col)) {
+      lower_ratio = (x_[col] - lower_bound_[col]) / lower_dual_[col];
+    }
+    if (HasUpperBound(col)) {
+      upper_ratio = (upper_bound_[col] - x_[col]) / upper_dual_[col];
+    }
+    if (lower_ratio <= upper_ratio) {
+      state->statuses[col] = lower_ratio == kInfinity
+                                 ? VariableStatus::FREE
+                                 : VariableStatus::AT_LOWER_BOUND;
+    } else {
+      state->statuses[col] = VariableStatus::AT_UPPER_BOUND;
+    }
+    const Fractional ratio = std::min(lower_ratio, upper_ratio);
+    if (ratio > threshold) {
+      candidates.push_back(std::make_pair(-ratio, col));
+    }
+  }
+
+  // Keeps at most num_rows_ basic variables, the most interior first.
+  std::sort(candidates.begin(), candidates.end());
+  const int num_basic =
+      std::min<int>(candidates.size(), num_rows_.value());
+  for (int i = 0; i < num_basic; ++i) {
+    state->statuses[candidates[i].second] = VariableStatus::BASIC;
+  }
+}
+
+double InteriorPointSolver::DeterministicTime() const {
+  return DeterministicTimeForFpOperations(cholesky_.NumberOfOperations());
+}
+
+}  // namespace glop
+}  // namespace operations_research
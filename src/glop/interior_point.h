@@ -0,0 +1,287 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Solves a Linear Programming problem with a primal-dual interior-point method
+// (also known as a barrier method) and computes a starting basis for the
+// revised simplex from the interior solution. This last step is known as
+// crossover and is needed because the rest of the solver (postsolve, solution
+// checks) works with basic solutions.
+//
+// The linear program is handled in the same form as in the revised simplex:
+// min c.x subject to A.x + s = 0, l <= x <= u, and the slack variables s are
+// bounded by the opposite of the constraint bounds. Each variable with a
+// finite lower (resp. upper) bound gets a non-negative dual variable zl
+// (resp. zu) and the algorithm follows the central path:
+//   A.x + s = 0,
+//   c - A^T.y - zl + zu = 0,
+//   (x - l).zl = mu, (u - x).zu = mu for mu going to zero.
+// Fixed variables are kept at their value and free variables get a small
+// primal regularization.
+//
+// Each iteration solves the Newton system of the path equations by a Cholesky
+// factorization of the normal equations matrix A.W.A^T where W is a positive
+// diagonal matrix that changes at each iteration. The non-zero pattern of the
+// factor does not depend on W, so a fill-reducing ordering and the factor
+// pattern are only computed once.
+//
+// References:
+//
+// Sanjay Mehrotra, "On the Implementation of a Primal-Dual Interior Point
+// Method", SIAM Journal on Optimization, Vol. 2, No. 4, pp. 575-601, 1992.
+// http://epubs.siam.org/doi/abs/10.1137/0802028
+//
+// Stephen J. Wright, "Primal-Dual Interior-Point Methods", SIAM, 1997,
+// ISBN 978-0898713824.
+//
+// Erling D. Andersen, Yinyu Ye, "Combining Interior-Point and Pivoting
+// Algorithms for Linear Programming", Management Science, Vol. 42, No. 12,
+// pp. 1719-1731, 1996.
+
+#ifndef OR_TOOLS_GLOP_INTERIOR_POINT_H_
+#define OR_TOOLS_GLOP_INTERIOR_POINT_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "glop/parameters.pb.h"
+#include "glop/revised_simplex.h"
+#include "glop/status.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/permutation.h"
+#include "lp_data/sparse.h"
+#include "util/stats.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+namespace glop {
+
+// Cholesky factorization L.L^T = P.(A.W.A^T + r.I).P^T of the normal equations
+// matrix, where W is a diagonal matrix of non-negative column weights and r a
+// small regularization. The permutation P is a minimum degree ordering of the
+// non-zero pattern of A.A^T.
+//
+// Note that A.W.A^T is never computed explicitly: each column of it is
+// scattered from the rows of A just before being factorized (left-looking
+// algorithm).
+//
+// TODO(user): Dense columns of A make A.A^T dense. They should be removed from
+// the normal equations and handled with a low-rank correction.
+class SparseCholeskyFactorization {
+ public:
+  SparseCholeskyFactorization();
+
+  // Computes the ordering P and the non-zero pattern of L. The transpose of A
+  // (i.e. its rows) must also be given. This only depends on the non-zero
+  // pattern of A, so it just needs to be called once before a sequence of
+  // Factorize() with the same matrix.
+  void ComputeOrderingAndPattern(const CompactSparseMatrix& matrix,
+                                 const CompactSparseMatrix& transpose);
+
+  // Computes the numerical values of L for the given weights. Pivots that
+  // are too small (the matrix is singular or nearly singular) are replaced by
+  // a huge value, which is the same as fixing the corresponding component of
+  // the solution to zero.
+  void Factorize(const CompactSparseMatrix& matrix,
+                 const CompactSparseMatrix& transpose, const DenseRow& weights,
+                 Fractional regularization);
+
+  // Solves (A.W.A^T + r.I).x = b. The given column contains b initially and x
+  // on return.
+  void Solve(DenseColumn* x) const;
+
+  // Returns the number of entries in L (without the diagonal).
+  EntryIndex NumberOfEntries() const { return EntryIndex(rows_.size()); }
+
+  // Returns the number of pivots replaced during the last Factorize().
+  int NumberOfReplacedPivots() const { return num_replaced_pivots_; }
+
+  // Returns the number of floating-point operations since the creation of this
+  // class. This is used to compute the deterministic time.
+  int64 NumberOfOperations() const { return num_operations_; }
+
+ private:
+  RowIndex num_rows_;
+
+  // Permutation from the rows of A to the rows of L and its inverse.
+  RowPermutation row_perm_;
+  RowPermutation inverse_row_perm_;
+
+  // The strictly lower part of L stored by columns. The rows of a column are
+  // sorted in increasing order.
+  StrictITIVector<RowIndex, EntryIndex> starts_;
+  StrictITIVector<EntryIndex, RowIndex> rows_;
+  StrictITIVector<EntryIndex, Fractional> values_;
+  DenseColumn diagonal_;
+
+  // Work data for Factorize(). For the column being factorized, first_[col] is
+  // the position of its next entry to use, and the columns that will update
+  // the same column next are chained through link_head_/link_next_.
+  DenseColumn work_;
+  StrictITIVector<RowIndex, EntryIndex> first_;
+  RowMapping link_head_;
+  RowMapping link_next_;
+  mutable DenseColumn solve_scratchpad_;
+
+  int num_replaced_pivots_;
+  mutable int64 num_operations_;
+
+  DISALLOW_COPY_AND_ASSIGN(SparseCholeskyFactorization);
+};
+
+// Entry point of the interior-point algorithm implementation.
+class InteriorPointSolver {
+ public:
+  InteriorPointSolver();
+
+  // Sets or gets the algorithm parameters to be used on the next Solve().
+  void SetParameters(const GlopParameters& parameters) {
+    parameters_ = parameters;
+  }
+  const GlopParameters& GetParameters() const { return parameters_; }
+
+  // Solves the given linear program. An error is only returned in case of
+  // numerical problems, the result is otherwise given by GetProblemStatus():
+  // - OPTIMAL if the interior solution is optimal within the
+  //   interior_point_tolerance from the parameters.
+  // - IMPRECISE if no solution was found within the iteration or time limits,
+  //   or if the iterates diverge. This is what happens on infeasible or
+  //   unbounded problems since this implementation does not try to detect them.
+  Status Solve(const LinearProgram& lp) MUST_USE_RESULT;
+
+  // Getters to retrieve all the information computed by the last Solve().
+  // Note that the primal values and the reduced costs correspond to the columns
+  // of the given problem. All these values are for the minimization version of
+  // the problem.
+  ProblemStatus GetProblemStatus() const { return problem_status_; }
+  int GetNumberOfIterations() const { return num_iterations_; }
+  Fractional GetVariableValue(ColIndex col) const { return x_[col]; }
+  Fractional GetReducedCost(ColIndex col) const {
+    return lower_dual_[col] - upper_dual_[col];
+  }
+  Fractional GetDualValue(RowIndex row) const { return y_[row]; }
+
+  // Computes a starting basis for the revised simplex from the last interior
+  // solution (see RevisedSimplex::LoadStateForNextSolve()). The variables
+  // (including the slacks) whose distance to one of their bounds is not greater
+  // than interior_point_crossover_ratio_threshold times their associated dual
+  // value are non-basic at this bound. The other ones are basic, the farthest
+  // from their bounds first. The returned basis may be incomplete or singular,
+  // it is up to the simplex to complete it.
+  void ComputeCrossoverState(BasisState* state) const;
+
+  // Returns the deterministic time used by the last Solve().
+  double DeterministicTime() const;
+
+  // Returns statistics about this class as a std::string.
+  std::string StatString() const { return stats_.StatString(); }
+
+ private:
+  // Fills the matrix and bound data from the given linear program.
+  void InitializeProblem(const LinearProgram& lp);
+
+  // Computes the starting point of the algorithm.
+  void InitializeStartingPoint();
+
+  // Computes the primal residual -A.x, the dual residual and returns true if
+  // the current point is optimal within the given tolerance.
+  bool ComputeResidualsAndTestOptimality(Fractional tolerance);
+
+  // Returns the average complementarity product of the current point, i.e. the
+  // current value of mu.
+  Fractional ComputeComplementarity() const;
+
+  // Solves the Newton system whose right hand sides are the primal and dual
+  // residuals and the given lower/upper complementarity residuals. The
+  // normal equations matrix must already be factorized.
+  void ComputeNewtonDirection(const DenseRow& lower_rhs,
+                              const DenseRow& upper_rhs);
+
+  // Returns the maximum primal and dual steps in [0, 1] that keep the current
+  // point interior when following the current direction.
+  void ComputeMaxSteps(Fractional* primal_step, Fractional* dual_step) const;
+
+  // Returns true if the given column has a finite lower or upper bound and
+  // is not fixed.
+  bool HasLowerBound(ColIndex col) const {
+    return lower_bound_[col] != -kInfinity && !is_fixed_[col];
+  }
+  bool HasUpperBound(ColIndex col) const {
+    return upper_bound_[col] != kInfinity && !is_fixed_[col];
+  }
+
+  // Problem data. The matrix contains the columns of A followed by the columns
+  // of the identity matrix for the slack variables.
+  RowIndex num_rows_;
+  ColIndex num_cols_;
+  ColIndex first_slack_col_;
+  CompactSparseMatrix matrix_;
+  CompactSparseMatrix transposed_matrix_;
+  DenseRow objective_;
+  DenseRow lower_bound_;
+  DenseRow upper_bound_;
+  DenseBooleanRow is_fixed_;
+  int num_finite_bounds_;
+
+  // Current point and residuals.
+  DenseRow x_;
+  DenseColumn y_;
+  DenseRow lower_dual_;
+  DenseRow upper_dual_;
+  DenseColumn primal_residual_;
+  DenseRow dual_residual_;
+
+  // Diagonal weights of the normal equations and their factorization.
+  DenseRow weights_;
+  SparseCholeskyFactorization cholesky_;
+
+  // Current Newton direction and the right hand sides used to compute it.
+  DenseRow dx_;
+  DenseColumn dy_;
+  DenseRow lower_dual_direction_;
+  DenseRow upper_dual_direction_;
+  DenseRow lower_rhs_;
+  DenseRow upper_rhs_;
+  DenseRow reduced_rhs_;
+
+  ProblemStatus problem_status_;
+  int num_iterations_;
+
+  struct Stats : public StatsGroup {
+    Stats()
+        : StatsGroup("InteriorPointSolver"),
+          cholesky_density("cholesky_density", this),
+          primal_step("primal_step", this),
+          dual_step("dual_step", this),
+          centering("centering", this),
+          replaced_pivots("replaced_pivots", this) {}
+    RatioDistribution cholesky_density;
+    DoubleDistribution primal_step;
+    DoubleDistribution dual_step;
+    DoubleDistribution centering;
+    IntegerDistribution replaced_pivots;
+  };
+  Stats stats_;
+
+  GlopParameters parameters_;
+
+  DISALLOW_COPY_AND_ASSIGN(InteriorPointSolver);
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_INTERIOR_POINT_H_
@@ -14,6 +14,7 @@
 
 #include "glop/lp_solver.h"
 
+#include <algorithm>
 #include <stack>
 #include <vector>
 
@@ -23,9 +24,11 @@
 
 #include "base/join.h"
 #include "base/strutil.h"
+#include "base/threadpool.h"
 #include "glop/preprocessor.h"
 #include "glop/proto_utils.h"
 #include "glop/status.h"
+#include "lp_data/lp_decomposer.h"
 #include "lp_data/lp_types.h"
 #include "lp_data/lp_utils.h"
 #include "util/fp_utils.h"
@@ -83,13 +86,82 @@ void DumpLinearProgramIfRequiredByFlags(const LinearProgram& linear_program,
   }
 }
 
+// Copies the solution found by the given revised simplex, which must have
+// successfully solved a problem of the same dimension as the given solution.
+void ExtractRevisedSimplexSolution(const RevisedSimplex& revised_simplex,
+                                   ProblemSolution* solution) {
+  solution->status = revised_simplex.GetProblemStatus();
+
+  const ColIndex num_cols = revised_simplex.GetProblemNumCols();
+  DCHECK_EQ(solution->primal_values.size(), num_cols);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    solution->primal_values[col] = revised_simplex.GetVariableValue(col);
+    solution->variable_statuses[col] = revised_simplex.GetVariableStatus(col);
+  }
+
+  const RowIndex num_rows = revised_simplex.GetProblemNumRows();
+  DCHECK_EQ(solution->dual_values.size(), num_rows);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    solution->dual_values[row] = revised_simplex.GetDualValue(row);
+    solution->constraint_statuses[row] =
+        revised_simplex.GetConstraintStatus(row);
+  }
+}
+
+// The result of the revised simplex on one of the independent blocks of a
+// problem, see LPSolver::SolveIndependentBlocksIfDecomposable().
+struct BlockResult {
+  BlockResult()
+      : solution(RowIndex(0), ColIndex(0)),
+        num_iterations(0),
+        deterministic_time(0.0) {}
+  ProblemSolution solution;
+  int num_iterations;
+  double deterministic_time;
+};
+
+// Builds the problem_index^th problem of the given decomposer and solves it
+// with a new revised simplex. This is called concurrently for different
+// problems, so it only uses the thread-safe functions of the decomposer and
+// the const functions of the time limit. The time limit is shared by all the
+// blocks: each block only gets the time left when it starts.
+void SolveBlock(const GlopParameters& parameters, const TimeLimit* time_limit,
+                int problem_index, LPDecomposer* decomposer,
+                BlockResult* result) {
+  CHECK(time_limit != nullptr);
+  CHECK(decomposer != nullptr);
+  CHECK(result != nullptr);
+  LinearProgram block;
+  decomposer->BuildProblem(problem_index, &block);
+
+  // The constraints are not created in increasing order by BuildProblem().
+  block.CleanUp();
+
+  GlopParameters block_parameters = parameters;
+  block_parameters.set_max_time_in_seconds(time_limit->GetTimeLeft());
+  RevisedSimplex revised_simplex;
+  revised_simplex.SetParameters(block_parameters);
+  result->solution =
+      ProblemSolution(block.num_constraints(), block.num_variables());
+  if (revised_simplex.Solve(block).ok()) {
+    ExtractRevisedSimplexSolution(revised_simplex, &result->solution);
+  } else {
+    result->solution.status = ProblemStatus::ABNORMAL;
+  }
+  result->num_iterations = revised_simplex.GetNumberOfIterations();
+  result->deterministic_time = revised_simplex.DeterministicTime();
+}
+
 }  // anonymous namespace
 
 // --------------------------------------------------------
 // LPSolver
 // --------------------------------------------------------
 
-LPSolver::LPSolver() : num_solves_(0) {}
+LPSolver::LPSolver()
+    : num_interior_point_iterations_(0),
+      blocks_deterministic_time_(0.0),
+      num_solves_(0) {}
 
 void LPSolver::SetParameters(const GlopParameters& parameters) {
   parameters_ = parameters;
@@ -102,6 +174,8 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
 
   ++num_solves_;
   num_revised_simplex_iterations_ = 0;
+  num_interior_point_iterations_ = 0;
+  blocks_deterministic_time_ = 0.0;
   DumpLinearProgramIfRequiredByFlags(lp, num_solves_);
 
   // Check some preconditions.
@@ -139,8 +213,23 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
   initial_num_cols_ = lp.num_variables();
   current_linear_program_.PopulateFromLinearProgram(lp, /*keep_names=*/false);
 
+  // Look for the basis of a previously solved problem with the same matrix,
+  // unless the revised simplex can already warm-start from its last Solve().
+  uint64 fingerprint = 0;
+  cached_basis_ = BasisState();
+  if (parameters_.use_basis_cache()) {
+    if (basis_cache_ == nullptr) {
+      basis_cache_.reset(new BasisCache(parameters_.basis_cache_directory()));
+    }
+    fingerprint = BasisCache::ComputeFingerprint(lp);
+    if (revised_simplex_ == nullptr || revised_simplex_->GetState().IsEmpty()) {
+      basis_cache_->Lookup(fingerprint, &cached_basis_);
+    }
+  }
+
   // Preprocess.
   status_ = ProblemStatus::INIT;
+  preprocessor_stats_.clear();
   RunPreprocessors(time_limit);
 
   // At this point, we need to initialize a ProblemSolution with the correct
@@ -148,15 +237,21 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
   ProblemSolution solution(current_linear_program_.num_constraints(),
                            current_linear_program_.num_variables());
   solution.status = status_;
-  RunRevisedSimplexIfNeeded(&solution);
+  RunRevisedSimplexIfNeeded(time_limit, &solution);
   PostprocessSolution(&solution);
-  return LoadAndVerifySolution(lp, solution);
+  const ProblemStatus status = LoadAndVerifySolution(lp, solution);
+  if (parameters_.use_basis_cache() && status == ProblemStatus::OPTIMAL) {
+    StoreBasisInCache(fingerprint);
+  }
+  return status;
 }
 
 void LPSolver::Clear() {
   ResizeSolution(RowIndex(0), ColIndex(0));
   preprocessors_.clear();
+  preprocessor_stats_.clear();
   revised_simplex_.reset(nullptr);
+  interior_point_.reset(nullptr);
 }
 
 ProblemStatus LPSolver::LoadAndVerifySolution(const LinearProgram& lp,
@@ -329,9 +424,19 @@ int LPSolver::GetNumberOfSimplexIterations() const {
   return num_revised_simplex_iterations_;
 }
 
+int LPSolver::GetNumberOfInteriorPointIterations() const {
+  return num_interior_point_iterations_;
+}
+
 double LPSolver::DeterministicTime() const {
-  return revised_simplex_ == nullptr ? 0.0
-                                     : revised_simplex_->DeterministicTime();
+  double time = blocks_deterministic_time_;
+  if (revised_simplex_ != nullptr) {
+    time += revised_simplex_->DeterministicTime();
+  }
+  if (interior_point_ != nullptr) {
+    time += interior_point_->DeterministicTime();
+  }
+  return time;
 }
 
 void LPSolver::MovePrimalValuesWithinBounds(const LinearProgram& lp) {
@@ -381,7 +486,9 @@ void LPSolver::ResizeSolution(RowIndex num_rows, ColIndex num_cols) {
                        time_limit)
 
 void LPSolver::RunPreprocessors(const TimeLimit& time_limit) {
-  if (parameters_.use_preprocessing()) {
+  // A cached basis is given for the initial problem, so the preprocessors that
+  // remove rows or columns are not run when there is one.
+  if (parameters_.use_preprocessing() && cached_basis_.IsEmpty()) {
     RUN_PREPROCESSOR(ShiftVariableBoundsPreprocessor);
     RUN_PREPROCESSOR(RemoveNearZeroEntriesPreprocessor);
 
@@ -398,6 +505,10 @@ void LPSolver::RunPreprocessors(const TimeLimit& time_limit) {
       RUN_PREPROCESSOR(DoubletonEqualityRowPreprocessor);
       RUN_PREPROCESSOR(ImpliedFreePreprocessor);
       RUN_PREPROCESSOR(DoubletonFreeColumnPreprocessor);
+      if (parameters_.use_bound_propagation()) {
+        RUN_PREPROCESSOR(NearlyProportionalRowPreprocessor);
+        RUN_PREPROCESSOR(BoundPropagationPreprocessor);
+      }
 
       // Abort early if none of the preprocessors did something. Technically
       // this is true if none of the preprocessors above needs postsolving,
@@ -433,10 +544,24 @@ void LPSolver::RunPreprocessors(const TimeLimit& time_limit) {
   // use_preprocessing() parameter.
   RUN_PREPROCESSOR(SingletonColumnSignPreprocessor);
   RUN_PREPROCESSOR(ScalingPreprocessor);
+  VLOG(1) << GetPreprocessorStatString();
 }
 
 #undef RUN_PREPROCESSOR
 
+std::string LPSolver::GetPreprocessorStatString() const {
+  std::string result = StringPrintf(
+      "%-45s %5s %5s %10s %10s %10s %12s\n", "preprocessor", "runs",
+      "used", "time(s)", "-rows", "-cols", "-entries");
+  for (const PreprocessorStats& stats : preprocessor_stats_) {
+    StringAppendF(&result, "%-45s %5d %5d %10.4f %10lld %10lld %12lld\n",
+                  stats.name.c_str(), stats.num_runs, stats.num_reductions,
+                  stats.time_in_seconds, stats.num_removed_rows,
+                  stats.num_removed_cols, stats.num_removed_entries);
+  }
+  return result;
+}
+
 void LPSolver::RunAndPushIfRelevant(std::unique_ptr<Preprocessor> preprocessor,
                                     const std::string& name,
                                     const TimeLimit& time_limit) {
@@ -451,7 +576,33 @@ void LPSolver::RunAndPushIfRelevant(std::unique_ptr<Preprocessor> preprocessor,
     if (current_linear_program_.num_variables() == 0 &&
         current_linear_program_.num_constraints() == 0) {
       status_ = ProblemStatus::OPTIMAL;
-    } else if (preprocessor->Run(&current_linear_program_)) {
+      return;
+    }
+
+    // The stats are kept in the order in which the preprocessors are first
+    // run. There are only a few of them, so a linear search is fine.
+    PreprocessorStats* stats = nullptr;
+    for (PreprocessorStats& s : preprocessor_stats_) {
+      if (s.name == name) stats = &s;
+    }
+    if (stats == nullptr) {
+      preprocessor_stats_.push_back(PreprocessorStats(name));
+      stats = &preprocessor_stats_.back();
+    }
+    const RowIndex old_num_rows = current_linear_program_.num_constraints();
+    const ColIndex old_num_cols = current_linear_program_.num_variables();
+    const EntryIndex old_num_entries = current_linear_program_.num_entries();
+    const bool need_postsolve = preprocessor->Run(&current_linear_program_);
+    ++stats->num_runs;
+    stats->time_in_seconds += timer.Get();
+    stats->num_removed_rows +=
+        (old_num_rows - current_linear_program_.num_constraints()).value();
+    stats->num_removed_cols +=
+        (old_num_cols - current_linear_program_.num_variables()).value();
+    stats->num_removed_entries +=
+        (old_num_entries - current_linear_program_.num_entries()).value();
+    if (need_postsolve) {
+      ++stats->num_reductions;
       const EntryIndex new_num_entries = current_linear_program_.num_entries();
       VLOG(1) << StringPrintf(
           "%s(%fs): %d(%d) rows, %d(%d) columns, %lld(%lld) entries.",
@@ -478,7 +629,16 @@ void LPSolver::RunAndPushIfRelevant(std::unique_ptr<Preprocessor> preprocessor,
   }
 }
 
-void LPSolver::RunRevisedSimplexIfNeeded(ProblemSolution* solution) {
+void LPSolver::RunRevisedSimplexIfNeeded(const TimeLimit& time_limit,
+                                         ProblemSolution* solution) {
+  if (solution->status == ProblemStatus::INIT &&
+      parameters_.solve_independent_blocks() &&
+      !parameters_.use_interior_point() && cached_basis_.IsEmpty() &&
+      SolveIndependentBlocksIfDecomposable(time_limit, solution)) {
+    current_linear_program_.ClearTransposeMatrix();
+    return;
+  }
+
   // Note that the transpose matrix is no longer needed at this point.
   // This helps reduce the peak memory usage of the solver.
   current_linear_program_.ClearTransposeMatrix();
@@ -486,30 +646,168 @@ void LPSolver::RunRevisedSimplexIfNeeded(ProblemSolution* solution) {
   if (revised_simplex_ == nullptr) {
     revised_simplex_.reset(new RevisedSimplex());
   }
-  revised_simplex_->SetParameters(parameters_);
+  // The time spent on the independent blocks or on the interior point method
+  // is deducted from the time limit of the revised simplex.
+  GlopParameters simplex_parameters = parameters_;
+  if (!cached_basis_.IsEmpty()) {
+    // Only the preprocessors that do not change the problem dimensions were
+    // run, so the cached basis of the initial problem can be used as is. Like
+    // for the crossover below, only the primal simplex can start from it.
+    DCHECK_EQ(cached_basis_.num_rows, current_linear_program_.num_constraints());
+    DCHECK_EQ(cached_basis_.num_cols, current_linear_program_.num_variables());
+    revised_simplex_->LoadStateForNextSolve(cached_basis_);
+    simplex_parameters.set_use_dual_simplex(false);
+  } else if (parameters_.use_interior_point()) {
+    parameters_.set_max_time_in_seconds(time_limit.GetTimeLeft());
+    if (RunInteriorPointAndLoadCrossoverState()) {
+      simplex_parameters.set_use_dual_simplex(false);
+    }
+  }
+  simplex_parameters.set_max_time_in_seconds(time_limit.GetTimeLeft());
+  revised_simplex_->SetParameters(simplex_parameters);
   if (revised_simplex_->Solve(current_linear_program_).ok()) {
-    num_revised_simplex_iterations_ = revised_simplex_->GetNumberOfIterations();
-    solution->status = revised_simplex_->GetProblemStatus();
+    // Note that some iterations may already have been done on the independent
+    // blocks of the problem.
+    num_revised_simplex_iterations_ +=
+        revised_simplex_->GetNumberOfIterations();
+    ExtractRevisedSimplexSolution(*revised_simplex_, solution);
+  } else {
+    VLOG(1) << "Error during the revised simplex algorithm.";
+    solution->status = ProblemStatus::ABNORMAL;
+  }
+}
 
-    const ColIndex num_cols = revised_simplex_->GetProblemNumCols();
-    DCHECK_EQ(solution->primal_values.size(), num_cols);
-    for (ColIndex col(0); col < num_cols; ++col) {
-      solution->primal_values[col] = revised_simplex_->GetVariableValue(col);
-      solution->variable_statuses[col] =
-          revised_simplex_->GetVariableStatus(col);
+void LPSolver::StoreBasisInCache(uint64 fingerprint) {
+  DCHECK(basis_cache_ != nullptr);
+  BasisState state;
+  state.num_rows = constraint_statuses_.size();
+  state.num_cols = variable_statuses_.size();
+  state.statuses = variable_statuses_;
+  for (const ConstraintStatus status : constraint_statuses_) {
+    // The slack variable of a constraint has the opposite sign, see
+    // RevisedSimplex::GetConstraintStatus().
+    switch (status) {
+      case ConstraintStatus::AT_LOWER_BOUND:
+        state.statuses.push_back(VariableStatus::AT_UPPER_BOUND);
+        break;
+      case ConstraintStatus::AT_UPPER_BOUND:
+        state.statuses.push_back(VariableStatus::AT_LOWER_BOUND);
+        break;
+      case ConstraintStatus::FIXED_VALUE:
+        state.statuses.push_back(VariableStatus::FIXED_VALUE);
+        break;
+      case ConstraintStatus::FREE:
+        state.statuses.push_back(VariableStatus::FREE);
+        break;
+      case ConstraintStatus::BASIC:
+        state.statuses.push_back(VariableStatus::BASIC);
+        break;
     }
+  }
+  basis_cache_->Store(fingerprint, state, num_revised_simplex_iterations_);
+  VLOG(1) << basis_cache_->StatString();
+}
+
+bool LPSolver::SolveIndependentBlocksIfDecomposable(
+    const TimeLimit& time_limit, ProblemSolution* solution) {
+  const LinearProgram& lp = current_linear_program_;
+
+  // The empty constraints do not belong to any block. Their activity is zero,
+  // so if it is not within their bounds, we let the revised simplex report the
+  // infeasibility of the whole problem.
+  const SparseMatrix& transpose = lp.GetTransposeSparseMatrix();
+  const RowIndex num_rows = lp.num_constraints();
+  for (RowIndex row(0); row < num_rows; ++row) {
+    if (transpose.column(RowToColIndex(row)).IsEmpty() &&
+        (lp.constraint_lower_bounds()[row] > 0.0 ||
+         lp.constraint_upper_bounds()[row] < 0.0)) {
+      return false;
+    }
+  }
 
-    const RowIndex num_rows = revised_simplex_->GetProblemNumRows();
-    DCHECK_EQ(solution->dual_values.size(), num_rows);
-    for (RowIndex row(0); row < num_rows; ++row) {
-      solution->dual_values[row] = revised_simplex_->GetDualValue(row);
-      solution->constraint_statuses[row] =
-          revised_simplex_->GetConstraintStatus(row);
+  LPDecomposer decomposer;
+  decomposer.Decompose(&lp);
+  const int num_blocks = decomposer.GetNumberOfProblems();
+  if (num_blocks <= 1) return false;
+  const int num_threads =
+      std::max(1, std::min(parameters_.num_block_threads(), num_blocks));
+  VLOG(1) << "Solving " << num_blocks << " independent blocks with "
+          << num_threads << " threads.";
+
+  std::vector<BlockResult> results(num_blocks);
+  if (num_threads == 1) {
+    for (int i = 0; i < num_blocks; ++i) {
+      SolveBlock(parameters_, &time_limit, i, &decomposer, &results[i]);
     }
   } else {
-    VLOG(1) << "Error during the revised simplex algorithm.";
-    solution->status = ProblemStatus::ABNORMAL;
+    // The pool destructor waits for all the blocks to be solved.
+    ThreadPool pool("LPSolver_Blocks", num_threads);
+    for (int i = 0; i < num_blocks; ++i) {
+      pool.Add(NewCallback(&SolveBlock, parameters_, &time_limit, i,
+                           &decomposer, &results[i]));
+    }
+    pool.StartWorkers();
+  }
+
+  bool all_optimal = true;
+  for (int i = 0; i < num_blocks; ++i) {
+    num_revised_simplex_iterations_ += results[i].num_iterations;
+    blocks_deterministic_time_ += results[i].deterministic_time;
+    if (results[i].solution.status != ProblemStatus::OPTIMAL) {
+      VLOG(1) << "Block " << i << " status is "
+              << GetProblemStatusString(results[i].solution.status)
+              << ", solving the problem as a whole.";
+      all_optimal = false;
+    }
   }
+  if (!all_optimal) return false;
+
+  // Merge the block solutions. The union of the block bases is a basis of the
+  // whole problem once the slacks of the empty constraints are added to it.
+  for (RowIndex row(0); row < num_rows; ++row) {
+    solution->dual_values[row] = 0.0;
+    solution->constraint_statuses[row] = ConstraintStatus::BASIC;
+  }
+  for (int i = 0; i < num_blocks; ++i) {
+    const ProblemSolution& block_solution = results[i].solution;
+    const StrictITIVector<ColIndex, ColIndex> local_to_global_cols =
+        decomposer.GetLocalToGlobalVariables(i);
+    for (ColIndex col(0); col < local_to_global_cols.size(); ++col) {
+      const ColIndex global_col = local_to_global_cols[col];
+      solution->primal_values[global_col] = block_solution.primal_values[col];
+      solution->variable_statuses[global_col] =
+          block_solution.variable_statuses[col];
+    }
+    const StrictITIVector<RowIndex, RowIndex> local_to_global_rows =
+        decomposer.GetLocalToGlobalConstraints(i);
+    for (RowIndex row(0); row < local_to_global_rows.size(); ++row) {
+      const RowIndex global_row = local_to_global_rows[row];
+      solution->dual_values[global_row] = block_solution.dual_values[row];
+      solution->constraint_statuses[global_row] =
+          block_solution.constraint_statuses[row];
+    }
+  }
+  solution->status = ProblemStatus::OPTIMAL;
+  return true;
+}
+
+bool LPSolver::RunInteriorPointAndLoadCrossoverState() {
+  if (interior_point_ == nullptr) {
+    interior_point_.reset(new InteriorPointSolver());
+  }
+  interior_point_->SetParameters(parameters_);
+  const Status status = interior_point_->Solve(current_linear_program_);
+  num_interior_point_iterations_ = interior_point_->GetNumberOfIterations();
+  if (!status.ok() ||
+      interior_point_->GetProblemStatus() != ProblemStatus::OPTIMAL) {
+    VLOG(1) << "The interior point did not find an optimal solution, the "
+               "revised simplex starts from scratch.";
+    return false;
+  }
+  BasisState state;
+  interior_point_->ComputeCrossoverState(&state);
+  revised_simplex_->LoadStateForNextSolve(state);
+  return true;
 }
 
 void LPSolver::PostprocessSolution(ProblemSolution* solution) {
@@ -14,8 +14,14 @@
 #ifndef OR_TOOLS_GLOP_LP_SOLVER_H_
 #define OR_TOOLS_GLOP_LP_SOLVER_H_
 
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
 #include "base/unique_ptr.h"
 
+#include "glop/basis_cache.h"
+#include "glop/interior_point.h"
 #include "glop/parameters.pb.h"
 #include "glop/preprocessor.h"
 #include "lp_data/lp_data.h"
@@ -113,16 +119,61 @@ class LPSolver {
   // Returns the number of simplex iterations used by the last Solve().
   int GetNumberOfSimplexIterations() const;
 
+  // Returns the number of interior-point iterations used by the last Solve().
+  // This is always zero if use_interior_point is false.
+  int GetNumberOfInteriorPointIterations() const;
+
   // Returns the "deterministic time" since the creation of the solver. Note
   // That this time is only increased when some operations take place in this
-  // class.
+  // class. The time spent on the independent blocks is the one of the last
+  // Solve() only, since a decomposed solve does not reuse any state.
   //
-  // TODO(user): Currently, this is only modified when the simplex code is
-  // executed.
+  // TODO(user): Currently, this is only modified when the simplex or the
+  // interior-point code is executed.
   //
   // TODO(user): Improve the correlation with the running time.
   double DeterministicTime() const;
 
+  // Returns the basis cache used when use_basis_cache is true, or nullptr if
+  // it was never used. Its counters cover all the Solve() since the creation
+  // of this solver.
+  const BasisCache* basis_cache() const { return basis_cache_.get(); }
+
+  // Statistics on one preprocessor, accumulated over all the times it was run
+  // during the last Solve().
+  struct PreprocessorStats {
+    explicit PreprocessorStats(const std::string& _name)
+        : name(_name),
+          num_runs(0),
+          num_reductions(0),
+          time_in_seconds(0.0),
+          num_removed_rows(0),
+          num_removed_cols(0),
+          num_removed_entries(0) {}
+    std::string name;
+    int num_runs;
+
+    // Number of runs that modified the problem, i.e. that need a postsolve.
+    int num_reductions;
+    double time_in_seconds;
+
+    // Number of rows, columns and entries removed by all the runs. This can be
+    // negative since some preprocessors (e.g. the DualizerPreprocessor) add
+    // some.
+    int64 num_removed_rows;
+    int64 num_removed_cols;
+    int64 num_removed_entries;
+  };
+
+  // Returns the statistics of the preprocessors run by the last Solve(), in
+  // the order in which they were first run.
+  const std::vector<PreprocessorStats>& preprocessor_stats() const {
+    return preprocessor_stats_;
+  }
+
+  // Returns a human-readable table of preprocessor_stats().
+  std::string GetPreprocessorStatString() const;
+
  private:
   // Resizes all the solution vectors to the given sizes.
   // This is used in case of error to make sure all the getter functions will
@@ -144,8 +195,30 @@ class LPSolver {
                             const std::string& name, const TimeLimit& time_limit);
 
   // Runs the revised simplex algorithm if needed (i.e. if the program was not
-  // already solved by the preprocessors).
-  void RunRevisedSimplexIfNeeded(ProblemSolution* solution);
+  // already solved by the preprocessors). The independent blocks, the interior
+  // point method and the revised simplex all share the given time limit.
+  void RunRevisedSimplexIfNeeded(const TimeLimit& time_limit,
+                                 ProblemSolution* solution);
+
+  // Splits current_linear_program_ into independent blocks with an
+  // LPDecomposer and solves them with the revised simplex, concurrently if
+  // num_block_threads > 1. Returns true and fills the given solution (with the
+  // merged values and statuses of the blocks) if the problem had more than one
+  // block and all of them were solved to optimality. Otherwise, returns false
+  // and the problem must be solved as a whole, within what is left of the
+  // given time limit.
+  bool SolveIndependentBlocksIfDecomposable(const TimeLimit& time_limit,
+                                            ProblemSolution* solution);
+
+  // Stores the optimal basis given by variable_statuses_ and
+  // constraint_statuses_ in basis_cache_ for the given fingerprint of the
+  // initial problem.
+  void StoreBasisInCache(uint64 fingerprint);
+
+  // Runs the interior-point algorithm on current_linear_program_ and, if it
+  // found an optimal solution, loads the corresponding crossover basis as the
+  // revised simplex warm-start. Returns true in this case.
+  bool RunInteriorPointAndLoadCrossoverState();
 
   // Postprocess the solution by calling the StoreSolution() of the
   // preprocessors in the reverse order in which their where applied.
@@ -215,12 +288,34 @@ class LPSolver {
   // Stack of preprocessors currently applied to the current linear program.
   std::vector<std::unique_ptr<Preprocessor>> preprocessors_;
 
+  // The statistics of the preprocessors run by the last Solve().
+  std::vector<PreprocessorStats> preprocessor_stats_;
+
   // The revised simplex solver.
   std::unique_ptr<RevisedSimplex> revised_simplex_;
 
+  // The interior-point solver, only used if use_interior_point is true.
+  std::unique_ptr<InteriorPointSolver> interior_point_;
+
+  // The cache of optimal bases, only used if use_basis_cache is true. Note
+  // that it is not reset by Clear().
+  std::unique_ptr<BasisCache> basis_cache_;
+
+  // The basis found in basis_cache_ for the problem given to the current
+  // Solve(), or an empty state if there is none.
+  BasisState cached_basis_;
+
   // The number of revised simplex iterations used by the last Solve().
   int num_revised_simplex_iterations_;
 
+  // The number of interior-point iterations used by the last Solve().
+  int num_interior_point_iterations_;
+
+  // The deterministic time spent by the revised simplex on the independent
+  // blocks during the last Solve(). The revised simplex instances used on the
+  // blocks are not kept, so it is stored here.
+  double blocks_deterministic_time_;
+
   // The current ProblemSolution.
   // TODO(user): use a ProblemSolution directly?
   ProblemStatus status_;
@@ -13,6 +13,9 @@
 
 
 #include "glop/lu_factorization.h"
+
+#include <algorithm>
+
 #include "lp_data/lp_utils.h"
 
 namespace operations_research {
@@ -216,13 +219,21 @@ bool AreEqualWithPermutation(const DenseColumn& a, const DenseColumn& b,
 }
 }  // namespace
 
-void LuFactorization::RightSolveLWithPermutedInput(const DenseColumn& a,
-                                                   DenseColumn* x) const {
+void LuFactorization::RightSolveLWithPermutedInput(
+    ScatteredColumnReference a, DenseColumn* x,
+    RowIndexVector* non_zeros) const {
   SCOPED_TIME_STAT(&stats_);
+  non_zeros->clear();
   if (is_identity_factorization_) {
-    *x = a;
-  } else {
-    DCHECK(AreEqualWithPermutation(a, *x, row_perm_));
+    *x = a.dense_column;
+    non_zeros->assign(a.non_zero_rows.begin(), a.non_zero_rows.end());
+    return;
+  }
+  DCHECK(AreEqualWithPermutation(a.dense_column, *x, row_perm_));
+  for (const RowIndex row : a.non_zero_rows) {
+    non_zeros->push_back(row_perm_[row]);
+  }
+  if (!HypersparseSolve(lower_, x, non_zeros)) {
     lower_.LowerSolve(x);
   }
 }
@@ -261,13 +272,15 @@ void LuFactorization::LeftSolveL(DenseRow* y) const {
   ApplyInversePermutation(row_perm_, dense_column_scratchpad_, x);
 }
 
-void LuFactorization::RightSolveLForSparseColumn(const SparseColumn& b,
-                                                 DenseColumn* x) const {
+void LuFactorization::RightSolveLForSparseColumn(
+    const SparseColumn& b, DenseColumn* x, RowIndexVector* non_zeros) const {
   SCOPED_TIME_STAT(&stats_);
   DCHECK(IsAllZero(*x));
+  non_zeros->clear();
   if (is_identity_factorization_) {
     for (const SparseColumn::Entry e : b) {
       (*x)[e.row()] = e.coefficient();
+      non_zeros->push_back(e.row());
     }
     return;
   }
@@ -282,6 +295,7 @@ void LuFactorization::RightSolveLForSparseColumn(const SparseColumn& b,
   for (const SparseColumn::Entry e : b) {
     const RowIndex permuted_row = row_perm_[e.row()];
     (*x)[permuted_row] = e.coefficient();
+    non_zeros->push_back(permuted_row);
 
     // The second condition only works because lower_ only has 1.0
     // element on its diagonal.
@@ -293,7 +307,7 @@ void LuFactorization::RightSolveLForSparseColumn(const SparseColumn& b,
     first_column_to_consider = std::min(first_column_to_consider, col);
   }
 
-  // TODO(user): Use an hyper-sparse solve here?
+  if (HypersparseSolve(lower_, x, non_zeros)) return;
   lower_.LowerSolveStartingAt(first_column_to_consider, x);
 }
 
@@ -301,7 +315,19 @@ void LuFactorization::RightSolveUWithNonZeros(
     DenseColumn* x, std::vector<RowIndex>* non_zeros) const {
   SCOPED_TIME_STAT(&stats_);
   if (is_identity_factorization_) {
-    ComputeNonZeros(*x, non_zeros);
+    if (non_zeros->empty()) {
+      ComputeNonZeros(*x, non_zeros);
+    } else {
+      PermuteWithKnownNonZeros(RowPermutation(), x, non_zeros);
+    }
+    return;
+  }
+  if (HypersparseSolve(upper_, x, non_zeros)) {
+    if (col_perm_.empty()) {
+      PermuteWithKnownNonZeros(RowPermutation(), x, non_zeros);
+    } else {
+      PermuteWithKnownNonZeros(inverse_col_perm_, x, non_zeros);
+    }
     return;
   }
   upper_.UpperSolveWithNonZeros(x, non_zeros);
@@ -315,11 +341,39 @@ void LuFactorization::LeftSolveLWithNonZeros(
     DenseRow* y, ColIndexVector* non_zeros,
     DenseColumn* result_before_permutation) const {
   SCOPED_TIME_STAT(&stats_);
+  DenseColumn* const x = DenseRowAsColumn(y);
+  RowIndexVector* const non_zero_rows =
+      reinterpret_cast<RowIndexVector*>(non_zeros);
   if (is_identity_factorization_) {
-    ComputeNonZeros(*y, non_zeros);
+    if (non_zeros->empty()) {
+      ComputeNonZeros(*y, non_zeros);
+    } else {
+      PermuteWithKnownNonZeros(RowPermutation(), x, non_zero_rows);
+    }
     return;
   }
-  DenseColumn* const x = DenseRowAsColumn(y);
+  if (!non_zeros->empty()) {
+    if (transpose_lower_.IsEmpty()) {
+      ComputeTransposeLower();
+    }
+    if (HypersparseSolve(transpose_lower_, x, non_zero_rows)) {
+      if (result_before_permutation == nullptr) {
+        PermuteWithKnownNonZeros(inverse_row_perm_, x, non_zero_rows);
+      } else {
+        // Note that clearing x is in O(num_rows), but this is a simple memset
+        // compared to the dense triangular solve it replaces.
+        x->swap(*result_before_permutation);
+        x->AssignToZero(inverse_row_perm_.size());
+        for (RowIndex& row : *non_zero_rows) {
+          const RowIndex permuted_row = inverse_row_perm_[row];
+          (*x)[permuted_row] = (*result_before_permutation)[row];
+          row = permuted_row;
+        }
+        PermuteWithKnownNonZeros(RowPermutation(), x, non_zero_rows);
+      }
+      return;
+    }
+  }
   RowIndex last_non_zero_row;
   lower_.TransposeLowerSolve(x, &last_non_zero_row);
   if (result_before_permutation == nullptr) {
@@ -364,10 +418,14 @@ ColIndex LuFactorization::LeftSolveUForUnitRow(
     (*y)[permuted_col] /= transpose_upper_.GetDiagonalCoefficient(permuted_col);
     non_zeros->push_back(permuted_col);
   } else {
-    // TODO(user): use an hyper-sparse solve here?
     // Note that leaving non_zeros empty() will be interpreted as this column
     // is dense for the rest of the algorithm.
-    transpose_upper_.LowerSolveStartingAt(permuted_col, x);
+    RowIndexVector* const non_zero_rows =
+        reinterpret_cast<RowIndexVector*>(non_zeros);
+    non_zero_rows->push_back(ColToRowIndex(permuted_col));
+    if (!HypersparseSolve(transpose_upper_, x, non_zero_rows)) {
+      transpose_upper_.LowerSolveStartingAt(permuted_col, x);
+    }
   }
   return permuted_col;
 }
@@ -516,6 +574,62 @@ void LuFactorization::ComputeTransposeLower() const {
   transpose_lower_.PopulateFromTranspose(lower_);
 }
 
+bool LuFactorization::HypersparseSolve(const TriangularMatrix& matrix,
+                                       DenseColumn* x,
+                                       RowIndexVector* non_zeros) const {
+  // Note that TriangularComputeRowsToConsider() clears non_zeros if the
+  // depth-first search needs too many operations compared to the number of
+  // rows, that is when a dense solve is as fast.
+  if (!non_zeros->empty()) {
+    matrix.TriangularComputeRowsToConsider(non_zeros);
+  }
+  IF_STATS_ENABLED(stats_.hypersparse_solves.Add(non_zeros->empty() ? 0 : 1));
+  if (non_zeros->empty()) return false;
+  matrix.SparseTriangularSolve(*non_zeros, x);
+  return true;
+}
+
+template <typename IndexType>
+void LuFactorization::PermuteWithKnownNonZeros(
+    const Permutation<IndexType>& perm, DenseColumn* x,
+    RowIndexVector* non_zeros) const {
+  // An empty permutation is the identity, in which case we just need to remove
+  // the zeros and the duplicates.
+  if (perm.empty()) {
+    std::sort(non_zeros->begin(), non_zeros->end());
+    non_zeros->erase(std::unique(non_zeros->begin(), non_zeros->end()),
+                     non_zeros->end());
+    int new_size = 0;
+    for (const RowIndex row : *non_zeros) {
+      if ((*x)[row] != 0.0) (*non_zeros)[new_size++] = row;
+    }
+    non_zeros->resize(new_size);
+    return;
+  }
+
+  // Move the non-zeros to the scratchpad first since the permuted positions
+  // may overlap with the initial ones. A duplicate position is only moved once
+  // because x is zero there after the first time.
+  dense_zero_scratchpad_.resize(x->size(), 0.0);
+  DCHECK(IsAllZero(dense_zero_scratchpad_));
+  int new_size = 0;
+  for (const RowIndex row : *non_zeros) {
+    const Fractional value = (*x)[row];
+    if (value == 0.0) continue;
+    dense_zero_scratchpad_[row] = value;
+    (*x)[row] = 0.0;
+    (*non_zeros)[new_size++] = row;
+  }
+  non_zeros->resize(new_size);
+  for (RowIndex& row : *non_zeros) {
+    const RowIndex permuted_row(perm[IndexType(row.value())].value());
+    (*x)[permuted_row] = dense_zero_scratchpad_[row];
+    dense_zero_scratchpad_[row] = 0.0;
+    row = permuted_row;
+  }
+  std::sort(non_zeros->begin(), non_zeros->end());
+}
+
 bool LuFactorization::CheckFactorization(const MatrixView& matrix,
                                          Fractional tolerance) const {
   if (is_identity_factorization_) return true;
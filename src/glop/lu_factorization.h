@@ -107,16 +107,27 @@ class LuFactorization {
 
   // Specialized version of RightSolveL() that takes a SparseColumn as input.
   // Important: the output x must be of the correct size and all zero.
-  void RightSolveLForSparseColumn(const SparseColumn& b, DenseColumn* x) const;
+  //
+  // The solve is hyper-sparse when possible: the non-zero positions of the
+  // result are computed first with a depth-first search in the graph of L (see
+  // TriangularMatrix::TriangularComputeRowsToConsider()) and then only these
+  // positions are touched. In this case, non_zeros contains a super-set of the
+  // non-zero positions of the result, otherwise it is left empty.
+  void RightSolveLForSparseColumn(const SparseColumn& b, DenseColumn* x,
+                                  RowIndexVector* non_zeros) const;
 
   // Specialized version of RightSolveL() where x is originaly equal to
   // 'a' permuted by row_perm_. Note that 'a' is only used for DCHECK or when
   // is_identity_factorization_ is true, in which case the assumption of x is
-  // relaxed since x is not used at all.
-  void RightSolveLWithPermutedInput(const DenseColumn& a, DenseColumn* x) const;
+  // relaxed since x is not used at all. The non-zero positions of 'a' are used
+  // for an hyper-sparse solve and non_zeros is filled like in
+  // RightSolveLForSparseColumn().
+  void RightSolveLWithPermutedInput(ScatteredColumnReference a, DenseColumn* x,
+                                    RowIndexVector* non_zeros) const;
 
   // Specialized version of LeftSolveU() for an unit right-hand side.
-  // non_zeros will either be cleared or set to the non zeros of the results.
+  // non_zeros will either be cleared or set to the non zeros of the results
+  // (when the solve can be done in an hyper-sparse way).
   // It also returns the value of col permuted by Q (which is the position
   // of the unit-vector rhs in the solve system: y.U = rhs).
   // Important: the output y must be of the correct size and all zero.
@@ -124,15 +135,18 @@ class LuFactorization {
                                 std::vector<ColIndex>* non_zeros) const;
 
   // Specialized version of RightSolveU() that also computes the non-zero
-  // pattern of the output. Note that the initial value of non_zeros is not
-  // used.
+  // pattern of the output. If non_zeros is not empty initially, it must
+  // contain all the non-zero positions of x (duplicates are allowed) and it is
+  // used to do an hyper-sparse solve. An empty non_zeros means that x is
+  // considered dense. On output, non_zeros contains the sorted positions of
+  // the non-zeros of x.
   void RightSolveUWithNonZeros(DenseColumn* x,
                                std::vector<RowIndex>* non_zeros) const;
 
   // Specialized version of LeftSolveL() that also computes the non-zero
-  // pattern of the output. Note that the initial value of non_zeros is not
-  // used. Moreover, if result_before_permutation is not NULL, it is filled with
-  // the result just before row_perm_ is applied to it.
+  // pattern of the output. The initial value of non_zeros is used like in
+  // RightSolveUWithNonZeros(). Moreover, if result_before_permutation is not
+  // NULL, it is filled with the result just before row_perm_ is applied to it.
   void LeftSolveLWithNonZeros(DenseRow* y, ColIndexVector* non_zeros,
                               DenseColumn* result_before_permutation) const;
 
@@ -226,14 +240,33 @@ class LuFactorization {
     Stats()
         : StatsGroup("LuFactorization"),
           basis_num_entries("basis_num_entries", this),
-          lu_fill_in("lu_fill_in", this) {}
+          lu_fill_in("lu_fill_in", this),
+          hypersparse_solves("hypersparse_solves", this) {}
     IntegerDistribution basis_num_entries;
     RatioDistribution lu_fill_in;
+    RatioDistribution hypersparse_solves;
   };
 
   // Internal function used in the left solve functions.
   void LeftSolveScratchpad() const;
 
+  // Solves the given triangular system in an hyper-sparse way. The given
+  // non_zeros must contain all the non-zero positions of x (duplicates are
+  // allowed). Returns false and clears non_zeros without touching x if the
+  // result is not sparse enough, in which case a dense solve must be used.
+  // Otherwise, returns true and non_zeros contains the positions of the
+  // result that may be non-zero (without duplicates).
+  bool HypersparseSolve(const TriangularMatrix& matrix, DenseColumn* x,
+                        RowIndexVector* non_zeros) const;
+
+  // Applies the given permutation to x whose non-zeros are all in the given
+  // positions, using dense_zero_scratchpad_ as a temporary. On return,
+  // non_zeros contains the sorted non-zero positions of the permuted x.
+  template <typename IndexType>
+  void PermuteWithKnownNonZeros(const Permutation<IndexType>& perm,
+                                DenseColumn* x,
+                                RowIndexVector* non_zeros) const;
+
   // Fills transpose_upper_ from upper_.
   void ComputeTransposeUpper();
 
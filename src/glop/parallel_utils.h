@@ -0,0 +1,60 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Utilities to split the loops of the simplex kernels (pricing, ratio test,
+// edge norm updates) across the num_omp_threads threads.
+//
+// A loop is always cut into contiguous chunks, each chunk computes a partial
+// result and the partial results are merged sequentially in chunk order. All
+// the merges used (minimum, maximum with ties, concatenation, integer sum) give
+// exactly the same result whatever the chunk boundaries, so the simplex path
+// does not depend on the number of threads.
+
+#ifndef OR_TOOLS_GLOP_PARALLEL_UTILS_H_
+#define OR_TOOLS_GLOP_PARALLEL_UTILS_H_
+
+#include <algorithm>
+
+#include "base/integral_types.h"
+#include "glop/parameters.pb.h"
+
+namespace operations_research {
+namespace glop {
+
+// Loops with fewer iterations than this are not worth the cost of starting the
+// threads and are never split.
+const int kMinParallelLoopSize = 10000;
+
+// Returns the number of chunks in which a loop of the given size should be
+// split. This is always 1 if the code is not compiled with OMP.
+inline int NumberOfParallelChunks(const GlopParameters& parameters,
+                                  int loop_size) {
+#ifdef OMP
+  if (loop_size < kMinParallelLoopSize) return 1;
+  return std::max(1, std::min(parameters.num_omp_threads(),
+                              loop_size / (kMinParallelLoopSize / 2)));
+#else
+  return 1;
+#endif
+}
+
+// Returns the first iteration of the given chunk. The chunk i is
+// [ChunkStart(i), ChunkStart(i + 1)) and ChunkStart(num_chunks) == loop_size.
+inline int ChunkStart(int loop_size, int num_chunks, int chunk) {
+  return static_cast<int64>(loop_size) * chunk / num_chunks;
+}
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_PARALLEL_UTILS_H_
@@ -15,6 +15,7 @@
 #include "glop/preprocessor.h"
 
 #include "base/stringprintf.h"
+#include "glop/parallel_utils.h"
 #include "glop/revised_simplex.h"
 #include "glop/status.h"
 #include "lp_data/lp_utils.h"
@@ -321,8 +322,10 @@ struct ColumnWithRepresentativeAndScaledCost {
 bool ProportionalColumnPreprocessor::Run(LinearProgram* lp) {
   RETURN_VALUE_IF_NULL(lp, false);
   const Fractional kTolerance = parameters_.preprocessor_zero_tolerance();
-  ColMapping mapping =
-      FindProportionalColumns(lp->GetSparseMatrix(), kTolerance);
+  const SparseMatrix& matrix = lp->GetSparseMatrix();
+  ColMapping mapping = FindProportionalColumns(
+      matrix, kTolerance,
+      NumberOfParallelChunks(parameters_, matrix.num_cols().value()));
 
   // Compute some statistics and make each class representative point to itself
   // in the mapping. Also store the columns that are proportional to at least
@@ -691,7 +694,9 @@ bool ProportionalRowPreprocessor::Run(LinearProgram* lp) {
   // We need the first representative of each proportional row class to point to
   // itself for the loop below. TODO(user): Already return such a mapping from
   // FindProportionalColumns()?
-  ColMapping mapping = FindProportionalColumns(transpose, kTolerance);
+  ColMapping mapping = FindProportionalColumns(
+      transpose, kTolerance,
+      NumberOfParallelChunks(parameters_, transpose.num_cols().value()));
   DenseBooleanColumn is_a_representative(num_rows, false);
   int num_proportional_rows = 0;
   for (RowIndex row(0); row < num_rows; ++row) {
@@ -902,6 +907,134 @@ void ProportionalRowPreprocessor::StoreSolution(
   }
 }
 
+// --------------------------------------------------------
+// NearlyProportionalRowPreprocessor
+// --------------------------------------------------------
+
+namespace {
+
+// Maximum number of kept rows of a class of nearly proportional rows to which
+// each other row of the class is compared. This bounds the work on the large
+// classes.
+const int kMaxNumComparedRows = 8;
+
+// Returns true if the constraint of the row implied_row is implied by the
+// constraint of the row source_row and by the variable bounds. The two rows
+// must have the same sparsity pattern.
+//
+// Note that only the exactly zero entries of the residual are ignored: even a
+// tiny residual entry matters if the bounds of its variable are large, and it
+// makes the residual activity unbounded (and the row not implied) if its
+// variable is free.
+bool IsRowImpliedByRow(const LinearProgram& lp, const SparseMatrix& transpose,
+                       RowIndex source_row, RowIndex implied_row) {
+  const SparseColumn& source = transpose.column(RowToColIndex(source_row));
+  const SparseColumn& implied = transpose.column(RowToColIndex(implied_row));
+  DCHECK_EQ(source.num_entries(), implied.num_entries());
+
+  // The implied row is factor * source + residual, so its activity is in
+  // factor * [source row bounds] + [bounds of the residual activity].
+  const Fractional factor =
+      implied.GetFirstCoefficient() / source.GetFirstCoefficient();
+  Fractional min_activity = factor * lp.constraint_lower_bounds()[source_row];
+  Fractional max_activity = factor * lp.constraint_upper_bounds()[source_row];
+  if (factor < 0.0) std::swap(min_activity, max_activity);
+  for (const EntryIndex i : source.AllEntryIndices()) {
+    DCHECK_EQ(source.EntryRow(i), implied.EntryRow(i));
+    const Fractional coefficient = implied.EntryCoefficient(i);
+    const Fractional residual =
+        coefficient - factor * source.EntryCoefficient(i);
+    if (residual == 0.0) continue;
+    const ColIndex col = RowToColIndex(source.EntryRow(i));
+    Fractional residual_lb = residual * lp.variable_lower_bounds()[col];
+    Fractional residual_ub = residual * lp.variable_upper_bounds()[col];
+    if (residual < 0.0) std::swap(residual_lb, residual_ub);
+    min_activity += residual_lb;
+    max_activity += residual_ub;
+  }
+  return min_activity >= lp.constraint_lower_bounds()[implied_row] &&
+         max_activity <= lp.constraint_upper_bounds()[implied_row];
+}
+
+}  // namespace
+
+bool NearlyProportionalRowPreprocessor::Run(LinearProgram* lp) {
+  RETURN_VALUE_IF_NULL(lp, false);
+  const RowIndex num_rows = lp->num_constraints();
+  const SparseMatrix& transpose = lp->GetTransposeSparseMatrix();
+  const ColMapping mapping = FindProportionalColumns(
+      transpose, parameters_.nearly_proportional_rows_tolerance(),
+      NumberOfParallelChunks(parameters_, transpose.num_cols().value()));
+
+  // Group the rows of each class by sorting the pairs (representative, row).
+  // Since the representative is the smallest row of its class, it comes first.
+  std::vector<std::pair<RowIndex, RowIndex>> rows_by_class;
+  DenseBooleanColumn is_representative(num_rows, false);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    const ColIndex representative_as_col = mapping[RowToColIndex(row)];
+    if (representative_as_col == kInvalidCol) continue;
+    const RowIndex representative = ColToRowIndex(representative_as_col);
+    if (!is_representative[representative]) {
+      is_representative[representative] = true;
+      rows_by_class.push_back(std::make_pair(representative, representative));
+    }
+    rows_by_class.push_back(std::make_pair(representative, row));
+  }
+  std::sort(rows_by_class.begin(), rows_by_class.end());
+
+  // Each row of a class is compared to the rows of the class that are kept so
+  // far. A kept row implied by a new row is deleted and replaced by it. This
+  // is valid because the implication is transitive, so at the end all the
+  // deleted rows are implied by one of the kept rows.
+  std::vector<RowIndex> kept_rows;
+  int num_implied_rows = 0;
+  for (int i = 0; i < rows_by_class.size(); ++i) {
+    if (i == 0 || rows_by_class[i].first != rows_by_class[i - 1].first) {
+      kept_rows.clear();
+    }
+    const RowIndex row = rows_by_class[i].second;
+    const int num_compared_rows =
+        std::min<int>(kept_rows.size(), kMaxNumComparedRows);
+    bool is_implied = false;
+    for (int j = 0; j < num_compared_rows; ++j) {
+      if (IsRowImpliedByRow(*lp, transpose, kept_rows[j], row)) {
+        is_implied = true;
+        break;
+      }
+    }
+    if (is_implied) {
+      row_deletion_helper_.MarkRowForDeletion(row);
+      ++num_implied_rows;
+      continue;
+    }
+    int new_size = 0;
+    for (int j = 0; j < kept_rows.size(); ++j) {
+      if (j < num_compared_rows &&
+          IsRowImpliedByRow(*lp, transpose, row, kept_rows[j])) {
+        row_deletion_helper_.MarkRowForDeletion(kept_rows[j]);
+        ++num_implied_rows;
+      } else {
+        kept_rows[new_size++] = kept_rows[j];
+      }
+    }
+    kept_rows.resize(new_size);
+    kept_rows.push_back(row);
+  }
+  if (num_implied_rows > 0) {
+    VLOG(1) << num_implied_rows
+            << " rows are implied by a nearly proportional row.";
+  }
+
+  lp->DeleteRows(row_deletion_helper_.GetMarkedRows());
+  return !row_deletion_helper_.IsEmpty();
+}
+
+void NearlyProportionalRowPreprocessor::StoreSolution(
+    ProblemSolution* solution) const {
+  RETURN_IF_NULL(solution);
+  row_deletion_helper_.RestoreDeletedRows(solution);
+}
+
 // --------------------------------------------------------
 // FixedVariablePreprocessor
 // --------------------------------------------------------
@@ -936,6 +1069,56 @@ void FixedVariablePreprocessor::StoreSolution(ProblemSolution* solution) const {
 // ForcingAndImpliedFreeConstraintPreprocessor
 // --------------------------------------------------------
 
+namespace {
+
+// Adds the bounds of coeff * x with x in [lower, upper] to the given implied
+// constraint bounds.
+inline void AddToImpliedBounds(Fractional coeff, Fractional lower,
+                               Fractional upper, Fractional* implied_lower,
+                               Fractional* implied_upper) {
+  if (coeff > 0.0) {
+    *implied_lower += lower * coeff;
+    *implied_upper += upper * coeff;
+  } else {
+    *implied_lower += upper * coeff;
+    *implied_upper += lower * coeff;
+  }
+}
+
+// Whether a column is forced to one of its bounds by the forcing constraints
+// in which it appears. It is INFEASIBLE if two of them force it to different
+// bounds.
+enum class ForcedColumnStatus : int8 { NOT_FORCED, FORCED, INFEASIBLE };
+
+ForcedColumnStatus ComputeForcedColumnStatus(
+    const SparseColumn& column, Fractional lower, Fractional upper,
+    const DenseBooleanColumn& is_forcing_down,
+    const DenseBooleanColumn& is_forcing_up, Fractional* target_bound) {
+  bool is_forced = false;
+  for (const SparseColumn::Entry e : column) {
+    if (is_forcing_down[e.row()]) {
+      const Fractional candidate = e.coefficient() < 0.0 ? lower : upper;
+      if (is_forced && candidate != *target_bound) {
+        return ForcedColumnStatus::INFEASIBLE;
+      }
+      *target_bound = candidate;
+      is_forced = true;
+    }
+    if (is_forcing_up[e.row()]) {
+      const Fractional candidate = e.coefficient() < 0.0 ? upper : lower;
+      if (is_forced && candidate != *target_bound) {
+        return ForcedColumnStatus::INFEASIBLE;
+      }
+      *target_bound = candidate;
+      is_forced = true;
+    }
+  }
+  return is_forced ? ForcedColumnStatus::FORCED
+                   : ForcedColumnStatus::NOT_FORCED;
+}
+
+}  // namespace
+
 bool ForcingAndImpliedFreeConstraintPreprocessor::Run(LinearProgram* lp) {
   RETURN_VALUE_IF_NULL(lp, false);
   const RowIndex num_rows = lp->num_constraints();
@@ -945,20 +1128,44 @@ bool ForcingAndImpliedFreeConstraintPreprocessor::Run(LinearProgram* lp) {
   DenseColumn implied_upper_bounds(num_rows, 0);
   const ColIndex num_cols = lp->num_variables();
   StrictITIVector<RowIndex, int> row_degree(num_rows, 0);
-  for (ColIndex col(0); col < num_cols; ++col) {
-    const Fractional lower = lp->variable_lower_bounds()[col];
-    const Fractional upper = lp->variable_upper_bounds()[col];
-    for (const SparseColumn::Entry e : lp->GetSparseColumn(col)) {
-      const RowIndex row = e.row();
-      const Fractional coeff = e.coefficient();
-      if (coeff > 0.0) {
-        implied_lower_bounds[row] += lower * coeff;
-        implied_upper_bounds[row] += upper * coeff;
-      } else {
-        implied_lower_bounds[row] += upper * coeff;
-        implied_upper_bounds[row] += lower * coeff;
+  const int num_row_chunks =
+      NumberOfParallelChunks(parameters_, num_rows.value());
+  if (num_row_chunks > 1) {
+    // Each row is independent, so the rows are split in chunks (see
+    // parallel_utils.h). The transpose lists the entries of a row by
+    // increasing column, so the sums are computed in exactly the same order
+    // as in the column-wise loop below.
+    const SparseMatrix& transpose = lp->GetTransposeSparseMatrix();
+#ifdef OMP
+#pragma omp parallel for num_threads(num_row_chunks)
+#endif
+    for (int chunk = 0; chunk < num_row_chunks; ++chunk) {
+      const RowIndex end(
+          ChunkStart(num_rows.value(), num_row_chunks, chunk + 1));
+      for (RowIndex row(ChunkStart(num_rows.value(), num_row_chunks, chunk));
+           row < end; ++row) {
+        const SparseColumn& row_entries = transpose.column(RowToColIndex(row));
+        for (const SparseColumn::Entry e : row_entries) {
+          const ColIndex col = RowToColIndex(e.row());
+          AddToImpliedBounds(e.coefficient(), lp->variable_lower_bounds()[col],
+                             lp->variable_upper_bounds()[col],
+                             &implied_lower_bounds[row],
+                             &implied_upper_bounds[row]);
+        }
+        row_degree[row] = row_entries.num_entries().value();
+      }
+    }
+  } else {
+    for (ColIndex col(0); col < num_cols; ++col) {
+      const Fractional lower = lp->variable_lower_bounds()[col];
+      const Fractional upper = lp->variable_upper_bounds()[col];
+      for (const SparseColumn::Entry e : lp->GetSparseColumn(col)) {
+        const RowIndex row = e.row();
+        AddToImpliedBounds(e.coefficient(), lower, upper,
+                           &implied_lower_bounds[row],
+                           &implied_upper_bounds[row]);
+        ++row_degree[row];
       }
-      ++row_degree[row];
     }
   }
 
@@ -1018,33 +1225,40 @@ bool ForcingAndImpliedFreeConstraintPreprocessor::Run(LinearProgram* lp) {
     lp_is_maximization_problem_ = lp->IsMaximizationProblem();
     deleted_columns_.PopulateFromZero(num_rows, num_cols);
     costs_.resize(num_cols, 0.0);
+
+    // The status of a column only depends on the forcing constraints, so it is
+    // computed by chunks of columns in parallel. The columns are then fixed
+    // sequentially in order.
+    StrictITIVector<ColIndex, ForcedColumnStatus> forced_status(
+        num_cols, ForcedColumnStatus::NOT_FORCED);
+    DenseRow target_bounds(num_cols, 0.0);
+    const int num_col_chunks =
+        NumberOfParallelChunks(parameters_, num_cols.value());
+#ifdef OMP
+#pragma omp parallel for num_threads(num_col_chunks) if (num_col_chunks > 1)
+#endif
+    for (int chunk = 0; chunk < num_col_chunks; ++chunk) {
+      const ColIndex end(
+          ChunkStart(num_cols.value(), num_col_chunks, chunk + 1));
+      for (ColIndex col(ChunkStart(num_cols.value(), num_col_chunks, chunk));
+           col < end; ++col) {
+        forced_status[col] = ComputeForcedColumnStatus(
+            lp->GetSparseColumn(col), lp->variable_lower_bounds()[col],
+            lp->variable_upper_bounds()[col], is_forcing_down, is_forcing_up_,
+            &target_bounds[col]);
+      }
+    }
     for (ColIndex col(0); col < num_cols; ++col) {
-      const SparseColumn& column = lp->GetSparseColumn(col);
-      const Fractional lower = lp->variable_lower_bounds()[col];
-      const Fractional upper = lp->variable_upper_bounds()[col];
-      bool is_forced = false;
-      Fractional target_bound;
-      for (const SparseColumn::Entry e : column) {
-        if (is_forcing_down[e.row()]) {
-          const Fractional candidate = e.coefficient() < 0.0 ? lower : upper;
-          if (is_forced && candidate != target_bound) {
-            status_ = ProblemStatus::PRIMAL_INFEASIBLE;
-            return false;
-          }
-          target_bound = candidate;
-          is_forced = true;
-        }
-        if (is_forcing_up_[e.row()]) {
-          const Fractional candidate = e.coefficient() < 0.0 ? upper : lower;
-          if (is_forced && candidate != target_bound) {
-            status_ = ProblemStatus::PRIMAL_INFEASIBLE;
-            return false;
-          }
-          target_bound = candidate;
-          is_forced = true;
-        }
+      if (forced_status[col] == ForcedColumnStatus::INFEASIBLE) {
+        status_ = ProblemStatus::PRIMAL_INFEASIBLE;
+        return false;
       }
-      if (is_forced) {
+      if (forced_status[col] == ForcedColumnStatus::FORCED) {
+        const SparseColumn& column = lp->GetSparseColumn(col);
+        const Fractional lower = lp->variable_lower_bounds()[col];
+        const Fractional upper = lp->variable_upper_bounds()[col];
+        const Fractional target_bound = target_bounds[col];
+
         // Fix the variable, update the constraint bounds and save this column
         // and its cost for the postsolve.
         SubtractColumnMultipleFromConstraintBound(col, target_bound, lp);
@@ -1170,16 +1384,43 @@ bool ImpliedFreePreprocessor::Run(LinearProgram* lp) {
   ITIVector<RowIndex, SumWithNegativeInfiniteAndOneMissing> lb_sums(size);
   ITIVector<RowIndex, SumWithPositiveInfiniteAndOneMissing> ub_sums(size);
 
-  // Initialize the sums by adding all the bounds of the variables.
-  for (ColIndex col(0); col < num_cols; ++col) {
-    const Fractional lower_bound = lp->variable_lower_bounds()[col];
-    const Fractional upper_bound = lp->variable_upper_bounds()[col];
-    for (const SparseColumn::Entry e : lp->GetSparseColumn(col)) {
-      Fractional entry_lb = e.coefficient() * lower_bound;
-      Fractional entry_ub = e.coefficient() * upper_bound;
-      if (e.coefficient() < 0.0) std::swap(entry_lb, entry_ub);
-      lb_sums[e.row()].Add(entry_lb);
-      ub_sums[e.row()].Add(entry_ub);
+  // Initialize the sums by adding all the bounds of the variables. As in
+  // ForcingAndImpliedFreeConstraintPreprocessor, large problems are processed
+  // by chunks of rows of the transpose, which gives the same sums.
+  const int num_row_chunks = NumberOfParallelChunks(parameters_, size);
+  if (num_row_chunks > 1) {
+    const SparseMatrix& transpose = lp->GetTransposeSparseMatrix();
+#ifdef OMP
+#pragma omp parallel for num_threads(num_row_chunks)
+#endif
+    for (int chunk = 0; chunk < num_row_chunks; ++chunk) {
+      const RowIndex end(ChunkStart(size, num_row_chunks, chunk + 1));
+      for (RowIndex row(ChunkStart(size, num_row_chunks, chunk)); row < end;
+           ++row) {
+        for (const SparseColumn::Entry e :
+             transpose.column(RowToColIndex(row))) {
+          const ColIndex col = RowToColIndex(e.row());
+          const Fractional lower_bound = lp->variable_lower_bounds()[col];
+          const Fractional upper_bound = lp->variable_upper_bounds()[col];
+          Fractional entry_lb = e.coefficient() * lower_bound;
+          Fractional entry_ub = e.coefficient() * upper_bound;
+          if (e.coefficient() < 0.0) std::swap(entry_lb, entry_ub);
+          lb_sums[row].Add(entry_lb);
+          ub_sums[row].Add(entry_ub);
+        }
+      }
+    }
+  } else {
+    for (ColIndex col(0); col < num_cols; ++col) {
+      const Fractional lower_bound = lp->variable_lower_bounds()[col];
+      const Fractional upper_bound = lp->variable_upper_bounds()[col];
+      for (const SparseColumn::Entry e : lp->GetSparseColumn(col)) {
+        Fractional entry_lb = e.coefficient() * lower_bound;
+        Fractional entry_ub = e.coefficient() * upper_bound;
+        if (e.coefficient() < 0.0) std::swap(entry_lb, entry_ub);
+        lb_sums[e.row()].Add(entry_lb);
+        ub_sums[e.row()].Add(entry_ub);
+      }
     }
   }
 
@@ -1741,6 +1982,332 @@ void UnconstrainedVariablePreprocessor::StoreSolution(
   }
 }
 
+// --------------------------------------------------------
+// BoundPropagationPreprocessor
+// --------------------------------------------------------
+
+namespace {
+
+// The propagation stops when the number of processed entries exceeds this
+// factor times the number of entries of the constraints. The bounds are always
+// valid, even if the fixed point is not reached.
+const int kPropagationWorkFactor = 20;
+
+// A bound is only changed if it moves by more than this fraction of the domain
+// size (or of the new bound magnitude if the domain is infinite). This avoids
+// an infinite sequence of tiny changes.
+const Fractional kMinRelativeBoundChange = 1e-3;
+
+// The implied bounds larger than this in magnitude are ignored: they are not
+// useful and the sums that use them lose all their precision.
+const Fractional kMaxImpliedBoundMagnitude = 1e10;
+
+// Returns true if changing bound to new_bound, which is closer to other_bound,
+// is significant.
+bool IsSignificantBoundChange(Fractional bound, Fractional other_bound,
+                              Fractional new_bound) {
+  if (fabs(new_bound) > kMaxImpliedBoundMagnitude) return false;
+  if (!IsFinite(bound)) return true;
+  const Fractional scale = IsFinite(other_bound) ? fabs(other_bound - bound)
+                                                 : fabs(new_bound);
+  return fabs(new_bound - bound) >
+         kMinRelativeBoundChange * std::max(1.0, scale);
+}
+
+// Propagates the bounds of the variables of the linear constraints
+//   constraint_lower_bounds[c] <= sum coeff * var <= constraint_upper_bounds[c]
+// with a worklist of constraints. The constraint c is the column c of
+// constraints and its variables are the rows of this column, transpose gives
+// the constraints in which each variable appears. This is used both for the
+// primal (one constraint per row) and the dual (one constraint per column) of
+// a linear program. Returns false if the constraints are infeasible.
+bool PropagateBounds(const SparseMatrix& constraints,
+                     const SparseMatrix& transpose,
+                     const DenseRow& constraint_lower_bounds,
+                     const DenseRow& constraint_upper_bounds,
+                     Fractional tolerance, DenseColumn* lower_bounds,
+                     DenseColumn* upper_bounds) {
+  const ColIndex num_constraints = constraints.num_cols();
+  const int64 work_limit =
+      kPropagationWorkFactor * (constraints.num_entries().value() + 1);
+  int64 work = 0;
+  std::vector<ColIndex> to_process;
+  std::vector<ColIndex> next_to_process;
+  DenseBooleanRow in_queue(num_constraints, false);
+  for (ColIndex c(0); c < num_constraints; ++c) {
+    if (IsFinite(constraint_lower_bounds[c]) ||
+        IsFinite(constraint_upper_bounds[c])) {
+      to_process.push_back(c);
+      in_queue[c] = true;
+    }
+  }
+  while (!to_process.empty() && work < work_limit) {
+    for (const ColIndex c : to_process) {
+      in_queue[c] = false;
+      const SparseColumn& constraint = constraints.column(c);
+      work += constraint.num_entries().value();
+
+      // Bounds on the constraint activity, with at most one infinite term
+      // missing (see ImpliedFreePreprocessor).
+      SumWithNegativeInfiniteAndOneMissing min_activity;
+      SumWithPositiveInfiniteAndOneMissing max_activity;
+      for (const SparseColumn::Entry e : constraint) {
+        Fractional entry_lb = e.coefficient() * (*lower_bounds)[e.row()];
+        Fractional entry_ub = e.coefficient() * (*upper_bounds)[e.row()];
+        if (e.coefficient() < 0.0) std::swap(entry_lb, entry_ub);
+        min_activity.Add(entry_lb);
+        max_activity.Add(entry_ub);
+      }
+      for (const SparseColumn::Entry e : constraint) {
+        const RowIndex var = e.row();
+        const Fractional coeff = e.coefficient();
+        const Fractional lower_bound = (*lower_bounds)[var];
+        const Fractional upper_bound = (*upper_bounds)[var];
+        Fractional entry_lb = coeff * lower_bound;
+        Fractional entry_ub = coeff * upper_bound;
+        if (coeff < 0.0) std::swap(entry_lb, entry_ub);
+
+        // coeff * var = activity - (the other terms).
+        Fractional implied_lb = (constraint_lower_bounds[c] -
+                                 max_activity.SumWithout(entry_ub)) / coeff;
+        Fractional implied_ub = (constraint_upper_bounds[c] -
+                                 min_activity.SumWithout(entry_lb)) / coeff;
+        if (coeff < 0.0) std::swap(implied_lb, implied_ub);
+
+        bool changed = false;
+        if (implied_lb > lower_bound &&
+            IsSignificantBoundChange(lower_bound, upper_bound, implied_lb)) {
+          if (implied_lb >
+              upper_bound + tolerance * std::max(1.0, fabs(upper_bound))) {
+            return false;
+          }
+          (*lower_bounds)[var] = std::min(implied_lb, upper_bound);
+          changed = true;
+        }
+        if (implied_ub < upper_bound &&
+            IsSignificantBoundChange(upper_bound, lower_bound, implied_ub)) {
+          const Fractional new_lower_bound = (*lower_bounds)[var];
+          if (implied_ub < new_lower_bound -
+                               tolerance *
+                                   std::max(1.0, fabs(new_lower_bound))) {
+            return false;
+          }
+          (*upper_bounds)[var] = std::max(implied_ub, new_lower_bound);
+          changed = true;
+        }
+        if (!changed) continue;
+        for (const SparseColumn::Entry other :
+             transpose.column(RowToColIndex(var))) {
+          const ColIndex other_constraint = RowToColIndex(other.row());
+          if (other_constraint != c && !in_queue[other_constraint]) {
+            in_queue[other_constraint] = true;
+            next_to_process.push_back(other_constraint);
+          }
+        }
+      }
+    }
+    to_process.swap(next_to_process);
+    next_to_process.clear();
+  }
+  return true;
+}
+
+// Computes the bounds of the sum of coeff * value over the given entries, where
+// value is in [lower_bounds[row], upper_bounds[row]].
+void ComputeActivityBounds(const SparseColumn& column,
+                           const DenseColumn& lower_bounds,
+                           const DenseColumn& upper_bounds,
+                           Fractional* min_activity, Fractional* max_activity) {
+  *min_activity = 0.0;
+  *max_activity = 0.0;
+  for (const SparseColumn::Entry e : column) {
+    Fractional entry_lb = e.coefficient() * lower_bounds[e.row()];
+    Fractional entry_ub = e.coefficient() * upper_bounds[e.row()];
+    if (e.coefficient() < 0.0) std::swap(entry_lb, entry_ub);
+    *min_activity += entry_lb;
+    *max_activity += entry_ub;
+  }
+}
+
+// Returns true if no value smaller or equal to max_value can be at the given
+// upper bound, with a margin relative to its magnitude. The margin makes sure
+// that this is still true for the slightly infeasible solutions returned by
+// the simplex.
+bool IsUpperBoundUnreachable(Fractional upper_bound, Fractional max_value,
+                             Fractional margin) {
+  return upper_bound == kInfinity ||
+         max_value < upper_bound - margin * std::max(1.0, fabs(upper_bound));
+}
+
+// Same as IsUpperBoundUnreachable() for a lower bound.
+bool IsLowerBoundUnreachable(Fractional lower_bound, Fractional min_value,
+                             Fractional margin) {
+  return lower_bound == -kInfinity ||
+         min_value > lower_bound + margin * std::max(1.0, fabs(lower_bound));
+}
+
+}  // namespace
+
+bool BoundPropagationPreprocessor::Run(LinearProgram* lp) {
+  RETURN_VALUE_IF_NULL(lp, false);
+  const RowIndex num_rows = lp->num_constraints();
+  const ColIndex num_cols = lp->num_variables();
+  const SparseMatrix& matrix = lp->GetSparseMatrix();
+  const SparseMatrix& transpose = lp->GetTransposeSparseMatrix();
+
+  // Propagate the primal bounds. The constraints are the columns of the
+  // transpose, so the rows and the columns are exchanged.
+  DenseRow row_lower_bounds(RowToColIndex(num_rows), 0.0);
+  DenseRow row_upper_bounds(RowToColIndex(num_rows), 0.0);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    row_lower_bounds[RowToColIndex(row)] = lp->constraint_lower_bounds()[row];
+    row_upper_bounds[RowToColIndex(row)] = lp->constraint_upper_bounds()[row];
+  }
+  DenseColumn implied_lower_bounds(ColToRowIndex(num_cols), 0.0);
+  DenseColumn implied_upper_bounds(ColToRowIndex(num_cols), 0.0);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    implied_lower_bounds[ColToRowIndex(col)] = lp->variable_lower_bounds()[col];
+    implied_upper_bounds[ColToRowIndex(col)] = lp->variable_upper_bounds()[col];
+  }
+  if (!PropagateBounds(transpose, matrix, row_lower_bounds, row_upper_bounds,
+                       parameters_.primal_feasibility_tolerance(),
+                       &implied_lower_bounds, &implied_upper_bounds)) {
+    VLOG(1) << "Problem PRIMAL_INFEASIBLE, the bound propagation found an "
+               "empty variable domain.";
+    status_ = ProblemStatus::PRIMAL_INFEASIBLE;
+    return false;
+  }
+
+  // In an optimal solution (of a minimization problem), the reduced cost
+  // cost - column.dual_values of a variable is >= 0 if the variable is not at
+  // its upper bound and <= 0 if it is not at its lower bound. These are the
+  // dual constraints of the columns. Similarly, the dual value of a constraint
+  // is >= 0 if the constraint is not at its upper bound and <= 0 if it is not
+  // at its lower bound. We use the implied bounds to know which bounds are
+  // never reached by a feasible solution.
+  const Fractional margin = parameters_.solution_feasibility_tolerance();
+  DenseRow column_dual_lower_bounds(num_cols, -kInfinity);
+  DenseRow column_dual_upper_bounds(num_cols, kInfinity);
+  DenseBooleanRow can_be_at_lower_bound(num_cols, true);
+  DenseBooleanRow can_be_at_upper_bound(num_cols, true);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    const Fractional cost =
+        lp->GetObjectiveCoefficientForMinimizationVersion(col);
+    if (IsUpperBoundUnreachable(lp->variable_upper_bounds()[col],
+                                implied_upper_bounds[ColToRowIndex(col)],
+                                margin)) {
+      can_be_at_upper_bound[col] = false;
+      column_dual_upper_bounds[col] = cost;
+    }
+    if (IsLowerBoundUnreachable(lp->variable_lower_bounds()[col],
+                                implied_lower_bounds[ColToRowIndex(col)],
+                                margin)) {
+      can_be_at_lower_bound[col] = false;
+      column_dual_lower_bounds[col] = cost;
+    }
+  }
+  DenseColumn dual_lower_bounds(num_rows, -kInfinity);
+  DenseColumn dual_upper_bounds(num_rows, kInfinity);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    Fractional min_activity;
+    Fractional max_activity;
+    ComputeActivityBounds(transpose.column(RowToColIndex(row)),
+                          implied_lower_bounds, implied_upper_bounds,
+                          &min_activity, &max_activity);
+    if (IsUpperBoundUnreachable(lp->constraint_upper_bounds()[row],
+                                max_activity, margin)) {
+      dual_lower_bounds[row] = 0.0;
+    }
+    if (IsLowerBoundUnreachable(lp->constraint_lower_bounds()[row],
+                                min_activity, margin)) {
+      dual_upper_bounds[row] = 0.0;
+    }
+  }
+
+  // Propagate the bounds of the dual values and find the dominated columns.
+  // A dominated column is removed from the problem, so the dual values of the
+  // presolved problem do not satisfy its dual constraint anymore. The dual
+  // bounds used to prove that a column is dominated must thus not depend on
+  // the dual constraints of the removed columns. We start with the columns
+  // dominated when all the dual constraints are used, and remove from this set
+  // the columns that are not dominated anymore without the dual constraints
+  // of the set until it does not change.
+  const int kMaxNumIterations = 10;
+  const Fractional tolerance = parameters_.dual_feasibility_tolerance();
+  DenseBooleanRow is_dominated(num_cols, false);
+  DenseRow target_bounds(num_cols, 0.0);
+  for (int iteration = 0;; ++iteration) {
+    if (iteration == kMaxNumIterations) return false;
+    DenseRow dual_constraint_lower_bounds = column_dual_lower_bounds;
+    DenseRow dual_constraint_upper_bounds = column_dual_upper_bounds;
+    for (ColIndex col(0); col < num_cols; ++col) {
+      if (is_dominated[col]) {
+        dual_constraint_lower_bounds[col] = -kInfinity;
+        dual_constraint_upper_bounds[col] = kInfinity;
+      }
+    }
+    DenseColumn implied_dual_lower_bounds = dual_lower_bounds;
+    DenseColumn implied_dual_upper_bounds = dual_upper_bounds;
+    if (!PropagateBounds(matrix, transpose, dual_constraint_lower_bounds,
+                         dual_constraint_upper_bounds, tolerance,
+                         &implied_dual_lower_bounds,
+                         &implied_dual_upper_bounds)) {
+      VLOG(1) << "The dual bound propagation found an empty domain.";
+      return false;
+    }
+
+    bool changed = false;
+    int num_dominated_columns = 0;
+    for (ColIndex col(0); col < num_cols; ++col) {
+      if (iteration > 0 && !is_dominated[col]) continue;
+      const Fractional lower_bound = lp->variable_lower_bounds()[col];
+      const Fractional upper_bound = lp->variable_upper_bounds()[col];
+      bool dominated = false;
+      if (lower_bound != upper_bound && !matrix.column(col).IsEmpty()) {
+        Fractional min_dual_activity;
+        Fractional max_dual_activity;
+        ComputeActivityBounds(matrix.column(col), implied_dual_lower_bounds,
+                              implied_dual_upper_bounds, &min_dual_activity,
+                              &max_dual_activity);
+        const Fractional cost =
+            lp->GetObjectiveCoefficientForMinimizationVersion(col);
+        if (cost - max_dual_activity > tolerance) {
+          // The reduced cost is always positive.
+          dominated = IsFinite(lower_bound) && can_be_at_lower_bound[col];
+          target_bounds[col] = lower_bound;
+        } else if (cost - min_dual_activity < -tolerance) {
+          // The reduced cost is always negative.
+          dominated = IsFinite(upper_bound) && can_be_at_upper_bound[col];
+          target_bounds[col] = upper_bound;
+        }
+      }
+      if (dominated != is_dominated[col]) changed = true;
+      is_dominated[col] = dominated;
+      if (dominated) ++num_dominated_columns;
+    }
+    if (num_dominated_columns == 0) return false;
+    if (iteration > 0 && !changed) break;
+  }
+
+  for (ColIndex col(0); col < num_cols; ++col) {
+    if (!is_dominated[col]) continue;
+    SubtractColumnMultipleFromConstraintBound(col, target_bounds[col], lp);
+    column_deletion_helper_.MarkColumnForDeletionWithState(
+        col, target_bounds[col],
+        ComputeVariableStatus(target_bounds[col],
+                              lp->variable_lower_bounds()[col],
+                              lp->variable_upper_bounds()[col]));
+  }
+  lp->DeleteColumns(column_deletion_helper_.GetMarkedColumns());
+  return !column_deletion_helper_.IsEmpty();
+}
+
+void BoundPropagationPreprocessor::StoreSolution(
+    ProblemSolution* solution) const {
+  RETURN_IF_NULL(solution);
+  column_deletion_helper_.RestoreDeletedColumns(solution);
+}
+
 // --------------------------------------------------------
 // FreeConstraintPreprocessor
 // --------------------------------------------------------
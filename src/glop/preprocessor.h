@@ -298,6 +298,30 @@ class ProportionalRowPreprocessor : public Preprocessor {
   DISALLOW_COPY_AND_ASSIGN(ProportionalRowPreprocessor);
 };
 
+// --------------------------------------------------------
+// NearlyProportionalRowPreprocessor
+// --------------------------------------------------------
+// Removes the rows that are implied by a nearly proportional row and by the
+// variable bounds. If b = factor * a + e, where e is small, then
+// b.x = factor * a.x + e.x and the bounds of a.x and of e.x (computed from the
+// variable bounds) may imply the bounds of b.x. Contrary to
+// ProportionalRowPreprocessor, the bounds of the rows are never merged and no
+// entry of e is neglected (an entry of e on a free variable makes the bounds
+// of e.x infinite), so this is exact even if the rows are only nearly
+// proportional. The candidate pairs are found with the same row hashing, using
+// the tolerance nearly_proportional_rows_tolerance.
+class NearlyProportionalRowPreprocessor : public Preprocessor {
+ public:
+  NearlyProportionalRowPreprocessor() {}
+  virtual ~NearlyProportionalRowPreprocessor() {}
+  virtual bool Run(LinearProgram* linear_program);
+  virtual void StoreSolution(ProblemSolution* solution) const;
+
+ private:
+  RowDeletionHelper row_deletion_helper_;
+  DISALLOW_COPY_AND_ASSIGN(NearlyProportionalRowPreprocessor);
+};
+
 // --------------------------------------------------------
 // SingletonPreprocessor
 // --------------------------------------------------------
@@ -647,6 +671,43 @@ class UnconstrainedVariablePreprocessor : public Preprocessor {
   DISALLOW_COPY_AND_ASSIGN(UnconstrainedVariablePreprocessor);
 };
 
+// --------------------------------------------------------
+// BoundPropagationPreprocessor
+// --------------------------------------------------------
+// Generalizes the UnconstrainedVariablePreprocessor and the fixing of the
+// dominated proportional columns of the ProportionalColumnPreprocessor using
+// bound propagation on both the primal and the dual. See section 3 of
+// E. D. Andersen, K. D. Andersen, "Presolving in linear programming."
+//
+// - The bounds implied on the variables by the constraints are propagated with
+//   a worklist until a fixed point (or a work limit) is reached. This detects
+//   some infeasible problems.
+// - A variable (resp. constraint) whose bound is never reached by a feasible
+//   solution cannot be at this bound in an optimal solution, which gives the
+//   sign of its reduced cost (resp. dual value). These signs are propagated
+//   the same way on the dual values.
+// - A variable whose reduced cost has the same strict sign for all these dual
+//   values is dominated: it is at the corresponding bound in all the optimal
+//   solutions and is fixed there.
+//
+// The implied bounds are never written in the problem, so the feasible set is
+// only changed by the fixing of the dominated variables. The dual reasoning
+// only uses the columns that are kept, so the optimal dual values of the
+// presolved problem give reduced costs of the correct sign to the fixed
+// variables and no dual postsolve is needed.
+class BoundPropagationPreprocessor : public Preprocessor {
+ public:
+  BoundPropagationPreprocessor() {}
+  virtual ~BoundPropagationPreprocessor() {}
+  virtual bool Run(LinearProgram* linear_program);
+  virtual void StoreSolution(ProblemSolution* solution) const;
+  virtual void UseInMipContext() { LOG(FATAL) << "Not implemented."; }
+
+ private:
+  ColumnDeletionHelper column_deletion_helper_;
+  DISALLOW_COPY_AND_ASSIGN(BoundPropagationPreprocessor);
+};
+
 // --------------------------------------------------------
 // FreeConstraintPreprocessor
 // --------------------------------------------------------
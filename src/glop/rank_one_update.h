@@ -14,6 +14,9 @@
 #ifndef OR_TOOLS_GLOP_RANK_ONE_UPDATE_H_
 #define OR_TOOLS_GLOP_RANK_ONE_UPDATE_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "base/logging.h"
 #include "glop/status.h"
 #include "lp_data/lp_types.h"
@@ -73,6 +76,30 @@ class RankOneUpdateElementaryMatrix {
                                              reinterpret_cast<DenseColumn*>(y));
   }
 
+  // Same as RightSolve() and LeftSolve() but also append the positions that
+  // may become non-zero to the given non-zeros vector, which may thus contain
+  // duplicates. Note that an empty non_zeros is used to indicate a dense vector
+  // and is left as is. The non-zeros are also cleared if their number becomes
+  // too large since the vector is then better treated as dense.
+  void RightSolveWithNonZeros(DenseColumn* x,
+                              RowIndexVector* non_zeros) const {
+    DCHECK(!IsSingular());
+    const Fractional multiplier =
+        -storage_->ColumnScalarProduct(v_index_, Transpose(*x)) / mu_;
+    if (multiplier == 0.0) return;
+    storage_->ColumnAddMultipleToDenseColumn(u_index_, multiplier, x);
+    AppendColumnRows(u_index_, non_zeros);
+  }
+  void LeftSolveWithNonZeros(DenseRow* y, ColIndexVector* non_zeros) const {
+    DCHECK(!IsSingular());
+    const Fractional multiplier =
+        -storage_->ColumnScalarProduct(u_index_, *y) / mu_;
+    if (multiplier == 0.0) return;
+    storage_->ColumnAddMultipleToDenseColumn(v_index_, multiplier,
+                                             reinterpret_cast<DenseColumn*>(y));
+    AppendColumnRows(v_index_, reinterpret_cast<RowIndexVector*>(non_zeros));
+  }
+
   // Computes T.x for a given column vector.
   void RightMultiply(DenseColumn* x) const {
     const Fractional multiplier =
@@ -93,6 +120,22 @@ class RankOneUpdateElementaryMatrix {
   }
 
  private:
+  // Appends the rows of the given storage column to non_zeros if it is not
+  // empty, or clears it if the result would contain more than 10% of the
+  // positions.
+  void AppendColumnRows(ColIndex col, RowIndexVector* non_zeros) const {
+    if (non_zeros->empty()) return;
+    const EntryIndex num_entries = storage_->ColumnNumEntries(col);
+    if (10 * (non_zeros->size() + num_entries.value()) >
+        storage_->num_rows().value()) {
+      non_zeros->clear();
+      return;
+    }
+    for (const EntryIndex i : storage_->Column(col)) {
+      non_zeros->push_back(storage_->EntryRow(i));
+    }
+  }
+
   // This is only used in debug mode.
   Fractional ComputeUScalarV() const {
     DenseColumn dense_u;
@@ -143,9 +186,40 @@ class RankOneUpdateFactorization {
     }
   }
 
+  // Versions of the solves above that also update the non-zero positions of
+  // the vector. See RankOneUpdateElementaryMatrix::RightSolveWithNonZeros().
+  // Unlike for a single matrix, the non-zeros contain no duplicates on output
+  // if they contained none on input.
+  void LeftSolveWithNonZeros(DenseRow* y, ColIndexVector* non_zeros) const {
+    RETURN_IF_NULL(y);
+    const size_t initial_size = non_zeros->size();
+    for (int i = elementary_matrices_.size() - 1; i >= 0; --i) {
+      elementary_matrices_[i].LeftSolveWithNonZeros(y, non_zeros);
+    }
+    RemoveDuplicatesIfGrown(initial_size, non_zeros);
+  }
+  void RightSolveWithNonZeros(DenseColumn* d, RowIndexVector* non_zeros) const {
+    RETURN_IF_NULL(d);
+    const size_t initial_size = non_zeros->size();
+    const size_t end = elementary_matrices_.size();
+    for (int i = 0; i < end; ++i) {
+      elementary_matrices_[i].RightSolveWithNonZeros(d, non_zeros);
+    }
+    RemoveDuplicatesIfGrown(initial_size, non_zeros);
+  }
+
   EntryIndex num_entries() const { return num_entries_; }
 
  private:
+  template <typename IndexType>
+  static void RemoveDuplicatesIfGrown(size_t initial_size,
+                                      std::vector<IndexType>* non_zeros) {
+    if (non_zeros->size() == initial_size) return;
+    std::sort(non_zeros->begin(), non_zeros->end());
+    non_zeros->erase(std::unique(non_zeros->begin(), non_zeros->end()),
+                     non_zeros->end());
+  }
+
   EntryIndex num_entries_;
   std::vector<RankOneUpdateElementaryMatrix> elementary_matrices_;
   DISALLOW_COPY_AND_ASSIGN(RankOneUpdateFactorization);
@@ -298,7 +298,6 @@ void ReducedCosts::ComputeReducedCosts() {
   if (recompute_basic_objective_left_inverse_) {
     ComputeBasicObjectiveLeftInverse();
   }
-  Fractional dual_residual_error(0.0);
   const ColIndex num_cols = matrix_.num_cols();
 
   reduced_costs_.resize(num_cols, 0.0);
@@ -313,18 +312,11 @@ void ReducedCosts::ComputeReducedCosts() {
       reduced_costs_[col] =
           objective_[col] + objective_perturbation_[col] -
           matrix_.ColumnScalarProduct(col, basic_objective_left_inverse_);
-
-      // We also compute the dual residual error y.B - c_B.
-      if (is_basic.IsSet(col)) {
-        dual_residual_error =
-            std::max(dual_residual_error, fabs(reduced_costs_[col]));
-      }
     }
   } else {
 #ifdef OMP
     // In the multi-threaded case, perform the same computation as in the
     // single-threaded case above.
-    std::vector<Fractional> thread_local_dual_residual_error(num_omp_threads, 0.0);
     const int parallel_loop_size = num_cols.value();
 #pragma omp parallel for num_threads(num_omp_threads)
     for (int i = 0; i < parallel_loop_size; i++) {
@@ -332,21 +324,16 @@ void ReducedCosts::ComputeReducedCosts() {
       reduced_costs_[col] =
           objective_[col] + objective_perturbation_[col] -
           matrix_.ColumnScalarProduct(col, basic_objective_left_inverse_);
-
-      if (is_basic.IsSet(col)) {
-        thread_local_dual_residual_error[omp_get_thread_num()] =
-            std::max(thread_local_dual_residual_error[omp_get_thread_num()],
-                fabs(reduced_costs_[col]));
-      }
     }
     // end of omp parallel for
-    for (int i = 0; i < num_omp_threads; i++) {
-      dual_residual_error =
-          std::max(dual_residual_error, thread_local_dual_residual_error[i]);
-    }
 #endif  // OMP
   }
 
+  // We also compute the dual residual error y.B - c_B. This is done in a
+  // separate vectorized pass so the loop above stays branch-free.
+  const Fractional dual_residual_error =
+      MaskedInfinityNorm(reduced_costs_, is_basic);
+
   recompute_reduced_costs_ = false;
   are_reduced_costs_recomputed_ = true;
   are_reduced_costs_precise_ = basis_factorization_.IsRefactorized();
@@ -27,6 +27,7 @@
 #include "base/stringprintf.h"
 #include "base/timer.h"
 #include "glop/initial_basis.h"
+#include "glop/parallel_utils.h"
 #include "glop/parameters.pb.h"
 #include "lp_data/lp_data.h"
 #include "lp_data/lp_print_utils.h"
@@ -91,6 +92,10 @@ RevisedSimplex::RevisedSimplex()
       total_time_(0.0),
       feasibility_time_(0.0),
       optimization_time_(0.0),
+      pricing_time_(0.0),
+      update_row_time_(0.0),
+      ratio_test_time_(0.0),
+      edge_norms_time_(0.0),
       iteration_stats_(),
       ratio_test_stats_(),
       function_stats_("SimplexFunctionStats"),
@@ -135,6 +140,10 @@ Status RevisedSimplex::Solve(const LinearProgram& lp) {
   num_optimization_iterations_ = 0;
   feasibility_time_ = 0.0;
   optimization_time_ = 0.0;
+  pricing_time_ = 0.0;
+  update_row_time_ = 0.0;
+  ratio_test_time_ = 0.0;
+  edge_norms_time_ = 0.0;
   total_time_ = 0.0;
 
   if (FLAGS_v > 0) {
@@ -331,11 +340,17 @@ std::string RevisedSimplex::GetPrettySolverStats() const {
       "Number of iterations for solvability         : %llu\n"
       "Time for optimization                        : %-6.4g\n"
       "Number of iterations for optimization        : %llu\n"
+      "Time for pricing                             : %-6.4g\n"
+      "Time for update row                          : %-6.4g\n"
+      "Time for ratio test                          : %-6.4g\n"
+      "Time for edge norms                          : %-6.4g\n"
+      "Number of threads                            : %d\n"
       "Stop after first basis                       : %d\n",
       GetProblemStatusString(problem_status_).c_str(), total_time_,
       num_iterations_, feasibility_time_, num_feasibility_iterations_,
-      optimization_time_, num_optimization_iterations_,
-      FLAGS_simplex_stop_after_first_basis);
+      optimization_time_, num_optimization_iterations_, pricing_time_,
+      update_row_time_, ratio_test_time_, edge_norms_time_,
+      parameters_.num_omp_threads(), FLAGS_simplex_stop_after_first_basis);
 }
 
 double RevisedSimplex::DeterministicTime() const {
@@ -871,6 +886,50 @@ Status RevisedSimplex::InitializeFirstBasis(const RowToColMapping& basis) {
   return Status::OK;
 }
 
+Status RevisedSimplex::InitializeFirstBasisFromWarmStart() {
+  RowToColMapping candidates;
+  for (const ColIndex col : variables_info_.GetIsBasicBitRow()) {
+    candidates.push_back(col);
+  }
+  MatrixView candidate_matrix;
+  candidate_matrix.PopulateFromBasis(matrix_with_slack_, candidates);
+
+  // Note that if the candidate columns are dependent, the returned status
+  // reports it but the permutations are still valid: they describe a maximum
+  // set of independent columns and the rows they cover.
+  Markowitz markowitz;
+  markowitz.SetParameters(parameters_);
+  RowPermutation row_perm;
+  ColumnPermutation col_perm;
+  const Status status = markowitz.ComputeRowAndColumnPermutation(
+      candidate_matrix, &row_perm, &col_perm);
+  if (!status.ok()) {
+    VLOG(1) << "The warm-start basis is singular, it will be completed with "
+               "slack columns.";
+  }
+
+  // Each kept column goes to the row that has the same pivot index.
+  RowToColMapping basis(num_rows_, kInvalidCol);
+  StrictITIVector<ColIndex, RowIndex> pivot_row(candidate_matrix.num_cols(),
+                                                kInvalidRow);
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    if (row_perm[row] != kInvalidRow &&
+        RowToColIndex(row_perm[row]) < pivot_row.size()) {
+      pivot_row[RowToColIndex(row_perm[row])] = row;
+    }
+  }
+  for (ColIndex i(0); i < candidate_matrix.num_cols(); ++i) {
+    const ColIndex col = candidates[ColToRowIndex(i)];
+    if (col_perm[i] == kInvalidCol || pivot_row[col_perm[i]] == kInvalidRow) {
+      SetNonBasicVariableStatusAndDeriveValue(
+          col, ComputeDefaultVariableStatus(col));
+    } else {
+      basis[pivot_row[col_perm[i]]] = col;
+    }
+  }
+  return InitializeFirstBasis(basis);
+}
+
 Status RevisedSimplex::Initialize(const LinearProgram& lp) {
   parameters_ = initial_parameters_;
   PropagateParameters();
@@ -918,17 +977,27 @@ Status RevisedSimplex::Initialize(const LinearProgram& lp) {
     // works with an initial identity basis).
     // TODO(user): This is no longer true, change this.
     //
-    // Currently, a warm-start is performed only if the previous solve state was
+    // Currently, a warm-start is performed only if the state was given by
+    // LoadStateForNextSolve(), or if the previous solve state was
     // primal-feasible and only the cost changed.
     if (!parameters_.use_dual_simplex()) {
       // First, always clear the dual norms and the dual_pricing_vector_.
       dual_edge_norms_.Clear();
       dual_pricing_vector_.clear();
 
-      if (is_matrix_unchanged && are_bounds_unchanged &&
-          (problem_status_ == ProblemStatus::OPTIMAL ||
-           problem_status_ == ProblemStatus::PRIMAL_UNBOUNDED ||
-           problem_status_ == ProblemStatus::PRIMAL_FEASIBLE)) {
+      if (solution_state_has_been_set_externally_) {
+        // The phase I of the primal simplex takes care of the basic variables
+        // that are not within their bounds.
+        InitializeVariableStatusesForWarmStart(solution_state_);
+        if (InitializeFirstBasisFromWarmStart().ok()) {
+          primal_edge_norms_.Clear();
+          reduced_costs_.ClearAndRemoveCostShifts();
+          solve_from_scratch = false;
+        }
+      } else if (is_matrix_unchanged && are_bounds_unchanged &&
+                 (problem_status_ == ProblemStatus::OPTIMAL ||
+                  problem_status_ == ProblemStatus::PRIMAL_UNBOUNDED ||
+                  problem_status_ == ProblemStatus::PRIMAL_FEASIBLE)) {
         reduced_costs_.ClearAndRemoveCostShifts();
         solve_from_scratch = false;
       }
@@ -1191,6 +1260,45 @@ template <bool is_entering_reduced_cost_positive>
 Fractional RevisedSimplex::ComputeHarrisRatioAndLeavingCandidates(
     Fractional bound_flip_ratio, SparseColumn* leaving_candidates) const {
   SCOPED_TIME_STAT(&function_stats_);
+  leaving_candidates->Clear();
+  const int num_positions = direction_non_zero_.size();
+  const int num_chunks = NumberOfParallelChunks(parameters_, num_positions);
+  if (num_chunks == 1) {
+    return ComputeHarrisRatioAndLeavingCandidatesOnChunk<
+        is_entering_reduced_cost_positive>(0, num_positions, bound_flip_ratio,
+                                           leaving_candidates);
+  }
+
+  // Each chunk starts with bound_flip_ratio and may thus keep a few more
+  // candidates than the sequential loop, but the final harris ratio (the
+  // minimum over the chunks) is exactly the same. The extra candidates all
+  // have a ratio greater than it and are ignored by the caller.
+  std::vector<SparseColumn> chunk_candidates(num_chunks);
+  std::vector<Fractional> chunk_harris_ratio(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    chunk_harris_ratio[chunk] = ComputeHarrisRatioAndLeavingCandidatesOnChunk<
+        is_entering_reduced_cost_positive>(
+        ChunkStart(num_positions, num_chunks, chunk),
+        ChunkStart(num_positions, num_chunks, chunk + 1), bound_flip_ratio,
+        &chunk_candidates[chunk]);
+  }
+  Fractional harris_ratio = bound_flip_ratio;
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    harris_ratio = std::min(harris_ratio, chunk_harris_ratio[chunk]);
+    for (const SparseColumn::Entry e : chunk_candidates[chunk]) {
+      leaving_candidates->SetCoefficient(e.row(), e.coefficient());
+    }
+  }
+  return harris_ratio;
+}
+
+template <bool is_entering_reduced_cost_positive>
+Fractional RevisedSimplex::ComputeHarrisRatioAndLeavingCandidatesOnChunk(
+    int begin, int end, Fractional bound_flip_ratio,
+    SparseColumn* leaving_candidates) const {
   const Fractional harris_tolerance =
       parameters_.harris_tolerance_ratio() *
       parameters_.primal_feasibility_tolerance();
@@ -1201,9 +1309,9 @@ Fractional RevisedSimplex::ComputeHarrisRatioAndLeavingCandidates(
   // bound_flip_ratio since it seems to be always better to choose the
   // bound-flip over such leaving variable.
   Fractional harris_ratio = bound_flip_ratio;
-  leaving_candidates->Clear();
   const Fractional threshold = parameters_.ratio_test_zero_threshold();
-  for (const RowIndex row : direction_non_zero_) {
+  for (int i = begin; i < end; ++i) {
+    const RowIndex row = direction_non_zero_[i];
     const Fractional magnitude = fabs(direction_[row]);
     if (magnitude < threshold) continue;
     Fractional ratio = GetRatio<is_entering_reduced_cost_positive>(row);
@@ -2070,8 +2178,11 @@ Status RevisedSimplex::Minimize(TimeLimit* time_limit) {
 
     Fractional reduced_cost = 0.0;
     ColIndex entering_col = kInvalidCol;
-    RETURN_IF_ERROR(
-        entering_variable_.PrimalChooseEnteringColumn(&entering_col));
+    {
+      ScopedWallTime pricing_timer(&pricing_time_);
+      RETURN_IF_ERROR(
+          entering_variable_.PrimalChooseEnteringColumn(&entering_col));
+    }
     if (entering_col == kInvalidCol) {
       if (reduced_costs_.AreReducedCostsPrecise() &&
           basis_factorization_.IsRefactorized()) {
@@ -2129,14 +2240,17 @@ Status RevisedSimplex::Minimize(TimeLimit* time_limit) {
     Fractional step_length;
     RowIndex leaving_row;
     Fractional target_bound;
-    if (feasibility_phase_) {
-      PrimalPhaseIChooseLeavingVariableRow(entering_col, reduced_cost,
-                                           &refactorize, &leaving_row,
-                                           &step_length, &target_bound);
-    } else {
-      RETURN_IF_ERROR(ChooseLeavingVariableRow(entering_col, reduced_cost,
-                                               &refactorize, &leaving_row,
-                                               &step_length, &target_bound));
+    {
+      ScopedWallTime ratio_test_timer(&ratio_test_time_);
+      if (feasibility_phase_) {
+        PrimalPhaseIChooseLeavingVariableRow(entering_col, reduced_cost,
+                                             &refactorize, &leaving_row,
+                                             &step_length, &target_bound);
+      } else {
+        RETURN_IF_ERROR(ChooseLeavingVariableRow(entering_col, reduced_cost,
+                                                 &refactorize, &leaving_row,
+                                                 &step_length, &target_bound));
+      }
     }
     if (refactorize) continue;
 
@@ -2213,10 +2327,13 @@ Status RevisedSimplex::Minimize(TimeLimit* time_limit) {
         ScatteredColumnReference(direction_, direction_non_zero_), entering_col,
         step);
     if (leaving_row != kInvalidRow) {
-      primal_edge_norms_.UpdateBeforeBasisPivot(
-          entering_col, basis_[leaving_row], leaving_row,
-          ScatteredColumnReference(direction_, direction_non_zero_),
-          &update_row_);
+      {
+        ScopedWallTime edge_norms_timer(&edge_norms_time_);
+        primal_edge_norms_.UpdateBeforeBasisPivot(
+            entering_col, basis_[leaving_row], leaving_row,
+            ScatteredColumnReference(direction_, direction_non_zero_),
+            &update_row_);
+      }
       reduced_costs_.UpdateBeforeBasisPivot(entering_col, leaving_row,
                                             direction_, &update_row_);
       if (!is_degenerate) {
@@ -2386,12 +2503,15 @@ Status RevisedSimplex::DualMinimize(TimeLimit* time_limit) {
         }
       }
 
-      if (feasibility_phase_) {
-        RETURN_IF_ERROR(DualPhaseIChooseLeavingVariableRow(
-            &leaving_row, &cost_variation, &target_bound));
-      } else {
-        RETURN_IF_ERROR(DualChooseLeavingVariableRow(
-            &leaving_row, &cost_variation, &target_bound));
+      {
+        ScopedWallTime pricing_timer(&pricing_time_);
+        if (feasibility_phase_) {
+          RETURN_IF_ERROR(DualPhaseIChooseLeavingVariableRow(
+              &leaving_row, &cost_variation, &target_bound));
+        } else {
+          RETURN_IF_ERROR(DualChooseLeavingVariableRow(
+              &leaving_row, &cost_variation, &target_bound));
+        }
       }
       if (leaving_row == kInvalidRow) {
         if (!basis_factorization_.IsRefactorized()) {
@@ -2416,15 +2536,21 @@ Status RevisedSimplex::DualMinimize(TimeLimit* time_limit) {
         return Status::OK;
       }
 
-      update_row_.ComputeUpdateRow(leaving_row);
-      if (feasibility_phase_) {
-        RETURN_IF_ERROR(entering_variable_.DualPhaseIChooseEnteringColumn(
-            update_row_, cost_variation, &entering_col, &entering_coeff,
-            &ratio));
-      } else {
-        RETURN_IF_ERROR(entering_variable_.DualChooseEnteringColumn(
-            update_row_, cost_variation, &bound_flip_candidates, &entering_col,
-            &entering_coeff, &ratio));
+      {
+        ScopedWallTime update_row_timer(&update_row_time_);
+        update_row_.ComputeUpdateRow(leaving_row);
+      }
+      {
+        ScopedWallTime ratio_test_timer(&ratio_test_time_);
+        if (feasibility_phase_) {
+          RETURN_IF_ERROR(entering_variable_.DualPhaseIChooseEnteringColumn(
+              update_row_, cost_variation, &entering_col, &entering_coeff,
+              &ratio));
+        } else {
+          RETURN_IF_ERROR(entering_variable_.DualChooseEnteringColumn(
+              update_row_, cost_variation, &bound_flip_candidates,
+              &entering_col, &entering_coeff, &ratio));
+        }
       }
 
       // No entering_col: Unbounded problem / Infeasible problem.
@@ -2519,10 +2645,13 @@ Status RevisedSimplex::DualMinimize(TimeLimit* time_limit) {
 
     reduced_costs_.UpdateBeforeBasisPivot(entering_col, leaving_row, direction_,
                                           &update_row_);
-    dual_edge_norms_.UpdateBeforeBasisPivot(
-        entering_col, leaving_row,
-        ScatteredColumnReference(direction_, direction_non_zero_),
-        update_row_.GetUnitRowLeftInverse());
+    {
+      ScopedWallTime edge_norms_timer(&edge_norms_time_);
+      dual_edge_norms_.UpdateBeforeBasisPivot(
+          entering_col, leaving_row,
+          ScatteredColumnReference(direction_, direction_non_zero_),
+          update_row_.GetUnitRowLeftInverse());
+    }
 
     // It is important to do the actual pivot after the update above!
     const ColIndex leaving_col = basis_[leaving_row];
@@ -326,6 +326,12 @@ class RevisedSimplex {
   Status InitializeFirstBasis(const RowToColMapping& initial_basis)
       MUST_USE_RESULT;
 
+  // Sets the initial basis to the basic variables of a warm-start state given
+  // by InitializeVariableStatusesForWarmStart(). Only a maximum set of linearly
+  // independent basic columns is kept (the other ones are made non-basic) and
+  // the basis is completed with slack columns.
+  Status InitializeFirstBasisFromWarmStart() MUST_USE_RESULT;
+
   // Entry point for the solver initialization.
   Status Initialize(const LinearProgram& lp) MUST_USE_RESULT;
 
@@ -394,6 +400,14 @@ class RevisedSimplex {
   Fractional ComputeHarrisRatioAndLeavingCandidates(
       Fractional bound_flip_ratio, SparseColumn* leaving_candidates) const;
 
+  // Same as ComputeHarrisRatioAndLeavingCandidates() but only for the
+  // positions [begin, end) of direction_non_zero_. The given leaving_candidates
+  // are not cleared. This is the unit of work of the parallel version.
+  template <bool is_entering_reduced_cost_positive>
+  Fractional ComputeHarrisRatioAndLeavingCandidatesOnChunk(
+      int begin, int end, Fractional bound_flip_ratio,
+      SparseColumn* leaving_candidates) const;
+
   // Chooses the leaving variable, considering the entering column and its
   // associated reduced cost. If there was a precision issue and the basis is
   // not refactorized, set refactorize to true. Otherwise, the row number of the
@@ -662,6 +676,13 @@ class RevisedSimplex {
   // Time spent in the second (optimization) phase.
   double optimization_time_;
 
+  // Time spent in the main kernels of an iteration, for both phases. These are
+  // the loops that are split across the num_omp_threads threads.
+  double pricing_time_;
+  double update_row_time_;
+  double ratio_test_time_;
+  double edge_norms_time_;
+
   // Statistics about the iterations done by Minimize().
   struct IterationStats : public StatsGroup {
     IterationStats()
@@ -0,0 +1,614 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lp_data/dense_vector_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/logging.h"
+#include "lp_data/lp_utils.h"
+#include "util/bitset.h"
+
+// The SIMD kernels are compiled with the target attribute of gcc and clang so
+// that the rest of the code does not depend on the compilation flags, and the
+// instruction set is chosen at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GLOP_X86_KERNELS
+#include <immintrin.h>
+#if defined(__clang__) || __GNUC__ >= 5
+#define GLOP_AVX512_KERNELS
+#endif
+#endif
+
+// The multiplications and additions must not be fused, otherwise the results
+// would depend on the instruction set (AVX-512F has fused multiply-add).
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+// Number of partial sums of the kernels, see the comment on
+// DenseVectorKernels.
+const int kNumLanes = 8;
+
+// Number of entries covered by one bucket of a mask.
+const int kMaskBucketSize = 64;
+
+// ---------------------------------------------------------------------------
+// Scalar kernels. They are also used to finish the SIMD kernels, so that all
+// the instruction sets give the same results.
+// ---------------------------------------------------------------------------
+
+// Returns the pairwise sum of the kNumLanes partial sums.
+Fractional SumLanes(const Fractional* lanes) {
+  return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) +
+         ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+Fractional MaxLanes(const Fractional* lanes) {
+  Fractional result = 0.0;
+  for (int j = 0; j < kNumLanes; ++j) result = std::max(result, lanes[j]);
+  return result;
+}
+
+// Adds the last n entries of a scalar product to its partial sums.
+Fractional FinishScalarProduct(const Fractional* lanes, const Fractional* u,
+                               const Fractional* v, int n) {
+  Fractional sum = SumLanes(lanes);
+  for (int i = 0; i < n; ++i) sum += u[i] * v[i];
+  return sum;
+}
+
+// Same as FinishScalarProduct() for the precise version. sums and errors are
+// the states of the AccurateSum of each lane.
+Fractional FinishPreciseScalarProduct(const Fractional* sums,
+                                      const Fractional* errors,
+                                      const Fractional* u, const Fractional* v,
+                                      int n) {
+  KahanSum sum;
+  for (int j = 0; j < kNumLanes; ++j) sum.Add(sums[j]);
+  for (int j = 0; j < kNumLanes; ++j) sum.Add(errors[j]);
+  for (int i = 0; i < n; ++i) sum.Add(u[i] * v[i]);
+  return sum.Value();
+}
+
+Fractional FinishInfinityNorm(Fractional infinity_norm, const Fractional* v,
+                              int n) {
+  for (int i = 0; i < n; ++i) {
+    infinity_norm = std::max(infinity_norm, fabs(v[i]));
+  }
+  return infinity_norm;
+}
+
+// Same as FinishInfinityNorm() on the entries of v from begin to end, with the
+// mask of the whole vector.
+Fractional FinishMaskedInfinityNorm(Fractional infinity_norm,
+                                    const Fractional* v, const uint64* mask,
+                                    int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    if ((mask[i / kMaskBucketSize] >> (i % kMaskBucketSize)) & 1) {
+      infinity_norm = std::max(infinity_norm, fabs(v[i]));
+    }
+  }
+  return infinity_norm;
+}
+
+void AddMultipleScalar(Fractional a, const Fractional* x, int n,
+                       Fractional* y) {
+  for (int i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+Fractional ScalarProductScalar(const Fractional* u, const Fractional* v,
+                               int n) {
+  Fractional lanes[kNumLanes] = {0.0};
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    for (int j = 0; j < kNumLanes; ++j) lanes[j] += u[i + j] * v[i + j];
+  }
+  return FinishScalarProduct(lanes, u + end, v + end, n - end);
+}
+
+Fractional PreciseScalarProductScalar(const Fractional* u, const Fractional* v,
+                                      int n) {
+  // This is AccurateSum::Add() on each lane.
+  Fractional sums[kNumLanes] = {0.0};
+  Fractional errors[kNumLanes] = {0.0};
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    for (int j = 0; j < kNumLanes; ++j) {
+      errors[j] += u[i + j] * v[i + j];
+      const Fractional new_sum = sums[j] + errors[j];
+      errors[j] += sums[j] - new_sum;
+      sums[j] = new_sum;
+    }
+  }
+  return FinishPreciseScalarProduct(sums, errors, u + end, v + end, n - end);
+}
+
+Fractional InfinityNormScalar(const Fractional* v, int n) {
+  return FinishInfinityNorm(0.0, v, n);
+}
+
+Fractional MaskedInfinityNormScalar(const Fractional* v, const uint64* mask,
+                                    int n) {
+  return FinishMaskedInfinityNorm(0.0, v, mask, 0, n);
+}
+
+const DenseVectorKernels kScalarKernels = {
+    SimdInstructionSet::SCALAR, &AddMultipleScalar, &ScalarProductScalar,
+    &PreciseScalarProductScalar, &InfinityNormScalar,
+    &MaskedInfinityNormScalar};
+
+#if defined(GLOP_X86_KERNELS)
+
+// For the kernels below, the absolute value is computed by clearing the sign
+// bit and the maximum with max(|v[i]|, current maximum) which returns the
+// current maximum if v[i] is a NaN, like std::max(current maximum, |v[i]|).
+// The masked kernels clear the entries that are not in the mask, which is
+// fine since the maximum is always non-negative.
+const int64 kAllBitsButSign = GG_LONGLONG(0x7FFFFFFFFFFFFFFF);
+
+// ---------------------------------------------------------------------------
+// SSE2 kernels, the 8 lanes are in 4 registers of 2 entries.
+// ---------------------------------------------------------------------------
+
+#define GLOP_TARGET_SSE2 __attribute__((target("sse2")))
+
+// The masks for 2 consecutive entries, indexed by their 2 bits of the mask.
+const int64 kSse2LaneMasks[4][2] __attribute__((aligned(16))) = {
+    {0, 0}, {-1, 0}, {0, -1}, {-1, -1}};
+
+GLOP_TARGET_SSE2 void AddMultipleSse2(Fractional a, const Fractional* x, int n,
+                                      Fractional* y) {
+  const __m128d multiplier = _mm_set1_pd(a);
+  const int end = n - n % 2;
+  for (int i = 0; i < end; i += 2) {
+    const __m128d product = _mm_mul_pd(multiplier, _mm_loadu_pd(x + i));
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), product));
+  }
+  AddMultipleScalar(a, x + end, n - end, y + end);
+}
+
+// Returns the product of the 2 entries of u and v starting at i.
+GLOP_TARGET_SSE2 inline __m128d ProductSse2(const Fractional* u,
+                                            const Fractional* v, int i) {
+  return _mm_mul_pd(_mm_loadu_pd(u + i), _mm_loadu_pd(v + i));
+}
+
+// AccurateSum::Add() on 2 lanes.
+GLOP_TARGET_SSE2 inline void AccurateAddSse2(__m128d value, __m128d* sum,
+                                             __m128d* error) {
+  *error = _mm_add_pd(*error, value);
+  const __m128d new_sum = _mm_add_pd(*sum, *error);
+  *error = _mm_add_pd(*error, _mm_sub_pd(*sum, new_sum));
+  *sum = new_sum;
+}
+
+GLOP_TARGET_SSE2 inline void StoreLanesSse2(__m128d a, __m128d b, __m128d c,
+                                            __m128d d, Fractional* lanes) {
+  _mm_storeu_pd(lanes, a);
+  _mm_storeu_pd(lanes + 2, b);
+  _mm_storeu_pd(lanes + 4, c);
+  _mm_storeu_pd(lanes + 6, d);
+}
+
+GLOP_TARGET_SSE2 Fractional ScalarProductSse2(const Fractional* u,
+                                              const Fractional* v, int n) {
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  __m128d sum2 = _mm_setzero_pd();
+  __m128d sum3 = _mm_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    sum0 = _mm_add_pd(sum0, ProductSse2(u, v, i));
+    sum1 = _mm_add_pd(sum1, ProductSse2(u, v, i + 2));
+    sum2 = _mm_add_pd(sum2, ProductSse2(u, v, i + 4));
+    sum3 = _mm_add_pd(sum3, ProductSse2(u, v, i + 6));
+  }
+  Fractional lanes[kNumLanes];
+  StoreLanesSse2(sum0, sum1, sum2, sum3, lanes);
+  return FinishScalarProduct(lanes, u + end, v + end, n - end);
+}
+
+GLOP_TARGET_SSE2 Fractional PreciseScalarProductSse2(const Fractional* u,
+                                                     const Fractional* v,
+                                                     int n) {
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  __m128d sum2 = _mm_setzero_pd();
+  __m128d sum3 = _mm_setzero_pd();
+  __m128d error0 = _mm_setzero_pd();
+  __m128d error1 = _mm_setzero_pd();
+  __m128d error2 = _mm_setzero_pd();
+  __m128d error3 = _mm_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    AccurateAddSse2(ProductSse2(u, v, i), &sum0, &error0);
+    AccurateAddSse2(ProductSse2(u, v, i + 2), &sum1, &error1);
+    AccurateAddSse2(ProductSse2(u, v, i + 4), &sum2, &error2);
+    AccurateAddSse2(ProductSse2(u, v, i + 6), &sum3, &error3);
+  }
+  Fractional sums[kNumLanes];
+  Fractional errors[kNumLanes];
+  StoreLanesSse2(sum0, sum1, sum2, sum3, sums);
+  StoreLanesSse2(error0, error1, error2, error3, errors);
+  return FinishPreciseScalarProduct(sums, errors, u + end, v + end, n - end);
+}
+
+// Returns max(|v[i]| & lane_mask, max) on 2 lanes. abs_mask must be the
+// sign-clearing mask and lane_mask a subset of it.
+GLOP_TARGET_SSE2 inline __m128d MaxAbsSse2(const Fractional* v, int i,
+                                           __m128d lane_mask, __m128d max) {
+  return _mm_max_pd(_mm_and_pd(_mm_loadu_pd(v + i), lane_mask), max);
+}
+
+GLOP_TARGET_SSE2 Fractional InfinityNormSse2(const Fractional* v, int n) {
+  const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(kAllBitsButSign));
+  __m128d max0 = _mm_setzero_pd();
+  __m128d max1 = _mm_setzero_pd();
+  __m128d max2 = _mm_setzero_pd();
+  __m128d max3 = _mm_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    max0 = MaxAbsSse2(v, i, abs_mask, max0);
+    max1 = MaxAbsSse2(v, i + 2, abs_mask, max1);
+    max2 = MaxAbsSse2(v, i + 4, abs_mask, max2);
+    max3 = MaxAbsSse2(v, i + 6, abs_mask, max3);
+  }
+  Fractional lanes[kNumLanes];
+  StoreLanesSse2(max0, max1, max2, max3, lanes);
+  return FinishInfinityNorm(MaxLanes(lanes), v + end, n - end);
+}
+
+GLOP_TARGET_SSE2 Fractional MaskedInfinityNormSse2(const Fractional* v,
+                                                   const uint64* mask, int n) {
+  const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(kAllBitsButSign));
+  __m128d max0 = _mm_setzero_pd();
+  __m128d max1 = _mm_setzero_pd();
+  const int num_buckets = n / kMaskBucketSize;
+  for (int b = 0; b < num_buckets; ++b) {
+    uint64 bucket = mask[b];
+    if (bucket == 0) continue;
+    const Fractional* block = v + b * kMaskBucketSize;
+    if (bucket == kAllBits64) {
+      for (int i = 0; i < kMaskBucketSize; i += 4) {
+        max0 = MaxAbsSse2(block, i, abs_mask, max0);
+        max1 = MaxAbsSse2(block, i + 2, abs_mask, max1);
+      }
+      continue;
+    }
+    for (int i = 0; i < kMaskBucketSize; i += 4, bucket >>= 4) {
+      const __m128d lane_mask0 = _mm_and_pd(
+          abs_mask, _mm_load_pd(reinterpret_cast<const double*>(
+                        kSse2LaneMasks[bucket & 3])));
+      const __m128d lane_mask1 = _mm_and_pd(
+          abs_mask, _mm_load_pd(reinterpret_cast<const double*>(
+                        kSse2LaneMasks[(bucket >> 2) & 3])));
+      max0 = MaxAbsSse2(block, i, lane_mask0, max0);
+      max1 = MaxAbsSse2(block, i + 2, lane_mask1, max1);
+    }
+  }
+  Fractional lanes[kNumLanes];
+  StoreLanesSse2(max0, max1, _mm_setzero_pd(), _mm_setzero_pd(), lanes);
+  return FinishMaskedInfinityNorm(MaxLanes(lanes), v, mask,
+                                  num_buckets * kMaskBucketSize, n);
+}
+
+const DenseVectorKernels kSse2Kernels = {
+    SimdInstructionSet::SSE2, &AddMultipleSse2, &ScalarProductSse2,
+    &PreciseScalarProductSse2, &InfinityNormSse2, &MaskedInfinityNormSse2};
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels, the 8 lanes are in 2 registers of 4 entries.
+// ---------------------------------------------------------------------------
+
+#define GLOP_TARGET_AVX2 __attribute__((target("avx2")))
+
+GLOP_TARGET_AVX2 void AddMultipleAvx2(Fractional a, const Fractional* x, int n,
+                                      Fractional* y) {
+  const __m256d multiplier = _mm256_set1_pd(a);
+  const int end = n - n % 4;
+  for (int i = 0; i < end; i += 4) {
+    const __m256d product = _mm256_mul_pd(multiplier, _mm256_loadu_pd(x + i));
+    _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), product));
+  }
+  AddMultipleScalar(a, x + end, n - end, y + end);
+}
+
+GLOP_TARGET_AVX2 inline __m256d ProductAvx2(const Fractional* u,
+                                            const Fractional* v, int i) {
+  return _mm256_mul_pd(_mm256_loadu_pd(u + i), _mm256_loadu_pd(v + i));
+}
+
+GLOP_TARGET_AVX2 inline void AccurateAddAvx2(__m256d value, __m256d* sum,
+                                             __m256d* error) {
+  *error = _mm256_add_pd(*error, value);
+  const __m256d new_sum = _mm256_add_pd(*sum, *error);
+  *error = _mm256_add_pd(*error, _mm256_sub_pd(*sum, new_sum));
+  *sum = new_sum;
+}
+
+GLOP_TARGET_AVX2 Fractional ScalarProductAvx2(const Fractional* u,
+                                              const Fractional* v, int n) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    sum0 = _mm256_add_pd(sum0, ProductAvx2(u, v, i));
+    sum1 = _mm256_add_pd(sum1, ProductAvx2(u, v, i + 4));
+  }
+  Fractional lanes[kNumLanes];
+  _mm256_storeu_pd(lanes, sum0);
+  _mm256_storeu_pd(lanes + 4, sum1);
+  return FinishScalarProduct(lanes, u + end, v + end, n - end);
+}
+
+GLOP_TARGET_AVX2 Fractional PreciseScalarProductAvx2(const Fractional* u,
+                                                     const Fractional* v,
+                                                     int n) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  __m256d error0 = _mm256_setzero_pd();
+  __m256d error1 = _mm256_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    AccurateAddAvx2(ProductAvx2(u, v, i), &sum0, &error0);
+    AccurateAddAvx2(ProductAvx2(u, v, i + 4), &sum1, &error1);
+  }
+  Fractional sums[kNumLanes];
+  Fractional errors[kNumLanes];
+  _mm256_storeu_pd(sums, sum0);
+  _mm256_storeu_pd(sums + 4, sum1);
+  _mm256_storeu_pd(errors, error0);
+  _mm256_storeu_pd(errors + 4, error1);
+  return FinishPreciseScalarProduct(sums, errors, u + end, v + end, n - end);
+}
+
+GLOP_TARGET_AVX2 inline __m256d MaxAbsAvx2(const Fractional* v, int i,
+                                           __m256d lane_mask, __m256d max) {
+  return _mm256_max_pd(_mm256_and_pd(_mm256_loadu_pd(v + i), lane_mask), max);
+}
+
+// Returns the mask of 4 consecutive entries from the 4 lowest bits of bits.
+GLOP_TARGET_AVX2 inline __m256d LaneMaskAvx2(uint64 bits) {
+  const __m256i lane_bits = _mm256_set_epi64x(8, 4, 2, 1);
+  const __m256i selected =
+      _mm256_and_si256(_mm256_set1_epi64x(bits), lane_bits);
+  return _mm256_castsi256_pd(_mm256_cmpeq_epi64(selected, lane_bits));
+}
+
+GLOP_TARGET_AVX2 Fractional InfinityNormAvx2(const Fractional* v, int n) {
+  const __m256d abs_mask =
+      _mm256_castsi256_pd(_mm256_set1_epi64x(kAllBitsButSign));
+  __m256d max0 = _mm256_setzero_pd();
+  __m256d max1 = _mm256_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    max0 = MaxAbsAvx2(v, i, abs_mask, max0);
+    max1 = MaxAbsAvx2(v, i + 4, abs_mask, max1);
+  }
+  Fractional lanes[kNumLanes];
+  _mm256_storeu_pd(lanes, max0);
+  _mm256_storeu_pd(lanes + 4, max1);
+  return FinishInfinityNorm(MaxLanes(lanes), v + end, n - end);
+}
+
+GLOP_TARGET_AVX2 Fractional MaskedInfinityNormAvx2(const Fractional* v,
+                                                   const uint64* mask, int n) {
+  const __m256d abs_mask =
+      _mm256_castsi256_pd(_mm256_set1_epi64x(kAllBitsButSign));
+  __m256d max0 = _mm256_setzero_pd();
+  __m256d max1 = _mm256_setzero_pd();
+  const int num_buckets = n / kMaskBucketSize;
+  for (int b = 0; b < num_buckets; ++b) {
+    uint64 bucket = mask[b];
+    if (bucket == 0) continue;
+    const Fractional* block = v + b * kMaskBucketSize;
+    if (bucket == kAllBits64) {
+      for (int i = 0; i < kMaskBucketSize; i += kNumLanes) {
+        max0 = MaxAbsAvx2(block, i, abs_mask, max0);
+        max1 = MaxAbsAvx2(block, i + 4, abs_mask, max1);
+      }
+      continue;
+    }
+    for (int i = 0; i < kMaskBucketSize; i += kNumLanes, bucket >>= 8) {
+      max0 = MaxAbsAvx2(block, i,
+                        _mm256_and_pd(abs_mask, LaneMaskAvx2(bucket)), max0);
+      max1 = MaxAbsAvx2(block, i + 4,
+                        _mm256_and_pd(abs_mask, LaneMaskAvx2(bucket >> 4)),
+                        max1);
+    }
+  }
+  Fractional lanes[kNumLanes];
+  _mm256_storeu_pd(lanes, max0);
+  _mm256_storeu_pd(lanes + 4, max1);
+  return FinishMaskedInfinityNorm(MaxLanes(lanes), v, mask,
+                                  num_buckets * kMaskBucketSize, n);
+}
+
+const DenseVectorKernels kAvx2Kernels = {
+    SimdInstructionSet::AVX2, &AddMultipleAvx2, &ScalarProductAvx2,
+    &PreciseScalarProductAvx2, &InfinityNormAvx2, &MaskedInfinityNormAvx2};
+
+#if defined(GLOP_AVX512_KERNELS)
+
+// ---------------------------------------------------------------------------
+// AVX-512 kernels, the 8 lanes are in one register.
+// ---------------------------------------------------------------------------
+
+#define GLOP_TARGET_AVX512 __attribute__((target("avx512f")))
+
+GLOP_TARGET_AVX512 void AddMultipleAvx512(Fractional a, const Fractional* x,
+                                          int n, Fractional* y) {
+  const __m512d multiplier = _mm512_set1_pd(a);
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    const __m512d product = _mm512_mul_pd(multiplier, _mm512_loadu_pd(x + i));
+    _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), product));
+  }
+  AddMultipleScalar(a, x + end, n - end, y + end);
+}
+
+GLOP_TARGET_AVX512 Fractional ScalarProductAvx512(const Fractional* u,
+                                                  const Fractional* v, int n) {
+  __m512d sum = _mm512_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    sum = _mm512_add_pd(
+        sum, _mm512_mul_pd(_mm512_loadu_pd(u + i), _mm512_loadu_pd(v + i)));
+  }
+  Fractional lanes[kNumLanes];
+  _mm512_storeu_pd(lanes, sum);
+  return FinishScalarProduct(lanes, u + end, v + end, n - end);
+}
+
+// AVX-512F has no floating-point "and", so the sign is cleared on integers.
+GLOP_TARGET_AVX512 inline __m512d AbsAvx512(const Fractional* v,
+                                            __m512i abs_mask) {
+  return _mm512_castsi512_pd(
+      _mm512_and_si512(_mm512_castpd_si512(_mm512_loadu_pd(v)), abs_mask));
+}
+
+GLOP_TARGET_AVX512 Fractional InfinityNormAvx512(const Fractional* v, int n) {
+  const __m512i abs_mask = _mm512_set1_epi64(kAllBitsButSign);
+  __m512d max = _mm512_setzero_pd();
+  const int end = n - n % kNumLanes;
+  for (int i = 0; i < end; i += kNumLanes) {
+    max = _mm512_max_pd(AbsAvx512(v + i, abs_mask), max);
+  }
+  Fractional lanes[kNumLanes];
+  _mm512_storeu_pd(lanes, max);
+  return FinishInfinityNorm(MaxLanes(lanes), v + end, n - end);
+}
+
+GLOP_TARGET_AVX512 Fractional MaskedInfinityNormAvx512(const Fractional* v,
+                                                       const uint64* mask,
+                                                       int n) {
+  const __m512i abs_mask = _mm512_set1_epi64(kAllBitsButSign);
+  __m512d max = _mm512_setzero_pd();
+  const int num_buckets = n / kMaskBucketSize;
+  for (int b = 0; b < num_buckets; ++b) {
+    const uint64 bucket = mask[b];
+    if (bucket == 0) continue;
+    const Fractional* block = v + b * kMaskBucketSize;
+    for (int i = 0; i < kMaskBucketSize; i += kNumLanes) {
+      const __mmask8 lane_mask = (bucket >> i) & 255;
+      max = _mm512_mask_max_pd(max, lane_mask, AbsAvx512(block + i, abs_mask),
+                               max);
+    }
+  }
+  Fractional lanes[kNumLanes];
+  _mm512_storeu_pd(lanes, max);
+  return FinishMaskedInfinityNorm(MaxLanes(lanes), v, mask,
+                                  num_buckets * kMaskBucketSize, n);
+}
+
+// With a single register of partial sums, the precise scalar product is
+// bounded by the latency of its 3 dependent additions, so the AVX2 version
+// with 2 independent registers is faster.
+const DenseVectorKernels kAvx512Kernels = {
+    SimdInstructionSet::AVX512, &AddMultipleAvx512, &ScalarProductAvx512,
+    &PreciseScalarProductAvx2, &InfinityNormAvx512, &MaskedInfinityNormAvx512};
+
+#endif  // GLOP_AVX512_KERNELS
+#endif  // GLOP_X86_KERNELS
+
+const DenseVectorKernels* FindBestDenseVectorKernels() {
+  const SimdInstructionSet kInstructionSets[] = {
+      SimdInstructionSet::AVX512, SimdInstructionSet::AVX2,
+      SimdInstructionSet::SSE2};
+  for (const SimdInstructionSet instruction_set : kInstructionSets) {
+    if (IsSimdInstructionSetSupported(instruction_set)) {
+      VLOG(1) << "Using the " << GetSimdInstructionSetString(instruction_set)
+              << " dense vector kernels.";
+      return &GetDenseVectorKernels(instruction_set);
+    }
+  }
+  return &kScalarKernels;
+}
+
+}  // namespace
+
+std::string GetSimdInstructionSetString(SimdInstructionSet instruction_set) {
+  switch (instruction_set) {
+    case SimdInstructionSet::SCALAR:
+      return "SCALAR";
+    case SimdInstructionSet::SSE2:
+      return "SSE2";
+    case SimdInstructionSet::AVX2:
+      return "AVX2";
+    case SimdInstructionSet::AVX512:
+      return "AVX512";
+  }
+  // Fallback. We don't use "default:" so the compiler will return an error
+  // if we forgot one enum case above.
+  return "UNKNOWN SimdInstructionSet";
+}
+
+bool IsSimdInstructionSetSupported(SimdInstructionSet instruction_set) {
+  switch (instruction_set) {
+    case SimdInstructionSet::SCALAR:
+      return true;
+#if defined(GLOP_X86_KERNELS)
+    case SimdInstructionSet::SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case SimdInstructionSet::AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#if defined(GLOP_AVX512_KERNELS)
+    case SimdInstructionSet::AVX512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif  // GLOP_AVX512_KERNELS
+#endif  // GLOP_X86_KERNELS
+    default:
+      return false;
+  }
+}
+
+const DenseVectorKernels& GetDenseVectorKernels(
+    SimdInstructionSet instruction_set) {
+  CHECK(IsSimdInstructionSetSupported(instruction_set))
+      << GetSimdInstructionSetString(instruction_set);
+  switch (instruction_set) {
+#if defined(GLOP_X86_KERNELS)
+    case SimdInstructionSet::SSE2:
+      return kSse2Kernels;
+    case SimdInstructionSet::AVX2:
+      return kAvx2Kernels;
+#if defined(GLOP_AVX512_KERNELS)
+    case SimdInstructionSet::AVX512:
+      return kAvx512Kernels;
+#endif  // GLOP_AVX512_KERNELS
+#endif  // GLOP_X86_KERNELS
+    default:
+      return kScalarKernels;
+  }
+}
+
+const DenseVectorKernels& GetBestDenseVectorKernels() {
+  static const DenseVectorKernels* const kernels =
+      FindBestDenseVectorKernels();
+  return *kernels;
+}
+
+}  // namespace glop
+}  // namespace operations_research
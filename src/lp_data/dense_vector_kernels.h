@@ -0,0 +1,81 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Vectorized kernels for the loops over the dense vectors of Fractional (i.e.
+// DenseRow and DenseColumn) with a runtime dispatch on the instruction set of
+// the CPU. Most of the code should use the functions of lp_utils.h which call
+// GetBestDenseVectorKernels().
+
+#ifndef OR_TOOLS_LP_DATA_DENSE_VECTOR_KERNELS_H_
+#define OR_TOOLS_LP_DATA_DENSE_VECTOR_KERNELS_H_
+
+#include <string>
+
+#include "base/integral_types.h"
+#include "lp_data/lp_types.h"
+
+namespace operations_research {
+namespace glop {
+
+// The instruction sets for which the kernels are implemented, from the least
+// to the most efficient. The SIMD ones are only available on x86 with gcc or
+// clang, SCALAR is always available.
+enum class SimdInstructionSet { SCALAR = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+std::string GetSimdInstructionSetString(SimdInstructionSet instruction_set);
+
+// The kernels for one instruction set. They work on arrays of n entries with no
+// alignment requirement.
+//
+// The sums are computed in the same order for all the instruction sets: entry
+// i is added to the partial sum i % 8 of the first 8 * (n / 8) entries, the
+// 8 partial sums are then added pairwise and the last n % 8 entries are added
+// in order. No fused multiply-add is used, so the results are bitwise
+// identical whatever the instruction set and the solver stays deterministic
+// across machines.
+struct DenseVectorKernels {
+  SimdInstructionSet instruction_set;
+
+  // Does y[i] += a * x[i] for all i.
+  void (*add_multiple)(Fractional a, const Fractional* x, int n, Fractional* y);
+
+  // Returns the sum of the u[i] * v[i]. The precise version uses one KahanSum
+  // per partial sum.
+  Fractional (*scalar_product)(const Fractional* u, const Fractional* v, int n);
+  Fractional (*precise_scalar_product)(const Fractional* u, const Fractional* v,
+                                       int n);
+
+  // Returns the maximum of the |v[i]| (or 0.0 if n is 0). The masked version
+  // only considers the i such that the bit i % 64 of mask[i / 64] is set, i.e.
+  // mask can be the buckets of a Bitset64 of size n.
+  Fractional (*infinity_norm)(const Fractional* v, int n);
+  Fractional (*masked_infinity_norm)(const Fractional* v, const uint64* mask,
+                                     int n);
+};
+
+// Returns true if the kernels for the given instruction set are compiled in
+// and supported by the CPU.
+bool IsSimdInstructionSetSupported(SimdInstructionSet instruction_set);
+
+// Returns the kernels for the given instruction set which must be supported.
+const DenseVectorKernels& GetDenseVectorKernels(
+    SimdInstructionSet instruction_set);
+
+// Returns the kernels for the most efficient supported instruction set. The
+// CPU is only inspected on the first call.
+const DenseVectorKernels& GetBestDenseVectorKernels();
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_LP_DATA_DENSE_VECTOR_KERNELS_H_
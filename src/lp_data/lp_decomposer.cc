@@ -29,6 +29,7 @@ LPDecomposer::LPDecomposer()
     : original_problem_(nullptr),
       clusters_(),
       local_to_global_vars_(),
+      local_to_global_constraints_(),
       mutex_() {}
 
 void LPDecomposer::Decompose(const LinearProgram* linear_problem) {
@@ -36,6 +37,7 @@ void LPDecomposer::Decompose(const LinearProgram* linear_problem) {
   original_problem_ = linear_problem;
   clusters_.clear();
   local_to_global_vars_.clear();
+  local_to_global_constraints_.clear();
 
   const SparseMatrix& transposed_matrix =
       original_problem_->GetTransposeSparseMatrix();
@@ -65,6 +67,7 @@ void LPDecomposer::Decompose(const LinearProgram* linear_problem) {
     std::sort(clusters_[i].begin(), clusters_[i].end());
   }
   local_to_global_vars_.resize(clusters_.size());
+  local_to_global_constraints_.resize(clusters_.size());
 }
 
 int LPDecomposer::GetNumberOfProblems() const {
@@ -91,6 +94,7 @@ void LPDecomposer::BuildProblem(int problem_index, LinearProgram* lp) {
       original_problem_->num_constraints());
   StrictITIVector<ColIndex, ColIndex> local_to_global(ColIndex(cluster.size()),
                                                       kInvalidCol);
+  StrictITIVector<RowIndex, RowIndex> local_to_global_constraints;
   lp->SetMaximizationProblem(original_problem_->IsMaximizationProblem());
 
   // Create variables and get all constraints of the cluster.
@@ -125,6 +129,8 @@ void LPDecomposer::BuildProblem(int problem_index, LinearProgram* lp) {
   for (const RowIndex global_row :
        constraints_to_use.PositionsSetAtLeastOnce()) {
     const RowIndex local_row = lp->CreateNewConstraint();
+    local_to_global_constraints.push_back(global_row);
+    DCHECK_EQ(local_row + 1, local_to_global_constraints.size());
     lp->SetConstraintName(local_row,
                           original_problem_->GetConstraintName(global_row));
     lp->SetConstraintBounds(
@@ -141,6 +147,7 @@ void LPDecomposer::BuildProblem(int problem_index, LinearProgram* lp) {
 
   MutexLock mutex_lock(&mutex_);
   local_to_global_vars_[problem_index] = local_to_global;
+  local_to_global_constraints_[problem_index] = local_to_global_constraints;
 }
 
 DenseRow LPDecomposer::AggregateAssignments(
@@ -162,5 +169,21 @@ DenseRow LPDecomposer::AggregateAssignments(
   return values;
 }
 
+StrictITIVector<ColIndex, ColIndex> LPDecomposer::GetLocalToGlobalVariables(
+    int problem_index) const {
+  MutexLock mutex_lock(&mutex_);
+  CHECK_GE(problem_index, 0);
+  CHECK_LT(problem_index, local_to_global_vars_.size());
+  return local_to_global_vars_[problem_index];
+}
+
+StrictITIVector<RowIndex, RowIndex> LPDecomposer::GetLocalToGlobalConstraints(
+    int problem_index) const {
+  MutexLock mutex_lock(&mutex_);
+  CHECK_GE(problem_index, 0);
+  CHECK_LT(problem_index, local_to_global_constraints_.size());
+  return local_to_global_constraints_[problem_index];
+}
+
 }  // namespace glop
 }  // namespace operations_research
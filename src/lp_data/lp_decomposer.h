@@ -73,10 +73,20 @@ class LPDecomposer {
   DenseRow AggregateAssignments(const std::vector<DenseRow>& assignments) const
       LOCKS_EXCLUDED(mutex_);
 
+  // Returns the mapping from the variables (resp. constraints) of the
+  // problem_index^th problem, as built by BuildProblem(), to the variables
+  // (resp. constraints) of the original problem. BuildProblem() must have
+  // been called for this problem.
+  StrictITIVector<ColIndex, ColIndex> GetLocalToGlobalVariables(
+      int problem_index) const LOCKS_EXCLUDED(mutex_);
+  StrictITIVector<RowIndex, RowIndex> GetLocalToGlobalConstraints(
+      int problem_index) const LOCKS_EXCLUDED(mutex_);
+
  private:
   const LinearProgram* original_problem_;
   std::vector<std::vector<ColIndex>> clusters_;
   std::vector<StrictITIVector<ColIndex, ColIndex>> local_to_global_vars_;
+  std::vector<StrictITIVector<RowIndex, RowIndex>> local_to_global_constraints_;
 
   mutable Mutex mutex_;
 
@@ -47,27 +47,17 @@ Fractional PreciseSquaredNorm(ScatteredColumnReference v) {
 }
 
 Fractional SquaredNorm(const DenseColumn& column) {
-  Fractional sum(0.0);
-  for (RowIndex row(0); row < column.size(); ++row) {
-    sum += Square(column[row]);
-  }
-  return sum;
+  return GetBestDenseVectorKernels().scalar_product(
+      column.data(), column.data(), column.size().value());
 }
 
 Fractional PreciseSquaredNorm(const DenseColumn& column) {
-  KahanSum sum;
-  for (RowIndex row(0); row < column.size(); ++row) {
-    sum.Add(Square(column[row]));
-  }
-  return sum.Value();
+  return GetBestDenseVectorKernels().precise_scalar_product(
+      column.data(), column.data(), column.size().value());
 }
 
 Fractional InfinityNorm(const DenseColumn& v) {
-  Fractional infinity_norm = 0.0;
-  for (RowIndex row(0); row < v.size(); ++row) {
-    infinity_norm = std::max(infinity_norm, fabs(v[row]));
-  }
-  return infinity_norm;
+  return GetBestDenseVectorKernels().infinity_norm(v.data(), v.size().value());
 }
 
 Fractional InfinityNorm(const SparseColumn& v) {
@@ -78,6 +68,12 @@ Fractional InfinityNorm(const SparseColumn& v) {
   return infinity_norm;
 }
 
+Fractional MaskedInfinityNorm(const DenseRow& v, const DenseBitRow& mask) {
+  DCHECK_EQ(v.size(), mask.size());
+  return GetBestDenseVectorKernels().masked_infinity_norm(
+      v.data(), mask.buckets(), v.size().value());
+}
+
 double Density(const DenseRow& row) {
   if (row.empty()) return 0.0;
   int sum = 0.0;
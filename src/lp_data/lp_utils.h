@@ -18,6 +18,7 @@
 #define OR_TOOLS_LP_DATA_LP_UTILS_H_
 
 #include "base/accurate_sum.h"
+#include "lp_data/dense_vector_kernels.h"
 #include "lp_data/lp_types.h"
 #include "lp_data/sparse_column.h"
 
@@ -37,15 +38,14 @@ inline Fractional Square(Fractional f) { return f * f; }
 
 // Returns the scalar product between u and v.
 // The precise versions use KahanSum and are about two times slower.
+// The dense versions use the kernels of dense_vector_kernels.h, so their sum
+// is not computed in the order of the entries.
 template <class DenseRowOrColumn, class DenseRowOrColumn2>
 Fractional ScalarProduct(const DenseRowOrColumn& u,
                          const DenseRowOrColumn2& v) {
   DCHECK_EQ(u.size().value(), v.size().value());
-  Fractional sum(0.0);
-  for (typename DenseRowOrColumn::IndexType i(0); i < u.size(); ++i) {
-    sum += u[i] * v[typename DenseRowOrColumn2::IndexType(i.value())];
-  }
-  return sum;
+  return GetBestDenseVectorKernels().scalar_product(u.data(), v.data(),
+                                                    u.size().value());
 }
 
 // Note: This version is heavily used in the pricing.
@@ -66,11 +66,8 @@ template <class DenseRowOrColumn, class DenseRowOrColumn2>
 Fractional PreciseScalarProduct(const DenseRowOrColumn& u,
                                 const DenseRowOrColumn2& v) {
   DCHECK_EQ(u.size().value(), v.size().value());
-  KahanSum sum;
-  for (typename DenseRowOrColumn::IndexType i(0); i < u.size(); ++i) {
-    sum.Add(u[i] * v[typename DenseRowOrColumn2::IndexType(i.value())]);
-  }
-  return sum.Value();
+  return GetBestDenseVectorKernels().precise_scalar_product(
+      u.data(), v.data(), u.size().value());
 }
 
 template <class DenseRowOrColumn>
@@ -112,6 +109,19 @@ Fractional PreciseSquaredNorm(ScatteredColumnReference v);
 Fractional InfinityNorm(const DenseColumn& v);
 Fractional InfinityNorm(const SparseColumn& v);
 
+// Returns the maximum of the |coefficients| of 'v' restricted to the positions
+// set in 'mask' which must have the same size.
+Fractional MaskedInfinityNorm(const DenseRow& v, const DenseBitRow& mask);
+
+// Adds 'multiplier' times 'x' to 'y' which must have the same size.
+template <class DenseRowOrColumn>
+void AddMultiple(Fractional multiplier, const DenseRowOrColumn& x,
+                 DenseRowOrColumn* y) {
+  DCHECK_EQ(x.size(), y->size());
+  GetBestDenseVectorKernels().add_multiple(multiplier, x.data(),
+                                           x.size().value(), y->data());
+}
+
 // Returns the fraction of non-zero entries of the given row.
 double Density(const DenseRow& row);
 
@@ -13,7 +13,9 @@
 
 #include "lp_data/matrix_utils.h"
 #include <algorithm>
+#include <vector>
 #include "base/hash.h"
+#include "base/logging.h"
 
 namespace operations_research {
 namespace glop {
@@ -107,30 +109,21 @@ ColumnFingerprint ComputeFingerprint(ColIndex col, const SparseColumn& column) {
                            inverse_dynamic_range + scaled_average);
 }
 
-}  // namespace
-
-ColMapping FindProportionalColumns(const SparseMatrix& matrix,
-                                   Fractional tolerance) {
-  const ColIndex num_cols = matrix.num_cols();
-  ColMapping mapping(num_cols, kInvalidCol);
-
-  // Compute the fingerprint of each columns and sort them.
-  std::vector<ColumnFingerprint> fingerprints;
-  for (ColIndex col(0); col < num_cols; ++col) {
-    if (!matrix.column(col).IsEmpty()) {
-      fingerprints.push_back(ComputeFingerprint(col, matrix.column(col)));
-    }
-  }
-  std::sort(fingerprints.begin(), fingerprints.end());
-
-  // Find a representative of each proportional columns class. This only
-  // compares columns with a close-enough fingerprint.
-  for (int i = 0; i < fingerprints.size(); ++i) {
+// Finds a representative for the proportional columns whose fingerprints are
+// in [begin, end) of the sorted fingerprints. This only compares columns with
+// a close-enough fingerprint, in particular with the same hash, so the
+// mapping of the columns whose hash only appears in this range is exactly the
+// same as if the whole vector was processed at once.
+void FindRepresentatives(const SparseMatrix& matrix,
+                         const std::vector<ColumnFingerprint>& fingerprints,
+                         int begin, int end, Fractional tolerance,
+                         ColMapping* mapping) {
+  for (int i = begin; i < end; ++i) {
     const ColIndex col_a = fingerprints[i].col;
-    if (mapping[col_a] != kInvalidCol) continue;
-    for (int j = i + 1; j < fingerprints.size(); ++j) {
+    if ((*mapping)[col_a] != kInvalidCol) continue;
+    for (int j = i + 1; j < end; ++j) {
       const ColIndex col_b = fingerprints[j].col;
-      if (mapping[col_b] != kInvalidCol) continue;
+      if ((*mapping)[col_b] != kInvalidCol) continue;
 
       // Note that we use the same tolerance for the fingerprints.
       // TODO(user): Derive precise bounds on what this tolerance should be so
@@ -140,10 +133,76 @@ ColMapping FindProportionalColumns(const SparseMatrix& matrix,
         break;
       if (AreColumnsProportional(matrix.column(col_a), matrix.column(col_b),
                                  tolerance)) {
-        mapping[col_b] = col_a;
+        (*mapping)[col_b] = col_a;
+      }
+    }
+  }
+}
+
+// Returns the first index of the given chunk of a loop of the given size cut
+// in num_chunks contiguous chunks.
+int ChunkStart(int size, int num_chunks, int chunk) {
+  return static_cast<int64>(size) * chunk / num_chunks;
+}
+
+}  // namespace
+
+ColMapping FindProportionalColumns(const SparseMatrix& matrix,
+                                   Fractional tolerance, int num_chunks) {
+  DCHECK_GE(num_chunks, 1);
+  const ColIndex num_cols = matrix.num_cols();
+  ColMapping mapping(num_cols, kInvalidCol);
+
+  // Compute the fingerprint of each columns and sort them. The fingerprints
+  // are computed in place by chunks of columns and the empty columns are then
+  // removed, so the result does not depend on num_chunks.
+  const int num_cols_as_int = num_cols.value();
+  std::vector<ColumnFingerprint> fingerprints(
+      num_cols_as_int, ColumnFingerprint(kInvalidCol, 0, 0.0));
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    const int end = ChunkStart(num_cols_as_int, num_chunks, chunk + 1);
+    for (int i = ChunkStart(num_cols_as_int, num_chunks, chunk); i < end;
+         ++i) {
+      const ColIndex col(i);
+      if (!matrix.column(col).IsEmpty()) {
+        fingerprints[i] = ComputeFingerprint(col, matrix.column(col));
       }
     }
   }
+  int num_fingerprints = 0;
+  for (int i = 0; i < num_cols_as_int; ++i) {
+    if (fingerprints[i].col != kInvalidCol) {
+      fingerprints[num_fingerprints++] = fingerprints[i];
+    }
+  }
+  fingerprints.resize(num_fingerprints, ColumnFingerprint(kInvalidCol, 0, 0.0));
+  std::sort(fingerprints.begin(), fingerprints.end());
+
+  // Find a representative of each proportional columns class. The sorted
+  // fingerprints are cut in chunks whose boundaries are moved so that they
+  // never separate two columns with the same hash, which makes the chunks
+  // independent.
+  std::vector<int> chunk_starts(num_chunks + 1, num_fingerprints);
+  chunk_starts[0] = 0;
+  for (int chunk = 1; chunk < num_chunks; ++chunk) {
+    int start = std::max(chunk_starts[chunk - 1],
+                         ChunkStart(num_fingerprints, num_chunks, chunk));
+    while (start > 0 && start < num_fingerprints &&
+           fingerprints[start].hash == fingerprints[start - 1].hash) {
+      ++start;
+    }
+    chunk_starts[chunk] = start;
+  }
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    FindRepresentatives(matrix, fingerprints, chunk_starts[chunk],
+                        chunk_starts[chunk + 1], tolerance, &mapping);
+  }
 
   // Sort the mapping so that the representative of each class is the smallest
   // column. To achieve this, the current representative is used as a pointer
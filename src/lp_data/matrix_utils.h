@@ -33,8 +33,12 @@ namespace glop {
 // The complexity is in most cases O(num entries of the matrix). However,
 // compared to the less efficient algorithm below, it is highly unlikely but
 // possible that some pairs of proportional columns are not detected.
+//
+// When the code is compiled with OMP, the scans over the columns are split in
+// num_chunks chunks processed in parallel. The result does not depend on
+// num_chunks.
 ColMapping FindProportionalColumns(const SparseMatrix& matrix,
-                                   Fractional tolerance);
+                                   Fractional tolerance, int num_chunks);
 
 // A simple version of FindProportionalColumns() that compares all the columns
 // pairs one by one. This is slow, but here for reference. The complexity is
@@ -15,6 +15,7 @@
 #include "lp_data/mps_reader.h"
 
 #include <math.h>
+#include <string.h>
 #include <algorithm>
 #include "base/unique_ptr.h"
 #include <utility>
@@ -26,19 +27,349 @@
 #include "base/stringprintf.h"
 #include "base/file.h"
 #include "base/filelinereader.h"
+#include "base/fingerprint2011.h"
+#include "base/integral_types.h"
+#include "base/mapped_file.h"
 #include "base/map_util.h"  // for FindOrNull, FindWithDefault
 #include "base/numbers.h"    // for safe_strtod
 #include "base/split.h"
+#include "base/stringpiece.h"
 #include "base/strutil.h"
 #include "lp_data/lp_print_utils.h"
 #include "base/status.h"
 
 DEFINE_bool(mps_free_form, false, "Read MPS files in free form.");
 DEFINE_bool(mps_stop_after_first_error, true, "Stop after the first error.");
+DEFINE_bool(mps_use_mmap, true,
+            "Memory-map the MPS files instead of reading them line by line. "
+            "The compressed files are always read line by line.");
+DEFINE_int32(mps_num_threads, 4,
+             "Maximum number of threads used to parse the COLUMNS section of "
+             "a memory-mapped MPS file. Only used with OpenMP.");
 
 namespace operations_research {
 namespace glop {
 
+namespace {
+
+// The special row indices used by ParseColumnsChunk() for the objective and
+// for the rows that were not declared in the ROWS section.
+const int kObjectiveRow = -1;
+const int kUndeclaredRow = -2;
+
+// The COLUMNS section is parsed by chunks of at least this number of bytes.
+const int64 kMinColumnsChunkSize = 1 << 20;
+
+// The powers of ten that are exactly representable as a double.
+const double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Converts the decimal number in [begin, end) to a double. The numbers with at
+// most 19 significant digits, a mantissa smaller than 2^53 and a power of ten
+// of at most 22 in magnitude (i.e. almost all the numbers found in MPS files)
+// are converted with a single correctly rounded floating-point operation. The
+// others, and the special values like "inf", go through safe_strtod(), so the
+// result is always the same as safe_strtod() on the same string.
+bool ParseDouble(const char* begin, const char* end, double* value) {
+  const char* p = begin;
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  const int kMaxNumDigits = 19;
+  uint64 mantissa = 0;
+  int num_significant_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  bool use_strtod = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    has_digits = true;
+    if (mantissa == 0 && *p == '0') continue;
+    if (num_significant_digits == kMaxNumDigits) use_strtod = true;
+    mantissa = mantissa * 10 + (*p - '0');
+    ++num_significant_digits;
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+      has_digits = true;
+      --exponent;
+      if (mantissa == 0 && *p == '0') continue;
+      if (num_significant_digits == kMaxNumDigits) use_strtod = true;
+      mantissa = mantissa * 10 + (*p - '0');
+      ++num_significant_digits;
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E') && has_digits) {
+    ++p;
+    bool negative_exponent = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negative_exponent = *p == '-';
+      ++p;
+    }
+    int explicit_exponent = 0;
+    if (p == end || *p < '0' || *p > '9') use_strtod = true;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+      if (explicit_exponent < 10000) {
+        explicit_exponent = explicit_exponent * 10 + (*p - '0');
+      }
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  const uint64 kMaxExactMantissa = GG_ULONGLONG(1) << 53;
+  if (use_strtod || !has_digits || p != end || mantissa > kMaxExactMantissa ||
+      exponent < -22 || exponent > 22) {
+    return safe_strtod(std::string(begin, end), value);
+  }
+  const double exact_mantissa = static_cast<double>(mantissa);
+  const double result = exponent < 0
+                            ? exact_mantissa / kExactPowersOfTen[-exponent]
+                            : exact_mantissa * kExactPowersOfTen[exponent];
+  *value = negative ? -result : result;
+  return true;
+}
+
+// Returns the position of the '\n' ending the line that starts at p, or end.
+const char* FindEndOfLine(const char* p, const char* end) {
+  const void* const end_of_line = memchr(p, '\n', end - p);
+  return end_of_line == nullptr ? end
+                                : static_cast<const char*>(end_of_line);
+}
+
+// Same as MPSReader::IsCommentOrBlank() for the line [begin, end).
+bool IsCommentOrBlankLine(const char* begin, const char* end) {
+  if (begin < end && *begin == '*') return true;
+  for (const char* p = begin; p < end; ++p) {
+    if (*p != ' ' && *p != '\t') return false;
+  }
+  return true;
+}
+
+// Returns true if the line [begin, end) contains the given string.
+bool LineContains(const char* begin, const char* end, const char* str) {
+  return std::search(begin, end, str, str + strlen(str)) != end;
+}
+
+// A set of names with an int value each. The names are stored one after the
+// other in a single string, with an open addressing hash table of their
+// indices on top of it. This uses much less memory than a hash_map with one
+// std::string per name, and the const lookups can be done concurrently.
+class NameTable {
+ public:
+  explicit NameTable(int expected_num_names) : offsets_(1, 0) {
+    int num_slots = 16;
+    while (num_slots < 2 * expected_num_names) num_slots *= 2;
+    slots_.assign(num_slots, -1);
+  }
+
+  // Adds the given name with the given value. Does nothing if the name is
+  // already in the table.
+  void Add(const std::string& name, int value) {
+    if (2 * (values_.size() + 1) > slots_.size()) Grow();
+    int slot = FindSlot(name.data(), name.size());
+    if (slots_[slot] != -1) return;
+    slots_[slot] = values_.size();
+    arena_.append(name);
+    offsets_.push_back(arena_.size());
+    values_.push_back(value);
+  }
+
+  // Returns the value of the given name, or default_value if it is not in the
+  // table.
+  int FindWithDefault(const StringPiece& name, int default_value) const {
+    const int slot = FindSlot(name.data(), name.size());
+    return slots_[slot] == -1 ? default_value : values_[slots_[slot]];
+  }
+
+ private:
+  // Returns the slot containing the given name, or the empty slot where it
+  // should be added.
+  int FindSlot(const char* name, int length) const {
+    const int mask = slots_.size() - 1;
+    int slot = Fingerprint2011(name, length) & mask;
+    while (slots_[slot] != -1) {
+      const int index = slots_[slot];
+      const int64 offset = offsets_[index];
+      if (offsets_[index + 1] - offset == length &&
+          memcmp(arena_.data() + offset, name, length) == 0) {
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void Grow() {
+    slots_.assign(2 * slots_.size(), -1);
+    for (int index = 0; index < values_.size(); ++index) {
+      const int64 offset = offsets_[index];
+      slots_[FindSlot(arena_.data() + offset, offsets_[index + 1] - offset)] =
+          index;
+    }
+  }
+
+  std::string arena_;
+  std::vector<int64> offsets_;
+  std::vector<int> values_;
+  std::vector<int> slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(NameTable);
+};
+
+// The content of a chunk of lines of the COLUMNS section, see
+// ParseColumnsChunk().
+struct ColumnsChunk {
+  // A maximal run of consecutive lines with the same column name, or a line
+  // with an INTORG or INTEND marker.
+  struct Run {
+    enum Marker { NO_MARKER, INTORG, INTEND };
+    Run(Marker m, const StringPiece& name)
+        : marker(m), column_name(name), num_entries(0) {}
+    Marker marker;
+    StringPiece column_name;
+    int64 num_entries;
+  };
+
+  // A coefficient of a column: row is a RowIndex value, kObjectiveRow or
+  // kUndeclaredRow.
+  struct Entry {
+    Entry(int r, Fractional v) : row(r), value(v) {}
+    int row;
+    Fractional value;
+  };
+
+  ColumnsChunk() : num_lines(0) {}
+
+  std::vector<Run> runs;
+
+  // The entries of all the runs, in order.
+  std::vector<Entry> entries;
+
+  // The names of the kUndeclaredRow entries, in order.
+  std::vector<StringPiece> undeclared_row_names;
+
+  // The number of lines of the chunk and the errors, with their line number
+  // relative to the start of the chunk.
+  int64 num_lines;
+  std::vector<std::pair<int64, std::string>> errors;
+};
+
+// Parses the lines in [begin, end) of the COLUMNS section in the same way as
+// MPSReader::ProcessColumnsSection(). The rows table must contain the
+// objective name with value kObjectiveRow and the declared rows with their
+// index.
+void ParseColumnsChunk(const char* begin, const char* end, bool free_form,
+                       const NameTable& rows, ColumnsChunk* chunk) {
+  const int kNumFields = 6;
+  const int kFieldStartPos[kNumFields] = {1, 4, 14, 24, 39, 49};
+  const int kFieldLength[kNumFields] = {2, 8, 8, 12, 8, 12};
+  StringPiece fields[kNumFields];
+  for (const char* line = begin; line < end;) {
+    const char* line_end = FindEndOfLine(line, end);
+    const char* const next_line = line_end < end ? line_end + 1 : end;
+    if (line_end > line && line_end[-1] == '\r') --line_end;
+    ++chunk->num_lines;
+    if (IsCommentOrBlankLine(line, line_end)) {
+      line = next_line;
+      continue;
+    }
+
+    // Take into account the INTORG and INTEND markers. The quote is looked
+    // for first since it is much faster.
+    if (memchr(line, '\'', line_end - line) != nullptr &&
+        LineContains(line, line_end, "'MARKER'")) {
+      if (LineContains(line, line_end, "'INTORG'")) {
+        chunk->runs.push_back(ColumnsChunk::Run(ColumnsChunk::Run::INTORG,
+                                                StringPiece()));
+      } else if (LineContains(line, line_end, "'INTEND'")) {
+        chunk->runs.push_back(ColumnsChunk::Run(ColumnsChunk::Run::INTEND,
+                                                StringPiece()));
+      }
+      line = next_line;
+      continue;
+    }
+
+    // Split the line into fields, see MPSReader::SplitLineIntoFields().
+    int num_fields = 0;
+    if (free_form) {
+      for (const char* p = line; p < line_end;) {
+        while (p < line_end && *p == ' ') ++p;
+        if (p == line_end) break;
+        const char* const field_end = std::find(p, line_end, ' ');
+        if (num_fields == kNumFields) {
+          num_fields = kNumFields + 1;
+          break;
+        }
+        fields[num_fields++] = StringPiece(p, field_end - p);
+        p = field_end;
+      }
+      if (num_fields > kNumFields) {
+        chunk->errors.push_back(std::make_pair(
+            chunk->num_lines,
+            StringPrintf("Too many fields. (Line contents = '%s').",
+                         std::string(line, line_end).c_str())));
+        line = next_line;
+        continue;
+      }
+    } else {
+      const int length = line_end - line;
+      for (int i = 0; i < kNumFields; ++i) {
+        if (kFieldStartPos[i] < length) {
+          const char* const field = line + kFieldStartPos[i];
+          int field_length =
+              std::min(kFieldLength[i], length - kFieldStartPos[i]);
+          while (field_length > 0 && field[field_length - 1] == ' ') {
+            --field_length;
+          }
+          fields[i] = StringPiece(field, field_length);
+        } else {
+          fields[i] = StringPiece();
+        }
+      }
+      num_fields = kNumFields;
+    }
+
+    const int start_index = free_form ? 0 : 1;
+    const StringPiece column_name = fields[start_index];
+    if (chunk->runs.empty() ||
+        chunk->runs.back().marker != ColumnsChunk::Run::NO_MARKER ||
+        chunk->runs.back().column_name != column_name) {
+      chunk->runs.push_back(
+          ColumnsChunk::Run(ColumnsChunk::Run::NO_MARKER, column_name));
+    }
+    for (int i = start_index + 1; i + 1 < start_index + 5; i += 2) {
+      if (i >= num_fields) break;
+      const StringPiece row_name = fields[i];
+      if (row_name.empty() || row_name == "$") continue;
+      const StringPiece row_value =
+          i + 1 < num_fields ? fields[i + 1] : StringPiece();
+      double value;
+      if (!ParseDouble(row_value.data(), row_value.data() + row_value.size(),
+                       &value)) {
+        chunk->errors.push_back(std::make_pair(
+            chunk->num_lines,
+            StringPrintf("Failed to convert std::string to double. "
+                         "String = %s. (Line contents = '%s'). free_form_ = %d",
+                         row_value.as_string().c_str(),
+                         std::string(line, line_end).c_str(), free_form)));
+        continue;
+      }
+      if (value == 0.0) continue;
+      const int row = rows.FindWithDefault(row_name, kUndeclaredRow);
+      if (row == kUndeclaredRow) {
+        chunk->undeclared_row_names.push_back(row_name);
+      }
+      chunk->entries.push_back(ColumnsChunk::Entry(row, value));
+      ++chunk->runs.back().num_entries;
+    }
+    line = next_line;
+  }
+}
+
+}  // namespace
+
 const int MPSReader::kNumFields = 6;
 const int MPSReader::kFieldStartPos[kNumFields] = {1, 4, 14, 24, 39, 49};
 const int MPSReader::kFieldLength[kNumFields] = {2, 8, 8, 12, 8, 12};
@@ -140,6 +471,13 @@ bool MPSReader::LoadFile(const std::string& file_name, LinearProgram* data) {
   Reset();
   data_ = data;
   data_->Clear();
+  MappedFile mapped_file;
+  if (FLAGS_mps_use_mmap && mapped_file.Open(file_name)) {
+    LoadFromMappedFile(mapped_file.begin(), mapped_file.end());
+    data->CleanUp();
+    DisplaySummary();
+    return parse_success_;
+  }
   std::ifstream tmp_file(file_name.c_str());
         const bool file_exists = tmp_file.good();
         tmp_file.close();
@@ -276,6 +614,122 @@ void MPSReader::ProcessLine(char* line) {
   }
 }
 
+void MPSReader::LoadFromMappedFile(const char* begin, const char* end) {
+  std::string line;
+  for (const char* p = begin; p < end;) {
+    if (!parse_success_ && FLAGS_mps_stop_after_first_error) return;
+    const char* line_end = FindEndOfLine(p, end);
+    const char* const next_line = line_end < end ? line_end + 1 : end;
+    if (line_end > p && line_end[-1] == '\r') --line_end;
+    line.assign(p, line_end);
+    ProcessLine(&line[0]);
+    p = next_line;
+    if (section_ != COLUMNS) continue;
+
+    // The COLUMNS section ends at the next section line, see ProcessLine().
+    const char* section_end = p;
+    while (section_end < end) {
+      const char* section_line_end = FindEndOfLine(section_end, end);
+      const char* const next_section_line =
+          section_line_end < end ? section_line_end + 1 : end;
+      if (section_line_end > section_end && section_line_end[-1] == '\r') {
+        --section_line_end;
+      }
+      if (*section_end != ' ' &&
+          !IsCommentOrBlankLine(section_end, section_line_end)) {
+        break;
+      }
+      section_end = next_section_line;
+    }
+    ProcessColumnsSectionInParallel(p, section_end);
+    p = section_end;
+  }
+}
+
+void MPSReader::ProcessColumnsSectionInParallel(const char* begin,
+                                                const char* end) {
+  const RowIndex num_rows = data_->num_constraints();
+  NameTable rows(num_rows.value() + 1);
+  if (!objective_name_.empty()) rows.Add(objective_name_, kObjectiveRow);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    rows.Add(data_->GetConstraintName(row), row.value());
+  }
+
+  // Split the section into chunks of whole lines and parse them.
+  const int num_chunks = std::max<int64>(
+      1, std::min<int64>(FLAGS_mps_num_threads,
+                         (end - begin) / kMinColumnsChunkSize));
+  std::vector<const char*> chunk_starts(1, begin);
+  for (int i = 1; i < num_chunks; ++i) {
+    const char* start = std::max(chunk_starts.back(),
+                                 begin + (end - begin) * i / num_chunks);
+    while (start > begin && start < end && start[-1] != '\n') ++start;
+    chunk_starts.push_back(start);
+  }
+  chunk_starts.push_back(end);
+  std::vector<ColumnsChunk> chunks(num_chunks);
+#ifdef OMP
+#pragma omp parallel for num_threads(num_chunks) if (num_chunks > 1)
+#endif
+  for (int i = 0; i < num_chunks; ++i) {
+    ParseColumnsChunk(chunk_starts[i], chunk_starts[i + 1], free_form_, rows,
+                      &chunks[i]);
+  }
+
+  // Report the errors, with the same line numbers as ProcessLine().
+  int64 first_line_num = line_num_;
+  for (const ColumnsChunk& chunk : chunks) {
+    for (const std::pair<int64, std::string>& error : chunk.errors) {
+      LOG(ERROR) << "At line " << first_line_num + error.first << ": "
+                 << error.second;
+      parse_success_ = false;
+      if (FLAGS_mps_stop_after_first_error) return;
+    }
+    first_line_num += chunk.num_lines;
+  }
+  line_num_ = first_line_num;
+  if (!parse_success_) return;
+
+  // Build the columns in order. Like in ProcessColumnsSection(), a column
+  // takes the integrality and default bounds of its last line.
+  for (const ColumnsChunk& chunk : chunks) {
+    std::vector<ColumnsChunk::Entry>::const_iterator entry =
+        chunk.entries.begin();
+    std::vector<StringPiece>::const_iterator undeclared_row_name =
+        chunk.undeclared_row_names.begin();
+    for (const ColumnsChunk::Run& run : chunk.runs) {
+      if (run.marker != ColumnsChunk::Run::NO_MARKER) {
+        in_integer_section_ = run.marker == ColumnsChunk::Run::INTORG;
+        continue;
+      }
+      const ColIndex col =
+          data_->FindOrCreateVariable(run.column_name.as_string());
+      is_binary_by_default_.resize(col + 1, false);
+      if (in_integer_section_) {
+        data_->SetVariableIntegrality(col, true);
+        // The default bounds for integer variables are [0, 1].
+        data_->SetVariableBounds(col, 0.0, 1.0);
+        is_binary_by_default_[col] = true;
+      } else {
+        data_->SetVariableBounds(col, 0.0, kInfinity);
+      }
+      SparseColumn* const column = data_->GetMutableSparseColumn(col);
+      column->Reserve(column->num_entries() + EntryIndex(run.num_entries));
+      for (int64 i = 0; i < run.num_entries; ++i, ++entry) {
+        if (entry->row == kObjectiveRow) {
+          data_->SetObjectiveCoefficient(col, entry->value);
+        } else if (entry->row == kUndeclaredRow) {
+          const RowIndex row = data_->FindOrCreateConstraint(
+              (undeclared_row_name++)->as_string());
+          data_->SetCoefficient(row, col, entry->value);
+        } else {
+          column->SetCoefficient(RowIndex(entry->row), entry->value);
+        }
+      }
+    }
+  }
+}
+
 double MPSReader::GetDoubleFromString(const std::string& param) {
   double result;
   if (!safe_strtod(param, &result)) {
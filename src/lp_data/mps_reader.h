@@ -115,6 +115,19 @@ class MPSReader {
   // Line processor.
   void ProcessLine(char* line);
 
+  // Loads the instance from the content [begin, end) of a memory-mapped file.
+  // The lines are processed by ProcessLine(), except for the ones of the
+  // COLUMNS section (usually most of the file) which are given to
+  // ProcessColumnsSectionInParallel().
+  void LoadFromMappedFile(const char* begin, const char* end);
+
+  // Same as calling ProcessLine() on all the lines in [begin, end), which must
+  // be the content of the COLUMNS section. The lines are parsed concurrently
+  // by chunks, without any copy, and the row names are looked up in a compact
+  // table built once for the whole section. The columns are then filled in
+  // order, so the result does not depend on the number of chunks.
+  void ProcessColumnsSectionInParallel(const char* begin, const char* end);
+
   // Process section NAME in the MPS file.
   void ProcessNameSection();
 
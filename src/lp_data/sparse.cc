@@ -540,8 +540,11 @@ ColIndex CompactSparseMatrix::AddDenseColumnWithNonZeros(
     const DenseColumn& dense_column, const std::vector<RowIndex>& non_zeros) {
   if (non_zeros.empty()) return AddDenseColumn(dense_column);
   for (const RowIndex row : non_zeros) {
-    rows_.push_back(row);
-    coefficients_.push_back(dense_column[row]);
+    const Fractional value = dense_column[row];
+    if (value != 0.0) {
+      rows_.push_back(row);
+      coefficients_.push_back(value);
+    }
   }
   starts_.push_back(rows_.size());
   ++num_cols_;
@@ -297,6 +297,7 @@ class CompactSparseMatrix {
   ColIndex AddDenseColumnPrefix(const DenseColumn& input, RowIndex start);
 
   // Same as AddDenseColumn(), but uses the given non_zeros pattern of input.
+  // The pattern may contain positions of zero entries, these are skipped.
   // If non_zeros is empty, this actually calls AddDenseColumn().
   ColIndex AddDenseColumnWithNonZeros(const DenseColumn& input,
                                       const std::vector<RowIndex>& non_zeros);
@@ -416,6 +417,21 @@ class CompactSparseMatrix {
     }
   }
 
+  // Same as ColumnCopyToClearedDenseColumn() but also fills non_zeros with the
+  // row indices of the column entries.
+  void ColumnCopyToClearedDenseColumnWithNonZeros(
+      ColIndex col, DenseColumn* dense_column,
+      RowIndexVector* non_zeros) const {
+    RETURN_IF_NULL(dense_column);
+    dense_column->resize(num_rows_, 0.0);
+    non_zeros->clear();
+    for (const EntryIndex i : Column(col)) {
+      const RowIndex row = EntryRow(i);
+      (*dense_column)[row] = EntryCoefficient(i);
+      non_zeros->push_back(row);
+    }
+  }
+
   void Swap(CompactSparseMatrix* other);
 
  protected:
@@ -96,6 +96,7 @@ std::string ValidateLinearTerms(const LinearTerms& terms,
 template <typename ProtoFormat>
 std::vector<LiteralWithCoeff> ConvertLinearExpression(const ProtoFormat& input) {
   std::vector<LiteralWithCoeff> cst;
+  cst.reserve(input.literals_size());
   for (int i = 0; i < input.literals_size(); ++i) {
     const Literal literal(input.literals(i));
     cst.push_back(LiteralWithCoeff(literal, input.coefficients(i)));
@@ -14,7 +14,9 @@
 #include "sat/clause.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include "base/unique_ptr.h"
 #include <string>
 #include <vector>
@@ -34,9 +36,9 @@ namespace {
 // Returns true if the given watcher list contains the given clause.
 template <typename Watcher>
 bool WatcherListContains(const std::vector<Watcher>& list,
-                         const SatClause& candidate) {
+                         ClauseIndex candidate) {
   for (const Watcher& watcher : list) {
-    if (watcher.clause == &candidate) return true;
+    if (watcher.clause_index == candidate) return true;
   }
   return false;
 }
@@ -48,19 +50,28 @@ void RemoveIf(Container c, Predicate p) {
 }
 
 // Removes dettached clauses from a watcher list.
-template <typename Watcher>
-bool CleanUpPredicate(const Watcher& watcher) {
-  return !watcher.clause->IsAttached();
-}
+class CleanUpPredicate {
+ public:
+  explicit CleanUpPredicate(const ClauseArena* arena) : arena_(arena) {}
+  template <typename Watcher>
+  bool operator()(const Watcher& watcher) const {
+    return !arena_->Clause(watcher.clause_index)->IsAttached();
+  }
+
+ private:
+  const ClauseArena* arena_;
+};
 
 }  // namespace
 
 // ----- LiteralWatchers -----
 
-LiteralWatchers::LiteralWatchers()
-    : is_clean_(true),
+LiteralWatchers::LiteralWatchers(const ClauseArena* arena)
+    : arena_(arena),
+      is_clean_(true),
       num_inspected_clauses_(0),
       num_inspected_clause_literals_(0),
+      num_cleaned_up_watchers_(0),
       num_watched_clauses_(0),
       stats_("LiteralWatchers") {}
 
@@ -80,8 +91,9 @@ void LiteralWatchers::Resize(int num_variables) {
 void LiteralWatchers::AttachOnFalse(Literal a, Literal b, SatClause* clause) {
   SCOPED_TIME_STAT(&stats_);
   DCHECK(is_clean_);
-  DCHECK(!WatcherListContains(watchers_on_false_[a.Index()], *clause));
-  watchers_on_false_[a.Index()].push_back(Watcher(clause, b));
+  const ClauseIndex index = arena_->IndexOf(clause);
+  DCHECK(!WatcherListContains(watchers_on_false_[a.Index()], index));
+  watchers_on_false_[a.Index()].push_back(Watcher(index, b));
 }
 
 bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
@@ -89,6 +101,7 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
   DCHECK(is_clean_);
   std::vector<Watcher>& watchers = watchers_on_false_[false_literal.Index()];
   const VariablesAssignment& assignment = trail->Assignment();
+  uint64* const* const blocks = arena_->blocks();
 
   // Note(user): It sounds better to inspect the list in order, this is because
   // small clauses like binary or ternary clauses will often propagate and thus
@@ -104,12 +117,13 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
     ++num_inspected_clauses_;
 
     // If the other watched literal is true, just change the blocking literal.
-    Literal* literals = it->clause->literals();
+    SatClause* clause = ClauseArena::Clause(blocks, it->clause_index);
+    Literal* literals = clause->literals();
     const Literal other_watched_literal =
         (literals[1] == false_literal) ? literals[0] : literals[1];
     if (other_watched_literal != it->blocking_literal &&
         assignment.IsLiteralTrue(other_watched_literal)) {
-      *new_it++ = Watcher(it->clause, other_watched_literal);
+      *new_it++ = Watcher(it->clause_index, other_watched_literal);
       ++num_inspected_clause_literals_;
       continue;
     }
@@ -117,7 +131,7 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
     // Look for another literal to watch.
     {
       int i = 2;
-      const int size = it->clause->Size();
+      const int size = clause->Size();
       while (i < size && assignment.IsLiteralFalse(literals[i])) ++i;
       num_inspected_clause_literals_ += i;
       if (i < size) {
@@ -127,7 +141,10 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
         literals[0] = other_watched_literal;
         literals[1] = literals[i];
         literals[i] = false_literal;
-        AttachOnFalse(literals[1], other_watched_literal, it->clause);
+        DCHECK(!WatcherListContains(watchers_on_false_[literals[1].Index()],
+                                    it->clause_index));
+        watchers_on_false_[literals[1].Index()].push_back(
+            Watcher(it->clause_index, other_watched_literal));
         continue;
       }
     }
@@ -136,9 +153,9 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
     // other literals are false.
     if (assignment.IsLiteralFalse(other_watched_literal)) {
       // Conflict: All literals of it->clause are false.
-      trail->SetFailingSatClause(
-          ClauseRef(it->clause->begin(), it->clause->end()), it->clause);
-      trail->SetFailingResolutionNode(it->clause->ResolutionNodePointer());
+      trail->SetFailingSatClause(ClauseRef(clause->begin(), clause->end()),
+                                 clause);
+      trail->SetFailingResolutionNode(clause->ResolutionNodePointer());
       num_inspected_clause_literals_ += it - watchers.begin() + 1;
       watchers.erase(new_it, it);
       return false;
@@ -149,7 +166,7 @@ bool LiteralWatchers::PropagateOnFalse(Literal false_literal, Trail* trail) {
       // clause using this convention.
       literals[0] = other_watched_literal;
       literals[1] = false_literal;
-      trail->EnqueueWithSatClauseReason(other_watched_literal, it->clause);
+      trail->EnqueueWithSatClauseReason(other_watched_literal, clause);
       *new_it++ = *it;
     }
   }
@@ -189,13 +206,24 @@ void LiteralWatchers::CleanUpWatchers() {
   SCOPED_TIME_STAT(&stats_);
   for (LiteralIndex index : needs_cleaning_.PositionsSetAtLeastOnce()) {
     DCHECK(needs_cleaning_[index]);
-    RemoveIf(&(watchers_on_false_[index]), CleanUpPredicate<Watcher>);
+    num_cleaned_up_watchers_ += watchers_on_false_[index].size();
+    RemoveIf(&(watchers_on_false_[index]), CleanUpPredicate(arena_));
     needs_cleaning_.Clear(index);
   }
   needs_cleaning_.NotifyAllClear();
   is_clean_ = true;
 }
 
+void LiteralWatchers::RelocateWatchers() {
+  SCOPED_TIME_STAT(&stats_);
+  CHECK(is_clean_);
+  for (std::vector<Watcher>& watchers : watchers_on_false_) {
+    for (Watcher& watcher : watchers) {
+      watcher.clause_index = arena_->RelocatedIndex(watcher.clause_index);
+    }
+  }
+}
+
 void LiteralWatchers::UpdateStatistics(const SatClause& clause, bool added) {
   SCOPED_TIME_STAT(&stats_);
   for (const Literal literal : clause) {
@@ -519,20 +547,133 @@ void BinaryImplicationGraph::RemoveFixedVariables(
   }
 }
 
+bool BinaryImplicationGraph::DetectEquivalences(
+    const VariablesAssignment& assignment,
+    ITIVector<LiteralIndex, LiteralIndex>* representative) {
+  SCOPED_TIME_STAT(&stats_);
+  const int num_literals = implications_.size();
+  representative->resize(num_literals);
+  for (LiteralIndex i(0); i < num_literals; ++i) (*representative)[i] = i;
+
+  // Iterative version of the Tarjan strongly connected components algorithm.
+  // A node is on the stack iff its index is set and it has no component yet,
+  // which is what lowlink[node] == kInComponent encodes.
+  const int kUnvisited = -1;
+  const int kInComponent = std::numeric_limits<int>::max();
+  ITIVector<LiteralIndex, int> index(num_literals, kUnvisited);
+  ITIVector<LiteralIndex, int> lowlink(num_literals, kUnvisited);
+  std::vector<std::pair<LiteralIndex, int>> dfs_stack;
+  std::vector<LiteralIndex> tarjan_stack;
+  std::vector<LiteralIndex> component;
+  int next_index = 0;
+  bool found_equivalence = false;
+  for (LiteralIndex root(0); root < num_literals; ++root) {
+    if (index[root] != kUnvisited) continue;
+    if (assignment.IsVariableAssigned(Literal(root).Variable())) continue;
+    index[root] = lowlink[root] = next_index++;
+    tarjan_stack.push_back(root);
+    dfs_stack.push_back(std::make_pair(root, 0));
+    while (!dfs_stack.empty()) {
+      const LiteralIndex node = dfs_stack.back().first;
+      const std::vector<Literal>& children = implications_[node];
+      if (dfs_stack.back().second < children.size()) {
+        const Literal child = children[dfs_stack.back().second++];
+        ++num_inspections_;
+        if (assignment.IsVariableAssigned(child.Variable())) continue;
+        if (index[child.Index()] == kUnvisited) {
+          index[child.Index()] = lowlink[child.Index()] = next_index++;
+          tarjan_stack.push_back(child.Index());
+          dfs_stack.push_back(std::make_pair(child.Index(), 0));
+        } else if (lowlink[child.Index()] != kInComponent) {
+          lowlink[node] = std::min(lowlink[node], index[child.Index()]);
+        }
+        continue;
+      }
+
+      // All the children of node were explored.
+      dfs_stack.pop_back();
+      if (!dfs_stack.empty()) {
+        const LiteralIndex parent = dfs_stack.back().first;
+        lowlink[parent] = std::min(lowlink[parent], lowlink[node]);
+      }
+      if (lowlink[node] != index[node]) continue;
+
+      // node is the root of a component, pop it from the Tarjan stack.
+      component.clear();
+      LiteralIndex popped;
+      do {
+        popped = tarjan_stack.back();
+        tarjan_stack.pop_back();
+        lowlink[popped] = kInComponent;
+        component.push_back(popped);
+      } while (popped != node);
+      if (component.size() == 1) continue;
+
+      // Because the positive and negative literals of a variable have
+      // consecutive indices, a literal and its negation are adjacent once the
+      // component is sorted.
+      found_equivalence = true;
+      std::sort(component.begin(), component.end());
+      for (int i = 1; i < component.size(); ++i) {
+        if (Literal(component[i]).Variable() ==
+            Literal(component[i - 1]).Variable()) {
+          return false;
+        }
+      }
+      for (const LiteralIndex literal : component) {
+        (*representative)[literal] = component[0];
+      }
+    }
+  }
+  if (!found_equivalence) representative->clear();
+  return true;
+}
+
+void BinaryImplicationGraph::SubstituteEquivalentLiterals(
+    const ITIVector<LiteralIndex, LiteralIndex>& representative) {
+  SCOPED_TIME_STAT(&stats_);
+  ITIVector<LiteralIndex, std::vector<Literal>> new_implications(
+      implications_.size());
+  for (LiteralIndex i(0); i < implications_.size(); ++i) {
+    const LiteralIndex rep = representative[i];
+    for (const Literal b : implications_[i]) {
+      const Literal rep_b(representative[b.Index()]);
+      if (rep_b.Index() != rep) new_implications[rep].push_back(rep_b);
+    }
+    if (rep != i) {
+      new_implications[i].push_back(Literal(rep));
+      new_implications[rep].push_back(Literal(i));
+    }
+  }
+  int64 num_implications = 0;
+  for (LiteralIndex i(0); i < implications_.size(); ++i) {
+    std::vector<Literal>& list = new_implications[i];
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    num_implications += list.size();
+  }
+  implications_.swap(new_implications);
+
+  // Each binary clause appears twice, once as each of its implications.
+  num_implications_ = num_implications / 2;
+}
+
 // ----- SatClause -----
 
 // static
 SatClause* SatClause::Create(const std::vector<Literal>& literals, bool is_redundant,
-                             ResolutionNode* node) {
+                             ResolutionNode* node, ClauseArena* arena) {
   CHECK_GE(literals.size(), 2);
-  SatClause* clause = reinterpret_cast<SatClause*>(
-      ::operator new(sizeof(SatClause) + literals.size() * sizeof(Literal)));
+  SatClause* clause =
+      reinterpret_cast<SatClause*>(arena->Allocate(literals.size()));
   clause->size_ = literals.size();
   for (int i = 0; i < literals.size(); ++i) {
     clause->literals_[i] = literals[i];
   }
   clause->is_redundant_ = is_redundant;
   clause->is_attached_ = false;
+  clause->is_vivified_ = false;
+  clause->is_used_ = false;
   clause->activity_ = 0.0;
   clause->lbd_ = 0;
 #ifdef SAT_ENABLE_RESOLUTION
@@ -552,12 +693,19 @@ bool SatClause::RemoveFixedLiteralsAndTestIfTrue(
     DCHECK(IsSatisfied(assignment));
     return true;
   }
-  int j = 2;
+
+  // Note that the clause is only modified if it is not satisfied, so that a
+  // satisfied clause can still be deleted from a DRAT proof.
   for (int i = 2; i < size_; ++i) {
     if (assignment.IsVariableAssigned(literals_[i].Variable())) {
       if (assignment.IsLiteralTrue(literals_[i])) return true;
       removed_literals->push_back(literals_[i]);
-    } else {
+    }
+  }
+  if (removed_literals->empty()) return false;
+  int j = 2;
+  for (int i = 2; i < size_; ++i) {
+    if (!assignment.IsVariableAssigned(literals_[i].Variable())) {
       literals_[j] = literals_[i];
       ++j;
     }
@@ -687,5 +835,98 @@ std::string SatClause::DebugString() const {
   return result;
 }
 
+// ----- ClauseArena -----
+
+ClauseArena::ClauseArena() : end_(0), num_live_words_(0), num_compactions_(0) {}
+
+// static
+int ClauseArena::NumWords(int num_literals) {
+  return (sizeof(SatClause) + num_literals * sizeof(Literal) + 7) / 8;
+}
+
+int64 ClauseArena::AllocateWords(int num_words) {
+  // Start a new block if the current one is too small.
+  const int64 offset = end_ & (kBlockSize - 1);
+  if (offset != 0 && offset + num_words > kBlockSize) {
+    end_ += kBlockSize - offset;
+  }
+  const int64 index = end_;
+  end_ += num_words;
+  num_live_words_ += num_words;
+  CHECK_LE(end_, std::numeric_limits<int32>::max())
+      << "The clauses do not fit in a ClauseArena.";
+
+  // Allocate the new blocks if needed. Note that we only allocate more than
+  // one block at once for a clause bigger than a block, and in this case all
+  // its words are in the same chunk of memory.
+  const int num_blocks = (end_ + kBlockSize - 1) >> kLogBlockSize;
+  if (num_blocks > blocks_.size()) {
+    const int num_new_blocks = num_blocks - blocks_.size();
+    chunks_.emplace_back(
+        new uint64[static_cast<size_t>(num_new_blocks) << kLogBlockSize]);
+    for (int i = 0; i < num_new_blocks; ++i) {
+      blocks_.push_back(chunks_.back().get() +
+                        (static_cast<size_t>(i) << kLogBlockSize));
+    }
+  }
+  return index;
+}
+
+void* ClauseArena::Allocate(int num_literals) {
+  const int64 index = AllocateWords(NumWords(num_literals));
+  SatClause* const clause = Clause(ClauseIndex(index));
+  clause->block_ = index >> kLogBlockSize;
+  return clause;
+}
+
+void ClauseArena::Free(SatClause* clause) {
+  num_live_words_ -= NumWords(clause->Size());
+  clause->size_ = 0;
+}
+
+ClauseIndex ClauseArena::IndexOf(const SatClause* clause) const {
+  const uint64* const address = reinterpret_cast<const uint64*>(clause);
+  const int block = clause->block_;
+  DCHECK_LT(block, blocks_.size());
+  DCHECK(address >= blocks_[block] && address < blocks_[block] + kBlockSize)
+      << "The clause is not in this arena.";
+  return ClauseIndex((block << kLogBlockSize) + (address - blocks_[block]));
+}
+
+bool ClauseArena::CompactionIsWorthIt() const {
+  // We don't bother with small arenas, and otherwise we wait for half of the
+  // memory to be wasted so that the cost of a compaction is amortized.
+  const int64 num_wasted_words = end_ - num_live_words_;
+  return num_wasted_words >= kBlockSize / 8 &&
+         num_wasted_words >= num_live_words_;
+}
+
+void ClauseArena::StartCompaction() {
+  CHECK(old_blocks_.empty());
+  old_blocks_.swap(blocks_);
+  old_chunks_.swap(chunks_);
+  end_ = 0;
+  num_live_words_ = 0;
+  ++num_compactions_;
+}
+
+SatClause* ClauseArena::Relocate(const SatClause* clause) {
+  const int num_words = NumWords(clause->Size());
+  const int64 index = AllocateWords(num_words);
+  SatClause* new_clause = Clause(ClauseIndex(index));
+  memcpy(new_clause, clause, num_words * sizeof(uint64));
+  new_clause->block_ = index >> kLogBlockSize;
+
+  // The first word of the old clause now contains the new index so that
+  // RelocatedIndex() and RelocatedClause() can find it.
+  *reinterpret_cast<uint64*>(const_cast<SatClause*>(clause)) = index;
+  return new_clause;
+}
+
+void ClauseArena::FinishCompaction() {
+  old_blocks_.clear();
+  old_chunks_.clear();
+}
+
 }  // namespace sat
 }  // namespace operations_research
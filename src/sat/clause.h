@@ -19,6 +19,7 @@
 
 #include "base/hash.h"
 #include "base/unique_ptr.h"
+#include <algorithm>
 #include <queue>
 #include <string>
 #include <vector>
@@ -41,6 +42,7 @@ namespace sat {
 
 // Forward declarations.
 // TODO(user): This cyclic dependency can be relatively easily removed.
+class ClauseArena;
 class LiteralWatchers;
 
 // Variable information. This is updated each time we attach/detach a clause.
@@ -62,11 +64,12 @@ struct VariableInfo {
 // the solver needs to keep a few extra fields attached to each clause.
 class SatClause {
  public:
-  // Creates a sat clause. There must be at least 2 literals. Smaller clause are
-  // treated separatly and never constructed. A redundant clause can be removed
-  // without changing the problem.
+  // Creates a sat clause in the given arena which owns its memory. There must
+  // be at least 2 literals. Smaller clause are treated separatly and never
+  // constructed. A redundant clause can be removed without changing the
+  // problem.
   static SatClause* Create(const std::vector<Literal>& literals, bool is_redundant,
-                           ResolutionNode* node);
+                           ResolutionNode* node, ClauseArena* arena);
 
   // Number of literals in the clause.
   int Size() const { return size_; }
@@ -128,13 +131,25 @@ class SatClause {
   double Activity() const { return activity_; }
 
   // Set and get the clause LBD (Literal Blocks Distance). The LBD is not
-  // computed here. See ComputeClauseLbd() in SatSolver.
-  void SetLbd(int value) { lbd_ = value; }
+  // computed here. See ComputeClauseLbd() in SatSolver. It is capped to
+  // kMaxLbd, which does not change the clause cleaning heuristic in practice.
+  static const int kMaxLbd = (1 << 17) - 1;
+  void SetLbd(int value) { lbd_ = std::min(value, kMaxLbd); }
   int Lbd() const { return lbd_; }
 
   // Returns true if the clause is attached to a LiteralWatchers.
   bool IsAttached() const { return is_attached_; }
 
+  // Marks the clause as already vivified by the SatSolver inprocessing so that
+  // the next inprocessing rounds do not spend time on it again.
+  void MarkAsVivified() { is_vivified_ = true; }
+  bool IsVivified() const { return is_vivified_; }
+
+  // Marks the clause as used by a conflict analysis. The SatSolver clears this
+  // mark at each clause cleanup to find the clauses that are still useful.
+  void SetIsUsed(bool value) { is_used_ = value; }
+  bool IsUsed() const { return is_used_; }
+
   // Marks the clause so that the next call to CleanUpWatchers() can identify it
   // and actually detach it.
   void LazyDetach() { is_attached_ = false; }
@@ -152,13 +167,21 @@ class SatClause {
   std::string DebugString() const;
 
  private:
+  friend class ClauseArena;
+
   // The data is packed so that only 16 bytes are used for these fields.
   // Note that the max lbd is the maximum depth of the search tree (decision
-  // levels), so it should fit easily in 30 bits. Note that we can also upper
-  // bound it without hurting too much the clause cleaning heuristic.
+  // levels), it is upper bounded by kMaxLbd without hurting too much the clause
+  // cleaning heuristic.
   bool is_redundant_ : 1;
   bool is_attached_ : 1;
-  int lbd_ : 30;
+  bool is_vivified_ : 1;
+  bool is_used_ : 1;
+  int lbd_ : 17;
+  // The block of the ClauseArena containing the start of the clause. It is set
+  // by the arena, and makes ClauseArena::IndexOf() constant time. A ClauseIndex
+  // is a 32 bits number of words, so there are at most 2^11 blocks.
+  unsigned int block_ : 11;
   int size_ : 32;
   double activity_;
 
@@ -178,12 +201,121 @@ class SatClause {
   DISALLOW_COPY_AND_ASSIGN(SatClause);
 };
 
+// The position of a SatClause in a ClauseArena, in units of 8 bytes.
+DEFINE_INT_TYPE(ClauseIndex, int32);
+
+// Stores the SatClause of a solver in a few big blocks of memory instead of
+// using one heap allocation per clause. The clauses are thus allocated
+// contiguously in their creation order, which improves the memory locality of
+// the propagation, and the LiteralWatchers can refer to them with a 32 bits
+// ClauseIndex instead of a 64 bits pointer.
+//
+// The memory of a freed clause is only reclaimed by a compaction that copies
+// all the live clauses to new blocks. Everything that refers to a clause must
+// then be updated with the Relocated*() functions below:
+//
+//   arena.StartCompaction();
+//   for (SatClause*& clause : clauses) clause = arena.Relocate(clause);
+//   ... update the other references with RelocatedIndex()/RelocatedClause().
+//   arena.FinishCompaction();
+class ClauseArena {
+ public:
+  ClauseArena();
+
+  // Returns the uninitialized memory for a new clause with the given number of
+  // literals. This is only meant to be called by SatClause::Create().
+  void* Allocate(int num_literals);
+
+  // Marks the memory of the given clause as unused. The clause must not be
+  // accessed anymore. Its memory will be reclaimed by the next compaction. Its
+  // size is set to zero, so that a use after Free() sees an empty clause
+  // instead of the old literals.
+  void Free(SatClause* clause);
+
+  // Conversions between a clause and its index, both in constant time. Clause()
+  // is the one used during propagation. IndexOf() uses the block stored in the
+  // clause by Allocate() or Relocate().
+  SatClause* Clause(ClauseIndex index) const {
+    return Clause(blocks_.data(), index);
+  }
+  ClauseIndex IndexOf(const SatClause* clause) const;
+
+  // Same as Clause() but with the block table returned by blocks(). A loop that
+  // does not allocate any clause can keep this table in a local variable which
+  // saves a memory access per clause. The table is invalidated by Allocate().
+  uint64* const* blocks() const { return blocks_.data(); }
+  static SatClause* Clause(uint64* const* blocks, ClauseIndex index) {
+    return reinterpret_cast<SatClause*>(blocks[index.value() >> kLogBlockSize] +
+                                        (index.value() & (kBlockSize - 1)));
+  }
+
+  // Returns true if the freed clauses waste enough memory for a compaction to
+  // be worth its cost.
+  bool CompactionIsWorthIt() const;
+
+  // Functions used to compact the arena, see the class comment. Relocate() must
+  // be called exactly once on each clause that was not freed, and returns its
+  // new address. The other two functions map an old reference to a relocated
+  // clause to its new value, and can only be called before FinishCompaction().
+  void StartCompaction();
+  SatClause* Relocate(const SatClause* clause);
+  ClauseIndex RelocatedIndex(ClauseIndex old_index) const {
+    return ClauseIndex(static_cast<int32>(
+        old_blocks_[old_index.value() >> kLogBlockSize]
+                   [old_index.value() & (kBlockSize - 1)]));
+  }
+  SatClause* RelocatedClause(const SatClause* old_clause) const {
+    return Clause(ClauseIndex(
+        static_cast<int32>(*reinterpret_cast<const uint64*>(old_clause))));
+  }
+  void FinishCompaction();
+
+  // Memory statistics. The number of live bytes is an upper bound because the
+  // literals removed from a clause in place are only reclaimed by the next
+  // compaction.
+  int64 num_used_bytes() const { return 8 * end_; }
+  int64 num_live_bytes() const { return 8 * num_live_words_; }
+  int64 num_compactions() const { return num_compactions_; }
+
+ private:
+  // The arena is made of blocks of kBlockSize words. A clause never crosses a
+  // block boundary, except the ones bigger than a block which are allocated in
+  // a memory chunk spanning as many consecutive blocks as needed.
+  static const int kLogBlockSize = 20;
+  static const int kBlockSize = 1 << kLogBlockSize;
+
+  // Number of words (of 8 bytes) of a clause with the given size.
+  static int NumWords(int num_literals);
+
+  // Reserves the given number of contiguous words and returns the index of the
+  // first one.
+  int64 AllocateWords(int num_words);
+
+  // The start of each block. The block b contains the clauses whose index is
+  // in [b * kBlockSize, (b + 1) * kBlockSize). The memory is owned by chunks_.
+  std::vector<uint64*> blocks_;
+  std::vector<std::unique_ptr<uint64[]>> chunks_;
+
+  // Index of the next free word in the arena.
+  int64 end_;
+
+  // The blocks of the arena being compacted.
+  std::vector<uint64*> old_blocks_;
+  std::vector<std::unique_ptr<uint64[]>> old_chunks_;
+
+  int64 num_live_words_;
+  int64 num_compactions_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClauseArena);
+};
+
 // Stores the 2-watched literals data structure.  See
 // http://www.cs.berkeley.edu/~necula/autded/lecture24-sat.pdf for
 // detail.
 class LiteralWatchers {
  public:
-  LiteralWatchers();
+  // The arena is the one used to create all the clauses given to this class.
+  explicit LiteralWatchers(const ClauseArena* arena);
   ~LiteralWatchers();
 
   // Resizes the data structure.
@@ -205,6 +337,11 @@ class LiteralWatchers {
   void LazyDetach(SatClause* clause);
   void CleanUpWatchers();
 
+  // Updates the watchers after a compaction of the ClauseArena. This must be
+  // called after all the attached clauses were relocated, and the watchers must
+  // be clean.
+  void RelocateWatchers();
+
   // Launches all propagation when the given literal becomes false.
   // Returns false if a contradiction was encountered.
   bool PropagateOnFalse(Literal false_literal, Trail* trail);
@@ -215,6 +352,9 @@ class LiteralWatchers {
     return num_inspected_clause_literals_;
   }
 
+  // Total number of watchers scanned during calls to CleanUpWatchers().
+  int64 num_cleaned_up_watchers() const { return num_cleaned_up_watchers_; }
+
   // Number of clauses currently watched.
   int64 num_watched_clauses() const { return num_watched_clauses_; }
 
@@ -235,14 +375,16 @@ class LiteralWatchers {
   void UpdateStatistics(const SatClause& clause, bool added);
 
   // Contains, for each literal, the list of clauses that need to be inspected
-  // when the corresponding literal becomes false.
+  // when the corresponding literal becomes false. A Watcher uses only 8 bytes
+  // so that a cache line covers 8 of them.
   struct Watcher {
     Watcher() {}
-    Watcher(SatClause* c, Literal b) : clause(c), blocking_literal(b) {}
-    SatClause* clause;
+    Watcher(ClauseIndex c, Literal b) : clause_index(c), blocking_literal(b) {}
+    ClauseIndex clause_index;
     Literal blocking_literal;
   };
   ITIVector<LiteralIndex, std::vector<Watcher> > watchers_on_false_;
+  const ClauseArena* arena_;
 
   // Indicates if the corresponding watchers_on_false_ list need to be
   // cleaned. The boolean is_clean_ is just used in DCHECKs.
@@ -253,6 +395,7 @@ class LiteralWatchers {
   SatParameters parameters_;
   int64 num_inspected_clauses_;
   int64 num_inspected_clause_literals_;
+  int64 num_cleaned_up_watchers_;
   int64 num_watched_clauses_;
   mutable StatsGroup stats_;
   DISALLOW_COPY_AND_ASSIGN(LiteralWatchers);
@@ -303,11 +446,6 @@ class BinaryClauseManager {
 // Special class to store and propagate clauses of size 2 (i.e. implication).
 // Such clauses are never deleted.
 //
-// TODO(user): All the variables in a strongly connected component are
-// equivalent and can be thus merged as one. This is relatively cheap to compute
-// from time to time (linear complexity). We will also get contradiction (a <=>
-// not a) this way.
-//
 // TODO(user): An implication (a => not a) implies that a is false. I am not
 // sure it is worth detecting that because if the solver assign a to true, it
 // will learn that right away. I don't think we can do it faster.
@@ -389,6 +527,33 @@ class BinaryImplicationGraph {
   void RemoveFixedVariables(int first_unprocessed_trail_index,
                             const Trail& trail);
 
+  // Returns the literals directly implied by the given one. That is the other
+  // literal of all the binary clauses containing its negation.
+  const std::vector<Literal>& Implications(Literal literal) const {
+    return implications_[literal.Index()];
+  }
+
+  // All the literals in a strongly connected component of the implication
+  // graph are equivalent. This computes these components (ignoring the
+  // assigned variables) and fills representative so that representative[l] is
+  // the smallest literal of the component of l. It is cleared if there is no
+  // component with more than one literal. Returns false if a literal is
+  // equivalent to its negation, which means that the problem is UNSAT.
+  //
+  // This is linear in the size of the graph, and the number of arcs inspected
+  // is added to num_inspections().
+  bool DetectEquivalences(const VariablesAssignment& assignment,
+                          ITIVector<LiteralIndex, LiteralIndex>* representative);
+
+  // Rewrites the graph using a representative mapping computed by
+  // DetectEquivalences(). All the implications are moved to the
+  // representatives, and each other literal l is only linked to its
+  // representative with the two implications l => r and r => l. This way the
+  // propagation keeps all the literals of a component consistent while their
+  // implications are only stored once.
+  void SubstituteEquivalentLiterals(
+      const ITIVector<LiteralIndex, LiteralIndex>& representative);
+
   // Number of literal propagated by this class (including conflicts).
   int64 num_propagations() const { return num_propagations_; }
 
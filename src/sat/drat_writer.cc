@@ -0,0 +1,124 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sat/drat_writer.h"
+
+#include "base/logging.h"
+#include "base/status.h"
+
+namespace operations_research {
+namespace sat {
+
+namespace {
+
+// The buffer is written to the file once it is larger than this.
+const int kBufferSize = 1 << 16;
+
+}  // namespace
+
+DratWriter::DratWriter(bool in_binary_format, File* output)
+    : in_binary_format_(in_binary_format),
+      output_(output),
+      num_initial_variables_(0),
+      num_added_clauses_(0),
+      num_deleted_clauses_(0) {
+  CHECK(output_ != nullptr);
+  buffer_.reserve(2 * kBufferSize);
+}
+
+DratWriter::~DratWriter() {
+  FlushBuffer();
+  CHECK(output_->Close());
+  delete output_;
+}
+
+void DratWriter::SetNumVariables(int num_variables) {
+  while (reverse_mapping_.size() < num_variables) {
+    reverse_mapping_.push_back(VariableIndex(num_initial_variables_));
+    ++num_initial_variables_;
+  }
+}
+
+void DratWriter::ApplyMapping(
+    const ITIVector<VariableIndex, VariableIndex>& mapping) {
+  ITIVector<VariableIndex, VariableIndex> new_mapping;
+  for (VariableIndex v(0); v < mapping.size(); ++v) {
+    const VariableIndex image = mapping[v];
+    if (image == VariableIndex(-1)) continue;
+    if (image >= new_mapping.size()) {
+      new_mapping.resize(image.value() + 1, VariableIndex(-1));
+    }
+    CHECK_EQ(new_mapping[image], VariableIndex(-1));
+    CHECK_LT(v, reverse_mapping_.size());
+    new_mapping[image] = reverse_mapping_[v];
+  }
+  std::swap(new_mapping, reverse_mapping_);
+}
+
+void DratWriter::AddClause(ClauseRef clause) {
+  if (in_binary_format_) buffer_.push_back('a');
+  WriteClause(clause);
+  ++num_added_clauses_;
+}
+
+void DratWriter::DeleteClause(ClauseRef clause) {
+  buffer_.push_back('d');
+  if (!in_binary_format_) buffer_.push_back(' ');
+  WriteClause(clause);
+  ++num_deleted_clauses_;
+}
+
+void DratWriter::WriteClause(ClauseRef clause) {
+  char digits[16];
+  for (const Literal literal : clause) {
+    CHECK_LT(literal.Variable(), reverse_mapping_.size());
+    const VariableIndex var = reverse_mapping_[literal.Variable()];
+    CHECK_NE(var, VariableIndex(-1));
+
+    // The variables are numbered from 1 in the DRAT format, and the binary
+    // format encodes a literal as 2 * variable + sign using 7 bits per byte
+    // (the high bit indicates that more bytes follow).
+    uint32 value = var.value() + 1;
+    if (in_binary_format_) {
+      value = 2 * value + (literal.IsPositive() ? 0 : 1);
+      while (value > 127) {
+        buffer_.push_back(static_cast<char>((value & 127) | 128));
+        value >>= 7;
+      }
+      buffer_.push_back(static_cast<char>(value));
+    } else {
+      if (!literal.IsPositive()) buffer_.push_back('-');
+      int num_digits = 0;
+      do {
+        digits[num_digits++] = '0' + value % 10;
+        value /= 10;
+      } while (value > 0);
+      while (num_digits > 0) buffer_.push_back(digits[--num_digits]);
+      buffer_.push_back(' ');
+    }
+  }
+  if (in_binary_format_) {
+    buffer_.push_back(0);
+  } else {
+    buffer_.append("0\n");
+  }
+  if (buffer_.size() > kBufferSize) FlushBuffer();
+}
+
+void DratWriter::FlushBuffer() {
+  CHECK(file::WriteString(output_, buffer_, file::Defaults()).ok());
+  buffer_.clear();
+}
+
+}  // namespace sat
+}  // namespace operations_research
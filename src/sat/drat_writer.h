@@ -0,0 +1,94 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains a streaming writer of UNSAT proofs in the DRAT format.
+// Contrary to the in-memory resolution DAG of unsat_proof.h, nothing is kept
+// in memory apart from a small output buffer, and the proof can be verified by
+// an external checker like drat-trim:
+// - Marijn J. H. Heule, Warren A. Hunt Jr., Nathan Wetzler, "Trimming while
+//   Checking Clausal Proofs", FMCAD 2013.
+// - The binary format: https://www.cs.utexas.edu/~marijn/drat-trim/
+
+#ifndef OR_TOOLS_SAT_DRAT_WRITER_H_
+#define OR_TOOLS_SAT_DRAT_WRITER_H_
+
+#include <string>
+
+#include "base/file.h"
+#include "base/int_type_indexed_vector.h"
+#include "base/macros.h"
+#include "sat/sat_base.h"
+
+namespace operations_research {
+namespace sat {
+
+// Writes a DRAT proof of the clauses added to or deleted from a clause
+// database. The proof is only valid if each added clause can be checked by
+// "reverse unit propagation" (RUP) from the problem clauses and the clauses
+// added and not yet deleted before it, which is the case for the clauses
+// learned by conflict analysis and for most clause simplifications. Deleting
+// a clause is always valid, but it speeds up the check.
+//
+// The literals are written in terms of the variables of the initial problem,
+// even after some presolve steps remapped the variables, see ApplyMapping().
+class DratWriter {
+ public:
+  // The writer takes ownership of the given file, and closes it on
+  // destruction. In binary format, the proof is about twice smaller and
+  // faster to write and to parse.
+  DratWriter(bool in_binary_format, File* output);
+  ~DratWriter();
+
+  // Sets the number of variables of the current problem. The new variables
+  // are mapped to new variables of the initial problem.
+  void SetNumVariables(int num_variables);
+
+  // This is the same as SatPostsolver::ApplyMapping(): all the subsequent
+  // clauses will refer to the new variables, where mapping[v] is the new index
+  // of the variable v, or -1 if it was deleted.
+  void ApplyMapping(const ITIVector<VariableIndex, VariableIndex>& mapping);
+
+  // Writes a clause addition (resp. deletion) to the proof. Adding the empty
+  // clause means that the problem is proven UNSAT.
+  void AddClause(ClauseRef clause);
+  void DeleteClause(ClauseRef clause);
+
+  // Number of lines of the proof written so far.
+  int64 num_added_clauses() const { return num_added_clauses_; }
+  int64 num_deleted_clauses() const { return num_deleted_clauses_; }
+
+ private:
+  void WriteClause(ClauseRef clause);
+
+  // Appends the buffer to the output file and clears it.
+  void FlushBuffer();
+
+  const bool in_binary_format_;
+  File* output_;
+  std::string buffer_;
+
+  // The variable of the initial problem for each variable of the current one,
+  // and the number of variables of the initial problem.
+  ITIVector<VariableIndex, VariableIndex> reverse_mapping_;
+  int num_initial_variables_;
+
+  int64 num_added_clauses_;
+  int64 num_deleted_clauses_;
+
+  DISALLOW_COPY_AND_ASSIGN(DratWriter);
+};
+
+}  // namespace sat
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_SAT_DRAT_WRITER_H_
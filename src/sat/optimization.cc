@@ -13,9 +13,13 @@
 
 #include "sat/optimization.h"
 
+#include <atomic>
 #include <deque>
 #include <queue>
 
+#include "base/callback.h"
+#include "base/mutex.h"
+#include "base/threadpool.h"
 #include "google/protobuf/descriptor.h"
 #include "sat/encoding.h"
 
@@ -50,6 +54,94 @@ std::string CnfObjectiveLine(const LinearBooleanProblem& problem,
   return StringPrintf("o %lld", static_cast<int64>(scaled_objective));
 }
 
+// The state shared by the two threads of SolveWithParallelCoreAndLinearScan().
+// All the functions are thread-safe.
+class SharedOptimizationState {
+ public:
+  SharedOptimizationState(LogBehavior log, const LinearBooleanProblem& problem)
+      : logger_(log),
+        problem_(problem),
+        stop_(false),
+        upper_bound_(kCoefficientMax),
+        lower_bound_(kint64min),
+        status_(SatSolver::LIMIT_REACHED) {}
+
+  // Keeps the given feasible solution if it is better than the best one found
+  // so far, and logs its objective.
+  void AddSolution(const std::vector<bool>& solution) {
+    const Coefficient objective = ComputeObjectiveValue(problem_, solution);
+    MutexLock mutex_lock(&mutex_);
+    if (objective >= upper_bound_) return;
+    upper_bound_ = objective;
+    solution_ = solution;
+    logger_.Log(CnfObjectiveLine(problem_, objective));
+  }
+
+  // The objective of the best solution found so far (kCoefficientMax if there
+  // is none), and a lower bound on the optimal objective (kint64min if there
+  // is none). These are in the same unit as ComputeObjectiveValue(), which may
+  // be negative.
+  Coefficient upper_bound() {
+    MutexLock mutex_lock(&mutex_);
+    return upper_bound_;
+  }
+  Coefficient lower_bound() {
+    MutexLock mutex_lock(&mutex_);
+    return lower_bound_;
+  }
+  void UpdateLowerBound(Coefficient lower_bound) {
+    MutexLock mutex_lock(&mutex_);
+    lower_bound_ = std::max(lower_bound_, lower_bound);
+  }
+
+  // The cores only made of initial objective literals are valid clauses for
+  // all the solutions better than the best one. They are exported as such by
+  // the core-based thread and imported by the linear scan one. Each call to
+  // GetNewCores() returns the cores added since the previous call.
+  void AddCore(const std::vector<Literal>& clause) {
+    MutexLock mutex_lock(&mutex_);
+    cores_.push_back(clause);
+  }
+  void GetNewCores(int* num_imported_cores,
+                   std::vector<std::vector<Literal>>* cores) {
+    MutexLock mutex_lock(&mutex_);
+    cores->assign(cores_.begin() + *num_imported_cores, cores_.end());
+    *num_imported_cores = cores_.size();
+  }
+
+  // Called by a thread whose search is over. The first such call fixes the
+  // final status and asks the other thread to abort.
+  void NotifyFinished(SatSolver::Status status) {
+    MutexLock mutex_lock(&mutex_);
+    if (status_ != SatSolver::LIMIT_REACHED) return;
+    status_ = status;
+    stop_ = true;
+  }
+  const std::atomic<bool>* stop() const { return &stop_; }
+
+  // The final result, once all the threads are done.
+  SatSolver::Status status() {
+    MutexLock mutex_lock(&mutex_);
+    return status_;
+  }
+  std::vector<bool> solution() {
+    MutexLock mutex_lock(&mutex_);
+    return solution_;
+  }
+
+ private:
+  Logger logger_;
+  const LinearBooleanProblem& problem_;
+  std::atomic<bool> stop_;
+
+  Mutex mutex_;
+  Coefficient upper_bound_ GUARDED_BY(mutex_);
+  Coefficient lower_bound_ GUARDED_BY(mutex_);
+  std::vector<bool> solution_ GUARDED_BY(mutex_);
+  std::vector<std::vector<Literal>> cores_ GUARDED_BY(mutex_);
+  SatSolver::Status status_ GUARDED_BY(mutex_);
+};
+
 struct LiteralWithCoreIndex {
   LiteralWithCoreIndex(Literal l, int i) : literal(l), core_index(i) {}
   Literal literal;
@@ -806,10 +898,15 @@ SatSolver::Status SolveWithRandomParameters(LogBehavior log,
   return SatSolver::LIMIT_REACHED;
 }
 
-SatSolver::Status SolveWithLinearScan(LogBehavior log,
-                                      const LinearBooleanProblem& problem,
-                                      SatSolver* solver,
-                                      std::vector<bool>* solution) {
+namespace {
+
+// Implementation of SolveWithLinearScan(). If shared is not nullptr, the
+// solutions are exchanged with the other threads of
+// SolveWithParallelCoreAndLinearScan(), and the search also uses their best
+// objective, their lower bound and their cores.
+SatSolver::Status SolveWithLinearScanInternal(
+    LogBehavior log, const LinearBooleanProblem& problem, SatSolver* solver,
+    std::vector<bool>* solution, SharedOptimizationState* shared) {
   Logger logger(log);
 
   // This has a big positive impact on most problems.
@@ -820,7 +917,23 @@ SatSolver::Status SolveWithLinearScan(LogBehavior log,
     CHECK(IsAssignmentValid(problem, *solution));
     objective = ComputeObjectiveValue(problem, *solution);
   }
+  int num_imported_cores = 0;
+  std::vector<std::vector<Literal>> cores;
   while (true) {
+    if (shared != nullptr) {
+      objective = std::min(objective, shared->upper_bound());
+      if (objective != kCoefficientMax && shared->lower_bound() >= objective) {
+        return SatSolver::MODEL_SAT;
+      }
+      solver->Backtrack(0);
+      shared->GetNewCores(&num_imported_cores, &cores);
+      for (const std::vector<Literal>& core : cores) {
+        if (!solver->AddProblemClause(core)) {
+          if (objective == kCoefficientMax) return SatSolver::MODEL_UNSAT;
+          return SatSolver::MODEL_SAT;
+        }
+      }
+    }
     if (objective != kCoefficientMax) {
       // Over constrain the objective.
       solver->Backtrack(0);
@@ -848,10 +961,24 @@ SatSolver::Status SolveWithLinearScan(LogBehavior log,
     const Coefficient old_objective = objective;
     objective = ComputeObjectiveValue(problem, *solution);
     CHECK_LT(objective, old_objective);
-    logger.Log(CnfObjectiveLine(problem, objective));
+    if (shared != nullptr) {
+      shared->AddSolution(*solution);
+    } else {
+      logger.Log(CnfObjectiveLine(problem, objective));
+    }
   }
 }
 
+}  // namespace
+
+SatSolver::Status SolveWithLinearScan(LogBehavior log,
+                                      const LinearBooleanProblem& problem,
+                                      SatSolver* solver,
+                                      std::vector<bool>* solution) {
+  return SolveWithLinearScanInternal(log, problem, solver, solution,
+                                     /*shared=*/nullptr);
+}
+
 SatSolver::Status SolveWithCardinalityEncoding(
     LogBehavior log, const LinearBooleanProblem& problem, SatSolver* solver,
     std::vector<bool>* solution) {
@@ -932,11 +1059,11 @@ bool EncodingNodeByDepth(const EncodingNode* a, const EncodingNode* b) {
 
 bool EmptyEncodingNode(const EncodingNode* a) { return a->size() == 0; }
 
-}  // namespace
-
-SatSolver::Status SolveWithCardinalityEncodingAndCore(
+// Implementation of SolveWithCardinalityEncodingAndCore(). The shared state is
+// used like in SolveWithLinearScanInternal().
+SatSolver::Status SolveWithCardinalityEncodingAndCoreInternal(
     LogBehavior log, const LinearBooleanProblem& problem, SatSolver* solver,
-    std::vector<bool>* solution) {
+    std::vector<bool>* solution, SharedOptimizationState* shared) {
   Logger logger(log);
   SatParameters parameters = solver->parameters();
   std::deque<EncodingNode> repository;
@@ -981,6 +1108,13 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
     for (EncodingNode* n : nodes) {
       lower_bound += n->Reduce(*solver) * n->weight();
     }
+    if (shared != nullptr) {
+      shared->UpdateLowerBound(lower_bound - offset);
+      const Coefficient shared_upper_bound = shared->upper_bound();
+      if (shared_upper_bound != kCoefficientMax) {
+        upper_bound = std::min(upper_bound, shared_upper_bound + offset);
+      }
+    }
 
     // Fix the nodes right-most variables that are above the gap.
     if (upper_bound != kCoefficientMax) {
@@ -1043,7 +1177,11 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
       const Coefficient obj = ComputeObjectiveValue(problem, temp_solution);
       if (obj + offset < upper_bound) {
         *solution = temp_solution;
-        logger.Log(CnfObjectiveLine(problem, obj));
+        if (shared != nullptr) {
+          shared->AddSolution(temp_solution);
+        } else {
+          logger.Log(CnfObjectiveLine(problem, obj));
+        }
         upper_bound = obj + offset;
       }
 
@@ -1070,6 +1208,7 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
     // Compute the min weight of all the nodes in the core.
     // The lower bound will be increased by that much.
     Coefficient min_weight = kCoefficientMax;
+    bool core_has_only_leaf_nodes = true;
     {
       int index = 0;
       for (int i = 0; i < core.size(); ++i) {
@@ -1079,8 +1218,17 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
         }
         CHECK_LT(index, nodes.size());
         min_weight = std::min(min_weight, nodes[index]->weight());
+        if (nodes[index]->depth() > 0) core_has_only_leaf_nodes = false;
       }
     }
+
+    // The literals of the leaf nodes are the ones of the problem objective, so
+    // such a core is also a valid clause for the other solvers.
+    if (shared != nullptr && core_has_only_leaf_nodes) {
+      std::vector<Literal> clause;
+      for (const Literal literal : core) clause.push_back(literal.Negated());
+      shared->AddCore(clause);
+    }
     previous_core_info =
         StringPrintf("core:%zu mw:%lld", core.size(), min_weight.value());
 
@@ -1148,5 +1296,84 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
   }
 }
 
+// The two threads of SolveWithParallelCoreAndLinearScan().
+class ParallelOptimizationWorkers {
+ public:
+  ParallelOptimizationWorkers(LogBehavior log,
+                              const LinearBooleanProblem& problem,
+                              SatSolver* core_solver, SatSolver* linear_solver,
+                              SharedOptimizationState* shared)
+      : log_(log),
+        problem_(problem),
+        core_solver_(core_solver),
+        linear_solver_(linear_solver),
+        shared_(shared) {}
+
+  void RunWorker(int worker_id) {
+    std::vector<bool> solution = shared_->solution();
+    SatSolver::Status status;
+    if (worker_id == 0) {
+      status = SolveWithCardinalityEncodingAndCoreInternal(
+          log_, problem_, core_solver_, &solution, shared_);
+    } else {
+      status = SolveWithLinearScanInternal(log_, problem_, linear_solver_,
+                                           &solution, shared_);
+    }
+    if (status != SatSolver::LIMIT_REACHED) shared_->NotifyFinished(status);
+  }
+
+ private:
+  const LogBehavior log_;
+  const LinearBooleanProblem& problem_;
+  SatSolver* const core_solver_;
+  SatSolver* const linear_solver_;
+  SharedOptimizationState* const shared_;
+};
+
+}  // namespace
+
+SatSolver::Status SolveWithCardinalityEncodingAndCore(
+    LogBehavior log, const LinearBooleanProblem& problem, SatSolver* solver,
+    std::vector<bool>* solution) {
+  return SolveWithCardinalityEncodingAndCoreInternal(log, problem, solver,
+                                                     solution,
+                                                     /*shared=*/nullptr);
+}
+
+SatSolver::Status SolveWithParallelCoreAndLinearScan(
+    LogBehavior log, const LinearBooleanProblem& problem,
+    SatSolver* core_solver, SatSolver* linear_solver,
+    std::vector<bool>* solution) {
+  SharedOptimizationState shared(log, problem);
+  if (!solution->empty()) {
+    CHECK(IsAssignmentValid(problem, *solution));
+    shared.AddSolution(*solution);
+  }
+  core_solver->GetTimeLimit()->RegisterExternalBooleanAsLimit(shared.stop());
+  linear_solver->GetTimeLimit()->RegisterExternalBooleanAsLimit(shared.stop());
+  ParallelOptimizationWorkers workers(log, problem, core_solver,
+                                      linear_solver, &shared);
+  {
+    ThreadPool thread_pool("ParallelOptimization", 2);
+    for (int worker_id = 0; worker_id < 2; ++worker_id) {
+      thread_pool.Add(NewCallback(&workers,
+                                  &ParallelOptimizationWorkers::RunWorker,
+                                  worker_id));
+    }
+    thread_pool.StartWorkers();
+  }
+  core_solver->GetTimeLimit()->RegisterExternalBooleanAsLimit(nullptr);
+  linear_solver->GetTimeLimit()->RegisterExternalBooleanAsLimit(nullptr);
+
+  // A thread may prove that there is no solution better than the best one,
+  // which may have been found by the other thread.
+  *solution = shared.solution();
+  const SatSolver::Status status = shared.status();
+  if (status == SatSolver::MODEL_UNSAT && !solution->empty()) {
+    return SatSolver::MODEL_SAT;
+  }
+  return status;
+}
+
 }  // namespace sat
 }  // namespace operations_research
@@ -112,6 +112,22 @@ SatSolver::Status SolveWithCardinalityEncodingAndCore(
     LogBehavior log, const LinearBooleanProblem& problem, SatSolver* solver,
     std::vector<bool>* solution);
 
+// Runs SolveWithCardinalityEncodingAndCore() on core_solver and
+// SolveWithLinearScan() on linear_solver in two threads. The threads share
+// their best solution: the core-based one uses its objective to fix the nodes
+// above the gap and the linear scan one constrains its objective below it.
+// The lower bound of the core-based thread and its cores that only involve
+// objective literals are also used by the linear scan thread. The first thread
+// to prove optimality (or infeasibility) stops the other one.
+//
+// The problem is assumed to be already loaded into both solvers. Note that the
+// encoding nodes are specific to core_solver, only the objective literals are
+// common to both solvers.
+SatSolver::Status SolveWithParallelCoreAndLinearScan(
+    LogBehavior log, const LinearBooleanProblem& problem,
+    SatSolver* core_solver, SatSolver* linear_solver,
+    std::vector<bool>* solution);
+
 }  // namespace sat
 }  // namespace operations_research
 
@@ -16,6 +16,17 @@
 #include "base/fingerprint2011.h"
 #include "util/saturated_arithmetic.h"
 
+// The SIMD kernels are compiled with the target attribute of gcc and clang so
+// that the rest of the code does not depend on the compilation flags, and the
+// instruction set is chosen at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAT_X86_KERNELS
+#include <immintrin.h>
+#if defined(__clang__) || __GNUC__ >= 5
+#define SAT_AVX512_KERNELS
+#endif
+#endif
+
 namespace operations_research {
 namespace sat {
 
@@ -32,8 +43,235 @@ bool CoeffComparator(const LiteralWithCoeff& a, const LiteralWithCoeff& b) {
   return a.coefficient < b.coefficient;
 }
 
+// ---------------------------------------------------------------------------
+// Threshold update kernels of PbConstraints. They perform
+// thresholds[indices[i]] -= coefficients[i] (or +=) for all i in [0, size). A
+// constraint appears at most once in the list of a literal, so the indices are
+// distinct and the SIMD versions can update several thresholds at once.
+// ---------------------------------------------------------------------------
+
+// Returns the minimum of zero and of the updated thresholds.
+int64 SubtractCoefficientsAndGetMinScalar(const int32* indices,
+                                          const int64* coefficients, int size,
+                                          Coefficient* thresholds) {
+  int64 min_threshold = 0;
+  for (int i = 0; i < size; ++i) {
+    const int64 threshold = thresholds[indices[i]].value() - coefficients[i];
+    thresholds[indices[i]] = Coefficient(threshold);
+    min_threshold = std::min(min_threshold, threshold);
+  }
+  return min_threshold;
+}
+
+void AddCoefficientsScalar(const int32* indices, const int64* coefficients,
+                           int size, Coefficient* thresholds) {
+  for (int i = 0; i < size; ++i) {
+    thresholds[indices[i]] =
+        Coefficient(thresholds[indices[i]].value() + coefficients[i]);
+  }
+}
+
+const PbThresholdKernels kScalarKernels = {PbInstructionSet::SCALAR,
+                                           &SubtractCoefficientsAndGetMinScalar,
+                                           &AddCoefficientsScalar};
+
+#if defined(SAT_X86_KERNELS)
+
+// The thresholds are only read and written by the gather and scatter
+// instructions through this address, never by a C++ expression of another
+// type.
+COMPILE_ASSERT(sizeof(Coefficient) == sizeof(long long),
+               Coefficient_is_gathered_as_a_64_bit_integer);
+inline const long long* GatherAddress(const Coefficient* thresholds) {
+  return reinterpret_cast<const long long*>(thresholds);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels. AVX2 can gather 4 thresholds at once but has no scatter, so the
+// updated thresholds are stored one by one.
+// ---------------------------------------------------------------------------
+
+#define SAT_TARGET_AVX2 __attribute__((target("avx2")))
+
+SAT_TARGET_AVX2 inline __m256i UpdatedThresholdsAvx2(
+    const int32* indices, const int64* coefficients, int64 sign,
+    const Coefficient* thresholds) {
+  const __m128i index_vector =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices));
+  const __m256i coefficient_vector =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefficients));
+  const __m256i gathered =
+      _mm256_i32gather_epi64(GatherAddress(thresholds), index_vector, 8);
+  return sign > 0 ? _mm256_add_epi64(gathered, coefficient_vector)
+                  : _mm256_sub_epi64(gathered, coefficient_vector);
+}
+
+SAT_TARGET_AVX2 int64 SubtractCoefficientsAndGetMinAvx2(
+    const int32* indices, const int64* coefficients, int size,
+    Coefficient* thresholds) {
+  __m256i min_vector = _mm256_setzero_si256();
+  int64 lanes[4];
+  const int end = size - size % 4;
+  for (int i = 0; i < end; i += 4) {
+    const __m256i threshold_vector = UpdatedThresholdsAvx2(
+        indices + i, coefficients + i, -1, thresholds);
+    // There is no 64-bit integer minimum before AVX-512.
+    min_vector = _mm256_blendv_epi8(
+        min_vector, threshold_vector,
+        _mm256_cmpgt_epi64(min_vector, threshold_vector));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), threshold_vector);
+    for (int j = 0; j < 4; ++j) {
+      thresholds[indices[i + j]] = Coefficient(lanes[j]);
+    }
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), min_vector);
+  const int64 min_threshold =
+      std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+  return std::min(min_threshold, SubtractCoefficientsAndGetMinScalar(
+                                     indices + end, coefficients + end,
+                                     size - end, thresholds));
+}
+
+SAT_TARGET_AVX2 void AddCoefficientsAvx2(const int32* indices,
+                                         const int64* coefficients, int size,
+                                         Coefficient* thresholds) {
+  int64 lanes[4];
+  const int end = size - size % 4;
+  for (int i = 0; i < end; i += 4) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(lanes),
+        UpdatedThresholdsAvx2(indices + i, coefficients + i, 1, thresholds));
+    for (int j = 0; j < 4; ++j) {
+      thresholds[indices[i + j]] = Coefficient(lanes[j]);
+    }
+  }
+  AddCoefficientsScalar(indices + end, coefficients + end, size - end,
+                        thresholds);
+}
+
+const PbThresholdKernels kAvx2Kernels = {PbInstructionSet::AVX2,
+                                         &SubtractCoefficientsAndGetMinAvx2,
+                                         &AddCoefficientsAvx2};
+
+#if defined(SAT_AVX512_KERNELS)
+
+// ---------------------------------------------------------------------------
+// AVX-512 kernels, 8 thresholds are updated at once with a gather and a
+// scatter.
+// ---------------------------------------------------------------------------
+
+#define SAT_TARGET_AVX512 __attribute__((target("avx512f")))
+
+SAT_TARGET_AVX512 int64 SubtractCoefficientsAndGetMinAvx512(
+    const int32* indices, const int64* coefficients, int size,
+    Coefficient* thresholds) {
+  __m512i min_vector = _mm512_setzero_si512();
+  const int end = size - size % 8;
+  for (int i = 0; i < end; i += 8) {
+    const __m256i index_vector =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+    const __m512i threshold_vector = _mm512_sub_epi64(
+        _mm512_i32gather_epi64(index_vector, GatherAddress(thresholds), 8),
+        _mm512_loadu_si512(coefficients + i));
+    _mm512_i32scatter_epi64(thresholds, index_vector, threshold_vector, 8);
+    min_vector = _mm512_min_epi64(min_vector, threshold_vector);
+  }
+  int64 lanes[8];
+  _mm512_storeu_si512(lanes, min_vector);
+  int64 min_threshold = 0;
+  for (int j = 0; j < 8; ++j) min_threshold = std::min(min_threshold, lanes[j]);
+  return std::min(min_threshold, SubtractCoefficientsAndGetMinScalar(
+                                     indices + end, coefficients + end,
+                                     size - end, thresholds));
+}
+
+SAT_TARGET_AVX512 void AddCoefficientsAvx512(const int32* indices,
+                                             const int64* coefficients,
+                                             int size,
+                                             Coefficient* thresholds) {
+  const int end = size - size % 8;
+  for (int i = 0; i < end; i += 8) {
+    const __m256i index_vector =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+    const __m512i threshold_vector = _mm512_add_epi64(
+        _mm512_i32gather_epi64(index_vector, GatherAddress(thresholds), 8),
+        _mm512_loadu_si512(coefficients + i));
+    _mm512_i32scatter_epi64(thresholds, index_vector, threshold_vector, 8);
+  }
+  AddCoefficientsScalar(indices + end, coefficients + end, size - end,
+                        thresholds);
+}
+
+const PbThresholdKernels kAvx512Kernels = {PbInstructionSet::AVX512,
+                                           &SubtractCoefficientsAndGetMinAvx512,
+                                           &AddCoefficientsAvx512};
+
+#endif  // SAT_AVX512_KERNELS
+#endif  // SAT_X86_KERNELS
+
+const PbThresholdKernels& GetPbThresholdKernels(
+    PbInstructionSet instruction_set) {
+  CHECK(IsPbInstructionSetSupported(instruction_set))
+      << GetPbInstructionSetString(instruction_set);
+  switch (instruction_set) {
+#if defined(SAT_X86_KERNELS)
+    case PbInstructionSet::AVX2:
+      return kAvx2Kernels;
+#if defined(SAT_AVX512_KERNELS)
+    case PbInstructionSet::AVX512:
+      return kAvx512Kernels;
+#endif  // SAT_AVX512_KERNELS
+#endif  // SAT_X86_KERNELS
+    default:
+      return kScalarKernels;
+  }
+}
+
+// Note that the AVX2 kernels are never chosen by default: without a scatter,
+// they are not faster than the scalar ones on pb_propagation_benchmark.
+const PbThresholdKernels* FindBestPbThresholdKernels() {
+  if (IsPbInstructionSetSupported(PbInstructionSet::AVX512)) {
+    VLOG(1) << "Using the AVX512 pseudo-Boolean threshold kernels.";
+    return &GetPbThresholdKernels(PbInstructionSet::AVX512);
+  }
+  return &kScalarKernels;
+}
+
 }  // namespace
 
+std::string GetPbInstructionSetString(PbInstructionSet instruction_set) {
+  switch (instruction_set) {
+    case PbInstructionSet::SCALAR:
+      return "SCALAR";
+    case PbInstructionSet::AVX2:
+      return "AVX2";
+    case PbInstructionSet::AVX512:
+      return "AVX512";
+  }
+  // Fallback. We don't use "default:" so the compiler will return an error
+  // if we forgot one enum case above.
+  return "UNKNOWN PbInstructionSet";
+}
+
+bool IsPbInstructionSetSupported(PbInstructionSet instruction_set) {
+  switch (instruction_set) {
+    case PbInstructionSet::SCALAR:
+      return true;
+#if defined(SAT_X86_KERNELS)
+    case PbInstructionSet::AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#if defined(SAT_AVX512_KERNELS)
+    case PbInstructionSet::AVX512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif  // SAT_AVX512_KERNELS
+#endif  // SAT_X86_KERNELS
+    default:
+      return false;
+  }
+}
+
 bool ComputeBooleanLinearExpressionCanonicalForm(std::vector<LiteralWithCoeff>* cst,
                                                  Coefficient* bound_shift,
                                                  Coefficient* max_value) {
@@ -802,6 +1040,17 @@ void UpperBoundedLinearConstraint::Untrail(Coefficient* threshold,
   }
 }
 
+// static
+const PbThresholdKernels& PbConstraints::BestThresholdKernels() {
+  static const PbThresholdKernels* const kernels =
+      FindBestPbThresholdKernels();
+  return *kernels;
+}
+
+void PbConstraints::SetInstructionSet(PbInstructionSet instruction_set) {
+  kernels_ = &GetPbThresholdKernels(instruction_set);
+}
+
 // TODO(user): This is relatively slow. Take the "transpose" all at once, and
 // maybe put small constraints first on the to_update_ lists.
 bool PbConstraints::AddConstraint(const std::vector<LiteralWithCoeff>& cst,
@@ -839,6 +1088,7 @@ bool PbConstraints::AddConstraint(const std::vector<LiteralWithCoeff>& cst,
         // ResolutionNode. TODO(user): The old one could be unlocked at this
         // point.
         candidate->ChangeResolutionNode(node);
+        AddProcessedLiteralsToUntrail(cst, i);
         return candidate->InitializeRhs(rhs, propagation_trail_index_,
                                         &thresholds_[i], trail_,
                                         &conflict_scratchpad_);
@@ -861,13 +1111,36 @@ bool PbConstraints::AddConstraint(const std::vector<LiteralWithCoeff>& cst,
   constraints_.emplace_back(c.release());
   for (LiteralWithCoeff term : cst) {
     DCHECK_LT(term.literal.Index(), to_update_.size());
-    to_update_[term.literal.Index()].push_back(ConstraintIndexWithCoeff(
-        trail_->Assignment().IsVariableAssigned(term.literal.Variable()),
-        cst_index, term.coefficient));
+    LiteralUpdates& updates = to_update_[term.literal.Index()];
+    updates.indices.push_back(cst_index.value());
+    updates.coefficients.push_back(term.coefficient.value());
   }
+  AddProcessedLiteralsToUntrail(cst, cst_index);
   return true;
 }
 
+void PbConstraints::AddProcessedLiteralsToUntrail(
+    const std::vector<LiteralWithCoeff>& cst, ConstraintIndex cst_index) {
+  const int old_size = constraints_to_untrail_.size();
+  for (LiteralWithCoeff term : cst) {
+    if (!trail_->Assignment().IsLiteralTrue(term.literal)) continue;
+    const int trail_index = trail_->Info(term.literal.Variable()).trail_index;
+    if (trail_index < propagation_trail_index_) {
+      constraints_to_untrail_.push_back(
+          ConstraintToUntrail(trail_index, cst_index));
+    }
+  }
+
+  // Restore the increasing trail index order of constraints_to_untrail_.
+  if (constraints_to_untrail_.size() > old_size) {
+    const auto middle = constraints_to_untrail_.begin() + old_size;
+    std::sort(middle, constraints_to_untrail_.end());
+    std::inplace_merge(
+        std::upper_bound(constraints_to_untrail_.begin(), middle, *middle),
+        middle, constraints_to_untrail_.end());
+  }
+}
+
 bool PbConstraints::AddLearnedConstraint(const std::vector<LiteralWithCoeff>& cst,
                                          Coefficient rhs,
                                          ResolutionNode* node) {
@@ -891,52 +1164,63 @@ bool PbConstraints::PropagateNext() {
   ++propagation_trail_index_;
 
   // We need to upate ALL threshold, otherwise the Untrail() will not be
-  // synchronized.
-  bool conflict = false;
-  num_threshold_updates_ += to_update_[true_literal.Index()].size();
-  for (ConstraintIndexWithCoeff& update : to_update_[true_literal.Index()]) {
-    const Coefficient threshold =
-        thresholds_[update.index] - update.coefficient;
-    thresholds_[update.index] = threshold;
-    if (threshold < 0 && !conflict) {
-      UpperBoundedLinearConstraint* const cst =
-          constraints_[update.index.value()].get();
-      update.need_untrail_inspection = true;
-      ++num_constraint_lookups_;
-      const int old_value = cst->already_propagated_end();
-      if (!cst->Propagate(order, &thresholds_[update.index], trail_,
-                          &conflict_scratchpad_)) {
-        trail_->SetFailingClause(ClauseRef(conflict_scratchpad_));
-        trail_->SetFailingResolutionNode(cst->ResolutionNodePointer());
-        conflicting_constraint_index_ = update.index;
-        conflict = true;
-
-        // We bump the activity of the conflict.
-        BumpActivity(constraints_[update.index.value()].get());
-      }
-      num_inspected_constraint_literals_ +=
-          old_value - cst->already_propagated_end();
+  // synchronized. This is done in a first pass that only streams through the
+  // two arrays of the literal, and since most of the time no threshold becomes
+  // negative, the second pass that calls Propagate() is usually skipped.
+  const LiteralUpdates& updates = to_update_[true_literal.Index()];
+  const int num_updates = updates.indices.size();
+  num_threshold_updates_ += num_updates;
+  if (kernels_->subtract_coefficients_and_get_min(
+          updates.indices.data(), updates.coefficients.data(), num_updates,
+          thresholds_.data()) >= 0) {
+    return true;
+  }
+
+  // Note that each constraint appears at most once in the list of a literal,
+  // so the threshold of a constraint can't be changed by the Propagate() of
+  // another one.
+  for (const int32 i : updates.indices) {
+    const ConstraintIndex index(i);
+    if (thresholds_[index] >= 0) continue;
+    UpperBoundedLinearConstraint* const cst = constraints_[index.value()].get();
+    constraints_to_untrail_.push_back(ConstraintToUntrail(order, index));
+    ++num_constraint_lookups_;
+    const int old_value = cst->already_propagated_end();
+    const bool ok = cst->Propagate(order, &thresholds_[index], trail_,
+                                   &conflict_scratchpad_);
+    num_inspected_constraint_literals_ +=
+        old_value - cst->already_propagated_end();
+    if (!ok) {
+      trail_->SetFailingClause(ClauseRef(conflict_scratchpad_));
+      trail_->SetFailingResolutionNode(cst->ResolutionNodePointer());
+      conflicting_constraint_index_ = index;
+
+      // We bump the activity of the conflict.
+      BumpActivity(cst);
+      return false;
     }
   }
-  return !conflict;
+  return true;
 }
 
 void PbConstraints::Untrail(int trail_index) {
   SCOPED_TIME_STAT(&stats_);
-  to_untrail_.ClearAndResize(ConstraintIndex(constraints_.size()));
   while (propagation_trail_index_ > trail_index) {
     --propagation_trail_index_;
     const Literal literal = (*trail_)[propagation_trail_index_];
-    for (ConstraintIndexWithCoeff& update : to_update_[literal.Index()]) {
-      thresholds_[update.index] += update.coefficient;
-
-      // Only the constraints which where inspected during Propagate() need
-      // inspection during Untrail().
-      if (update.need_untrail_inspection) {
-        update.need_untrail_inspection = false;
-        to_untrail_.Set(update.index);
-      }
-    }
+    const LiteralUpdates& updates = to_update_[literal.Index()];
+    kernels_->add_coefficients(updates.indices.data(),
+                               updates.coefficients.data(),
+                               updates.indices.size(), thresholds_.data());
+  }
+
+  // Only the constraints which where inspected during Propagate() need
+  // inspection during Untrail().
+  to_untrail_.ClearAndResize(ConstraintIndex(constraints_.size()));
+  while (!constraints_to_untrail_.empty() &&
+         constraints_to_untrail_.back().trail_index >= trail_index) {
+    to_untrail_.Set(constraints_to_untrail_.back().index);
+    constraints_to_untrail_.pop_back();
   }
   for (ConstraintIndex cst_index : to_untrail_.PositionsSetAtLeastOnce()) {
     constraints_[cst_index.value()]->Untrail(&(thresholds_[cst_index]),
@@ -1081,18 +1365,30 @@ void PbConstraints::DeleteConstraintMarkedForDeletion() {
   // This is the slow part, we need to remap all the ConstraintIndex to the
   // new ones.
   for (LiteralIndex lit(0); lit < to_update_.size(); ++lit) {
-    std::vector<ConstraintIndexWithCoeff>& updates = to_update_[lit];
+    LiteralUpdates& updates = to_update_[lit];
     int new_index = 0;
-    for (int i = 0; i < updates.size(); ++i) {
-      const ConstraintIndex m = index_mapping[updates[i].index];
+    for (int i = 0; i < updates.indices.size(); ++i) {
+      const ConstraintIndex m =
+          index_mapping[ConstraintIndex(updates.indices[i])];
       if (m != -1) {
-        updates[new_index] = updates[i];
-        updates[new_index].index = m;
+        updates.indices[new_index] = m.value();
+        updates.coefficients[new_index] = updates.coefficients[i];
         ++new_index;
       }
     }
-    updates.resize(new_index);
+    updates.indices.resize(new_index);
+    updates.coefficients.resize(new_index);
+  }
+  int new_size = 0;
+  for (const ConstraintToUntrail& entry : constraints_to_untrail_) {
+    const ConstraintIndex m = index_mapping[entry.index];
+    if (m != -1) {
+      constraints_to_untrail_[new_size] =
+          ConstraintToUntrail(entry.trail_index, m);
+      ++new_size;
+    }
   }
+  constraints_to_untrail_.resize(new_size);
 }
 
 }  // namespace sat
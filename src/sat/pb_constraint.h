@@ -16,6 +16,7 @@
 
 #include <deque>
 #include <limits>
+#include <string>
 #include "sat/sat_base.h"
 #include "sat/sat_parameters.pb.h"
 #include "util/stats.h"
@@ -479,12 +480,44 @@ class UpperBoundedLinearConstraint {
   int64 hash_;
 };
 
+// The instruction sets for which the threshold updates of PbConstraints are
+// implemented. The SIMD ones are only available on x86 with gcc or clang. There
+// is no SSE version since the updates need gather instructions.
+enum class PbInstructionSet { SCALAR = 0, AVX2 = 1, AVX512 = 2 };
+
+std::string GetPbInstructionSetString(PbInstructionSet instruction_set);
+
+// Returns true if the kernels for the given instruction set are compiled in
+// and supported by the CPU.
+bool IsPbInstructionSetSupported(PbInstructionSet instruction_set);
+
+// The threshold update loops of PbConstraints for one instruction set. They
+// perform thresholds[indices[i]] -= coefficients[i] (resp. +=) for the i in
+// [0, size), and the indices must be distinct. The first one also returns the
+// minimum of zero and of the updated thresholds.
+struct PbThresholdKernels {
+  PbInstructionSet instruction_set;
+  int64 (*subtract_coefficients_and_get_min)(const int32* indices,
+                                             const int64* coefficients,
+                                             int size, Coefficient* thresholds);
+  void (*add_coefficients)(const int32* indices, const int64* coefficients,
+                           int size, Coefficient* thresholds);
+};
+
 // Class responsible for managing a set of pseudo-Boolean constraints and their
 // propagation.
+//
+// Each assignment updates the threshold (i.e. the slack) of all the constraints
+// that contain the assigned literal. Note that a propagation that only watches
+// a subset of the literals of each constraint, like the two watched literals of
+// the clauses, would not touch all these thresholds. It is not implemented
+// because UpperBoundedLinearConstraint::Propagate(), Untrail() and the PB
+// conflict analysis rely on the thresholds being exact for the current trail.
 class PbConstraints {
  public:
   explicit PbConstraints(Trail* trail)
       : trail_(trail),
+        kernels_(&BestThresholdKernels()),
         propagation_trail_index_(0),
         conflicting_constraint_index_(-1),
         num_learned_constraint_before_cleanup_(0),
@@ -505,7 +538,7 @@ class PbConstraints {
   void Resize(int num_variables) {
     // Note that we avoid using up memory in the common case where there is no
     // pb constraints at all. If there is 10 million variables, this vector
-    // alone will take 480 MB!
+    // alone will take 960 MB!
     if (!constraints_.empty()) to_update_.resize(num_variables << 1);
   }
 
@@ -514,6 +547,15 @@ class PbConstraints {
     parameters_ = parameters;
   }
 
+  // Changes the instruction set of the threshold updates done by
+  // PropagateNext() and Untrail(). It must be supported. By default, AVX512 is
+  // used if it is supported and SCALAR otherwise. This is mainly useful for
+  // benchmarks.
+  void SetInstructionSet(PbInstructionSet instruction_set);
+  PbInstructionSet instruction_set() const {
+    return kernels_->instruction_set;
+  }
+
   // Adds a constraint in canonical form to the set of managed constraints. Note
   // that this detects constraints with exactly the same terms. In this case,
   // the constraint rhs is updated if the new one is lower or nothing is done
@@ -591,6 +633,19 @@ class PbConstraints {
   int64 num_threshold_updates() const { return num_threshold_updates_; }
 
  private:
+  // Each constraint managed by this class is associated with an index.
+  // The set of indices is always [0, num_constraints_).
+  //
+  // Note(user): this complicate things during deletion, but the propagation is
+  // about two times faster with this implementation than one with direct
+  // pointer to an UpperBoundedLinearConstraint. The main reason for this is
+  // probably that the thresholds_ vector is a lot more efficient cache-wise.
+  DEFINE_INT_TYPE(ConstraintIndex, int32);
+
+  // Returns the default kernels, see SetInstructionSet(). The CPU is only
+  // inspected on the first call.
+  static const PbThresholdKernels& BestThresholdKernels();
+
   // Same function as the clause related one is SatSolver().
   // TODO(user): Remove duplication.
   void ComputeNewLearnedConstraintLimit();
@@ -601,27 +656,44 @@ class PbConstraints {
   // terms in all constraints).
   void DeleteConstraintMarkedForDeletion();
 
-  // Each constraint managed by this class is associated with an index.
-  // The set of indices is always [0, num_constraints_).
-  //
-  // Note(user): this complicate things during deletion, but the propagation is
-  // about two times faster with this implementation than one with direct
-  // pointer to an UpperBoundedLinearConstraint. The main reason for this is
-  // probably that the thresholds_ vector is a lot more efficient cache-wise.
-  DEFINE_INT_TYPE(ConstraintIndex, int32);
-  struct ConstraintIndexWithCoeff {
-    ConstraintIndexWithCoeff() {}  // Needed for vector.resize()
-    ConstraintIndexWithCoeff(bool n, ConstraintIndex i, Coefficient c)
-        : need_untrail_inspection(n), index(i), coefficient(c) {}
-    bool need_untrail_inspection;
+  // The state of a constraint computed by InitializeRhs() depends on its
+  // literals already processed by PropagateNext(), so the constraint must be
+  // inspected by Untrail() when any of them is untrailed.
+  void AddProcessedLiteralsToUntrail(const std::vector<LiteralWithCoeff>& cst,
+                                     ConstraintIndex cst_index);
+
+  // The constraints that contain a given literal, together with the literal
+  // coefficient in these constraints. The two vectors are parallel, this
+  // "structure of arrays" layout uses 12 bytes per term instead of the 16 bytes
+  // of an aligned struct, and the threshold update loops in PropagateNext() and
+  // Untrail() only stream through these two arrays. They contain the values of
+  // the ConstraintIndex and of the Coefficient, as expected by the kernels.
+  struct LiteralUpdates {
+    std::vector<int32> indices;
+    std::vector<int64> coefficients;
+  };
+
+  // A constraint on which Propagate() was called (or that was added with some
+  // of its literals already assigned) and the trail index of the literal that
+  // caused it. UpperBoundedLinearConstraint::Untrail() must be called on this
+  // constraint when this literal is untrailed.
+  struct ConstraintToUntrail {
+    ConstraintToUntrail() {}  // Needed for vector.resize()
+    ConstraintToUntrail(int t, ConstraintIndex i) : trail_index(t), index(i) {}
+    bool operator<(const ConstraintToUntrail& other) const {
+      return trail_index < other.trail_index;
+    }
+    int trail_index;
     ConstraintIndex index;
-    Coefficient coefficient;
   };
 
   // The solver trail that contains the variables assignements and all the
   // assignment info.
   Trail* trail_;
 
+  // The threshold update loops, see SetInstructionSet().
+  const PbThresholdKernels* kernels_;
+
   // Index of the first assigned variable from the trail that is not yet
   // processed by this class.
   int propagation_trail_index_;
@@ -637,9 +709,13 @@ class PbConstraints {
 
   // For each literal, the list of all the constraints that contains it together
   // with the literal coefficient in these constraints.
-  ITIVector<LiteralIndex, std::vector<ConstraintIndexWithCoeff>> to_update_;
+  ITIVector<LiteralIndex, LiteralUpdates> to_update_;
 
-  // Bitset used to optimize the Untrail() function.
+  // Only the constraints inspected by Propagate() need to be inspected by
+  // Untrail(). They are kept here by increasing trail index, so Untrail() just
+  // pops the ones that are untrailed. The bitset is used to call
+  // UpperBoundedLinearConstraint::Untrail() once per constraint.
+  std::vector<ConstraintToUntrail> constraints_to_untrail_;
   SparseBitset<ConstraintIndex> to_untrail_;
 
   // Pointers to the constraints grouped by their hash.
@@ -392,6 +392,13 @@ class Trail {
     return info_[var];
   }
 
+  // Changes the clause that propagated a variable. This is needed when the
+  // clauses are moved in memory, see ClauseArena.
+  void ChangeSatClauseReason(VariableIndex var, SatClause* clause) {
+    DCHECK_EQ(info_[var].type, AssignmentInfo::CLAUSE_PROPAGATION);
+    info_[var].sat_clause = clause;
+  }
+
   // Sets the new resolution node for a variable that is fixed.
   void SetFixedVariableInfo(VariableIndex var, ResolutionNode* node) {
     CHECK_EQ(info_[var].level, 0);
@@ -0,0 +1,254 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sat/sat_portfolio.h"
+
+#include "base/callback.h"
+#include "base/logging.h"
+#include "base/mutex.h"
+#include "base/threadpool.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+namespace sat {
+
+SharedClausePool::SharedClausePool(int num_workers, int buffer_size) {
+  CHECK_GT(num_workers, 0);
+  CHECK_GT(buffer_size, 0);
+  for (int i = 0; i < num_workers; ++i) {
+    buffers_.emplace_back(new RingBuffer(buffer_size));
+  }
+  read_positions_.assign(num_workers, std::vector<int64>(num_workers, 0));
+}
+
+void SharedClausePool::AddClause(int worker_id, ClauseRef clause) {
+  RingBuffer* const buffer = buffers_[worker_id].get();
+  const int64 capacity = buffer->data.size();
+  if (clause.size() + 1 > capacity) return;
+
+  // Only this thread writes write_position, so a relaxed load is enough.
+  int64 position = buffer->write_position.load(std::memory_order_relaxed);
+  buffer->data[position % capacity].store(clause.size(),
+                                          std::memory_order_relaxed);
+  ++position;
+  for (const Literal literal : clause) {
+    buffer->data[position % capacity].store(literal.Index().value(),
+                                            std::memory_order_relaxed);
+    ++position;
+  }
+  buffer->write_position.store(position, std::memory_order_release);
+  ++buffer->num_published_clauses;
+}
+
+void SharedClausePool::GetNewClauses(
+    int worker_id, std::vector<std::vector<Literal>>* clauses) {
+  std::vector<int64>& read_positions = read_positions_[worker_id];
+  for (int writer = 0; writer < buffers_.size(); ++writer) {
+    if (writer == worker_id) continue;
+    RingBuffer* const buffer = buffers_[writer].get();
+    const int64 capacity = buffer->data.size();
+    const int64 write_position =
+        buffer->write_position.load(std::memory_order_acquire);
+    int64 position = read_positions[writer];
+
+    // If we were lapped, the clause boundaries are lost. We just skip
+    // everything that was written so far.
+    if (write_position - position > capacity) {
+      ++buffers_[worker_id]->num_skipped_clauses;
+      read_positions[writer] = write_position;
+      continue;
+    }
+    while (position < write_position) {
+      const int size =
+          buffer->data[position % capacity].load(std::memory_order_relaxed);
+
+      // A size that doesn't make sense means that the writer lapped us while
+      // we were reading the previous clauses.
+      if (size < 1 || position + size + 1 > write_position) {
+        ++buffers_[worker_id]->num_skipped_clauses;
+        position = write_position;
+        break;
+      }
+      clauses->push_back(std::vector<Literal>());
+      std::vector<Literal>& clause = clauses->back();
+      clause.reserve(size);
+      for (int i = 1; i <= size; ++i) {
+        clause.push_back(Literal(LiteralIndex(
+            buffer->data[(position + i) % capacity].load(
+                std::memory_order_relaxed))));
+      }
+
+      // Check that the writer didn't overwrite the words we just read. Note
+      // that the acquire fence orders the relaxed loads above before the load
+      // of the write position.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (buffer->write_position.load(std::memory_order_relaxed) - position >
+          capacity) {
+        clauses->pop_back();
+        ++buffers_[worker_id]->num_skipped_clauses;
+        position = write_position;
+        break;
+      }
+      position += size + 1;
+    }
+    read_positions[writer] = position;
+  }
+}
+
+SatParameters PortfolioWorkerParameters(const SatParameters& parameters,
+                                        int worker_id) {
+  SatParameters result = parameters;
+  result.set_num_search_workers(1);
+  if (worker_id == 0) return result;
+  result.set_random_seed(parameters.random_seed() + worker_id);
+  result.set_log_search_progress(false);
+
+  // Each group of four consecutive workers covers the different restart
+  // policies.
+  switch (worker_id % 4) {
+    case 0:
+      result.set_restart_algorithm(SatParameters::DL_MOVING_AVERAGE_RESTART);
+      result.set_random_polarity_ratio(0.01);
+      break;
+    case 1:
+      result.set_restart_algorithm(SatParameters::LUBY_RESTART);
+      break;
+    case 2:
+      result.set_restart_algorithm(SatParameters::LBD_MOVING_AVERAGE_RESTART);
+      result.set_use_blocking_restart(true);
+      result.set_clause_cleanup_ordering(SatParameters::CLAUSE_LBD);
+      result.set_clause_cleanup_tier2_lbd_bound(6);
+      result.set_update_clause_lbd_during_conflict_analysis(true);
+      break;
+    case 3:
+      result.set_restart_algorithm(SatParameters::LUBY_RESTART);
+      result.set_luby_restart_period(3 * parameters.luby_restart_period());
+      result.set_use_phase_saving(false);
+      break;
+  }
+
+  // Every other group of four uses the opposite initial polarity.
+  if ((worker_id / 4) % 2 == 1) {
+    result.set_initial_polarity(
+        parameters.initial_polarity() == SatParameters::POLARITY_FALSE
+            ? SatParameters::POLARITY_TRUE
+            : SatParameters::POLARITY_FALSE);
+  }
+
+  // With many workers, some of them also take a few random decisions.
+  if (worker_id >= 8) {
+    result.set_random_branches_ratio(0.01);
+  }
+  return result;
+}
+
+namespace {
+
+// Size in words of the per-worker ring buffers of the SharedClausePool.
+const int kSharedClauseBufferSize = 1 << 20;
+
+// The state shared by all the threads of SolveWithPortfolio().
+class PortfolioState {
+ public:
+  PortfolioState(const SatParameters& parameters,
+                 const std::vector<SatSolver*>& solvers)
+      : parameters_(parameters),
+        solvers_(solvers),
+        stop_(false),
+        status_(SatSolver::LIMIT_REACHED),
+        first_to_finish_(-1) {}
+
+  void RunWorker(int worker_id) {
+    TimeLimit time_limit(parameters_.max_time_in_seconds(),
+                         parameters_.max_deterministic_time());
+    time_limit.RegisterExternalBooleanAsLimit(&stop_);
+    const SatSolver::Status status =
+        solvers_[worker_id]->SolveWithTimeLimit(&time_limit);
+    if (status == SatSolver::LIMIT_REACHED) return;
+
+    MutexLock mutex_lock(&mutex_);
+    if (first_to_finish_ == -1) {
+      first_to_finish_ = worker_id;
+      status_ = status;
+      stop_ = true;
+    }
+  }
+
+  SatSolver::Status status() const {
+    MutexLock mutex_lock(&mutex_);
+    return status_;
+  }
+  int first_to_finish() const {
+    MutexLock mutex_lock(&mutex_);
+    return first_to_finish_;
+  }
+
+ private:
+  const SatParameters& parameters_;
+  const std::vector<SatSolver*>& solvers_;
+  std::atomic<bool> stop_;
+
+  mutable Mutex mutex_;
+  SatSolver::Status status_ GUARDED_BY(mutex_);
+  int first_to_finish_ GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+SatSolver::Status SolveWithPortfolio(const SatParameters& parameters,
+                                     const std::vector<SatSolver*>& solvers,
+                                     int* first_to_finish) {
+  const int num_workers = solvers.size();
+  CHECK_GT(num_workers, 0);
+
+  // Clause sharing is incompatible with the resolution DAG needed to compute
+  // unsat cores since the imported clauses have no resolution node.
+  std::unique_ptr<SharedClausePool> pool;
+  if (num_workers > 1 && parameters.max_shared_clause_size() > 0 &&
+      !parameters.unsat_proof()) {
+    pool.reset(new SharedClausePool(num_workers, kSharedClauseBufferSize));
+  }
+  for (int worker_id = 0; worker_id < num_workers; ++worker_id) {
+    solvers[worker_id]->SetParameters(
+        PortfolioWorkerParameters(parameters, worker_id));
+    solvers[worker_id]->SetSharedClausePool(pool.get(), worker_id);
+  }
+
+  PortfolioState state(parameters, solvers);
+  {
+    ThreadPool thread_pool("SatPortfolio", num_workers);
+    for (int worker_id = 0; worker_id < num_workers; ++worker_id) {
+      thread_pool.Add(
+          NewCallback(&state, &PortfolioState::RunWorker, worker_id));
+    }
+    thread_pool.StartWorkers();
+  }
+
+  for (int worker_id = 0; worker_id < num_workers; ++worker_id) {
+    solvers[worker_id]->SetSharedClausePool(nullptr, 0);
+  }
+  if (parameters.log_search_progress()) {
+    for (int worker_id = 0; worker_id < num_workers; ++worker_id) {
+      LOG(INFO) << "Worker #" << worker_id << ": "
+                << solvers[worker_id]->num_failures() << " conflicts, "
+                << (pool == nullptr ? 0 : pool->num_published_clauses(worker_id))
+                << " shared clauses"
+                << (worker_id == state.first_to_finish() ? " (winner)" : "");
+    }
+  }
+  *first_to_finish = state.first_to_finish();
+  return state.status();
+}
+
+}  // namespace sat
+}  // namespace operations_research
@@ -0,0 +1,132 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A multi-threaded portfolio driver for the SatSolver: many solvers with
+// diversified parameters race on the same problem, exchange their short
+// learned clauses, and the first one to finish stops all the others.
+
+#ifndef OR_TOOLS_SAT_SAT_PORTFOLIO_H_
+#define OR_TOOLS_SAT_SAT_PORTFOLIO_H_
+
+#include <atomic>
+#include "base/unique_ptr.h"
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "sat/sat_base.h"
+#include "sat/sat_parameters.pb.h"
+#include "sat/sat_solver.h"
+
+namespace operations_research {
+namespace sat {
+
+// A lock-free exchange of learned clauses between the workers of a portfolio.
+//
+// Each worker owns a ring buffer in which it is the only one to write the
+// clauses it wants to share (single producer), and it reads the ring buffers
+// of all the other workers (multiple consumers). Nothing ever blocks: a reader
+// that is lapped by a writer just skips the overwritten clauses. This is fine
+// because clause sharing is only a heuristic, and all the clauses that go
+// through this class are implied by the problem.
+//
+// The clauses are stored as a size followed by the literal indices. A clause
+// is published by a release store of the write position after all its words
+// were written, and a reader checks after copying a clause that the writer did
+// not overwrite it in the meantime.
+class SharedClausePool {
+ public:
+  // The buffer_size is the number of words of each per-worker ring buffer. A
+  // clause uses its size plus one words.
+  SharedClausePool(int num_workers, int buffer_size);
+
+  int NumWorkers() const { return buffers_.size(); }
+
+  // Publishes the given clause to the other workers. This must only be called
+  // from the thread running the given worker. Clauses that do not fit in a
+  // ring buffer are silently ignored.
+  void AddClause(int worker_id, ClauseRef clause);
+
+  // Appends to clauses all the clauses published by the other workers since
+  // the last call to this function with the same worker_id. This must only be
+  // called from the thread running the given worker.
+  void GetNewClauses(int worker_id, std::vector<std::vector<Literal>>* clauses);
+
+  // Number of clauses published and read through this pool. Note that these
+  // counters are only updated by the owner of each ring buffer, so reading
+  // them while the workers run only gives an approximate value.
+  int64 num_published_clauses(int worker_id) const {
+    return buffers_[worker_id]->num_published_clauses;
+  }
+  int64 num_skipped_clauses(int worker_id) const {
+    return buffers_[worker_id]->num_skipped_clauses;
+  }
+
+ private:
+  struct RingBuffer {
+    explicit RingBuffer(int size)
+        : data(size),
+          write_position(0),
+          num_published_clauses(0),
+          num_skipped_clauses(0) {}
+
+    // The words are atomic (but only accessed with relaxed ordering) so that a
+    // reader racing with a writer that laps it is not undefined behavior.
+    std::vector<std::atomic<int32>> data;
+
+    // Number of words written since the creation of the buffer. The word of
+    // position p is stored in data[p % data.size()].
+    std::atomic<int64> write_position;
+
+    // Statistics, owned by the writer (resp. the reader) of this buffer.
+    int64 num_published_clauses;
+    int64 num_skipped_clauses;
+  };
+
+  std::vector<std::unique_ptr<RingBuffer>> buffers_;
+
+  // read_positions_[reader][writer] is the position in the ring buffer of the
+  // given writer up to which the given reader already read. Only the reader
+  // accesses its row.
+  std::vector<std::vector<int64>> read_positions_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedClausePool);
+};
+
+// Returns the parameters of the given worker of a portfolio. The worker 0 uses
+// the given parameters unchanged, and the other ones diversify the restart
+// policy, the polarity and the random seed so that they explore different
+// parts of the search space.
+SatParameters PortfolioWorkerParameters(const SatParameters& parameters,
+                                        int worker_id);
+
+// Solves the problem loaded in all the given solvers (they must all contain
+// the same problem) by running them concurrently, one thread per solver, with
+// the parameters computed by PortfolioWorkerParameters() from the given ones.
+// The solvers exchange their short learned clauses through a SharedClausePool
+// according to the max_shared_clause_size() and max_shared_clause_lbd()
+// parameters.
+//
+// The first solver to return anything other than LIMIT_REACHED stops all the
+// others. Its status is returned, and its index in solvers is stored in
+// first_to_finish, so that the caller can retrieve its assignment. If all the
+// solvers reach their limit, this returns LIMIT_REACHED and first_to_finish is
+// set to -1.
+SatSolver::Status SolveWithPortfolio(const SatParameters& parameters,
+                                     const std::vector<SatSolver*>& solvers,
+                                     int* first_to_finish);
+
+}  // namespace sat
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_SAT_SAT_PORTFOLIO_H_
@@ -24,6 +24,8 @@
 #include "base/join.h"
 #include "util/saturated_arithmetic.h"
 #include "base/stl_util.h"
+#include "sat/sat_portfolio.h"
+#include "sat/simplification.h"
 
 namespace operations_research {
 namespace sat {
@@ -31,6 +33,7 @@ namespace sat {
 SatSolver::SatSolver()
     : num_variables_(0),
       num_constraints_(0),
+      watched_clauses_(&clause_arena_),
       pb_constraints_(&trail_),
       symmetry_propagator_(&trail_),
       track_binary_clauses_(false),
@@ -50,6 +53,13 @@ SatSolver::SatSolver()
       target_number_of_learned_clauses_(0),
       conflicts_until_next_restart_(0),
       restart_count_(0),
+      shared_clause_pool_(nullptr),
+      worker_id_(0),
+      drat_writer_(nullptr),
+      num_solves_(0),
+      deterministic_time_at_last_inprocessing_(0.0),
+      inprocessing_deterministic_time_(0.0),
+      next_literal_to_probe_(0),
       same_reason_identifier_(trail_),
       is_relevant_for_core_computation_(true),
       time_limit_(new TimeLimit(std::numeric_limits<double>::infinity(),
@@ -80,7 +90,6 @@ SatSolver::~SatSolver() {
       unsat_proof_.UnlockNode(node);
     }
   }
-  STLDeleteElements(&clauses_);
 }
 
 void SatSolver::SetNumVariables(int num_variables) {
@@ -91,6 +100,7 @@ void SatSolver::SetNumVariables(int num_variables) {
   binary_implication_graph_.Resize(num_variables);
   watched_clauses_.Resize(num_variables);
   trail_.Resize(num_variables);
+  if (drat_writer_ != nullptr) drat_writer_->SetNumVariables(num_variables);
   pb_constraints_.Resize(num_variables);
   decisions_.resize(num_variables);
   same_reason_identifier_.Resize(num_variables);
@@ -99,17 +109,39 @@ void SatSolver::SetNumVariables(int num_variables) {
   activities_.resize(num_variables, 0.0);
   pq_need_update_for_var_at_trail_index_.Resize(num_variables);
   weighted_sign_.resize(num_variables, 0.0);
-  queue_elements_.resize(num_variables);
 
   // Only reset the polarity of the new variables.
   ResetPolarity(VariableIndex(polarity_.size()));
 
-  // Important: Because there is new variables, we need to recompute the
-  // priority queue. Note that this will not reset the activity, it will however
-  // change the order of the element with the same priority.
-  //
-  // TODO(user): Not even do that and just push the new ones at the end?
-  is_var_ordering_initialized_ = false;
+  // The priority queue contains pointers to the queue_elements_ which may be
+  // reallocated, so we save the variables in heap order and add them back.
+  // Since they already form a valid heap, this is linear and preserves the
+  // current order, contrary to a call to InitializeVariableOrdering(). This
+  // matters for the incremental use where a few variables are added between
+  // each Solve(). The new variables have no activity and are simply pushed at
+  // the end of the queue.
+  const VariableIndex old_num_variables(queue_elements_.size());
+  if (!is_var_ordering_initialized_) {
+    queue_elements_.resize(num_variables);
+    return;
+  }
+  std::vector<VariableIndex> queued_variables;
+  queued_variables.reserve(var_ordering_.Size());
+  for (const WeightedVarQueueElement* element : *var_ordering_.Raw()) {
+    queued_variables.push_back(element->variable);
+  }
+  queue_elements_.resize(num_variables);
+  var_ordering_.Clear();
+  for (const VariableIndex var : queued_variables) {
+    var_ordering_.Add(&queue_elements_[var]);
+  }
+  for (VariableIndex var = old_num_variables; var < num_variables_; ++var) {
+    queue_elements_[var].variable = var;
+    queue_elements_[var].weight = 0.0;
+    if (!trail_.Assignment().IsVariableAssigned(var)) {
+      var_ordering_.Add(&queue_elements_[var]);
+    }
+  }
 }
 
 int64 SatSolver::num_branches() const { return counters_.num_branches; }
@@ -120,6 +152,10 @@ int64 SatSolver::num_propagations() const {
   return trail_.NumberOfEnqueues() - counters_.num_branches;
 }
 
+int64 SatSolver::num_inprocessing_rounds() const {
+  return counters_.num_inprocessing_rounds;
+}
+
 double SatSolver::deterministic_time() const {
   // Each of these counters mesure really basic operations.
   // The weight are just an estimate of the operation complexity.
@@ -130,6 +166,8 @@ double SatSolver::deterministic_time() const {
                  1.0 * binary_implication_graph_.num_inspections() +
                  4.0 * watched_clauses_.num_inspected_clauses() +
                  1.0 * watched_clauses_.num_inspected_clause_literals() +
+                 1.0 * watched_clauses_.num_cleaned_up_watchers() +
+                 1.0 * counters_.num_subsumption_inspected_literals +
 
                  // Here there is a factor 2 because of the untrail.
                  20.0 * pb_constraints_.num_constraint_lookups() +
@@ -175,6 +213,9 @@ bool SatSolver::IsMemoryLimitReached() const {
 }
 
 bool SatSolver::SetModelUnsat() {
+  if (drat_writer_ != nullptr && !is_model_unsat_) {
+    drat_writer_->AddClause(ClauseRef());
+  }
   is_model_unsat_ = true;
   return false;
 }
@@ -183,6 +224,14 @@ bool SatSolver::AddUnitClause(Literal true_literal) {
   SCOPED_TIME_STAT(&stats_);
   CHECK_EQ(CurrentDecisionLevel(), 0);
   if (is_model_unsat_) return false;
+  if (!scope_selectors_.empty()) {
+    // In a scope, this is a binary clause with the negated selector.
+    return AddProblemClause(std::vector<Literal>(1, true_literal));
+  }
+  return AddUnitClauseOutsideOfScopes(true_literal);
+}
+
+bool SatSolver::AddUnitClauseOutsideOfScopes(Literal true_literal) {
   if (trail_.Assignment().IsLiteralFalse(true_literal)) return SetModelUnsat();
   if (trail_.Assignment().IsLiteralTrue(true_literal)) return true;
   trail_.EnqueueWithUnitReason(true_literal, CreateRootResolutionNode());
@@ -251,17 +300,17 @@ bool SatSolver::AddProblemClauseInternal(const std::vector<Literal>& literals,
     trail_.EnqueueWithUnitReason(literals[0], node);  // Not assigned.
     return true;
   }
-  // Create a new clause.
-  std::unique_ptr<SatClause> clause(
-      SatClause::Create(literals, /*is_redundant=*/false, node));
-
-  if (parameters_.treat_binary_clauses_separately() && clause->Size() == 2) {
-    AddBinaryClauseInternal(clause->FirstLiteral(), clause->SecondLiteral());
+  if (parameters_.treat_binary_clauses_separately() && literals.size() == 2) {
+    AddBinaryClauseInternal(literals[0], literals[1]);
   } else {
-    if (!watched_clauses_.AttachAndPropagate(clause.get(), &trail_)) {
+    // Create a new clause.
+    SatClause* clause = SatClause::Create(literals, /*is_redundant=*/false,
+                                          node, &clause_arena_);
+    if (!watched_clauses_.AttachAndPropagate(clause, &trail_)) {
+      clause_arena_.Free(clause);
       return SetModelUnsat();
     }
-    clauses_.push_back(clause.release());
+    clauses_.push_back(clause);
   }
   return true;
 }
@@ -310,6 +359,32 @@ bool SatSolver::AddLinearConstraintInternal(const std::vector<LiteralWithCoeff>&
   return pb_constraints_.AddConstraint(cst, rhs, node);
 }
 
+bool SatSolver::AddScopedLinearConstraintInternal(
+    const std::vector<LiteralWithCoeff>& cst, Coefficient rhs,
+    Coefficient max_value) {
+  SCOPED_TIME_STAT(&stats_);
+  if (scope_selectors_.empty() || rhs >= max_value) {
+    return AddLinearConstraintInternal(cst, rhs, max_value);
+  }
+
+  // The constraint "cst <= rhs" is relaxed to "cst <= rhs + slack * not(s)"
+  // where s is the selector and slack = max_value - rhs, which is always true
+  // when s is false. Since not(s) = 1 - s, this is equivalent to the canonical
+  // constraint "cst + slack * s <= max_value". Note that for a clause, this
+  // just adds the literal not(s) to it.
+  const Coefficient slack = max_value - rhs;
+  tmp_scoped_constraint_ = cst;
+  tmp_scoped_constraint_.push_back(
+      LiteralWithCoeff(scope_selectors_.back(), slack));
+  Coefficient bound_shift;
+  Coefficient new_max_value;
+  CHECK(ComputeBooleanLinearExpressionCanonicalForm(
+      &tmp_scoped_constraint_, &bound_shift, &new_max_value));
+  DCHECK_EQ(bound_shift, Coefficient(0));
+  return AddLinearConstraintInternal(tmp_scoped_constraint_, max_value,
+                                     new_max_value);
+}
+
 bool SatSolver::AddLinearConstraint(bool use_lower_bound,
                                     Coefficient lower_bound,
                                     bool use_upper_bound,
@@ -351,7 +426,7 @@ bool SatSolver::AddLinearConstraint(bool use_lower_bound,
   if (use_upper_bound) {
     const Coefficient rhs =
         ComputeCanonicalRhs(upper_bound, bound_shift, max_value);
-    if (!AddLinearConstraintInternal(*cst, rhs, max_value))
+    if (!AddScopedLinearConstraintInternal(*cst, rhs, max_value))
       return SetModelUnsat();
   }
   if (use_lower_bound) {
@@ -361,7 +436,7 @@ bool SatSolver::AddLinearConstraint(bool use_lower_bound,
     }
     const Coefficient rhs =
         ComputeNegatedCanonicalRhs(lower_bound, bound_shift, max_value);
-    if (!AddLinearConstraintInternal(*cst, rhs, max_value))
+    if (!AddScopedLinearConstraintInternal(*cst, rhs, max_value))
       return SetModelUnsat();
   }
   ++num_constraints_;
@@ -372,12 +447,14 @@ bool SatSolver::AddLinearConstraint(bool use_lower_bound,
 void SatSolver::AddLearnedClauseAndEnqueueUnitPropagation(
     const std::vector<Literal>& literals, bool is_redundant, ResolutionNode* node) {
   SCOPED_TIME_STAT(&stats_);
+  if (drat_writer_ != nullptr) drat_writer_->AddClause(ClauseRef(literals));
   if (literals.size() == 1) {
     // A length 1 clause fix a literal for all the search.
     // ComputeBacktrackLevel() should have returned 0.
     CHECK_EQ(CurrentDecisionLevel(), 0);
     trail_.EnqueueWithUnitReason(literals[0], node);
     lbd_running_average_.Add(1);
+    MaybeExportLearnedClause(literals, 1);
   } else if (literals.size() == 2 &&
              parameters_.treat_binary_clauses_separately()) {
     if (track_binary_clauses_) {
@@ -386,21 +463,30 @@ void SatSolver::AddLearnedClauseAndEnqueueUnitPropagation(
     binary_implication_graph_.AddBinaryConflict(literals[0], literals[1],
                                                 &trail_);
     lbd_running_average_.Add(2);
+    MaybeExportLearnedClause(literals, 2);
   } else {
     CleanClauseDatabaseIfNeeded();
-    SatClause* clause = SatClause::Create(literals, is_redundant, node);
+    SatClause* clause =
+        SatClause::Create(literals, is_redundant, node, &clause_arena_);
     clauses_.emplace_back(clause);
     BumpClauseActivity(clause);
 
     // Important: Even though the only literal at the last decision level has
     // been unassigned, its level was not modified, so ComputeLbd() works.
     clause->SetLbd(ComputeLbd(*clause));
+
+    // A new clause is protected until the next cleanup if it is in the tier2.
+    // It still counts toward this cleanup since it becomes deletable if it is
+    // not used again before the following one. Otherwise, a search learning
+    // only tier2 clauses would never trigger a cleanup.
     if (!ClauseShouldBeKept(clause)) {
       --num_learned_clause_before_cleanup_;
     }
+    clause->SetIsUsed(true);
 
     // Maintain the lbd average for the restart policy.
     lbd_running_average_.Add(clause->Lbd());
+    MaybeExportLearnedClause(literals, clause->Lbd());
 
     CHECK(watched_clauses_.AttachAndPropagate(clause, &trail_));
   }
@@ -427,6 +513,81 @@ UpperBoundedLinearConstraint* PBReasonOrNull(VariableIndex var,
 
 }  // namespace
 
+void SatSolver::SetSharedClausePool(SharedClausePool* pool, int worker_id) {
+  CHECK(pool == nullptr || !parameters_.unsat_proof());
+  CHECK(pool == nullptr || drat_writer_ == nullptr);
+  shared_clause_pool_ = pool;
+  worker_id_ = worker_id;
+}
+
+void SatSolver::SetDratWriter(DratWriter* drat_writer) {
+  CHECK(drat_writer == nullptr || shared_clause_pool_ == nullptr);
+  drat_writer_ = drat_writer;
+  if (drat_writer_ != nullptr) {
+    drat_writer_->SetNumVariables(num_variables_.value());
+  }
+}
+
+void SatSolver::MaybeExportLearnedClause(const std::vector<Literal>& literals,
+                                         int lbd) {
+  if (shared_clause_pool_ == nullptr) return;
+
+  // Unit and binary clauses are always worth sharing.
+  if (literals.size() > 2 &&
+      (literals.size() > parameters_.max_shared_clause_size() ||
+       lbd > parameters_.max_shared_clause_lbd())) {
+    return;
+  }
+  shared_clause_pool_->AddClause(worker_id_, ClauseRef(literals));
+  ++counters_.num_exported_clauses;
+}
+
+bool SatSolver::ImportSharedClauses() {
+  SCOPED_TIME_STAT(&stats_);
+  CHECK_EQ(CurrentDecisionLevel(), 0);
+  imported_clauses_.clear();
+  shared_clause_pool_->GetNewClauses(worker_id_, &imported_clauses_);
+  for (const std::vector<Literal>& clause : imported_clauses_) {
+    // Remove the fixed literals. Note that since we propagate after each new
+    // unit clause, the remaining literals are all unassigned.
+    bool is_satisfied = false;
+    literals_scratchpad_.clear();
+    for (const Literal literal : clause) {
+      if (trail_.Assignment().IsLiteralTrue(literal)) {
+        is_satisfied = true;
+        break;
+      }
+      if (!trail_.Assignment().IsLiteralFalse(literal)) {
+        literals_scratchpad_.push_back(literal);
+      }
+    }
+    if (is_satisfied) continue;
+    ++counters_.num_imported_clauses;
+    if (literals_scratchpad_.empty()) return SetModelUnsat();
+    if (literals_scratchpad_.size() == 1) {
+      trail_.EnqueueWithUnitReason(literals_scratchpad_[0], nullptr);
+      if (!Propagate()) return SetModelUnsat();
+    } else if (literals_scratchpad_.size() == 2 &&
+               parameters_.treat_binary_clauses_separately()) {
+      AddBinaryClauseInternal(literals_scratchpad_[0], literals_scratchpad_[1]);
+    } else {
+      SatClause* sat_clause =
+          SatClause::Create(literals_scratchpad_, /*is_redundant=*/true,
+                            /*node=*/nullptr, &clause_arena_);
+
+      // We don't know the LBD of the clause in this solver, but its size is
+      // an upper bound.
+      sat_clause->SetLbd(sat_clause->Size());
+      clauses_.push_back(sat_clause);
+      if (!ClauseShouldBeKept(sat_clause)) {
+        --num_learned_clause_before_cleanup_;
+      }
+      CHECK(watched_clauses_.AttachAndPropagate(sat_clause, &trail_));
+    }
+  }
+  return true;
+}
+
 void SatSolver::SaveDebugAssignment() {
   debug_assignment_.Resize(num_variables_.value());
   for (VariableIndex i(0); i < num_variables_; ++i) {
@@ -546,6 +707,7 @@ bool SatSolver::PropagateAndStopAfterOneConflictResolution() {
   // by AddLearnedClauseAndEnqueueUnitPropagation().
   if (trail_.FailingSatClause() != nullptr) {
     BumpClauseActivity(trail_.FailingSatClause());
+    MarkClauseAsUsed(trail_.FailingSatClause());
   }
   BumpReasonActivities(reason_used_to_infer_the_conflict_);
 
@@ -733,18 +895,39 @@ bool SatSolver::PropagateAndStopAfterOneConflictResolution() {
   bool is_redundant = true;
   if (!subsumed_clauses_.empty() &&
       parameters_.subsumption_during_conflict_analysis()) {
+    subsumed_literals_.clear();
+    subsumed_clause_ends_.clear();
     for (SatClause* clause : subsumed_clauses_) {
       DCHECK(ClauseSubsumption(learned_conflict_, clause));
       watched_clauses_.LazyDetach(clause);
       if (!clause->IsRedundant()) is_redundant = false;
+      if (drat_writer_ != nullptr) {
+        subsumed_literals_.insert(subsumed_literals_.end(), clause->begin(),
+                                  clause->end());
+        subsumed_clause_ends_.push_back(subsumed_literals_.size());
+      }
     }
     watched_clauses_.CleanUpWatchers();
     counters_.num_subsumed_clauses += subsumed_clauses_.size();
   }
 
-  // Create and attach the new learned clause.
+  // Create and attach the new learned clause. Note that this may delete the
+  // subsumed clauses from the arena if it triggers a clause cleanup.
   AddLearnedClauseAndEnqueueUnitPropagation(learned_conflict_, is_redundant,
                                             node);
+
+  // The subsumed clauses can only be deleted from the DRAT proof now, since
+  // they may be needed to check the learned clause. We use the copy of their
+  // literals made above.
+  if (drat_writer_ != nullptr && !subsumed_clause_ends_.empty()) {
+    int begin = 0;
+    for (const int end : subsumed_clause_ends_) {
+      drat_writer_->DeleteClause(ClauseRef(subsumed_literals_.data() + begin,
+                                           subsumed_literals_.data() + end));
+      begin = end;
+    }
+    subsumed_clause_ends_.clear();
+  }
   return false;
 }
 
@@ -898,7 +1081,78 @@ SatSolver::Status SatSolver::ResetAndSolveWithGivenAssumptions(
   return SolveInternal(time_limit_.get());
 }
 
+void SatSolver::PushScope() {
+  SCOPED_TIME_STAT(&stats_);
+  DCHECK(!is_model_unsat_);
+  Backtrack(0);
+  const VariableIndex selector(num_variables_.value());
+  SetNumVariables(num_variables_.value() + 1);
+  scope_selectors_.push_back(Literal(selector, true));
+}
+
+void SatSolver::PopScope() {
+  SCOPED_TIME_STAT(&stats_);
+  CHECK(!scope_selectors_.empty());
+  Backtrack(0);
+  const Literal selector = scope_selectors_.back();
+  scope_selectors_.pop_back();
+
+  // This is always possible (the problem can't become UNSAT) because the
+  // selector only appears negated in the constraints. Note that AddUnitClause()
+  // can't be used here: it would relax the unit clause by the selector of the
+  // enclosing scope, if any, and the selector would never be fixed.
+  if (!is_model_unsat_) CHECK(AddUnitClauseOutsideOfScopes(selector.Negated()));
+}
+
+SatSolver::Status SatSolver::SolveWithAssumptions(
+    const std::vector<Literal>& assumptions) {
+  SCOPED_TIME_STAT(&stats_);
+  if (is_model_unsat_) return MODEL_UNSAT;
+  std::vector<Literal> all_assumptions = scope_selectors_;
+  all_assumptions.insert(all_assumptions.end(), assumptions.begin(),
+                         assumptions.end());
+  return ResetAndSolveWithGivenAssumptions(all_assumptions);
+}
+
+std::vector<Literal> SatSolver::GetLastUnsatAssumptions() {
+  SCOPED_TIME_STAT(&stats_);
+  std::vector<Literal> result;
+  for (const Literal literal : GetLastIncompatibleDecisions()) {
+    if (std::find(scope_selectors_.begin(), scope_selectors_.end(), literal) ==
+        scope_selectors_.end()) {
+      result.push_back(literal);
+    }
+  }
+  return result;
+}
+
+SatSolver::SolveStatistics SatSolver::CurrentSolveStatistics() const {
+  SolveStatistics result;
+  result.num_branches = num_branches();
+  result.num_failures = num_failures();
+  result.num_propagations = num_propagations();
+  result.num_restarts = restart_count_;
+  result.num_learned_literals = counters_.num_literals_learned;
+  result.deterministic_time = deterministic_time();
+  result.wall_time = timer_.Get();
+  return result;
+}
+
 SatSolver::Status SatSolver::StatusWithLog(Status status) {
+  const SolveStatistics end = CurrentSolveStatistics();
+  last_solve_statistics_.num_branches =
+      end.num_branches - solve_start_statistics_.num_branches;
+  last_solve_statistics_.num_failures =
+      end.num_failures - solve_start_statistics_.num_failures;
+  last_solve_statistics_.num_propagations =
+      end.num_propagations - solve_start_statistics_.num_propagations;
+  last_solve_statistics_.num_restarts =
+      end.num_restarts - solve_start_statistics_.num_restarts;
+  last_solve_statistics_.num_learned_literals =
+      end.num_learned_literals - solve_start_statistics_.num_learned_literals;
+  last_solve_statistics_.deterministic_time =
+      end.deterministic_time - solve_start_statistics_.deterministic_time;
+  last_solve_statistics_.wall_time = end.wall_time;
   if (parameters_.log_search_progress()) {
     LOG(INFO) << RunningStatisticsString();
     LOG(INFO) << StatusString(status);
@@ -919,8 +1173,13 @@ SatSolver::Status SatSolver::Solve() {
 
 SatSolver::Status SatSolver::SolveInternal(TimeLimit* time_limit) {
   SCOPED_TIME_STAT(&stats_);
-  if (is_model_unsat_) return MODEL_UNSAT;
+  ++num_solves_;
+  if (is_model_unsat_) {
+    last_solve_statistics_ = SolveStatistics();
+    return MODEL_UNSAT;
+  }
   timer_.Restart();
+  solve_start_statistics_ = CurrentSolveStatistics();
 
   // This is done this way, so heuristics like the weighted_sign_ one can
   // wait for all the constraint to be added before beeing initialized.
@@ -1055,6 +1314,21 @@ SatSolver::Status SatSolver::SolveInternal(TimeLimit* time_limit) {
       if (restart) {
         restart_count_++;
         Backtrack(assumption_level_);
+
+        // Import the clauses learned by the other workers of a portfolio and
+        // simplify the clause database. This is only done at level zero where
+        // all the assigned literals are fixed. We then go back to the top of
+        // the loop because this may have assigned some variables.
+        if (CurrentDecisionLevel() == 0) {
+          const bool inprocess = InprocessingIsNeeded();
+          if (shared_clause_pool_ != nullptr || inprocess) {
+            if (shared_clause_pool_ != nullptr && !ImportSharedClauses()) {
+              return StatusWithLog(MODEL_UNSAT);
+            }
+            if (inprocess && !Inprocess()) return StatusWithLog(MODEL_UNSAT);
+            continue;
+          }
+        }
       }
 
       DCHECK_GE(CurrentDecisionLevel(), assumption_level_);
@@ -1141,6 +1415,7 @@ void SatSolver::BumpReasonActivities(const std::vector<Literal>& literals) {
     if (DecisionLevel(var) > 0) {
       if (trail_.Info(var).type == AssignmentInfo::CLAUSE_PROPAGATION) {
         BumpClauseActivity(trail_.Info(var).sat_clause);
+        MarkClauseAsUsed(trail_.Info(var).sat_clause);
       } else if (trail_.InitialAssignmentType(var) ==
                  AssignmentInfo::PB_PROPAGATION) {
         // TODO(user): Because one pb constraint may propagate many literals,
@@ -1159,6 +1434,18 @@ void SatSolver::BumpClauseActivity(SatClause* clause) {
   }
 }
 
+void SatSolver::MarkClauseAsUsed(SatClause* clause) {
+  if (!clause->IsRedundant()) return;
+  clause->SetIsUsed(true);
+  if (!parameters_.update_clause_lbd_during_conflict_analysis()) return;
+  if (clause->Lbd() <= parameters_.clause_cleanup_lbd_bound()) return;
+  const int lbd = ComputeLbd(*clause);
+  if (lbd < clause->Lbd()) {
+    ++counters_.num_lbd_updates;
+    clause->SetLbd(lbd);
+  }
+}
+
 void SatSolver::RescaleVariableActivities(double scaling_factor) {
   SCOPED_TIME_STAT(&stats_);
   variable_activity_increment_ *= scaling_factor;
@@ -1240,9 +1527,12 @@ int SatSolver::ComputeLbd(const LiteralList& conflict) {
       parameters_.count_assumption_levels_in_lbd() ? 0 : assumption_level_;
 
   // We know that the first literal of the conflict is always of the highest
-  // level.
-  is_level_marked_.ClearAndResize(
-      SatDecisionLevel(DecisionLevel(conflict.begin()->Variable()) + 1));
+  // level, or that all the literals are assigned at a level lower or equal to
+  // the current one.
+  is_level_marked_.ClearAndResize(SatDecisionLevel(
+      std::max(DecisionLevel(conflict.begin()->Variable()),
+               CurrentDecisionLevel()) +
+      1));
   for (const Literal literal : conflict) {
     const SatDecisionLevel level(DecisionLevel(literal.Variable()));
     DCHECK_GE(level, 0);
@@ -1293,6 +1583,11 @@ std::string SatSolver::StatusString(Status status) const {
                       watched_clauses_.num_inspected_clauses()) +
          StringPrintf("  num inspected clause_literals: %" GG_LL_FORMAT "d\n",
                       watched_clauses_.num_inspected_clause_literals()) +
+         StringPrintf("  clause arena: %.1f MB  (live: %.1f MB, "
+                      "compactions: %lld)\n",
+                      clause_arena_.num_used_bytes() / 1048576.0,
+                      clause_arena_.num_live_bytes() / 1048576.0,
+                      clause_arena_.num_compactions()) +
          StringPrintf(
              "  num learned literals: %lld  (avg: %.1f /clause)\n",
              counters_.num_literals_learned,
@@ -1303,7 +1598,27 @@ std::string SatSolver::StatusString(Status status) const {
                           counters_.num_failures) +
          StringPrintf("  num subsumed clauses: %lld\n",
                       counters_.num_subsumed_clauses) +
+         StringPrintf("  num clause lbd updates: %lld\n",
+                      counters_.num_lbd_updates) +
          StringPrintf("  num restarts: %d\n", restart_count_) +
+         StringPrintf("  num exported clauses: %lld\n",
+                      counters_.num_exported_clauses) +
+         StringPrintf("  num imported clauses: %lld\n",
+                      counters_.num_imported_clauses) +
+         StringPrintf("  num inprocessing rounds: %lld  (time: %f)\n",
+                      counters_.num_inprocessing_rounds,
+                      inprocessing_deterministic_time_) +
+         StringPrintf("  num failed literals: %lld\n",
+                      counters_.num_failed_literals) +
+         StringPrintf("  num substituted equivalent literals: %lld\n",
+                      counters_.num_substituted_literals) +
+         StringPrintf("  num inprocessing subsumed clauses: %lld\n",
+                      counters_.num_inprocessing_subsumed_clauses) +
+         StringPrintf("  num inprocessing strengthened clauses: %lld\n",
+                      counters_.num_inprocessing_strengthened_clauses) +
+         StringPrintf("  num vivified clauses: %lld  (literals removed: %lld)\n",
+                      counters_.num_vivified_clauses,
+                      counters_.num_vivified_literals_removed) +
          StringPrintf("  pb num threshold updates: %lld\n",
                       pb_constraints_.num_threshold_updates()) +
          StringPrintf("  pb num constraint lookups: %lld\n",
@@ -1378,9 +1693,19 @@ void SatSolver::ProcessNewlyFixedVariables() {
         // The clause is always true, detach it.
         // TODO(user): Unlock its associated resolution node right away since
         // the solver will not be able to reach it again.
+        if (drat_writer_ != nullptr) {
+          drat_writer_->DeleteClause(ClauseRef(clause->begin(), clause->end()));
+        }
         watched_clauses_.LazyDetach(clause);
         ++num_detached_clauses;
       } else if (!removed_literals.empty()) {
+        if (drat_writer_ != nullptr) {
+          drat_writer_->AddClause(ClauseRef(clause->begin(), clause->end()));
+          removed_literals.insert(removed_literals.end(), clause->begin(),
+                                  clause->end());
+          drat_writer_->DeleteClause(ClauseRef(removed_literals));
+          removed_literals.resize(removed_literals.size() - clause->Size());
+        }
         if (clause->Size() == 2 &&
             parameters_.treat_binary_clauses_separately()) {
           // The clause is now a binary clause, treat it separately. Note that
@@ -1430,8 +1755,33 @@ void SatSolver::DeleteDetachedClauses() {
       unsat_proof_.UnlockNode((*it)->ResolutionNodePointer());
     }
   }
-  STLDeleteContainerPointers(iter, clauses_.end());
+  for (std::vector<SatClause*>::iterator it = iter; it != clauses_.end(); ++it) {
+    clause_arena_.Free(*it);
+  }
   clauses_.erase(iter, clauses_.end());
+  CompactClauseArenaIfNeeded();
+}
+
+void SatSolver::CompactClauseArenaIfNeeded() {
+  if (!clause_arena_.CompactionIsWorthIt()) return;
+  SCOPED_TIME_STAT(&stats_);
+  watched_clauses_.CleanUpWatchers();
+  clause_arena_.StartCompaction();
+
+  // Note that the trail keeps the last reason of a variable even after it is
+  // unassigned, and this is used by IsClauseUsedAsReason(). Since a clause can
+  // only be the reason of its first literal, this updates all the reasons that
+  // refer to a live clause. The others are never used.
+  for (SatClause*& clause : clauses_) {
+    const bool is_reason = IsClauseUsedAsReason(clause);
+    clause = clause_arena_.Relocate(clause);
+    if (is_reason) {
+      trail_.ChangeSatClauseReason(clause->PropagatedLiteral().Variable(),
+                                   clause);
+    }
+  }
+  watched_clauses_.RelocateWatchers();
+  clause_arena_.FinishCompaction();
 }
 
 bool SatSolver::Propagate() {
@@ -2611,6 +2961,13 @@ void SatSolver::CleanClauseDatabaseIfNeeded() {
   std::vector<SatClause*>::iterator clause_to_keep_end = std::partition(
       clauses_.begin(), clauses_.end(),
       std::bind1st(std::mem_fun(&SatSolver::ClauseShouldBeKept), this));
+
+  // The tier2 clauses need to be used again before the next cleanup in order
+  // to be kept. Note that the deletable clauses are not concerned since they
+  // can only be in the tier2 if they are learned again.
+  for (auto iter = clauses_.begin(); iter < clause_to_keep_end; ++iter) {
+    (*iter)->SetIsUsed(false);
+  }
   if (parameters_.clause_cleanup_ordering() == SatParameters::CLAUSE_LBD) {
     std::sort(clause_to_keep_end, clauses_.end(), LbdClauseOrder);
   } else {
@@ -2624,16 +2981,494 @@ void SatSolver::CleanClauseDatabaseIfNeeded() {
     for (auto iter = first_clause_to_delete; iter < clauses_.end(); ++iter) {
       SatClause* clause = *iter;
       counters_.num_literals_forgotten += clause->Size();
+      if (drat_writer_ != nullptr) {
+        drat_writer_->DeleteClause(ClauseRef(clause->begin(), clause->end()));
+      }
       watched_clauses_.LazyDetach(clause);
       if (clause->ResolutionNodePointer() != nullptr) {
         unsat_proof_.UnlockNode(clause->ResolutionNodePointer());
       }
     }
     watched_clauses_.CleanUpWatchers();
-    STLDeleteContainerPointers(first_clause_to_delete, clauses_.end());
+    for (auto iter = first_clause_to_delete; iter < clauses_.end(); ++iter) {
+      clause_arena_.Free(*iter);
+    }
     clauses_.erase(first_clause_to_delete, clauses_.end());
   }
   InitLearnedClauseLimit(clauses_.end() - clause_to_keep_end);
+  CompactClauseArenaIfNeeded();
+}
+
+bool SatSolver::InprocessingIsNeeded() const {
+  if (!parameters_.use_inprocessing() || parameters_.unsat_proof()) {
+    return false;
+  }
+  const double budget =
+      parameters_.inprocessing_dtime_ratio() *
+      (deterministic_time() - deterministic_time_at_last_inprocessing_);
+  return budget >= parameters_.min_inprocessing_dtime();
+}
+
+bool SatSolver::Inprocess() {
+  SCOPED_TIME_STAT(&stats_);
+  CHECK_EQ(CurrentDecisionLevel(), 0);
+  const double start_time = deterministic_time();
+  const double budget =
+      parameters_.inprocessing_dtime_ratio() *
+      (start_time - deterministic_time_at_last_inprocessing_);
+  ++counters_.num_inprocessing_rounds;
+  if (num_processed_fixed_variables_ < trail_.Index()) {
+    ProcessNewlyFixedVariables();
+  }
+
+  // The probing assigns a lot of variables, and we don't want this to change
+  // the polarity chosen by the phase saving heuristic.
+  ITIVector<VariableIndex, Polarity> saved_polarity(polarity_);
+
+  // Each technique can use the part of the budget not used by the previous
+  // ones. The equivalent literal substitution is linear and always run.
+  bool is_feasible =
+      ProbeFailedLiterals(start_time + 0.3 * budget) &&
+      SubstituteEquivalentLiterals() &&
+      SubsumeAndStrengthenClauses(start_time + 0.6 * budget) &&
+      VivifyLearnedClauses(start_time + budget);
+  polarity_.swap(saved_polarity);
+  if (is_feasible) {
+    watched_clauses_.CleanUpWatchers();
+    if (!Propagate()) {
+      is_feasible = SetModelUnsat();
+    } else {
+      if (num_processed_fixed_variables_ < trail_.Index()) {
+        ProcessNewlyFixedVariables();
+      }
+      DeleteDetachedClauses();
+    }
+  }
+  deterministic_time_at_last_inprocessing_ = deterministic_time();
+  inprocessing_deterministic_time_ +=
+      deterministic_time_at_last_inprocessing_ - start_time;
+  VLOG(1) << "Inprocessing round #" << counters_.num_inprocessing_rounds
+          << " took " << deterministic_time_at_last_inprocessing_ - start_time
+          << " for a budget of " << budget << ".";
+  return is_feasible;
+}
+
+void SatSolver::EnqueueProbingDecision(Literal literal) {
+  DCHECK(!Assignment().IsVariableAssigned(literal.Variable()));
+  last_decision_or_backtrack_trail_index_ = trail_.Index();
+  decisions_[current_decision_level_] = Decision(trail_.Index(), literal);
+  ++current_decision_level_;
+  trail_.SetDecisionLevel(current_decision_level_);
+  trail_.Enqueue(literal, AssignmentInfo::SEARCH_DECISION);
+}
+
+bool SatSolver::ReplaceClause(SatClause* clause,
+                              const std::vector<Literal>& literals,
+                              bool is_redundant) {
+  DCHECK_EQ(CurrentDecisionLevel(), 0);
+  DCHECK(!clause->IsAttached());
+  literals_scratchpad_.clear();
+  for (const Literal literal : literals) {
+    if (trail_.Assignment().IsLiteralTrue(literal)) return true;
+    if (!trail_.Assignment().IsLiteralFalse(literal)) {
+      literals_scratchpad_.push_back(literal);
+    }
+  }
+  if (literals_scratchpad_.empty()) return SetModelUnsat();
+  if (drat_writer_ != nullptr) {
+    drat_writer_->AddClause(ClauseRef(literals_scratchpad_));
+  }
+  if (literals_scratchpad_.size() == 1) {
+    trail_.EnqueueWithUnitReason(literals_scratchpad_[0], nullptr);
+    if (!Propagate()) return SetModelUnsat();
+    return true;
+  }
+  if (literals_scratchpad_.size() == 2 &&
+      parameters_.treat_binary_clauses_separately()) {
+    AddBinaryClauseInternal(literals_scratchpad_[0], literals_scratchpad_[1]);
+    return true;
+  }
+  SatClause* new_clause = SatClause::Create(literals_scratchpad_, is_redundant,
+                                            /*node=*/nullptr, &clause_arena_);
+  new_clause->SetLbd(
+      std::min(clause->Lbd(), static_cast<int>(literals_scratchpad_.size())));
+  new_clause->IncreaseActivity(clause->Activity());
+  if (clause->IsVivified()) new_clause->MarkAsVivified();
+  clauses_.push_back(new_clause);
+  CHECK(watched_clauses_.AttachAndPropagate(new_clause, &trail_));
+  return true;
+}
+
+bool SatSolver::ProbeFailedLiterals(double deterministic_time_limit) {
+  SCOPED_TIME_STAT(&stats_);
+  const int num_literals = 2 * num_variables_.value();
+  for (int i = 0; i < num_literals; ++i) {
+    if (deterministic_time() > deterministic_time_limit) break;
+    if (next_literal_to_probe_ >= LiteralIndex(num_literals)) {
+      next_literal_to_probe_ = LiteralIndex(0);
+    }
+    const Literal literal(next_literal_to_probe_);
+    ++next_literal_to_probe_;
+
+    // We only probe the roots of the binary implication graph (literals with
+    // no incoming implications) since probing a root also propagates all the
+    // literals it implies.
+    if (trail_.Assignment().IsVariableAssigned(literal.Variable())) continue;
+    if (binary_implication_graph_.Implications(literal).empty() ||
+        !binary_implication_graph_.Implications(literal.Negated()).empty()) {
+      continue;
+    }
+    EnqueueProbingDecision(literal);
+    const bool is_failed = !Propagate();
+    Backtrack(0);
+    if (is_failed) {
+      ++counters_.num_failed_literals;
+      if (drat_writer_ != nullptr) {
+        const Literal unit = literal.Negated();
+        drat_writer_->AddClause(ClauseRef(&unit, &unit + 1));
+      }
+      trail_.EnqueueWithUnitReason(literal.Negated(), /*node=*/nullptr);
+      if (!Propagate()) return SetModelUnsat();
+    }
+  }
+  return true;
+}
+
+bool SatSolver::SubstituteEquivalentLiterals() {
+  SCOPED_TIME_STAT(&stats_);
+  ITIVector<LiteralIndex, LiteralIndex> representative;
+  if (!binary_implication_graph_.DetectEquivalences(trail_.Assignment(),
+                                                    &representative)) {
+    // A literal is equivalent to its negation, so probing it fails and then
+    // its negation fails too. The empty clause is not implied by propagation
+    // alone, so for the DRAT proof, we find such a literal by probing and fix
+    // the failed literals at level zero until there is a conflict.
+    if (drat_writer_ != nullptr) {
+      for (LiteralIndex i(0); i < 2 * num_variables_.value(); ++i) {
+        const Literal literal(i);
+        if (trail_.Assignment().IsVariableAssigned(literal.Variable())) {
+          continue;
+        }
+        EnqueueProbingDecision(literal);
+        const bool is_failed = !Propagate();
+        Backtrack(0);
+        if (is_failed) {
+          const Literal unit = literal.Negated();
+          drat_writer_->AddClause(ClauseRef(&unit, &unit + 1));
+          trail_.EnqueueWithUnitReason(unit, /*node=*/nullptr);
+          if (!Propagate()) break;
+        }
+      }
+    }
+    return SetModelUnsat();
+  }
+  if (representative.empty()) return true;
+  binary_implication_graph_.SubstituteEquivalentLiterals(representative);
+
+  // We first detach all the modified clauses, and then add their new version.
+  std::vector<SatClause*> modified_clauses;
+  std::vector<std::vector<Literal>> new_clauses;
+  std::vector<Literal> new_literals;
+  for (SatClause* clause : clauses_) {
+    if (!clause->IsAttached()) continue;
+    bool is_modified = false;
+    new_literals.clear();
+    for (const Literal literal : *clause) {
+      const LiteralIndex rep = representative[literal.Index()];
+      if (rep != literal.Index()) {
+        is_modified = true;
+        ++counters_.num_substituted_literals;
+      }
+      new_literals.push_back(Literal(rep));
+    }
+    if (!is_modified) continue;
+
+    // Remove the duplicates, and detect the clauses that are always true.
+    std::sort(new_literals.begin(), new_literals.end());
+    new_literals.erase(std::unique(new_literals.begin(), new_literals.end()),
+                       new_literals.end());
+    bool is_tautology = false;
+    for (int j = 1; j < new_literals.size(); ++j) {
+      if (new_literals[j] == new_literals[j - 1].Negated()) {
+        is_tautology = true;
+        break;
+      }
+    }
+    watched_clauses_.LazyDetach(clause);
+    if (is_tautology) {
+      if (drat_writer_ != nullptr) {
+        drat_writer_->DeleteClause(ClauseRef(clause->begin(), clause->end()));
+      }
+      continue;
+    }
+    modified_clauses.push_back(clause);
+    new_clauses.push_back(new_literals);
+  }
+  watched_clauses_.CleanUpWatchers();
+  for (int i = 0; i < modified_clauses.size(); ++i) {
+    if (!ReplaceClause(modified_clauses[i], new_clauses[i],
+                       modified_clauses[i]->IsRedundant())) {
+      return false;
+    }
+    if (drat_writer_ != nullptr) {
+      drat_writer_->DeleteClause(ClauseRef(modified_clauses[i]->begin(),
+                                           modified_clauses[i]->end()));
+    }
+  }
+  return true;
+}
+
+namespace {
+
+// Orders indices in the given vector by increasing size of the pointed lists.
+class IncreasingSizeOrder {
+ public:
+  explicit IncreasingSizeOrder(const std::vector<std::vector<Literal>>& lists)
+      : lists_(lists) {}
+  bool operator()(int a, int b) const {
+    return lists_[a].size() < lists_[b].size();
+  }
+
+ private:
+  const std::vector<std::vector<Literal>>& lists_;
+};
+
+// Returns a 64 bits signature of the variables of a clause. If the signature
+// of a is not included in the one of b, then a can't subsume or strengthen b.
+uint64 ComputeSignature(const std::vector<Literal>& literals) {
+  uint64 signature = 0;
+  for (const Literal literal : literals) {
+    signature |= uint64(1) << (literal.Variable().value() & 63);
+  }
+  return signature;
+}
+
+}  // namespace
+
+bool SatSolver::SubsumeAndStrengthenClauses(double deterministic_time_limit) {
+  SCOPED_TIME_STAT(&stats_);
+
+  // We work on sorted copies of the clauses literals, and only modify the
+  // clauses at the end. This way we can use SimplifyClause().
+  std::vector<SatClause*> sat_clauses;
+  std::vector<std::vector<Literal>> literals;
+  for (SatClause* clause : clauses_) {
+    if (!clause->IsAttached()) continue;
+    sat_clauses.push_back(clause);
+    literals.push_back(std::vector<Literal>(clause->begin(), clause->end()));
+    std::sort(literals.back().begin(), literals.back().end());
+  }
+  const int num_clauses = sat_clauses.size();
+  ITIVector<LiteralIndex, std::vector<int>> occurrences(2 *
+                                                        num_variables_.value());
+  std::vector<uint64> signatures(num_clauses);
+  std::vector<int> order(num_clauses);
+  for (int i = 0; i < num_clauses; ++i) {
+    order[i] = i;
+    signatures[i] = ComputeSignature(literals[i]);
+    for (const Literal literal : literals[i]) {
+      occurrences[literal.Index()].push_back(i);
+    }
+    counters_.num_subsumption_inspected_literals += literals[i].size();
+  }
+  std::stable_sort(order.begin(), order.end(), IncreasingSizeOrder(literals));
+
+  // A redundant clause that subsumes a problem clause must be promoted to a
+  // problem clause.
+  std::vector<bool> is_removed(num_clauses, false);
+  std::vector<bool> is_modified(num_clauses, false);
+  std::vector<bool> is_promoted(num_clauses, false);
+  SparseBitset<LiteralIndex> is_marked;
+  is_marked.ClearAndResize(LiteralIndex(2 * num_variables_.value()));
+  for (const int a : order) {
+    if (deterministic_time() > deterministic_time_limit) break;
+    if (is_removed[a]) continue;
+
+    // Subsumption and strengthening using the binary clauses (l OR m). Note
+    // that we only use the literals l still in the clause to strengthen it,
+    // so the result does not depend on a literal removed earlier.
+    if (binary_implication_graph_.NumberOfImplications() > 0) {
+      for (const Literal literal : literals[a]) is_marked.Set(literal.Index());
+      bool is_subsumed = false;
+      bool is_strengthened = false;
+      for (const Literal l : literals[a]) {
+        if (!is_marked[l.Index()]) continue;
+        const std::vector<Literal>& implied =
+            binary_implication_graph_.Implications(l.Negated());
+        counters_.num_subsumption_inspected_literals += implied.size();
+        for (const Literal m : implied) {
+          if (is_marked[m.Index()]) {
+            is_subsumed = true;
+            break;
+          }
+          if (is_marked[m.NegatedIndex()]) {
+            is_marked.Clear(m.NegatedIndex());
+            is_strengthened = true;
+          }
+        }
+        if (is_subsumed) break;
+      }
+      if (is_strengthened && !is_subsumed) {
+        int new_size = 0;
+        for (const Literal literal : literals[a]) {
+          if (is_marked[literal.Index()]) literals[a][new_size++] = literal;
+        }
+        literals[a].resize(new_size);
+        signatures[a] = ComputeSignature(literals[a]);
+        is_modified[a] = true;
+        ++counters_.num_inprocessing_strengthened_clauses;
+      }
+      is_marked.SparseClearAll();
+      if (is_subsumed) {
+        is_removed[a] = true;
+        ++counters_.num_inprocessing_subsumed_clauses;
+        continue;
+      }
+    }
+
+    // Subsumption and strengthening of the other clauses by this one. It is
+    // enough to look at the clauses containing one of its literal or its
+    // negation, so we choose the one with the fewest occurrences.
+    Literal best = literals[a][0];
+    for (const Literal literal : literals[a]) {
+      if (occurrences[literal.Index()].size() +
+              occurrences[literal.NegatedIndex()].size() <
+          occurrences[best.Index()].size() +
+              occurrences[best.NegatedIndex()].size()) {
+        best = literal;
+      }
+    }
+    const bool a_is_redundant = sat_clauses[a]->IsRedundant() && !is_promoted[a];
+    for (int negated = 0; negated < 2; ++negated) {
+      const Literal literal = negated ? best.Negated() : best;
+      for (const int b : occurrences[literal.Index()]) {
+        if (b == a || is_removed[b]) continue;
+        if (literals[b].size() < literals[a].size()) continue;
+        if ((signatures[a] & ~signatures[b]) != 0) continue;
+        counters_.num_subsumption_inspected_literals += literals[b].size();
+        LiteralIndex opposite_literal;
+        if (!SimplifyClause(literals[a], &literals[b], &opposite_literal)) {
+          continue;
+        }
+        if (opposite_literal == LiteralIndex(-1)) {
+          if (a_is_redundant &&
+              (!sat_clauses[b]->IsRedundant() || is_promoted[b])) {
+            is_promoted[a] = true;
+          }
+          is_removed[b] = true;
+          ++counters_.num_inprocessing_subsumed_clauses;
+        } else {
+          signatures[b] = ComputeSignature(literals[b]);
+          is_modified[b] = true;
+          ++counters_.num_inprocessing_strengthened_clauses;
+        }
+      }
+    }
+  }
+
+  // Apply the changes.
+  for (int i = 0; i < num_clauses; ++i) {
+    if (is_removed[i] || is_modified[i] || is_promoted[i]) {
+      watched_clauses_.LazyDetach(sat_clauses[i]);
+    }
+  }
+  watched_clauses_.CleanUpWatchers();
+  for (int i = 0; i < num_clauses; ++i) {
+    if (is_removed[i] || !(is_modified[i] || is_promoted[i])) continue;
+    if (!ReplaceClause(sat_clauses[i], literals[i],
+                       sat_clauses[i]->IsRedundant() && !is_promoted[i])) {
+      return false;
+    }
+  }
+
+  // The old clauses are deleted from the DRAT proof once all the new ones
+  // were added, since they may be needed to check them.
+  if (drat_writer_ != nullptr) {
+    for (int i = 0; i < num_clauses; ++i) {
+      if (is_removed[i] || is_modified[i] || is_promoted[i]) {
+        drat_writer_->DeleteClause(
+            ClauseRef(sat_clauses[i]->begin(), sat_clauses[i]->end()));
+      }
+    }
+  }
+  return true;
+}
+
+bool SatSolver::VivifyLearnedClauses(double deterministic_time_limit) {
+  SCOPED_TIME_STAT(&stats_);
+  std::vector<SatClause*> candidates;
+  for (SatClause* clause : clauses_) {
+    if (clause->IsAttached() && clause->IsRedundant() &&
+        !clause->IsVivified()) {
+      candidates.push_back(clause);
+    }
+  }
+
+  // The clauses that will be kept the longest are vivified first.
+  std::sort(candidates.begin(), candidates.end(), LbdClauseOrder);
+  std::vector<Literal> clause_literals;
+  std::vector<Literal> new_literals;
+  std::vector<SatClause*> vivified_clauses;
+  std::vector<std::vector<Literal>> vivified_literals;
+  for (SatClause* clause : candidates) {
+    if (deterministic_time() > deterministic_time_limit) break;
+    clause->MarkAsVivified();
+
+    // We need a copy since the propagation reorders the clause literals. For
+    // each literal in turn, we propagate its negation:
+    // - A literal already false is not needed in the clause.
+    // - A literal already true is implied by the previous ones, so the
+    //   literals after it are not needed.
+    // - If there is a conflict, the remaining literals are not needed.
+    // Note that this is correct even if the propagation uses the clause itself
+    // since the new clause is included in the old one.
+    clause_literals.assign(clause->begin(), clause->end());
+    new_literals.clear();
+    bool is_satisfied = false;
+    for (int i = 0; i < clause_literals.size(); ++i) {
+      const Literal literal = clause_literals[i];
+      if (trail_.Assignment().IsLiteralTrue(literal)) {
+        if (CurrentDecisionLevel() == 0) is_satisfied = true;
+        new_literals.push_back(literal);
+        break;
+      }
+      if (trail_.Assignment().IsLiteralFalse(literal)) continue;
+      new_literals.push_back(literal);
+      if (i + 1 == clause_literals.size()) break;
+      EnqueueProbingDecision(literal.Negated());
+      if (!Propagate()) break;
+    }
+    Backtrack(0);
+
+    // A clause satisfied at level zero will be removed by
+    // ProcessNewlyFixedVariables().
+    if (is_satisfied || new_literals.size() == clause_literals.size()) {
+      continue;
+    }
+    ++counters_.num_vivified_clauses;
+    counters_.num_vivified_literals_removed +=
+        clause_literals.size() - new_literals.size();
+    vivified_clauses.push_back(clause);
+    vivified_literals.push_back(new_literals);
+  }
+
+  // The vivified clauses are only replaced at the end, so that the watchers
+  // are cleaned once. Until then, the propagation uses the original clauses,
+  // which are implied by their vivified version.
+  for (SatClause* clause : vivified_clauses) {
+    watched_clauses_.LazyDetach(clause);
+  }
+  watched_clauses_.CleanUpWatchers();
+  for (int i = 0; i < vivified_clauses.size(); ++i) {
+    SatClause* const clause = vivified_clauses[i];
+    if (!ReplaceClause(clause, vivified_literals[i], /*is_redundant=*/true)) {
+      return false;
+    }
+    if (drat_writer_ != nullptr) {
+      drat_writer_->DeleteClause(ClauseRef(clause->begin(), clause->end()));
+    }
+  }
+  return true;
 }
 
 void SatSolver::InitRestart() {
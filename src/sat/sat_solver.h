@@ -33,6 +33,7 @@
 #include "base/random.h"
 #include "sat/pb_constraint.h"
 #include "sat/clause.h"
+#include "sat/drat_writer.h"
 #include "sat/sat_base.h"
 #include "sat/sat_parameters.pb.h"
 #include "sat/symmetry.h"
@@ -49,6 +50,9 @@ namespace sat {
 // A constant used by the EnqueueDecision*() API.
 const int kUnsatTrailIndex = -1;
 
+// Forward declaration, see sat_portfolio.h.
+class SharedClausePool;
+
 // The main SAT solver.
 // It currently implements the CDCL algorithm. See
 //    http://en.wikipedia.org/wiki/Conflict_Driven_Clause_Learning
@@ -189,6 +193,11 @@ class SatSolver {
   // specific api.
   Status SolveWithTimeLimit(TimeLimit* time_limit);
 
+  // The time limit used by Solve() and ResetAndSolveWithGivenAssumptions().
+  // Note that it is recreated by SetParameters(). This can be used to register
+  // an external Boolean that aborts the search when another thread sets it.
+  TimeLimit* GetTimeLimit() { return time_limit_.get(); }
+
   // Simple interface to solve a problem under the given assumptions. This
   // simply ask the solver to solve a problem given a set of variables fixed to
   // a given value (the assumptions). Compared to simply calling AddUnitClause()
@@ -219,6 +228,57 @@ class SatSolver {
   // the problem UNSAT.
   std::vector<Literal> GetLastIncompatibleDecisions();
 
+  // Incremental interface. A scope groups the constraints added between a
+  // PushScope() and the matching PopScope(), which removes them all. This is
+  // implemented with one new "selector" variable per scope: each constraint
+  // added while a scope is open is relaxed by the negation of the selector of
+  // the innermost scope, and the selectors of all the open scopes are used as
+  // the first assumptions of SolveWithAssumptions(). PopScope() fixes the
+  // selector to false, so the constraints of the scope (and the clauses learned
+  // from them) become satisfied and are removed by the next level-zero
+  // simplification. All the other learned clauses and the variable activities
+  // are kept across calls.
+  //
+  // Note that pseudo-Boolean constraints are supported in a scope, but
+  // constraints added outside any scope are permanent. These functions
+  // backtrack to level zero.
+  void PushScope();
+  void PopScope();
+  int NumScopes() const { return scope_selectors_.size(); }
+
+  // Same as ResetAndSolveWithGivenAssumptions(), but the selectors of the open
+  // scopes are implicitly added to the given assumptions. If ASSUMPTIONS_UNSAT
+  // is returned, GetLastUnsatAssumptions() returns a subset of the given
+  // assumptions that is incompatible with the constraints of the open scopes.
+  // It may be empty if these constraints are UNSAT on their own.
+  Status SolveWithAssumptions(const std::vector<Literal>& assumptions);
+  std::vector<Literal> GetLastUnsatAssumptions();
+
+  // Statistics of the last call to one of the Solve() functions. These are
+  // the differences of the corresponding solver-wide counters between the end
+  // and the start of the call.
+  struct SolveStatistics {
+    SolveStatistics()
+        : num_branches(0),
+          num_failures(0),
+          num_propagations(0),
+          num_restarts(0),
+          num_learned_literals(0),
+          deterministic_time(0.0),
+          wall_time(0.0) {}
+    int64 num_branches;
+    int64 num_failures;
+    int64 num_propagations;
+    int64 num_restarts;
+    int64 num_learned_literals;
+    double deterministic_time;
+    double wall_time;
+  };
+  const SolveStatistics& LastSolveStatistics() const {
+    return last_solve_statistics_;
+  }
+  int64 num_solves() const { return num_solves_; }
+
   // Returns an UNSAT core. That is a subset of the problem clauses that are
   // still UNSAT. A problem constraint of index #i is the one that was added
   // with the i-th call to one of the Add*() functions, see
@@ -310,6 +370,24 @@ class SatSolver {
   const std::vector<BinaryClause>& NewlyAddedBinaryClauses();
   void ClearNewlyAddedBinaryClauses();
 
+  // Advanced usage. Connects this solver to a pool of learned clauses shared
+  // with other solvers working on the same problem in other threads (see
+  // sat_portfolio.h). The solver then publishes the unit and binary clauses it
+  // learns as well as the short ones (see the max_shared_clause_size() and
+  // max_shared_clause_lbd() parameters), and imports the clauses learned by
+  // the other workers at each restart to decision level zero. Passing nullptr
+  // disconnects the solver. This can't be used with unsat_proof() on.
+  void SetSharedClausePool(SharedClausePool* pool, int worker_id);
+
+  // Advanced usage. Streams a DRAT proof of all the clauses learned, simplified
+  // or deleted by this solver to the given writer (not owned), so that an UNSAT
+  // result can be checked by an external program. This must be called before
+  // any problem clause is added. Note that the proof is only valid if the
+  // problem is a pure SAT problem given in the same order to the checker, and
+  // if the solver does not use pseudo-Boolean constraints, symmetries or a
+  // SharedClausePool. Passing nullptr stops the proof output.
+  void SetDratWriter(DratWriter* drat_writer);
+
   // Various getters of the current solver state.
   struct Decision {
     Decision() : trail_index(-1) {}
@@ -326,6 +404,7 @@ class SatSolver {
   int64 num_branches() const;
   int64 num_failures() const;
   int64 num_propagations() const;
+  int64 num_inprocessing_rounds() const;
 
   // A deterministic number that should be correlated with the time spent in
   // the Solve() function. The order of magnitude should be close to the time
@@ -360,9 +439,20 @@ class SatSolver {
       const std::vector<LiteralWithCoeff>& cst, const Coefficient rhs) const;
 
   // Logs the given status if parameters_.log_search_progress() is true.
-  // Also returns it.
+  // Also returns it. This also computes the last_solve_statistics_.
   Status StatusWithLog(Status status);
 
+  // Returns the current value of the solver-wide counters. The statistics of
+  // a Solve() are the difference of two such snapshots.
+  SolveStatistics CurrentSolveStatistics() const;
+
+  // Adds the given canonical constraint "cst <= rhs" like
+  // AddLinearConstraintInternal(), but relaxed by the selector of the
+  // innermost scope if there is one.
+  bool AddScopedLinearConstraintInternal(
+      const std::vector<LiteralWithCoeff>& cst, Coefficient rhs,
+      Coefficient max_value);
+
   // Main function called from SolveWithAssumptions() or from Solve() with an
   // assumption_level of 0 (meaning no assumptions).
   Status SolveInternal(int assumption_level);
@@ -437,13 +527,23 @@ class SatSolver {
            trail_.Info(var).sat_clause == clause;
   }
 
-  // Predicate used by CleanClauseDatabaseIfNeeded().
+  // Predicate used by CleanClauseDatabaseIfNeeded(). Apart from the clauses
+  // needed by the problem or by the current assignment, the learned clauses
+  // are split in three tiers depending on their LBD: the "core" ones are always
+  // kept, the "tier2" ones are kept while they are used, and the "local" ones
+  // are only kept according to the clause_cleanup_ordering.
   bool ClauseShouldBeKept(SatClause* clause) const {
     return !clause->IsRedundant() ||
            clause->Lbd() <= parameters_.clause_cleanup_lbd_bound() ||
-           clause->Size() <= 2 || IsClauseUsedAsReason(clause);
+           clause->Size() <= 2 || IsClauseUsedAsReason(clause) ||
+           (clause->IsUsed() &&
+            clause->Lbd() <= parameters_.clause_cleanup_tier2_lbd_bound());
   }
 
+  // Same as AddUnitClause(), but the unit clause is never relaxed by the
+  // selector of the current scope. This is used by PopScope().
+  bool AddUnitClauseOutsideOfScopes(Literal true_literal);
+
   // Add a problem clause. Not that the clause is assumed to be "cleaned", that
   // is no duplicate variables (not strictly required) and not empty.
   bool AddProblemClauseInternal(const std::vector<Literal>& literals,
@@ -486,6 +586,59 @@ class SatSolver {
   // Deletes all the clauses that are detached.
   void DeleteDetachedClauses();
 
+  // Compacts the clause_arena_ if enough memory is wasted by the deleted
+  // clauses, and updates all the references to the moved clauses. This must
+  // only be called when no SatClause pointer other than the ones in clauses_
+  // and in the trail reasons are in use.
+  void CompactClauseArenaIfNeeded();
+
+  // Clause sharing with the other workers of a portfolio, see
+  // SetSharedClausePool(). The first function publishes the given newly
+  // learned clause if it is short enough. The second must be called at
+  // decision level 0 and adds the clauses learned by the other workers as
+  // redundant clauses. It returns false if the problem is proved UNSAT.
+  void MaybeExportLearnedClause(const std::vector<Literal>& literals, int lbd);
+  bool ImportSharedClauses();
+
+  // Inprocessing, see the use_inprocessing() parameter. The first function
+  // returns true if a round should be run at the next restart to level zero.
+  // Inprocess() must be called at decision level zero, runs all the techniques
+  // below with a deterministic time budget proportional to the time spent in
+  // the search, and returns false if the problem is proved UNSAT.
+  bool InprocessingIsNeeded() const;
+  bool Inprocess();
+
+  // The inprocessing techniques. They all stop as soon as deterministic_time()
+  // goes over the given limit, and return false if the problem is UNSAT.
+  //
+  // - ProbeFailedLiterals() propagates the roots of the binary implication
+  //   graph and fixes the ones that lead to a conflict to false.
+  // - SubstituteEquivalentLiterals() replaces in all the clauses the literals
+  //   of a strongly connected component of the binary implication graph by
+  //   their representative.
+  // - SubsumeAndStrengthenClauses() removes the clauses subsumed by a binary
+  //   or another clause and removes the literals from a clause that can be
+  //   removed by self-subsuming resolution.
+  // - VivifyLearnedClauses() propagates the negation of the literals of the
+  //   learned clauses one by one, and shortens a clause as soon as the
+  //   propagation shows that its remaining literals are not needed.
+  bool ProbeFailedLiterals(double deterministic_time_limit);
+  bool SubstituteEquivalentLiterals();
+  bool SubsumeAndStrengthenClauses(double deterministic_time_limit);
+  bool VivifyLearnedClauses(double deterministic_time_limit);
+
+  // Utility functions for the inprocessing. EnqueueProbingDecision() enqueues
+  // a new decision without the side effects of EnqueueNewDecision(), and
+  // ReplaceClause() adds the clause with the given literals (which must be
+  // implied by the problem) in place of the given clause. The latter must
+  // already be detached, and the watchers cleaned up, so that many clauses can
+  // be replaced with only one cleanup. The fixed literals are ignored, and the
+  // new clause can be a unit or binary clause. Returns false if the new clause
+  // is empty (i.e. the problem is UNSAT).
+  void EnqueueProbingDecision(Literal literal);
+  bool ReplaceClause(SatClause* clause, const std::vector<Literal>& literals,
+                     bool is_redundant);
+
   // Simplifies the problem when new variables are assigned at level 0.
   void ProcessNewlyFixedVariables();
 
@@ -613,6 +766,12 @@ class SatSolver {
   // variables, but with different parameters.
   void BumpReasonActivities(const std::vector<Literal>& literals);
   void BumpClauseActivity(SatClause* clause);
+
+  // Called on each learned clause involved in a conflict analysis, while all
+  // its literals are still assigned. This marks the clause as used for the
+  // clause cleanup tiers, and decreases its LBD if the parameter
+  // update_clause_lbd_during_conflict_analysis is true.
+  void MarkClauseAsUsed(SatClause* clause);
   void RescaleClauseActivities(double scaling_factor);
   void UpdateClauseActivityIncrement();
 
@@ -632,10 +791,13 @@ class SatSolver {
   // The number of constraints of the initial problem that where added.
   int num_constraints_;
 
-  // All the clauses managed by the solver (initial and learned). This vector
-  // has ownership of the pointers. We currently do not use
-  // std::unique_ptr<SatClause> because it can't be used with some STL
-  // algorithms like std::partition.
+  // The memory of all the SatClause of this solver.
+  ClauseArena clause_arena_;
+
+  // All the clauses managed by the solver (initial and learned). Their memory
+  // is owned by clause_arena_, and a clause removed from this vector must be
+  // freed with ClauseArena::Free(). Note that a compaction of the arena changes
+  // all these pointers, see CompactClauseArenaIfNeeded().
   //
   // Note that the unit clauses are not kept here and if the parameter
   // treat_binary_clauses_separately is true, the binary clause are not kept
@@ -700,6 +862,22 @@ class SatSolver {
     int64 num_literals_learned;
     int64 num_literals_forgotten;
     int64 num_subsumed_clauses;
+    int64 num_lbd_updates;
+
+    // Clause sharing stats.
+    int64 num_exported_clauses;
+    int64 num_imported_clauses;
+
+    // Inprocessing stats. Note that the number of clause literals inspected by
+    // the subsumption is part of the deterministic time.
+    int64 num_inprocessing_rounds;
+    int64 num_failed_literals;
+    int64 num_substituted_literals;
+    int64 num_inprocessing_subsumed_clauses;
+    int64 num_inprocessing_strengthened_clauses;
+    int64 num_vivified_clauses;
+    int64 num_vivified_literals_removed;
+    int64 num_subsumption_inspected_literals;
 
     Counters()
         : num_branches(0),
@@ -710,7 +888,18 @@ class SatSolver {
           num_learned_pb_literals_(0),
           num_literals_learned(0),
           num_literals_forgotten(0),
-          num_subsumed_clauses(0) {}
+          num_subsumed_clauses(0),
+          num_lbd_updates(0),
+          num_exported_clauses(0),
+          num_imported_clauses(0),
+          num_inprocessing_rounds(0),
+          num_failed_literals(0),
+          num_substituted_literals(0),
+          num_inprocessing_subsumed_clauses(0),
+          num_inprocessing_strengthened_clauses(0),
+          num_vivified_clauses(0),
+          num_vivified_literals_removed(0),
+          num_subsumption_inspected_literals(0) {}
   };
   Counters counters_;
 
@@ -827,6 +1016,34 @@ class SatSolver {
   // Temporary member used by AddLinearConstraintInternal().
   std::vector<Literal> literals_scratchpad_;
 
+  // The pool used to exchange learned clauses with the other workers of a
+  // portfolio, or nullptr. Not owned. See SetSharedClausePool().
+  SharedClausePool* shared_clause_pool_;
+  int worker_id_;
+  std::vector<std::vector<Literal>> imported_clauses_;
+
+  // The output of the DRAT proof, or nullptr. Not owned. See SetDratWriter().
+  DratWriter* drat_writer_;
+
+  // The selector literals of the open scopes, see PushScope(). A constraint of
+  // a scope is only active when its selector is true.
+  std::vector<Literal> scope_selectors_;
+
+  // Temporary vector used by AddScopedLinearConstraintInternal().
+  std::vector<LiteralWithCoeff> tmp_scoped_constraint_;
+
+  // Per-call statistics, see LastSolveStatistics().
+  int64 num_solves_;
+  SolveStatistics solve_start_statistics_;
+  SolveStatistics last_solve_statistics_;
+
+  // Inprocessing state. The deterministic time at the end of the last round
+  // is used to compute the budget of the next one, and the failed literal
+  // probing restarts where the previous round stopped.
+  double deterministic_time_at_last_inprocessing_;
+  double inprocessing_deterministic_time_;
+  LiteralIndex next_literal_to_probe_;
+
   // A boolean vector used to temporarily mark decision levels.
   DEFINE_INT_TYPE(SatDecisionLevel, int);
   SparseBitset<SatDecisionLevel> is_level_marked_;
@@ -836,6 +1053,12 @@ class SatSolver {
   std::vector<Literal> reason_used_to_infer_the_conflict_;
   std::vector<SatClause*> subsumed_clauses_;
 
+  // Copy of the literals of the subsumed_clauses_ for the DRAT proof, since
+  // these clauses may be deleted when the learned clause is added. The
+  // literals of the i-th clause end at subsumed_clause_ends_[i].
+  std::vector<Literal> subsumed_literals_;
+  std::vector<int> subsumed_clause_ends_;
+
   // "cache" to avoid inspecting many times the same reason during conflict
   // analysis.
   VariableWithSameReasonIdentifier same_reason_identifier_;
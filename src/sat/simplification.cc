@@ -13,12 +13,73 @@
 
 #include "sat/simplification.h"
 
+#include "base/callback.h"
+#include "base/threadpool.h"
 #include "base/timer.h"
 #include "algorithms/dynamic_partition.h"
 
 namespace operations_research {
 namespace sat {
 
+namespace {
+
+// Maximum number of variables (resp. clauses) processed by each batch of
+// EliminateVariablesInParallel() (resp. ProcessAllClausesInParallel()). This
+// does not depend on the number of threads so that the presolve is
+// deterministic.
+const int kMaxVariableBatchSize = 1024;
+const int kMaxClauseBatchSize = 1 << 14;
+
+uint64 ComputeSignature(const std::vector<Literal>& clause) {
+  uint64 signature = 0;
+  for (const Literal l : clause) {
+    signature |= uint64(1) << (l.Variable().value() & 63);
+  }
+  return signature;
+}
+
+// Returns -1 if the clause b can't be simplified using a, otherwise returns
+// the position in b of the literal that SimplifyClause() removes, or b.size()
+// if a subsumes b.
+int SimplificationPosition(const std::vector<Literal>& a,
+                           const std::vector<Literal>& b) {
+  if (b.size() < a.size()) return -1;
+  DCHECK(std::is_sorted(a.begin(), a.end()));
+  DCHECK(std::is_sorted(b.begin(), b.end()));
+
+  int num_diff = 0;
+  std::vector<Literal>::const_iterator ia = a.begin();
+  std::vector<Literal>::const_iterator ib = b.begin();
+  std::vector<Literal>::const_iterator to_remove = b.end();
+
+  // Because we abort early when size_diff becomes negative, the second test
+  // in the while loop is not needed.
+  int size_diff = b.size() - a.size();
+  while (ia != a.end() /* && ib != b.end() */) {
+    if (*ia == *ib) {  // Same literal.
+      ++ia;
+      ++ib;
+    } else if (*ia == ib->Negated()) {  // Opposite literal.
+      ++num_diff;
+      if (num_diff > 1) return -1;  // Too much difference.
+      to_remove = ib;
+      ++ia;
+      ++ib;
+    } else if (*ia < *ib) {
+      return -1;  // A literal of a is not in b.
+    } else {      // *ia > *ib
+      ++ib;
+
+      // A literal of b is not in a, we can abort early by comparing the sizes
+      // left.
+      if (--size_diff < 0) return -1;
+    }
+  }
+  return to_remove - b.begin();
+}
+
+}  // namespace
+
 SatPostsolver::SatPostsolver(int num_variables) {
   reverse_mapping_.resize(num_variables);
   for (VariableIndex var(0); var < num_variables; ++var) {
@@ -155,6 +216,7 @@ void SatPresolver::AddClause(ClauseRef clause) {
     }
   }
 
+  clause_signatures_.push_back(ComputeSignature(clause_ref));
   const Literal max_literal = clause_ref.back();
   const int required_size =
       std::max(max_literal.Index().value(), max_literal.NegatedIndex().value()) + 1;
@@ -170,9 +232,11 @@ void SatPresolver::AddClause(ClauseRef clause) {
 
 void SatPresolver::AddClauseInternal(std::vector<Literal>* clause) {
   CHECK_GT(clause->size(), 0) << "TODO(fdid): Unsat during presolve?";
+  if (drat_writer_ != nullptr) drat_writer_->AddClause(ClauseRef(*clause));
   const ClauseIndex ci(clauses_.size());
   clauses_.push_back(std::vector<Literal>());
   clauses_.back().swap(*clause);
+  clause_signatures_.push_back(ComputeSignature(clauses_.back()));
   in_clause_to_process_.push_back(true);
   clause_to_process_.push_back(ci);
   for (Literal e : clauses_.back()) {
@@ -234,6 +298,23 @@ bool SatPresolver::Presolve() {
 
   // TODO(user): When a clause is strengthened, add it to a queue so it can
   // be processed again?
+  if (parameters_.presolve_num_threads() > 1) {
+    thread_pool_.reset(
+        new ThreadPool("SatPresolver", parameters_.presolve_num_threads()));
+    thread_pool_->StartWorkers();
+    bool result = ProcessAllClausesInParallel();
+    if (result) {
+      DisplayStats(timer.Get());
+      InitializePriorityQueue();
+      result = EliminateVariablesInParallel();
+    }
+    if (result) DisplayStats(timer.Get());
+
+    // Joins the threads.
+    thread_pool_.reset();
+    return result;
+  }
+
   if (!ProcessAllClauses()) return false;
   DisplayStats(timer.Get());
 
@@ -253,14 +334,15 @@ bool SatPresolver::Presolve() {
 // TODO(user): Binary clauses are really common, and we can probably do this
 // more efficiently for them. For instance, we could just take the intersection
 // of two sorted lists to get the simplified clauses.
-//
-// TODO(user): SimplifyClause can returns true only if the variables in 'a' are
-// a subset of the one in 'b'. Use an int64 signature for speeding up the test.
 bool SatPresolver::ProcessClauseToSimplifyOthers(ClauseIndex clause_index) {
   const std::vector<Literal>& clause = clauses_[clause_index];
   if (clause.empty()) return true;
   DCHECK(std::is_sorted(clause.begin(), clause.end()));
 
+  // SimplifyClause() can only return true if the variables of clause are a
+  // subset of the ones of the other clause.
+  const uint64 signature = clause_signatures_[clause_index];
+
   LiteralIndex opposite_literal;
   const Literal lit = FindLiteralWithShortestOccurenceList(clause);
 
@@ -271,14 +353,19 @@ bool SatPresolver::ProcessClauseToSimplifyOthers(ClauseIndex clause_index) {
     std::vector<ClauseIndex>& occurence_list_ref = literal_to_clauses_[lit.Index()];
     for (ClauseIndex ci : occurence_list_ref) {
       if (clauses_[ci].empty()) continue;
-      if (ci != clause_index &&
+      if (ci != clause_index && (signature & ~clause_signatures_[ci]) == 0 &&
           SimplifyClause(clause, &clauses_[ci], &opposite_literal)) {
         if (opposite_literal == LiteralIndex(-1)) {
           Remove(ci);
           continue;
         } else {
           CHECK_NE(opposite_literal, lit.Index());
+          if (drat_writer_ != nullptr) {
+            WriteStrengthenedClauseToDratProof(ci, opposite_literal);
+          }
           if (clauses_[ci].empty()) return false;  // UNSAT.
+          clause_signatures_[ci] = ComputeSignature(clauses_[ci]);
+
           // Remove ci from the occurence list. Note that the occurence list
           // can't be shortest_list or its negation.
           auto iter =
@@ -316,9 +403,14 @@ bool SatPresolver::ProcessClauseToSimplifyOthers(ClauseIndex clause_index) {
 
       // TODO(user): not super optimal since we could abort earlier if
       // opposite_literal is not the negation of shortest_list.
-      if (SimplifyClause(clause, &clauses_[ci], &opposite_literal)) {
+      if ((signature & ~clause_signatures_[ci]) == 0 &&
+          SimplifyClause(clause, &clauses_[ci], &opposite_literal)) {
         CHECK_EQ(opposite_literal, lit.NegatedIndex());
+        if (drat_writer_ != nullptr) {
+          WriteStrengthenedClauseToDratProof(ci, opposite_literal);
+        }
         if (clauses_[ci].empty()) return false;  // UNSAT.
+        clause_signatures_[ci] = ComputeSignature(clauses_[ci]);
         if (!in_clause_to_process_[ci]) {
           in_clause_to_process_[ci] = true;
           clause_to_process_.push_back(ci);
@@ -347,18 +439,31 @@ void SatPresolver::RemoveAndRegisterForPostsolveAllClauseContaining(Literal x) {
 }
 
 bool SatPresolver::CrossProduct(Literal x) {
-  const int s1 = literal_to_clause_sizes_[x.Index()];
-  const int s2 = literal_to_clause_sizes_[x.NegatedIndex()];
+  CrossProductResult result;
+  EvaluateCrossProduct(x, &result);
+  return ApplyCrossProduct(&result);
+}
+
+bool SatPresolver::IsCrossProductCandidate(VariableIndex var) const {
+  const int s1 = literal_to_clause_sizes_[Literal(var, true).Index()];
+  const int s2 = literal_to_clause_sizes_[Literal(var, false).Index()];
 
-  // Note that if s1 or s2 is equal to 0, this function will implicitely just
-  // fix the variable x.
+  // Note that if s1 or s2 is equal to 0, CrossProduct() will implicitely just
+  // fix the variable var.
   if (s1 == 0 && s2 == 0) return false;
 
-  // Heuristic. Abort if the work required to decide if x should be removed
+  // Heuristic. Abort if the work required to decide if var should be removed
   // seems to big.
-  if (s1 > 1 && s2 > 1 && s1 * s2 > parameters_.presolve_bve_threshold()) {
-    return false;
-  }
+  return s1 <= 1 || s2 <= 1 || s1 * s2 <= parameters_.presolve_bve_threshold();
+}
+
+void SatPresolver::EvaluateCrossProduct(Literal x,
+                                        CrossProductResult* result) const {
+  result->x = x;
+  result->blocked_clauses.clear();
+  result->eliminate = false;
+  result->resolvants.clear();
+  if (!IsCrossProductCandidate(x.Variable())) return;
 
   // Compute the threshold under which we don't remove x.Variable().
   int threshold = 0;
@@ -375,7 +480,11 @@ bool SatPresolver::CrossProduct(Literal x) {
   }
 
   // For the BCE, we prefer s2 to be small.
-  if (s1 < s2) x = x.Negated();
+  if (literal_to_clause_sizes_[x.Index()] <
+      literal_to_clause_sizes_[x.NegatedIndex()]) {
+    x = x.Negated();
+    result->x = x;
+  }
 
   // Test whether we should remove the x.Variable().
   int size = 0;
@@ -385,20 +494,22 @@ bool SatPresolver::CrossProduct(Literal x) {
     bool no_resolvant = true;
     for (ClauseIndex j : literal_to_clauses_[x.NegatedIndex()]) {
       if (clauses_[j].empty()) continue;
-
-      // TODO(user): The output temp is not needed here. Optimize.
       if (ComputeResolvant(x, clauses_[i], clauses_[j], &temp)) {
         no_resolvant = false;
         size += clause_weight + temp.size();
 
         // Abort early if the "size" become too big.
-        if (size > threshold) return false;
+        if (size > threshold) {
+          result->resolvants.clear();
+          return;
+        }
+        result->resolvants.push_back(temp);
       }
     }
     if (no_resolvant) {
       // This is an incomplete heuristic for blocked clause detection. Here,
-      // the clause i is "blocked", so we can remove it. Note that the code
-      // below already do that if we decide to eliminate x.
+      // the clause i is "blocked", so we can remove it. Note that
+      // ApplyCrossProduct() already do that if we decide to eliminate x.
       //
       // For more details, see the paper "Blocked clause elimination", Matti
       // Jarvisalo, Armin Biere, Marijn Heule. TACAS, volume 6015 of Lecture
@@ -408,21 +519,24 @@ bool SatPresolver::CrossProduct(Literal x) {
       // sizes? The function achieve the same if x = x.Negated(), however the
       // loops are not done in the same order which may change this incomplete
       // "blocked" clause detection.
-      RemoveAndRegisterForPostsolve(i, x);
+      result->blocked_clauses.push_back(i);
     }
   }
+  result->eliminate = true;
+}
+
+bool SatPresolver::ApplyCrossProduct(CrossProductResult* result) {
+  const Literal x = result->x;
+  for (ClauseIndex i : result->blocked_clauses) {
+    RemoveAndRegisterForPostsolve(i, x);
+  }
+  if (!result->eliminate) return false;
 
   // Add all the resolvant clauses.
   // Note that the variable priority queue will only be updated during the
   // deletion.
-  for (ClauseIndex i : literal_to_clauses_[x.Index()]) {
-    if (clauses_[i].empty()) continue;
-    for (ClauseIndex j : literal_to_clauses_[x.NegatedIndex()]) {
-      if (clauses_[j].empty()) continue;
-      if (ComputeResolvant(x, clauses_[i], clauses_[j], &temp)) {
-        AddClauseInternal(&temp);
-      }
-    }
+  for (std::vector<Literal>& resolvant : result->resolvants) {
+    AddClauseInternal(&resolvant);
   }
 
   // Deletes the old clauses.
@@ -437,7 +551,170 @@ bool SatPresolver::CrossProduct(Literal x) {
   return true;
 }
 
+void SatPresolver::RunInParallel(void (SatPresolver::*task)(int)) {
+  DCHECK(thread_pool_ != nullptr);
+  const int num_workers = parameters_.presolve_num_threads();
+  workers_mutex_.Lock();
+  num_running_workers_ = num_workers;
+  workers_mutex_.Unlock();
+  for (int worker = 0; worker < num_workers; ++worker) {
+    thread_pool_->Add(
+        NewCallback(this, &SatPresolver::RunWorker, task, worker));
+  }
+  MutexLock lock(&workers_mutex_);
+  while (num_running_workers_ > 0) workers_done_.Wait(&workers_mutex_);
+}
+
+void SatPresolver::RunWorker(void (SatPresolver::*task)(int), int worker) {
+  (this->*task)(worker);
+  MutexLock lock(&workers_mutex_);
+  --num_running_workers_;
+  if (num_running_workers_ == 0) workers_done_.Signal();
+}
+
+void SatPresolver::EvaluateCrossProductsOfBatch(int worker) {
+  const int num_workers = parameters_.presolve_num_threads();
+  for (int i = worker; i < batch_variables_.size(); i += num_workers) {
+    EvaluateCrossProduct(Literal(batch_variables_[i], true),
+                         &batch_cross_products_[i]);
+  }
+}
+
+// Each batch is a set of variables such that no clause contains two of them.
+// The cross product of a variable only reads the clauses containing it and
+// only modifies these clauses and adds clauses that do not contain the other
+// variables of the batch, so the cross products of a batch can be evaluated
+// concurrently on the same clause database and applied one after the other.
+bool SatPresolver::EliminateVariablesInParallel() {
+  SparseBitset<VariableIndex> in_batch_neighborhood;
+  std::vector<VariableIndex> postponed_variables;
+  while (var_pq_.Size() > 0) {
+    in_batch_neighborhood.ClearAndResize(VariableIndex(NumVariables()));
+    batch_variables_.clear();
+    postponed_variables.clear();
+    while (var_pq_.Size() > 0 &&
+           batch_variables_.size() < kMaxVariableBatchSize &&
+           postponed_variables.size() < kMaxVariableBatchSize) {
+      const VariableIndex var = var_pq_.Top()->variable;
+      var_pq_.Pop();
+      if (!IsCrossProductCandidate(var)) continue;
+      if (in_batch_neighborhood[var]) {
+        postponed_variables.push_back(var);
+        continue;
+      }
+      batch_variables_.push_back(var);
+      for (const Literal l : {Literal(var, true), Literal(var, false)}) {
+        for (ClauseIndex i : literal_to_clauses_[l.Index()]) {
+          for (Literal e : clauses_[i]) in_batch_neighborhood.Set(e.Variable());
+        }
+      }
+    }
+
+    batch_cross_products_.resize(batch_variables_.size());
+    RunInParallel(&SatPresolver::EvaluateCrossProductsOfBatch);
+    bool some_variable_eliminated = false;
+    for (int i = 0; i < batch_variables_.size(); ++i) {
+      if (ApplyCrossProduct(&batch_cross_products_[i])) {
+        some_variable_eliminated = true;
+      }
+    }
+    for (const VariableIndex var : postponed_variables) {
+      UpdatePriorityQueue(var);
+    }
+    if (some_variable_eliminated && !ProcessAllClausesInParallel()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SatPresolver::FindSimplifiedClausesOfBatch(int worker) {
+  const int num_workers = parameters_.presolve_num_threads();
+  for (int b = worker; b < batch_clauses_.size(); b += num_workers) {
+    std::vector<ClauseIndex>* simplified = &batch_simplified_clauses_[b];
+    simplified->clear();
+    const ClauseIndex clause_index = batch_clauses_[b];
+    const std::vector<Literal>& clause = clauses_[clause_index];
+    if (clause.empty()) continue;
+    const uint64 signature = clause_signatures_[clause_index];
+    const Literal lit = FindLiteralWithShortestOccurenceList(clause);
+    for (const Literal l : {lit, lit.Negated()}) {
+      for (ClauseIndex ci : literal_to_clauses_[l.Index()]) {
+        if (ci == clause_index || clauses_[ci].empty()) continue;
+        if ((signature & ~clause_signatures_[ci]) != 0) continue;
+        if (SimplificationPosition(clause, clauses_[ci]) >= 0) {
+          simplified->push_back(ci);
+        }
+      }
+    }
+  }
+}
+
+// The clauses of a batch are processed concurrently on the same clause
+// database, and the simplifications found are applied afterwards in the batch
+// order. Because a simplification may invalidate the ones found after it, each
+// of them is checked again when it is applied.
+bool SatPresolver::ProcessAllClausesInParallel() {
+  while (!clause_to_process_.empty()) {
+    batch_clauses_.clear();
+    while (!clause_to_process_.empty() &&
+           batch_clauses_.size() < kMaxClauseBatchSize) {
+      const ClauseIndex ci = clause_to_process_.front();
+      in_clause_to_process_[ci] = false;
+      clause_to_process_.pop_front();
+      batch_clauses_.push_back(ci);
+    }
+
+    batch_simplified_clauses_.resize(batch_clauses_.size());
+    RunInParallel(&SatPresolver::FindSimplifiedClausesOfBatch);
+    for (int b = 0; b < batch_clauses_.size(); ++b) {
+      for (ClauseIndex ci : batch_simplified_clauses_[b]) {
+        if (!SimplifyClauseUsing(batch_clauses_[b], ci)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SatPresolver::SimplifyClauseUsing(ClauseIndex clause_index,
+                                       ClauseIndex ci) {
+  const std::vector<Literal>& clause = clauses_[clause_index];
+  if (clause.empty() || clauses_[ci].empty()) return true;
+  if ((clause_signatures_[clause_index] & ~clause_signatures_[ci]) != 0) {
+    return true;
+  }
+  LiteralIndex opposite_literal;
+  if (!SimplifyClause(clause, &clauses_[ci], &opposite_literal)) return true;
+  if (opposite_literal == LiteralIndex(-1)) {
+    Remove(ci);
+    return true;
+  }
+  if (drat_writer_ != nullptr) {
+    WriteStrengthenedClauseToDratProof(ci, opposite_literal);
+  }
+  if (clauses_[ci].empty()) return false;  // UNSAT.
+  clause_signatures_[ci] = ComputeSignature(clauses_[ci]);
+
+  std::vector<ClauseIndex>& occurence_list_ref =
+      literal_to_clauses_[opposite_literal];
+  auto iter =
+      std::find(occurence_list_ref.begin(), occurence_list_ref.end(), ci);
+  DCHECK(iter != occurence_list_ref.end());
+  occurence_list_ref.erase(iter);
+  --literal_to_clause_sizes_[opposite_literal];
+  UpdatePriorityQueue(Literal(opposite_literal).Variable());
+
+  if (!in_clause_to_process_[ci]) {
+    in_clause_to_process_[ci] = true;
+    clause_to_process_.push_back(ci);
+  }
+  return true;
+}
+
 void SatPresolver::Remove(ClauseIndex ci) {
+  if (drat_writer_ != nullptr) {
+    drat_writer_->DeleteClause(ClauseRef(clauses_[ci]));
+  }
   for (Literal e : clauses_[ci]) {
     literal_to_clause_sizes_[e.Index()]--;
     UpdatePriorityQueue(e.Variable());
@@ -446,6 +723,9 @@ void SatPresolver::Remove(ClauseIndex ci) {
 }
 
 void SatPresolver::RemoveAndRegisterForPostsolve(ClauseIndex ci, Literal x) {
+  if (drat_writer_ != nullptr) {
+    drat_writer_->DeleteClause(ClauseRef(clauses_[ci]));
+  }
   for (Literal e : clauses_[ci]) {
     literal_to_clause_sizes_[e.Index()]--;
     UpdatePriorityQueue(e.Variable());
@@ -454,8 +734,17 @@ void SatPresolver::RemoveAndRegisterForPostsolve(ClauseIndex ci, Literal x) {
   postsolver_->Add(x, &clauses_[ci]);
 }
 
+void SatPresolver::WriteStrengthenedClauseToDratProof(
+    ClauseIndex ci, LiteralIndex removed_literal) {
+  const std::vector<Literal>& clause = clauses_[ci];
+  drat_writer_->AddClause(clause.empty() ? ClauseRef() : ClauseRef(clause));
+  std::vector<Literal> old_clause(clause);
+  old_clause.push_back(Literal(removed_literal));
+  drat_writer_->DeleteClause(ClauseRef(old_clause));
+}
+
 Literal SatPresolver::FindLiteralWithShortestOccurenceList(
-    const std::vector<Literal>& clause) {
+    const std::vector<Literal>& clause) const {
   CHECK(!clause.empty());
   Literal result = clause.front();
   for (Literal l : clause) {
@@ -526,43 +815,12 @@ void SatPresolver::DisplayStats(double elapsed_seconds) {
 
 bool SimplifyClause(const std::vector<Literal>& a, std::vector<Literal>* b,
                     LiteralIndex* opposite_literal) {
-  if (b->size() < a.size()) return false;
-  DCHECK(std::is_sorted(a.begin(), a.end()));
-  DCHECK(std::is_sorted(b->begin(), b->end()));
-
   *opposite_literal = LiteralIndex(-1);
-
-  int num_diff = 0;
-  std::vector<Literal>::const_iterator ia = a.begin();
-  std::vector<Literal>::iterator ib = b->begin();
-  std::vector<Literal>::iterator to_remove = b->begin();
-
-  // Because we abort early when size_diff becomes negative, the second test
-  // in the while loop is not needed.
-  int size_diff = b->size() - a.size();
-  while (ia != a.end() /* && ib != b->end() */) {
-    if (*ia == *ib) {  // Same literal.
-      ++ia;
-      ++ib;
-    } else if (*ia == ib->Negated()) {  // Opposite literal.
-      ++num_diff;
-      if (num_diff > 1) return false;  // Too much difference.
-      to_remove = ib;
-      ++ia;
-      ++ib;
-    } else if (*ia < *ib) {
-      return false;  // A literal of a is not in b.
-    } else {         // *ia > *ib
-      ++ib;
-
-      // A literal of b is not in a, we can abort early by comparing the sizes
-      // left.
-      if (--size_diff < 0) return false;
-    }
-  }
-  if (num_diff == 1) {
-    *opposite_literal = to_remove->Index();
-    b->erase(to_remove);
+  const int position = SimplificationPosition(a, *b);
+  if (position < 0) return false;
+  if (position < b->size()) {
+    *opposite_literal = (*b)[position].Index();
+    b->erase(b->begin() + position);
   }
   return true;
 }
@@ -22,11 +22,15 @@
 #include <deque>
 #include <vector>
 
+#include "sat/drat_writer.h"
 #include "sat/sat_base.h"
 #include "sat/sat_parameters.pb.h"
 #include "sat/sat_solver.h"
 
 #include "base/adjustable_priority_queue.h"
+#include "base/mutex.h"
+#include "base/threadpool.h"
+#include "base/unique_ptr.h"
 
 namespace operations_research {
 namespace sat {
@@ -107,9 +111,18 @@ class SatPresolver {
   typedef int32 ClauseIndex;
 
   explicit SatPresolver(SatPostsolver* postsolver)
-      : postsolver_(postsolver), num_trivial_clauses_(0) {}
+      : postsolver_(postsolver),
+        num_trivial_clauses_(0),
+        num_running_workers_(0),
+        drat_writer_(nullptr) {}
   void SetParameters(const SatParameters& params) { parameters_ = params; }
 
+  // Writes the clauses added, strengthened and deleted by the presolve to the
+  // given DRAT proof (not owned). See SatSolver::SetDratWriter(). Note that the
+  // variable elimination only deletes clauses, which is always valid in a DRAT
+  // proof even if the presolved problem is only equisatisfiable.
+  void SetDratWriter(DratWriter* drat_writer) { drat_writer_ = drat_writer; }
+
   // Registers a mapping to encode equivalent literals.
   // See ProbeAndFindEquivalentLiteral().
   void SetEquivalentLiteralMapping(
@@ -124,6 +137,9 @@ class SatPresolver {
   // Presolves the problem currently loaded. Returns false if the model is
   // proven to be UNSAT during the presolving.
   //
+  // If the presolve_num_threads parameter is greater than one, the work is
+  // split among this number of threads, see EliminateVariablesInParallel().
+  //
   // TODO(user): Add support for a time limit and some kind of iterations limit
   // so that this can never take too much time.
   bool Presolve();
@@ -173,20 +189,69 @@ class SatPresolver {
   // after this call.
   void AddClauseInternal(std::vector<Literal>* clause);
 
+  // Computes what CrossProduct() would do without modifying the clause
+  // database, and applies it. The two calls are only equivalent to
+  // CrossProduct() if the clauses containing x.Variable() are not modified in
+  // between.
+  struct CrossProductResult {
+    // The literal on which the resolution is done, this may be the negation of
+    // the literal given to EvaluateCrossProduct().
+    Literal x;
+
+    // The clauses containing x without any non-trivial resolvant, in the order
+    // in which they are removed. See the blocked clause comment in the .cc.
+    std::vector<ClauseIndex> blocked_clauses;
+
+    // Whether x.Variable() should be eliminated, in which case this contains
+    // all the non-trivial resolvants to add.
+    bool eliminate;
+    std::vector<std::vector<Literal>> resolvants;
+  };
+  bool IsCrossProductCandidate(VariableIndex var) const;
+  void EvaluateCrossProduct(Literal x, CrossProductResult* result) const;
+  bool ApplyCrossProduct(CrossProductResult* result);
+
   // Clause removal function.
   void Remove(ClauseIndex ci);
   void RemoveAndRegisterForPostsolve(ClauseIndex ci, Literal x);
   void RemoveAndRegisterForPostsolveAllClauseContaining(Literal x);
 
+  // Writes to the DRAT proof that the given literal was just removed from the
+  // clause ci.
+  void WriteStrengthenedClauseToDratProof(ClauseIndex ci,
+                                          LiteralIndex removed_literal);
+
   // Call ProcessClauseToSimplifyOthers() on all the clauses in
   // clause_to_process_ and empty the list afterwards. Note that while some
   // clauses are processed, new ones may be added to the list. Returns false if
   // the problem is shown to be UNSAT.
   bool ProcessAllClauses();
 
+  // Parallel versions of the two main loops of Presolve(). The work that only
+  // reads the clause database is split among the worker threads, and its
+  // result is applied sequentially in a deterministic order. Returns false if
+  // the problem is shown to be UNSAT.
+  bool EliminateVariablesInParallel();
+  bool ProcessAllClausesInParallel();
+
+  // Calls (this->*task)(worker) for all worker in [0, presolve_num_threads)
+  // concurrently on the threads of thread_pool_ and waits for all of them. The
+  // workers split the current batch by taking one element every
+  // presolve_num_threads.
+  void RunInParallel(void (SatPresolver::*task)(int));
+  void RunWorker(void (SatPresolver::*task)(int), int worker);
+  void EvaluateCrossProductsOfBatch(int worker);
+  void FindSimplifiedClausesOfBatch(int worker);
+
+  // Simplifies the clause ci using the clause clause_index (see
+  // SimplifyClause()) and updates the occurence lists accordingly. Returns
+  // false if ci becomes empty, that is if the problem is UNSAT.
+  bool SimplifyClauseUsing(ClauseIndex clause_index, ClauseIndex ci);
+
   // Finds the literal from the clause that occur the less in the clause
   // database.
-  Literal FindLiteralWithShortestOccurenceList(const std::vector<Literal>& clause);
+  Literal FindLiteralWithShortestOccurenceList(
+      const std::vector<Literal>& clause) const;
 
   // Display some statistics on the current clause database.
   void DisplayStats(double elapsed_seconds);
@@ -225,6 +290,11 @@ class SatPresolver {
   // An empty clause means that it has been removed.
   std::vector<std::vector<Literal>> clauses_;  // Indexed by ClauseIndex
 
+  // The signature of each clause has the bit (v % 64) set for each variable v
+  // of the clause. The clause a can only subsume or strengthen the clause b
+  // if the signature of a is included in the one of b.
+  std::vector<uint64> clause_signatures_;  // Indexed by ClauseIndex
+
   // Occurence list. For each literal, contains the ClauseIndex of the clause
   // that contains it (ordered by clause index).
   ITIVector<LiteralIndex, std::vector<ClauseIndex>> literal_to_clauses_;
@@ -241,7 +311,27 @@ class SatPresolver {
 
   int num_trivial_clauses_;
 
+  // The current batch of EliminateVariablesInParallel(): the variables to
+  // eliminate (none of them appears in a clause of another) and the result of
+  // EvaluateCrossProduct() for each of them.
+  std::vector<VariableIndex> batch_variables_;
+  std::vector<CrossProductResult> batch_cross_products_;
+
+  // The current batch of ProcessAllClausesInParallel(): the clauses to process
+  // and, for each of them, the clauses it can simplify.
+  std::vector<ClauseIndex> batch_clauses_;
+  std::vector<std::vector<ClauseIndex>> batch_simplified_clauses_;
+
+  // The threads used by RunInParallel(). They are started once per Presolve()
+  // and reused for all the batches, and num_running_workers_ is the number of
+  // workers of the current batch that are not done yet.
+  std::unique_ptr<ThreadPool> thread_pool_;
+  Mutex workers_mutex_;
+  CondVar workers_done_;
+  int num_running_workers_ GUARDED_BY(workers_mutex_);
+
   SatParameters parameters_;
+  DratWriter* drat_writer_;
   DISALLOW_COPY_AND_ASSIGN(SatPresolver);
 };
 
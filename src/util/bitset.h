@@ -494,6 +494,11 @@ class Bitset64 {
   // Same as IsSet().
   bool operator[](IndexType i) const { return IsSet(i); }
 
+  // Returns the underlying buckets: the bit at position i is the bit
+  // BitPos64(i) of buckets()[BitOffset64(i)]. Note that the bits past size()
+  // in the last bucket are not always 0.
+  const uint64* buckets() const { return data_.data(); }
+
   // Sets the bit at position i to 1.
   void Set(IndexType i) {
     DCHECK_GE(Value(i), 0);
@@ -599,6 +604,24 @@ class Bitset64 {
       current_ &= current_ - 1;
     }
 
+    // Same as above, but starts at the first position at 1 which is greater or
+    // equal to the given one. This is useful to iterate over a range of
+    // positions without testing all of them:
+    //   for (Bitset64<IndexType>::Iterator it(bitset, begin);
+    //        it.Ok() && it.Index() < end; it.Next()) {}
+    Iterator(const Bitset64& data_, IndexType start)
+        : bitset_(data_), index_(0), base_index_(0), current_(0) {
+      const int bucket = BitOffset64(bitset_.Value(start));
+      if (bucket >= static_cast<int>(bitset_.data_.size())) {
+        index_ = -1;
+      } else {
+        base_index_ = BitShift64(bucket);
+        current_ = bitset_.data_[bucket] &
+                   ~(OneBit64(BitPos64(bitset_.Value(start))) - 1);
+        Next();
+      }
+    }
+
     // STL version of the functions above to support range-based "for" loop.
     Iterator(const Bitset64& data_, bool at_end)
         : bitset_(data_), index_(0), base_index_(0), current_(0) {
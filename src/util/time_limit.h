@@ -15,6 +15,7 @@
 #define OR_TOOLS_UTIL_TIME_LIMIT_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
 #include <vector>
@@ -112,6 +113,16 @@ class TimeLimit {
     return elapsed_deterministic_time_;
   }
 
+  // Registers the external Boolean to check when LimitReached() is called.
+  // This is used to stop a computation from another thread, for instance when
+  // several solvers race on the same problem and the first one to finish
+  // wants the others to abort. Passing nullptr unregisters the Boolean. The
+  // pointed Boolean must outlive this object (or be unregistered before).
+  void RegisterExternalBooleanAsLimit(
+      const std::atomic<bool>* external_boolean_as_limit) {
+    external_boolean_as_limit_ = external_boolean_as_limit;
+  }
+
  private:
   const int64 start_ns_;
   int64 last_ns_;
@@ -126,6 +137,8 @@ class TimeLimit {
   double deterministic_limit_;
   double elapsed_deterministic_time_;
 
+  const std::atomic<bool>* external_boolean_as_limit_;
+
   DISALLOW_COPY_AND_ASSIGN(TimeLimit);
 };
 
@@ -140,7 +153,8 @@ inline TimeLimit::TimeLimit(double limit_in_seconds, double deterministic_limit)
       safety_buffer_ns_(static_cast<int64>(kSafetyBufferSeconds * 1e9)),
       running_max_(kHistorySize),
       deterministic_limit_(deterministic_limit),
-      elapsed_deterministic_time_(0.0) {
+      elapsed_deterministic_time_(0.0),
+      external_boolean_as_limit_(nullptr) {
   if (FLAGS_time_limit_use_usertime) {
     user_timer_.Start();
     limit_in_seconds_ = limit_in_seconds;
@@ -148,6 +162,10 @@ inline TimeLimit::TimeLimit(double limit_in_seconds, double deterministic_limit)
 }
 
 inline bool TimeLimit::LimitReached() {
+  if (external_boolean_as_limit_ != nullptr &&
+      external_boolean_as_limit_->load(std::memory_order_relaxed)) {
+    return true;
+  }
   if (GetDeterministicTimeLeft() <= 0.0) {
     return true;
   }